@@ -1,70 +1,720 @@
+#include <algorithm>
+
 #include "AppDomain.hxx"
-#include <sstream>
-#include <iomanip>
+#include "EnumCasting.hxx"
+#include "Interpreter.hxx"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
 
 using namespace std;
 
-AppDomain::AppDomain(const string& searchPath) : assemblyPath(searchPath) {}
+#ifdef WIN32
+static const char pathDelimiter = '\\';
+#else
+static const char pathDelimiter = '/';
+#endif
 
-const Guid& AppDomain::loadAssembly(const AssemblyData& assembly) {
-    return loadAssembly(&assembly);
+// Names of files in directory, empty set if directory doesn't exist.
+static unordered_set<string> listDirectory(const string& directory) {
+    unordered_set<string> result;
+#ifdef WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE search = FindFirstFileA((directory + "\\*").c_str(), &entry);
+    if (search == INVALID_HANDLE_VALUE) {
+        return result;
+    }
+    do {
+        if ((entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+            result.insert(entry.cFileName);
+        }
+    } while (FindNextFileA(search, &entry));
+    FindClose(search);
+#else
+    auto dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return result;
+    }
+    while (auto entry = readdir(dir)) {
+        result.insert(entry->d_name);
+    }
+    closedir(dir);
+#endif
+    return result;
 }
 
-const Guid& AppDomain::loadAssembly(const AssemblyData* assembly) {
-    shared_ptr<const AssemblyData> assemblyPtr(new AssemblyData(*assembly));
+static string joinPath(const string& directory, const string& name) {
+    if (directory.empty() || directory.back() == pathDelimiter || directory.back() == '/') {
+        return directory + name;
+    }
+    return directory + pathDelimiter + name;
+}
 
+AppDomain::AppDomain(const string& searchPath, const AppDomainOptions& domainOptions) : assemblyPath(searchPath), options(domainOptions) {
+    probeDirectories.push_back(searchPath);
+    probeDirectories.insert(probeDirectories.end(), options.probeDirectories.begin(), options.probeDirectories.end());
+}
+
+// Images are shared between domains, nothing is copied here.
+const Guid& AppDomain::loadAssembly(const shared_ptr<const AssemblyData>& assembly) {
+    auto assemblyPtr = AssemblyCache::add(assembly);
+
+    lock_guard<mutex> guard(assembliesLock);
     auto result = assemblies.insert(pair<Guid, shared_ptr<const AssemblyData> >(assemblyPtr->getGUID(), assemblyPtr));
     if (!result.second) {
         cout << "Assembly " << assemblyPtr->getGUID() << " already loaded" << endl;
+    } else {
+        const auto identity = AssemblyIdentity::ofAssembly(*assemblyPtr);
+        assembliesByIdentity.insert(make_pair(identity, assemblyPtr.get()));
+        assembliesWithoutToken.insert(make_pair(identity.withoutToken(), assemblyPtr.get()));
     }
     return (*result.first).first;
 }
 
-const Guid& AppDomain::loadAssembly(const u16string& name, const vector<uint16_t>& version) {
-    ostringstream ss;
-
-#ifdef WIN32
-    string delimiter = "\\";
-#else
-    string delimiter = "/";
-#endif
-
-    ss << assemblyPath << delimiter << dec;
+const Guid& AppDomain::loadAssembly(const string& name, const vector<uint16_t>& version) {
+    auto path = probe(name, version);
+    if (path.empty()) {
+        throw runtime_error("Unable to find assembly " + name);
+    }
+    return loadAssembly(path);
+}
 
-    for(const auto& n : version) {
+// Assemblies are searched as <directory>/<version>/<name>.dll or .exe
+string AppDomain::probe(const string& name, const vector<uint16_t>& version) {
+    string subdirectory;
+    for (const auto& n : version) {
         if (&n != &version[0]) {
-            ss << ".";
+            subdirectory += '.';
         }
-        ss << n;
+        subdirectory += to_string(n);
     }
+    const auto relativePath = joinPath(subdirectory, name);
 
-    ss << delimiter << string(name.begin(), name.end());
-    const AssemblyData* assemblyData;
-    try {
-        assemblyData = new AssemblyData(ss.str() + ".dll");
+    lock_guard<mutex> guard(probeLock);
+    if (missingAssemblies.find(relativePath) != missingAssemblies.end()) {
+        return string();
     }
-    catch (runtime_error&) {
-        assemblyData = new AssemblyData(ss.str() + ".exe");
+
+    for (const auto& probeDirectory : probeDirectories) {
+        const auto directory = joinPath(probeDirectory, subdirectory);
+        auto listing = directoryListings.find(directory);
+        if (listing == directoryListings.end()) {
+            listing = directoryListings.insert(make_pair(directory, listDirectory(directory))).first;
+        }
+        for (const auto* extension : { ".dll", ".exe" }) {
+            if ((*listing).second.find(name + extension) != (*listing).second.end()) {
+                return joinPath(directory, name + extension);
+            }
+        }
     }
 
-    return loadAssembly(assemblyData);
+    missingAssemblies.insert(relativePath);
+    return string();
+}
+
+const Guid& AppDomain::loadAssembly(const string& strFilePathName) {
+    return loadAssembly(AssemblyCache::load(strFilePathName, options.loadOptions));
 }
 
 const AssemblyData* AppDomain::getAssembly(const Guid& guid) const {
-    auto result = assemblies.find(guid);
-    if (result == assemblies.end()) {
+    auto result = tryGetAssembly(guid);
+    if (result == nullptr) {
         throw runtime_error("No such assembly in this domain");
     }
-    return (*result).second.get();
+    return result;
+}
+
+const AssemblyData* AppDomain::getAssembly(const string& name, const vector<uint16_t>& version) const {
+    auto result = tryGetAssembly(name, version);
+    if (result == nullptr) {
+        throw runtime_error("No such assembly in this domain");
+    }
+    return result;
+}
+
+const AssemblyData* AppDomain::tryGetAssembly(const Guid& guid) const {
+    lock_guard<mutex> guard(assembliesLock);
+    auto result = assemblies.find(guid);
+    return result != assemblies.end() ? (*result).second.get() : nullptr;
+}
+
+const AssemblyData* AppDomain::tryGetAssembly(const string& name, const vector<uint16_t>& version) const {
+    return findAssembly(AssemblyIdentity(name, version));
+}
+
+const AssemblyData* AppDomain::findAssembly(const AssemblyIdentity& identity) const {
+    lock_guard<mutex> guard(assembliesLock);
+    return findLoadedAssembly(identity);
+}
+
+const AssemblyData* AppDomain::findLoadedAssembly(const AssemblyIdentity& identity) const {
+    auto result = assembliesByIdentity.find(identity);
+    if (result != assembliesByIdentity.end()) {
+        return (*result).second;
+    }
+    if (identity.publicKeyToken != 0) {
+        return nullptr;
+    }
+    result = assembliesWithoutToken.find(identity);
+    return result != assembliesWithoutToken.end() ? (*result).second : nullptr;
+}
+
+TokenCache& AppDomain::getTokenCache(const AssemblyData* assembly) {
+    lock_guard<mutex> guard(assembliesLock);
+    auto& cache = tokenCaches[assembly];
+    if (!cache) {
+        cache.reset(new TokenCache(*assembly));
+    }
+    return *cache;
+}
+
+// Missing assembly is loaded either right here, or by loader threads if they are enabled.
+const AssemblyData* AppDomain::getReferencedAssembly(const AssemblyData* assembly, uint32_t assemblyRefRow) {
+    auto& cache = getTokenCache(assembly).assemblyRefs;
+    if (assemblyRefRow == 0 || assemblyRefRow > cache.size()) {
+        throw runtime_error("Invalid AssemblyRef index");
+    }
+    auto cached = cache.get(assemblyRefRow - 1);
+    if (cached != nullptr) {
+        return cached->assembly;
+    }
+
+    const auto& assemblyRef = assembly->getAssemblyRef()[assemblyRefRow - 1];
+    const auto identity = AssemblyIdentity::ofReference(*assembly, assemblyRef);
+    unique_ptr<ResolvedAssembly> resolved(new ResolvedAssembly());
+    resolved->assembly = findAssembly(identity);
+    if (resolved->assembly == nullptr) {
+        auto name = assembly->getStrings().utf8(assemblyRef.name);
+        if (options.preloadReferences) {
+            // Only this assembly is waited for, the rest of the closure keeps loading in background.
+            loadAssemblyAsync(name, assemblyRef.version);
+            waitForLoad(name, assemblyRef.version);
+            resolved->assembly = findAssembly(identity);
+            if (resolved->assembly == nullptr) {
+                throw runtime_error("Unable to load referenced assembly " + name);
+            }
+        } else {
+            auto path = probe(name, assemblyRef.version);
+            if (path.empty()) {
+                throw runtime_error("Unable to load referenced assembly " + name);
+            }
+            resolved->assembly = getAssembly(loadAssembly(path));
+        }
+    }
+    return cache.publish(assemblyRefRow - 1, move(resolved))->assembly;
 }
 
-const AssemblyData* AppDomain::getAssembly(const u16string& name, const vector<uint16_t>& version) const {
-    for (auto i : assemblies) {
-        if (i.second->getName() == name && i.second->getVersion() == version) {
-            return i.second.get();
+pair<const AssemblyData*, uint32_t> AppDomain::resolveTypeRef(const AssemblyData* assembly, uint32_t typeRefRow) {
+    // Forwarders could be chained, but a loop of them is an error.
+    static const uint32_t maxForwards = 16;
+
+    auto& cache = getTokenCache(assembly).typeRefs;
+    if (typeRefRow == 0 || typeRefRow > cache.size()) {
+        throw runtime_error("Invalid TypeRef index");
+    }
+    auto cached = cache.get(typeRefRow - 1);
+    if (cached != nullptr) {
+        return make_pair(cached->assembly, cached->typeDefRow);
+    }
+
+    const auto& typeRef = assembly->cliMetaDataTables._TypeRef[typeRefRow - 1];
+    const auto& strings = assembly->getStrings();
+
+    const AssemblyData* target = assembly;
+    uint32_t enclosing = 0;
+    switch (typeRef.resolutionScope.second) {
+    case CLIMetadataTableItem::TypeRef:
+    {
+        // Nested type is looked up in the same assembly as its enclosing type.
+        auto outer = resolveTypeRef(assembly, typeRef.resolutionScope.first);
+        target = outer.first;
+        enclosing = outer.second;
+    }
+    break;
+    case CLIMetadataTableItem::AssemblyRef:
+        target = getReferencedAssembly(assembly, typeRef.resolutionScope.first);
+        break;
+    case CLIMetadataTableItem::Module:
+        break;
+    default:
+        throw runtime_error("Unsupported TypeRef resolution scope");
+    }
+
+    for (uint32_t n = 0; n <= maxForwards; ++n) {
+        auto row = target->findTypeDef(strings, typeRef.typeNamespace, typeRef.typeName, enclosing);
+        if (row != 0) {
+            unique_ptr<ResolvedType> resolved(new ResolvedType());
+            resolved->assembly = target;
+            resolved->typeDefRow = row;
+            auto published = cache.publish(typeRefRow - 1, move(resolved));
+            return make_pair(published->assembly, published->typeDefRow);
+        }
+
+        // Nested types are forwarded together with their enclosing types.
+        auto exported = enclosing == 0 ? target->findExportedType(strings, typeRef.typeNamespace, typeRef.typeName) : 0;
+        if (exported == 0) {
+            break;
+        }
+        const auto& implementation = target->cliMetaDataTables._ExportedType[exported - 1].implementation;
+        if (implementation.second != CLIMetadataTableItem::AssemblyRef) {
+            break;
         }
+        target = getReferencedAssembly(target, implementation.first);
+    }
+
+    throw runtime_error("Unable to resolve type " + strings.utf8(typeRef.typeNamespace) + "." + strings.utf8(typeRef.typeName));
+}
+
+// TypeDefOrRef coded index of signature into the defining assembly and token of type. Type specifications
+//  are kept as they are.
+pair<const AssemblyData*, uint32_t> AppDomain::resolveTypeToken(const AssemblyData* assembly, uint32_t encodedType) {
+    auto row = encodedType >> 2;
+    switch (encodedType & 3) {
+    case 0:
+        return make_pair(assembly, (_u(CLIMetadataTableItem::TypeDef) << 24) | row);
+    case 1:
+    {
+        auto resolved = resolveTypeRef(assembly, row);
+        return make_pair(resolved.first, (_u(CLIMetadataTableItem::TypeDef) << 24) | resolved.second);
+    }
+    default:
+        return make_pair(assembly, (_u(CLIMetadataTableItem::TypeSpec) << 24) | row);
     }
-    throw runtime_error("No such assembly in this domain");
+}
+
+// Signatures of different assemblies are equal if they have the same shape and their type tokens are resolved
+//  into the same types.
+bool AppDomain::matchSignatures(const AssemblyData* assembly, const Signature& signature, const AssemblyData* otherAssembly, const Signature& otherSignature) {
+    using et = CLIElementType;
+
+    struct Matcher {
+        AppDomain& domain;
+        const AssemblyData* leftAssembly;
+        const Signature& left;
+        const AssemblyData* rightAssembly;
+        const Signature& right;
+        size_t position;
+
+        // Next item, which must be the same in both signatures
+        bool same(uint32_t& value) {
+            if (position >= left.size() || position >= right.size() || left[position] != right[position]) {
+                return false;
+            }
+            value = left[position++];
+            return true;
+        }
+
+        bool token() {
+            if (position >= left.size() || position >= right.size()) {
+                return false;
+            }
+            auto leftType = domain.resolveTypeToken(leftAssembly, left[position]);
+            auto rightType = domain.resolveTypeToken(rightAssembly, right[position]);
+            ++position;
+            return leftType == rightType;
+        }
+
+        bool type() {
+            uint32_t element, count;
+            if (!same(element)) {
+                return false;
+            }
+            switch (static_cast<et>(element)) {
+            case et::ELEMENT_TYPE_PTR:
+            case et::ELEMENT_TYPE_BYREF:
+            case et::ELEMENT_TYPE_SZARRAY:
+            case et::ELEMENT_TYPE_PINNED:
+            case et::ELEMENT_TYPE_SENTINEL:
+                return type();
+            case et::ELEMENT_TYPE_CMOD_REQD:
+            case et::ELEMENT_TYPE_CMOD_OPT:
+                return token() && type();
+            case et::ELEMENT_TYPE_VALUETYPE:
+            case et::ELEMENT_TYPE_CLASS:
+                return token();
+            case et::ELEMENT_TYPE_VAR:
+            case et::ELEMENT_TYPE_MVAR:
+                return same(count);
+            case et::ELEMENT_TYPE_ARRAY:
+            {
+                // Type, rank, sizes and lower bounds
+                if (!type() || !same(count) || !same(count)) {
+                    return false;
+                }
+                for (uint32_t n = 0, sizes = count; n < sizes; ++n) {
+                    if (!same(count)) {
+                        return false;
+                    }
+                }
+                if (!same(count)) {
+                    return false;
+                }
+                for (uint32_t n = 0, bounds = count; n < bounds; ++n) {
+                    if (!same(count)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            case et::ELEMENT_TYPE_GENERICINST:
+            {
+                if (!type() || !same(count)) {
+                    return false;
+                }
+                for (uint32_t n = 0, arguments = count; n < arguments; ++n) {
+                    if (!type()) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            case et::ELEMENT_TYPE_FNPTR:
+                return method();
+            default:
+                return true;
+            }
+        }
+
+        bool method() {
+            uint32_t flags, count;
+            if (!same(flags)) {
+                return false;
+            }
+            if ((flags & 0x0f) == _u(CLISignatureFlags::SIG_FIELD)) {
+                return type();
+            }
+            if ((flags & _u(CLISignatureFlags::SIG_GENERIC)) != 0 && !same(count)) {
+                return false;
+            }
+            if (!same(count) || !type()) {
+                return false;
+            }
+            for (uint32_t n = 0, parameters = count; n < parameters; ++n) {
+                if (!type()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    } matcher = { *this, assembly, signature, otherAssembly, otherSignature, 0 };
+
+    return signature.size() == otherSignature.size() && matcher.method() && matcher.position == signature.size();
+}
+
+const ResolvedMember& AppDomain::resolveMemberRef(const AssemblyData* assembly, uint32_t memberRefRow) {
+    auto& cache = getTokenCache(assembly).memberRefs;
+    if (memberRefRow == 0 || memberRefRow > cache.size()) {
+        throw runtime_error("Invalid MemberRef index");
+    }
+    auto cached = cache.get(memberRefRow - 1);
+    if (cached != nullptr) {
+        return *cached;
+    }
+
+    const auto& memberRef = assembly->cliMetaDataTables._MemberRef[memberRefRow - 1];
+    pair<const AssemblyData*, uint32_t> owner;
+    switch (memberRef.classRef.second) {
+    case CLIMetadataTableItem::TypeRef:
+    case CLIMetadataTableItem::TypeDef:
+    case CLIMetadataTableItem::TypeSpec:
+        // Members of generic instantiations are looked up in the generic type definition.
+        owner = resolveTypeDefinition(assembly, memberRef.classRef);
+        break;
+    default:
+        throw runtime_error("Unsupported MemberRef parent");
+    }
+
+    const auto* target = owner.first;
+    const auto& strings = assembly->getStrings();
+    const auto& targetStrings = target->getStrings();
+    const auto name = strings.utf8(memberRef.name);
+    const bool isField = memberRef.signature->isField();
+
+    unique_ptr<ResolvedMember> resolved(new ResolvedMember());
+    resolved->assembly = target;
+    if (isField) {
+        const auto& fields = target->cliMetaDataTables._FieldDef;
+        auto range = target->getFields(owner.second);
+        for (auto row = range.first; row < range.last; ++row) {
+            const auto& field = fields[row - 1];
+            if (targetStrings.equals(field.name, name) && matchSignatures(assembly, *memberRef.signature, target, *field.signature)) {
+                resolved->token = (_u(CLIMetadataTableItem::FieldDef) << 24) | row;
+                resolved->signature = field.signature;
+                break;
+            }
+        }
+    } else {
+        const auto& methods = target->cliMetaDataTables._MethodDef;
+        auto range = target->getMethods(owner.second);
+        for (auto row = range.first; row < range.last; ++row) {
+            const auto& method = methods[row - 1];
+            if (targetStrings.equals(method.name, name) && matchSignatures(assembly, *memberRef.signature, target, *method.signature)) {
+                resolved->token = (_u(CLIMetadataTableItem::MethodDef) << 24) | row;
+                resolved->methodDef = &method;
+                resolved->signature = method.signature;
+                break;
+            }
+        }
+    }
+
+    if (resolved->token == 0) {
+        throw runtime_error("Unable to resolve member " + name);
+    }
+    return *cache.publish(memberRefRow - 1, move(resolved));
+}
+
+pair<const AssemblyData*, uint32_t> AppDomain::resolveTypeDefinition(const AssemblyData* assembly, const pair<uint32_t, CLIMetadataTableItem>& type) {
+    switch (type.second) {
+    case CLIMetadataTableItem::TypeDef:
+        return make_pair(assembly, type.first);
+    case CLIMetadataTableItem::TypeRef:
+        return resolveTypeRef(assembly, type.first);
+    case CLIMetadataTableItem::TypeSpec:
+    {
+        const auto& typeSpecs = assembly->cliMetaDataTables._TypeSpec;
+        if (type.first == 0 || type.first > typeSpecs.size()) {
+            throw runtime_error("Invalid TypeSpec index");
+        }
+        // GENERICINST (CLASS | VALUETYPE) TypeDefOrRefEncoded GenArgCount Type*
+        const auto& signature = *typeSpecs[type.first - 1].signature;
+        if (signature.size() >= 3 && signature[0] == _u(CLIElementType::ELEMENT_TYPE_GENERICINST)) {
+            auto resolved = resolveTypeToken(assembly, signature[2]);
+            if ((resolved.second >> 24) == _u(CLIMetadataTableItem::TypeDef)) {
+                return make_pair(resolved.first, resolved.second & 0xFFFFFF);
+            }
+        }
+        throw runtime_error("Unsupported type specification");
+    }
+    default:
+        throw runtime_error("Invalid type index");
+    }
+}
+
+MethodHandle AppDomain::resolveMethodDefOrRef(const AssemblyData* assembly, const pair<uint32_t, CLIMetadataTableItem>& method) {
+    if (method.second == CLIMetadataTableItem::MethodDef) {
+        return MethodHandle(assembly, method.first);
+    }
+    const auto& member = resolveMemberRef(assembly, method.first);
+    if (member.methodDef == nullptr) {
+        throw runtime_error("MemberRef token doesn't refer to a method");
+    }
+    return MethodHandle(member.assembly, member.token & 0xFFFFFF);
+}
+
+bool AppDomain::matchMethods(const MethodHandle& method, const MethodHandle& other) {
+    const auto& methodDef = method.assembly->cliMetaDataTables._MethodDef[method.methodDefRow - 1];
+    const auto& otherDef = other.assembly->cliMetaDataTables._MethodDef[other.methodDefRow - 1];
+    if (!method.assembly->getStrings().equals(methodDef.name, other.assembly->getStrings(), otherDef.name)) {
+        return false;
+    }
+    if (method.assembly == other.assembly) {
+        // Signatures of one assembly are hash-consed.
+        return methodDef.signature == otherDef.signature;
+    }
+    return matchSignatures(method.assembly, *methodDef.signature, other.assembly, *otherDef.signature);
+}
+
+const MethodTable& AppDomain::getMethodTable(const AssemblyData* assembly, uint32_t typeDefRow) {
+    auto& cache = getTokenCache(assembly).methodTables;
+    if (typeDefRow == 0 || typeDefRow > cache.size()) {
+        throw runtime_error("Invalid TypeDef index");
+    }
+    auto cached = cache.get(typeDefRow - 1);
+    if (cached != nullptr) {
+        return *cached;
+    }
+    return *cache.publish(typeDefRow - 1, buildMethodTable(assembly, typeDefRow));
+}
+
+// Slots are assigned as described in ECMA-335 II.10.3. Generic instantiations of parent types and interfaces
+//  are presented by their generic type definitions, signatures are matched without substitution of type arguments.
+unique_ptr<MethodTable> AppDomain::buildMethodTable(const AssemblyData* assembly, uint32_t typeDefRow) {
+    using ma = MethodDefRow::MethodAttribute;
+    using ta = TypeDefRow::TypeAttributes;
+
+    const auto& tables = assembly->cliMetaDataTables;
+    const auto& typeDef = tables._TypeDef[typeDefRow - 1];
+
+    unique_ptr<MethodTable> result(new MethodTable());
+    auto& table = *result;
+    table.assembly = assembly;
+    table.typeDefRow = typeDefRow;
+    table.isInterface = (typeDef.flags & _u(ta::ClassSemanticsMask)) == _u(ta::Interface);
+    if (!table.isInterface && typeDef.extendsType.first != 0) {
+        auto parentType = resolveTypeDefinition(assembly, typeDef.extendsType);
+        table.parent = &getMethodTable(parentType.first, parentType.second);
+        table.vtable = table.parent->vtable;
+    }
+
+    // Virtual method overrides the inherited slot of method with the same name and signature, unless it asks
+    //  for a new slot. The most derived slot is taken if there are several of them.
+    const auto inheritedCount = static_cast<uint32_t>(table.vtable.size());
+    const auto methods = assembly->getMethods(typeDefRow);
+    vector<uint32_t> methodSlots(methods.last - methods.first, MethodTable::noSlot);
+    for (auto row = methods.first; row < methods.last; ++row) {
+        const auto& methodDef = tables._MethodDef[row - 1];
+        if ((methodDef.flags & _u(ma::Virtual)) == 0) {
+            continue;
+        }
+
+        const MethodHandle method(assembly, row);
+        auto slot = MethodTable::noSlot;
+        if ((methodDef.flags & _u(ma::NewSlot)) == 0) {
+            for (auto n = inheritedCount; n-- > 0; ) {
+                const auto& inherited = table.vtable[n];
+                if ((inherited.assembly->cliMetaDataTables._MethodDef[inherited.methodDefRow - 1].flags & _u(ma::Final)) == 0 && matchMethods(method, inherited)) {
+                    slot = n;
+                    break;
+                }
+            }
+        }
+        if (slot == MethodTable::noSlot) {
+            slot = static_cast<uint32_t>(table.vtable.size());
+            table.vtable.push_back(method);
+        } else {
+            table.vtable[slot] = method;
+        }
+        methodSlots[row - methods.first] = slot;
+    }
+    table.setMethodSlots(methods.first, move(methodSlots));
+
+    // Interfaces of this type and the interfaces which they are inheriting
+    vector<const MethodTable*> interfaces;
+    auto addInterface = [&interfaces](const MethodTable* interfaceType) {
+        if (find(interfaces.begin(), interfaces.end(), interfaceType) == interfaces.end()) {
+            interfaces.push_back(interfaceType);
+        }
+    };
+    const auto interfaceImpls = assembly->getInterfaceImpls(typeDefRow);
+    for (auto row = interfaceImpls.first; row < interfaceImpls.last; ++row) {
+        auto interfaceType = resolveTypeDefinition(assembly, tables._InterfaceImpl[row - 1].interfaceRef);
+        const auto* interfaceTable = &getMethodTable(interfaceType.first, interfaceType.second);
+        addInterface(interfaceTable);
+        for (uint32_t n = 0; n < interfaceTable->getInterfacesCount(); ++n) {
+            addInterface(interfaceTable->getInterface(n));
+        }
+    }
+
+    if (table.isInterface) {
+        // Base interfaces are only listed, interface methods are never dispatched through other interfaces.
+        for (const auto* interfaceTable : interfaces) {
+            table.addInterface(interfaceTable, vector<uint32_t>(interfaceTable->vtable.size(), MethodTable::noSlot));
+        }
+        table.finish();
+        return result;
+    }
+
+    // Explicit overrides are replacing slots of class methods, overrides of interface methods are applied below.
+    vector<pair<MethodHandle, MethodHandle> > interfaceOverrides;
+    const auto methodImpls = assembly->getMethodImpls(typeDefRow);
+    for (auto row = methodImpls.first; row < methodImpls.last; ++row) {
+        const auto& methodImpl = tables._MethodImpl[row - 1];
+        auto body = resolveMethodDefOrRef(assembly, methodImpl.methodBody);
+        auto declaration = resolveMethodDefOrRef(assembly, methodImpl.methodDeclaration);
+        const auto& declaringType = getMethodTable(declaration.assembly, declaration.assembly->getMethodOwner(declaration.methodDefRow));
+        if (declaringType.isInterface) {
+            interfaceOverrides.push_back(make_pair(declaration, body));
+            continue;
+        }
+        auto slot = declaringType.getSlot(declaration.methodDefRow);
+        if (slot != MethodTable::noSlot && slot < table.vtable.size()) {
+            table.vtable[slot] = body;
+        }
+    }
+
+    auto findSlot = [&table](const MethodHandle& method) {
+        for (auto n = static_cast<uint32_t>(table.vtable.size()); n-- > 0; ) {
+            if (table.vtable[n] == method) {
+                return n;
+            }
+        }
+        return MethodTable::noSlot;
+    };
+
+    // Interfaces of parent keep their slots, unless this type implements them again.
+    if (table.parent != nullptr) {
+        for (uint32_t n = 0; n < table.parent->getInterfacesCount(); ++n) {
+            const auto* interfaceTable = table.parent->getInterface(n);
+            if (find(interfaces.begin(), interfaces.end(), interfaceTable) == interfaces.end()) {
+                const auto* slots = table.parent->getInterfaceSlots(n);
+                table.addInterface(interfaceTable, vector<uint32_t>(slots, slots + interfaceTable->vtable.size()));
+            }
+        }
+    }
+
+    // Interface method is implemented by the explicit override, or by the public virtual method with the same
+    //  name and signature, or by the implementation which is inherited from parent.
+    for (const auto* interfaceTable : interfaces) {
+        vector<uint32_t> slots(interfaceTable->vtable.size(), MethodTable::noSlot);
+        for (uint32_t n = 0; n < slots.size(); ++n) {
+            const auto& declaration = interfaceTable->vtable[n];
+            for (const auto& interfaceOverride : interfaceOverrides) {
+                if (interfaceOverride.first == declaration) {
+                    slots[n] = findSlot(interfaceOverride.second);
+                    break;
+                }
+            }
+            for (auto slot = static_cast<uint32_t>(table.vtable.size()); slots[n] == MethodTable::noSlot && slot-- > 0; ) {
+                const auto& candidate = table.vtable[slot];
+                const auto flags = candidate.assembly->cliMetaDataTables._MethodDef[candidate.methodDefRow - 1].flags;
+                if ((flags & _u(ma::MemberAccessMask)) == _u(ma::Public) && matchMethods(candidate, declaration)) {
+                    slots[n] = slot;
+                }
+            }
+            if (slots[n] == MethodTable::noSlot && table.parent != nullptr) {
+                const auto* inherited = table.parent->findInterfaceMethod(interfaceTable, n);
+                if (inherited != nullptr) {
+                    slots[n] = findSlot(*inherited);
+                }
+            }
+        }
+        table.addInterface(interfaceTable, slots);
+    }
+
+    table.finish();
+    return result;
+}
+
+// Slot of the method is found when it's created, so dispatch is an indexed load from the vtable, or a probe of
+//  the interfaces and an indexed load. Implementation is looked up in the domain only on the first dispatch.
+const RuntimeMethod& AppDomain::resolveVirtualMethod(const MethodTable& objectType, const RuntimeMethod& method) {
+    auto slot = method.slot;
+    if (slot == MethodTable::noSlot) {
+        return method;
+    }
+
+    if (method.interfaceType != nullptr) {
+        slot = objectType.findInterfaceSlot(method.interfaceType, slot);
+        if (slot == MethodTable::noSlot) {
+            throw runtime_error("Interface method isn't implemented by the object type");
+        }
+    } else if (slot >= objectType.vtable.size()) {
+        throw runtime_error("Object type doesn't derive from the method type");
+    }
+
+    const auto* cached = objectType.getRuntimeMethod(slot);
+    if (cached != nullptr) {
+        return *cached;
+    }
+    const auto& implementation = objectType.vtable[slot];
+    const auto& resolved = getRuntimeMethod(implementation.assembly, implementation.methodDefRow);
+    objectType.publishRuntimeMethod(slot, &resolved);
+    return resolved;
+}
+
+const RuntimeMethod& AppDomain::getRuntimeMethod(const AssemblyData* assembly, uint32_t methodDefRow) {
+    auto& cache = getTokenCache(assembly).methods;
+    if (methodDefRow == 0 || methodDefRow > cache.size()) {
+        throw runtime_error("Invalid MethodDef index");
+    }
+    auto cached = cache.get(methodDefRow - 1);
+    if (cached != nullptr) {
+        return *cached;
+    }
+    return *cache.publish(methodDefRow - 1, Interpreter::makeMethod(*this, assembly, methodDefRow));
 }
 
 ExecutionThread* AppDomain::createThread() {
@@ -72,3 +722,82 @@ ExecutionThread* AppDomain::createThread() {
     threads.insert(threads.begin(), thread);
     return thread.get();
 }
+
+void AppDomain::loadAssemblyAsync(const string& name, const vector<uint16_t>& version) {
+    LoadRequest request(name, version);
+
+    {
+        lock_guard<mutex> guard(assembliesLock);
+        auto inserted = requestedLoads.insert(make_pair(request, LoadState::Pending));
+        if (!inserted.second) {
+            // Already loaded or being loaded.
+            return;
+        }
+        if (findLoadedAssembly(AssemblyIdentity(name, version)) != nullptr) {
+            (*inserted.first).second = LoadState::Loaded;
+            return;
+        }
+        ++pendingLoads;
+        if (!loaderPool) {
+            loaderPool.reset(new ThreadPool(options.loaderThreads));
+        }
+    }
+
+    loaderPool->submit([this, request] {
+        bool failed = false;
+        try {
+            auto path = probe(request.first, request.second);
+            if (path.empty()) {
+                failed = true;
+            } else {
+                const auto& id = loadAssembly(path);
+                // References are scheduled before this load is accounted as finished, so waiters see the whole closure.
+                loadReferences(getAssembly(id));
+            }
+        }
+        catch (...) {
+            // File exists, but it isn't a valid assembly, or loading has failed otherwise. Exception mustn't escape
+            //  from the task, the load still has to be accounted as finished so waiters aren't blocked forever.
+            failed = true;
+        }
+        {
+            // Request has been inserted before the task was submitted, so recording its state doesn't allocate.
+            lock_guard<mutex> guard(assembliesLock);
+            --pendingLoads;
+            (*requestedLoads.find(request)).second = failed ? LoadState::Failed : LoadState::Loaded;
+        }
+        loadsFinished.notify_all();
+    });
+}
+
+void AppDomain::preloadReferences(const Guid& guid) {
+    loadReferences(getAssembly(guid));
+}
+
+void AppDomain::loadReferences(const AssemblyData* assembly) {
+    const auto& assemblyRefs = assembly->getAssemblyRef();
+    for (uint32_t n = 0; n < assemblyRefs.size(); ++n) {
+        const auto& assemblyRef = assemblyRefs[n];
+        loadAssemblyAsync(assembly->getStrings().utf8(assemblyRef.name), assemblyRef.version);
+    }
+}
+
+void AppDomain::waitForPendingLoads() {
+    unique_lock<mutex> guard(assembliesLock);
+    loadsFinished.wait(guard, [this] { return pendingLoads == 0; });
+}
+
+void AppDomain::waitForLoad(const string& name, const vector<uint16_t>& version) {
+    unique_lock<mutex> guard(assembliesLock);
+    const auto request = requestedLoads.find(LoadRequest(name, version));
+    if (request != requestedLoads.end()) {
+        // Map nodes are stable, so the state is watched in place.
+        loadsFinished.wait(guard, [&request] { return (*request).second != LoadState::Pending; });
+    }
+}
+
+bool AppDomain::isLoadFailed(const string& name, const vector<uint16_t>& version) const {
+    lock_guard<mutex> guard(assembliesLock);
+    const auto request = requestedLoads.find(LoadRequest(name, version));
+    return request != requestedLoads.end() && (*request).second == LoadState::Failed;
+}
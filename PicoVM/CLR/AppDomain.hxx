@@ -4,24 +4,139 @@
 #include <cstdint>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 
 #include "AssemblyData.hxx"
+#include "AssemblyCache.hxx"
+#include "AssemblyIdentity.hxx"
 #include "ExecutionThread.hxx"
+#include "ManagedHeap.hxx"
+#include "ThreadPool.hxx"
+#include "TokenCache.hxx"
+
+// Application domain options
+struct AppDomainOptions {
+    // Load the transitive closure of entry assembly references in background before running the entry point.
+    bool preloadReferences = false;
+    // Number of loader threads, zero means one thread per hardware thread.
+    uint32_t loaderThreads = 0;
+    // Additional directories which are probed for referenced assemblies after the search path.
+    std::vector<std::string> probeDirectories;
+    // Execute methods as register code. Methods which can't be translated, and their callees, are executed from
+    //  threaded code.
+    bool registerCode = false;
+    // Options of assemblies which are loaded from files by this domain, including referenced ones.
+    AssemblyLoadOptions loadOptions;
+};
 
 struct AppDomain {
-    std::map<Guid, std::shared_ptr<const AssemblyData> > assemblies;
+    std::unordered_map<Guid, std::shared_ptr<const AssemblyData> > assemblies;
     std::vector<std::shared_ptr<ExecutionThread> > threads;
     std::string assemblyPath = "";
+    AppDomainOptions options;
+    // Objects which are created by the threads of domain
+    ManagedHeap heap;
 
-    const Guid& loadAssembly(const AssemblyData* assembly);
-    const Guid& loadAssembly(const AssemblyData& assembly);
-    const Guid& loadAssembly(const std::u16string& name, const std::vector<uint16_t>& version);
+    const Guid& loadAssembly(const std::shared_ptr<const AssemblyData>& assembly);
+    const Guid& loadAssembly(const std::string& strFilePathName);
+    const Guid& loadAssembly(const std::string& name, const std::vector<uint16_t>& version);
     const AssemblyData* getAssembly(const Guid& guid) const;
-    const AssemblyData* getAssembly(const std::u16string& name, const std::vector<uint16_t>& version) const;
+    const AssemblyData* getAssembly(const std::string& name, const std::vector<uint16_t>& version) const;
+    // Same as getAssembly(), but returns null if assembly isn't loaded.
+    const AssemblyData* tryGetAssembly(const Guid& guid) const;
+    const AssemblyData* tryGetAssembly(const std::string& name, const std::vector<uint16_t>& version) const;
+
+    // Path of the assembly file in probe directories, or empty string if there is no such file. Directory
+    //  listings and missing assemblies are cached, so repeated probes don't touch the file system.
+    std::string probe(const std::string& name, const std::vector<uint16_t>& version);
     ExecutionThread* createThread();
 
-    AppDomain(const std::string& searchPath);
+    // Resolved references of the loaded assembly, slots are filled by resolve functions.
+    TokenCache& getTokenCache(const AssemblyData* assembly);
+
+    // Resolve one-based TypeRef row of the assembly into the assembly and one-based TypeDef row which are defining
+    //  the type. Type forwarders are followed. Referenced assemblies are loaded if necessary.
+    std::pair<const AssemblyData*, uint32_t> resolveTypeRef(const AssemblyData* assembly, uint32_t typeRefRow);
+
+    // Resolve one-based MemberRef row into the method or field definition, matching both name and signature.
+    const ResolvedMember& resolveMemberRef(const AssemblyData* assembly, uint32_t memberRefRow);
+
+    // Vtable and interface map of the one-based TypeDef row, built on first use together with its parent types.
+    const MethodTable& getMethodTable(const AssemblyData* assembly, uint32_t typeDefRow);
+    // Implementation of the virtual or interface method for the object of given type. Non-virtual methods are
+    //  returned as they are.
+    const RuntimeMethod& resolveVirtualMethod(const MethodTable& objectType, const RuntimeMethod& method);
+
+    // Execution data of one-based MethodDef row, created on first call.
+    const RuntimeMethod& getRuntimeMethod(const AssemblyData* assembly, uint32_t methodDefRow);
+
+    // Start loading of the assembly on the loader threads, together with everything it references.
+    void loadAssemblyAsync(const std::string& name, const std::vector<uint16_t>& version);
+    // Start loading of all assemblies which are referenced by the loaded assembly.
+    void preloadReferences(const Guid& guid);
+    // Wait until all background loads are finished.
+    void waitForPendingLoads();
+    // Wait until the background load of this assembly is finished, loads of its references may still be running.
+    //  Returns immediately if its load wasn't requested.
+    void waitForLoad(const std::string& name, const std::vector<uint16_t>& version);
+    // Whether the background load of this assembly has failed.
+    bool isLoadFailed(const std::string& name, const std::vector<uint16_t>& version) const;
+
+    AppDomain(const std::string& searchPath, const AppDomainOptions& domainOptions = AppDomainOptions());
+
+private:
+    typedef std::pair<std::string, std::vector<uint16_t> > LoadRequest;
+    enum struct LoadState : uint8_t {
+        Pending,
+        Loaded,
+        Failed
+    };
+
+    void loadReferences(const AssemblyData* assembly);
+    const AssemblyData* findAssembly(const AssemblyIdentity& identity) const;
+    // Exact identity first, reference without public key token falls back to any assembly of that name and version.
+    //  Caller must hold assembliesLock
+    const AssemblyData* findLoadedAssembly(const AssemblyIdentity& identity) const;
+    const AssemblyData* getReferencedAssembly(const AssemblyData* assembly, uint32_t assemblyRefRow);
+    std::pair<const AssemblyData*, uint32_t> resolveTypeToken(const AssemblyData* assembly, uint32_t encodedType);
+    bool matchSignatures(const AssemblyData* assembly, const Signature& signature, const AssemblyData* otherAssembly, const Signature& otherSignature);
+    // TypeDef, TypeRef or TypeSpec into the defining assembly and TypeDef row. Generic instantiations are
+    //  resolved into their generic type definitions.
+    std::pair<const AssemblyData*, uint32_t> resolveTypeDefinition(const AssemblyData* assembly, const std::pair<uint32_t, CLIMetadataTableItem>& type);
+    MethodHandle resolveMethodDefOrRef(const AssemblyData* assembly, const std::pair<uint32_t, CLIMetadataTableItem>& method);
+    bool matchMethods(const MethodHandle& method, const MethodHandle& other);
+    std::unique_ptr<MethodTable> buildMethodTable(const AssemblyData* assembly, uint32_t typeDefRow);
+
+    // Protects assemblies and the state of background loads
+    mutable std::mutex assembliesLock;
+    std::condition_variable loadsFinished;
+    std::map<LoadRequest, LoadState> requestedLoads;
+    uint32_t pendingLoads = 0;
+
+    // Loaded assemblies by identity, guarded by assembliesLock. Keys point into the string heaps of assemblies.
+    std::unordered_map<AssemblyIdentity, const AssemblyData*, AssemblyIdentityHash> assembliesByIdentity;
+    // Same assemblies keyed by identity without public key token, the first loaded one wins.
+    std::unordered_map<AssemblyIdentity, const AssemblyData*, AssemblyIdentityHash> assembliesWithoutToken;
+
+    // Search path followed by additional probe directories
+    std::vector<std::string> probeDirectories;
+    // Guards probe caches, file system is never accessed under assembliesLock.
+    std::mutex probeLock;
+    // File names by directory, directories which don't exist have empty listings.
+    std::unordered_map<std::string, std::unordered_set<std::string> > directoryListings;
+    // Relative paths of assemblies which weren't found in any probe directory
+    std::unordered_set<std::string> missingAssemblies;
+
+    // Resolved references by assembly, guarded by assembliesLock
+    std::map<const AssemblyData*, std::unique_ptr<TokenCache> > tokenCaches;
+
+    // Declared last, so loader threads are stopped before anything else is destroyed.
+    std::unique_ptr<ThreadPool> loaderPool;
 };
 
 #endif
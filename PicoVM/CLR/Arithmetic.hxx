@@ -0,0 +1,116 @@
+#ifndef __ARITHMETIC_HXX__
+#define __ARITHMETIC_HXX__
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+// Arithmetic of the instructions which are knowing the types of their operands, it's shared by the threaded
+//  interpreter and register code.
+
+// Float to integer conversion, values out of range are unspecified by ECMA-335, they are giving the minimal value.
+inline int64_t truncateSigned(double value) {
+    if (!(value >= -9223372036854775808.0 && value < 9223372036854775808.0)) {
+        return INT64_MIN;
+    }
+    return static_cast<int64_t>(value);
+}
+
+inline uint64_t truncateUnsigned(double value) {
+    if (!(value > -1.0 && value < 18446744073709551616.0)) {
+        return 0;
+    }
+    return static_cast<uint64_t>(value);
+}
+
+// Integer arithmetic of typed instructions wraps around as the unsigned arithmetic of the same width.
+template<typename T>
+inline T wrappingAdd(T left, T right) {
+    typedef typename std::make_unsigned<T>::type U;
+    return static_cast<T>(static_cast<U>(left) + static_cast<U>(right));
+}
+
+template<typename T>
+inline T wrappingSub(T left, T right) {
+    typedef typename std::make_unsigned<T>::type U;
+    return static_cast<T>(static_cast<U>(left) - static_cast<U>(right));
+}
+
+template<typename T>
+inline T wrappingMul(T left, T right) {
+    typedef typename std::make_unsigned<T>::type U;
+    return static_cast<T>(static_cast<U>(left) * static_cast<U>(right));
+}
+
+template<typename T>
+inline T wrappingNeg(T value) {
+    typedef typename std::make_unsigned<T>::type U;
+    return static_cast<T>(0 - static_cast<U>(value));
+}
+
+template<typename T>
+void checkDivision(T left, T right) {
+    if (right == 0) {
+        throw std::runtime_error("Division by zero");
+    }
+    if (left == std::numeric_limits<T>::min() && right == -1) {
+        throw std::runtime_error("Arithmetic overflow");
+    }
+}
+
+template<typename T>
+T checkedDiv(T left, T right) {
+    checkDivision(left, right);
+    return left / right;
+}
+
+template<typename T>
+T checkedRem(T left, T right) {
+    checkDivision(left, right);
+    return left % right;
+}
+
+template<typename T>
+T unsignedDiv(T left, T right) {
+    typedef typename std::make_unsigned<T>::type U;
+    if (right == 0) {
+        throw std::runtime_error("Division by zero");
+    }
+    return static_cast<T>(static_cast<U>(left) / static_cast<U>(right));
+}
+
+template<typename T>
+T unsignedRem(T left, T right) {
+    typedef typename std::make_unsigned<T>::type U;
+    if (right == 0) {
+        throw std::runtime_error("Division by zero");
+    }
+    return static_cast<T>(static_cast<U>(left) % static_cast<U>(right));
+}
+
+// Shift amount is masked by the width of value, as it's done by polymorphic shifts.
+template<typename T>
+inline T shiftLeft(T value, int32_t amount) {
+    typedef typename std::make_unsigned<T>::type U;
+    return static_cast<T>(static_cast<U>(value) << (amount & (sizeof(T) * 8 - 1)));
+}
+
+template<typename T>
+inline T shiftRight(T value, int32_t amount) {
+    return value >> (amount & (sizeof(T) * 8 - 1));
+}
+
+template<typename T>
+inline T shiftRightUnsigned(T value, int32_t amount) {
+    typedef typename std::make_unsigned<T>::type U;
+    return static_cast<T>(static_cast<U>(value) >> (amount & (sizeof(T) * 8 - 1)));
+}
+
+template<typename T>
+inline bool unsignedLess(T left, T right) {
+    typedef typename std::make_unsigned<T>::type U;
+    return static_cast<U>(left) < static_cast<U>(right);
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "AssemblyCache.hxx"
+
+using namespace std;
+
+// Options which change how the image is decoded. Number of decoding threads doesn't matter, result is the same.
+typedef tuple<bool, bool, bool, string> OptionsKey;
+
+static OptionsKey getOptionsKey(const AssemblyLoadOptions& options) {
+    return OptionsKey(options.lazyTables, options.lazyMethodBodies, options.useSnapshot, options.snapshotDirectory);
+}
+
+// Images by canonical path and by module version identifier, each together with the options it was loaded with
+static map<pair<string, OptionsKey>, weak_ptr<const AssemblyData> > imagesByPath;
+static map<pair<Guid, OptionsKey>, weak_ptr<const AssemblyData> > imagesByMvid;
+static mutex imagesMutex;
+
+template<typename T>
+static shared_ptr<const AssemblyData> findImage(map<T, weak_ptr<const AssemblyData> >& images, const T& key) {
+    auto it = images.find(key);
+    if (it == images.end()) {
+        return nullptr;
+    }
+
+    auto existing = (*it).second.lock();
+    if (!existing) {
+        images.erase(it);
+    }
+    return existing;
+}
+
+shared_ptr<const AssemblyData> AssemblyCache::load(const string& strFilePathName, const AssemblyLoadOptions& options) {
+    auto canonicalPath = MappedImage::getCanonicalPath(strFilePathName);
+    const auto optionsKey = getOptionsKey(options);
+    const auto pathKey = make_pair(canonicalPath, optionsKey);
+
+    {
+        lock_guard<mutex> lock(imagesMutex);
+        auto existing = findImage(imagesByPath, pathKey);
+        if (existing) {
+            return existing;
+        }
+    }
+
+    // Parsing is done without holding the lock, if the same file is being loaded by two threads then one of images is discarded.
+    shared_ptr<const AssemblyData> assembly = make_shared<const AssemblyData>(canonicalPath, options);
+
+    lock_guard<mutex> lock(imagesMutex);
+    const auto mvidKey = make_pair(assembly->getGUID(), optionsKey);
+    auto existing = findImage(imagesByPath, pathKey);
+    if (!existing) {
+        existing = findImage(imagesByMvid, mvidKey);
+    }
+    if (existing) {
+        imagesByPath[pathKey] = existing;
+        return existing;
+    }
+
+    imagesByPath[pathKey] = assembly;
+    imagesByMvid[mvidKey] = assembly;
+    return assembly;
+}
+
+shared_ptr<const AssemblyData> AssemblyCache::add(shared_ptr<const AssemblyData> assembly) {
+    lock_guard<mutex> lock(imagesMutex);
+    const auto mvidKey = make_pair(assembly->getGUID(), getOptionsKey(assembly->getLoadOptions()));
+    auto existing = findImage(imagesByMvid, mvidKey);
+    if (existing) {
+        return existing;
+    }
+
+    imagesByMvid[mvidKey] = assembly;
+    return assembly;
+}
+
+size_t AssemblyCache::size() {
+    lock_guard<mutex> lock(imagesMutex);
+    size_t count = 0;
+    for (const auto& item : imagesByMvid) {
+        if (!item.second.expired()) {
+            ++count;
+        }
+    }
+    return count;
+}
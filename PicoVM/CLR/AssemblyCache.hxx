@@ -0,0 +1,28 @@
+#ifndef __ASSEMBLYCACHE_HXX__
+#define __ASSEMBLYCACHE_HXX__
+
+#include <memory>
+#include <string>
+
+#include "AssemblyData.hxx"
+
+// Process-wide cache of loaded assembly images. Images are immutable, so any number of application
+//  domains can share them. Cache doesn't own images, they are released when the last domain which
+//  is referencing the image goes away.
+struct AssemblyCache {
+    // Load assembly from the file, or return already loaded image of the same file or the same module which was
+    //  loaded with the same options. Images with different decoding options are cached separately, the number of
+    //  decoding threads isn't taken into account.
+    static std::shared_ptr<const AssemblyData> load(const std::string& strFilePathName, const AssemblyLoadOptions& options = AssemblyLoadOptions());
+
+    // Add image which has been loaded elsewhere, returns either the same image or the cached one with the same MVID
+    //  and options.
+    static std::shared_ptr<const AssemblyData> add(std::shared_ptr<const AssemblyData> assembly);
+
+    // Number of images which are still alive
+    static size_t size();
+
+    AssemblyCache() = delete;
+};
+
+#endif
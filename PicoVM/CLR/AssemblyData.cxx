@@ -1,11 +1,14 @@
-#include <fstream>
-#include <iterator>
 #include <string>
 #include <algorithm>
 #include <map>
 #include <limits>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 #include "AssemblyData.hxx"
+#include "ThreadPool.hxx"
+#include "MetadataSnapshot.hxx"
 #include "Formatting.hxx"
 #include "EnumCasting.hxx"
 
@@ -16,32 +19,25 @@ AssemblyData::CLIMetaDataTables::~CLIMetaDataTables() noexcept
     
 }
 
-AssemblyData::AssemblyData(string strFilePathName)
+AssemblyData::AssemblyData(string strFilePathName, const AssemblyLoadOptions& options) : loadOptions(options)
 {
-    ifstream AssemblyStream(strFilePathName, ios_base::in | ios_base::binary | ios_base::ate);
-    if (!AssemblyStream.is_open()) {
-        throw runtime_error("Unable to open assembly file");
-    }
-
-    vector<uint8_t> file_bytes;
-    file_bytes.reserve(AssemblyStream.tellg());
-    AssemblyStream.seekg(ios_base::beg);
-    file_bytes.assign((istreambuf_iterator<char>(AssemblyStream)), istreambuf_iterator<char>());
+    // Image is mapped into memory instead of being read, pages are loaded only when they are touched.
+    auto image = MappedImage::open(strFilePathName);
 
     // Check MZ header
-    if (file_bytes[0] != 0x4d || file_bytes[1] != 0x5a) {
+    if (image->size() < 2 || image->data()[0] != 0x4d || image->data()[1] != 0x5a) {
         throw runtime_error("There is no MZ header");
     }
 
     // Create reader and continue initialization process
-    reader = AssemblyReader(file_bytes);
+    reader = AssemblyReader(image);
     InitAssembly();
 }
 
-AssemblyData::AssemblyData(const vector<uint8_t>& assembly_bytes)
+AssemblyData::AssemblyData(const vector<uint8_t>& assembly_bytes, const AssemblyLoadOptions& options) : loadOptions(options)
 {
     // Check MZ header
-    if (assembly_bytes[0] != 0x4d || assembly_bytes[1] != 0x5a) {
+    if (assembly_bytes.size() < 2 || assembly_bytes[0] != 0x4d || assembly_bytes[1] != 0x5a) {
         throw runtime_error("There is no MZ header");
     }
 
@@ -61,6 +57,13 @@ void AssemblyData::swap(AssemblyData& other) noexcept {
     ::swap(cliMetadata, other.cliMetadata);
     ::swap(cliMetaDataTables, other.cliMetaDataTables);
     ::swap(fileHeader, other.fileHeader);
+    ::swap(loadOptions, other.loadOptions);
+    ::swap(strings, other.strings);
+    names.swap(other.names);
+    methodBodies.swap(other.methodBodies);
+    snapshot.swap(other.snapshot);
+    typeIndexes.swap(other.typeIndexes);
+    memberIndexes.swap(other.memberIndexes);
     reader.swap(other.reader);
 }
 
@@ -139,10 +142,19 @@ void AssemblyData::InitAssembly()
 
     // CLI MetaData section
     cliMetadata.cliMetadataOffset = getDataOffset(cliHeader.metaData.rva);
-    if (reader.read_uint32(cliMetadata.cliMetadataOffset) != 0x424A5342) {
+    if (cliMetadata.cliMetadataOffset == numeric_limits<uint32_t>::max() || reader.read_uint32(cliMetadata.cliMetadataOffset) != 0x424A5342) {
         throw runtime_error("Invalid CLI metadata.");
     }
 
+    // IL code is scattered across the section which contains the CLI header, there is no point in read-ahead for it.
+    //  Metadata is going to be read immediately, so ask the kernel to start loading it.
+    for (const auto& section : sections) {
+        if (section.virtualAddress <= cliDirectory.rva && cliDirectory.rva < section.virtualAddress + section.virtualSize) {
+            reader.advise(section.pointerToRawData, section.sizeOfRawData, MappedImage::Advice::Random);
+        }
+    }
+    reader.advise(cliMetadata.cliMetadataOffset, cliHeader.metaData.size, MappedImage::Advice::WillNeed);
+
     // CLI version data string
     auto versionLength = reader.read_uint32(cliMetadata.cliMetadataOffset + 12);
     cliMetadata.version.reserve(versionLength);
@@ -169,188 +181,290 @@ void AssemblyData::InitAssembly()
 
 void AssemblyData::FillTables()
 {
-    // Reader helper class. Basically it's a wrapper around AssemblyReader, which provides a set of methods used by row constructors.
-    MetadataRowsReader mr(reader, cliMetadata);
+    // Tables layout is computed from the #~ stream header, rows are decoded using this information on demand.
+    auto tablesLayout = make_shared<MetadataTablesLayout>(reader, cliMetadata);
 
     // Verify Module table
-    if (mr.mapTableLength[CLIMetadataTableItem::Module] != 1) {
+    if (tablesLayout->getRowCount(CLIMetadataTableItem::Module) != 1) {
         throw runtime_error("Module table must contain one and only one row.");
     }
 
-    // Load module information.
-    FillTable<ModuleRow>(mr, cliMetaDataTables._Module);
-
-    // TypeRef
-    FillTable<TypeRefRow>(mr, cliMetaDataTables._TypeRef);
-
-    // TypeDef
-    FillTable<TypeDefRow>(mr, cliMetaDataTables._TypeDef);
-
-    // FieldDef
-    FillTable<FieldDefRow>(mr, cliMetaDataTables._FieldDef);
-
-    // MethodDef
-    FillTable<MethodDefRow>(mr, cliMetaDataTables._MethodDef);
-
-    // ParamDef
-    FillTable<ParamDefRow>(mr, cliMetaDataTables._ParamDef);
-
-    // InterfaceImpl
-    FillTable<InterfaceImplRow>(mr, cliMetaDataTables._InterfaceImpl);
-
-    // MemberRef
-    FillTable<MemberRefRow>(mr, cliMetaDataTables._MemberRef);
+    // Cells and method headers are taken from the snapshot if there is one for this image.
+    string snapshotPath;
+    MetadataSnapshot::Key snapshotKey = {};
+    if (loadOptions.useSnapshot && (!reader.path().empty() || !loadOptions.snapshotDirectory.empty())) {
+        snapshotKey = MetadataSnapshot::makeKey(*tablesLayout);
+        snapshotPath = MetadataSnapshot::getPath(loadOptions.snapshotDirectory, reader.path(), snapshotKey);
+        snapshot = MetadataSnapshot::open(snapshotPath, snapshotKey, *tablesLayout);
+        if (snapshot) {
+            tablesLayout->attachSnapshot(snapshot);
+        }
+    }
 
-    // Constant
-    FillTable<ConstantRow>(mr, cliMetaDataTables._Constant);
+    shared_ptr<const MetadataTablesLayout> layout = tablesLayout;
 
-    // CustomAttribute
-    FillTable<CustomAttributeRow>(mr, cliMetaDataTables._CustomAttribute);
+    // Names are referenced by rows and compared in place, without being copied.
+    if (layout->stringStreamSize > reader.size() || layout->stringStreamOffset > reader.size() - layout->stringStreamSize) {
+        throw runtime_error("#Strings heap is out of image bounds.");
+    }
+    strings = layout->stringStreamSize != 0 ? StringHeap(&reader[layout->stringStreamOffset], layout->stringStreamSize) : StringHeap();
+    names = snapshot ? make_shared<const NameTable>(strings, snapshot->getNameTables()) : make_shared<const NameTable>(strings);
+    typeIndexes = make_shared<TypeIndexes>();
+    memberIndexes = make_shared<MemberIndexes>();
+
+    DecodeTasks tasks;
+    FillTable(layout, cliMetaDataTables._Module, tasks);
+    FillTable(layout, cliMetaDataTables._TypeRef, tasks);
+    FillTable(layout, cliMetaDataTables._TypeDef, tasks);
+    FillTable(layout, cliMetaDataTables._FieldDef, tasks);
+    FillTable(layout, cliMetaDataTables._MethodDef, tasks);
+    FillTable(layout, cliMetaDataTables._ParamDef, tasks);
+    FillTable(layout, cliMetaDataTables._InterfaceImpl, tasks);
+    FillTable(layout, cliMetaDataTables._MemberRef, tasks);
+    FillTable(layout, cliMetaDataTables._Constant, tasks);
+    FillTable(layout, cliMetaDataTables._CustomAttribute, tasks);
+    FillTable(layout, cliMetaDataTables._FieldMarshal, tasks);
+    FillTable(layout, cliMetaDataTables._DeclSecurity, tasks);
+    FillTable(layout, cliMetaDataTables._ClassLayout, tasks);
+    FillTable(layout, cliMetaDataTables._FieldLayout, tasks);
+    FillTable(layout, cliMetaDataTables._StandAloneSig, tasks);
+    FillTable(layout, cliMetaDataTables._EventMap, tasks);
+    FillTable(layout, cliMetaDataTables._Event, tasks);
+    FillTable(layout, cliMetaDataTables._PropertyMap, tasks);
+    FillTable(layout, cliMetaDataTables._Property, tasks);
+    FillTable(layout, cliMetaDataTables._MethodSemantics, tasks);
+    FillTable(layout, cliMetaDataTables._MethodImpl, tasks);
+    FillTable(layout, cliMetaDataTables._ModuleRef, tasks);
+    FillTable(layout, cliMetaDataTables._TypeSpec, tasks);
+    FillTable(layout, cliMetaDataTables._ImplMap, tasks);
+    FillTable(layout, cliMetaDataTables._FieldRVA, tasks);
+    FillTable(layout, cliMetaDataTables._Assembly, tasks);
+    FillTable(layout, cliMetaDataTables._AssemblyProcessor, tasks);
+    FillTable(layout, cliMetaDataTables._AssemblyOS, tasks);
+    FillTable(layout, cliMetaDataTables._AssemblyRef, tasks);
+    FillTable(layout, cliMetaDataTables._AssemblyRefProcessor, tasks);
+    FillTable(layout, cliMetaDataTables._AssemblyRefOS, tasks);
+    FillTable(layout, cliMetaDataTables._File, tasks);
+    FillTable(layout, cliMetaDataTables._ExportedType, tasks);
+    FillTable(layout, cliMetaDataTables._ManifestResource, tasks);
+    FillTable(layout, cliMetaDataTables._NestedClass, tasks);
+    FillTable(layout, cliMetaDataTables._GenericParam, tasks);
+    FillTable(layout, cliMetaDataTables._MethodSpec, tasks);
+    FillTable(layout, cliMetaDataTables._GenericParamConstraint, tasks);
+
+    // Method bodies are parsed later, on first use, unless eager loading is requested.
+    methodBodies = MethodBodies(static_cast<uint32_t>(cliMetaDataTables._MethodDef.size()));
+    if (!loadOptions.lazyMethodBodies) {
+        for (uint32_t first = 0; first < methodBodies.count; first += MetadataTable<MethodDefRow>::chunkSize) {
+            auto last = min(methodBodies.count, first + MetadataTable<MethodDefRow>::chunkSize);
+            tasks.push_back([this, first, last] {
+                for (uint32_t index = first; index < last; ++index) {
+                    getMethodBody(index + 1);
+                }
+            });
+        }
+    }
 
-    // FieldMarshal
-    FillTable<FieldMarshalRow>(mr, cliMetaDataTables._FieldMarshal);
+    RunDecodeTasks(tasks);
 
-    // DeclSecurity
-    FillTable<DeclSecurityRow>(mr, cliMetaDataTables._DeclSecurity);
+    if (!snapshotPath.empty() && !snapshot) {
+        SaveSnapshot(snapshotPath, snapshotKey, *layout);
+    }
+}
 
-    // ClassLayout
-    FillTable<ClassLayoutRow>(mr, cliMetaDataTables._ClassLayout);
+void AssemblyData::SaveSnapshot(const string& path, const MetadataSnapshot::Key& key, const MetadataTablesLayout& layout) const
+{
+    // Snapshot is just a cache, assembly is usable without it. Bodies which can't be parsed will fail on first use.
+    try {
+        vector<MetadataSnapshot::MethodEntry> methods;
+        vector<ExceptionClause> clauses;
+        methods.reserve(methodBodies.count);
+        for (uint32_t index = 0; index < methodBodies.count; ++index) {
+            methods.push_back(readMethodEntry(index, clauses));
+        }
+        MetadataSnapshot::write(path, key, layout, methods, clauses, *names);
+    }
+    catch (const runtime_error&) {
+    }
+}
 
-    // FieldLayout
-    FillTable<FieldLayoutRow>(mr, cliMetaDataTables._FieldLayout);
+// Every task is publishing its result with atomic operations, so tasks may run in any order on any thread.
+//  Body tasks are decoding the rows they need on their own if these rows aren't decoded yet.
+void AssemblyData::RunDecodeTasks(const DecodeTasks& tasks) const
+{
+    auto threadsCount = loadOptions.decodeThreads;
+    if (threadsCount == 0) {
+        threadsCount = max(thread::hardware_concurrency(), 1u);
+    }
+    threadsCount = min(threadsCount, static_cast<uint32_t>(tasks.size()));
 
-    // StandAloneSig
-    // Each row represents a signature that isn't referenced by any other table.
-    cliMetaDataTables._StandAloneSig.reserve(mr.mapTableLength[CLIMetadataTableItem::StandAloneSig]);
-    for (uint32_t n = 0; n < mr.mapTableLength[CLIMetadataTableItem::StandAloneSig]; ++n) {
-        vector<uint32_t> signature;
-        mr.readSignature(signature);
-        cliMetaDataTables._StandAloneSig.push_back(signature);
+    if (threadsCount <= 1) {
+        for (const auto& task : tasks) {
+            task();
+        }
+        return;
     }
 
-    // EventMap
-    FillTable<EventMapRow>(mr, cliMetaDataTables._EventMap);
+    // Calling thread is working too.
+    ThreadPool pool(threadsCount - 1);
+    pool.parallelFor(static_cast<uint32_t>(tasks.size()), [&tasks](uint32_t n) { tasks[n](); });
+}
 
-    // Event
-    FillTable<EventRow>(mr, cliMetaDataTables._Event);
+// Get physical offset from the beginning of file.
+uint32_t AssemblyData::getDataOffset(uint32_t address) const
+{
+    for (const auto& section : sections) {
+        if (section.virtualAddress <= address && address < section.virtualAddress + section.virtualSize) {
+            return section.pointerToRawData + (address - section.virtualAddress);
+        }
+    }
 
-    // PropertyMap
-    FillTable<PropertyMapRow>(mr, cliMetaDataTables._PropertyMap);
+    // It looks like we weren't able to find anything
+    return numeric_limits<uint32_t>::max();
+}
 
-    // Property
-    FillTable<PropertyRow>(mr, cliMetaDataTables._Property);
+const MethodDefRow& AssemblyData::getMethodDef(uint32_t token) const
+{
+    return cliMetaDataTables._MethodDef[(token & 0xFFFFFF) - 1];
+}
 
-    // MethodSemantics
-    FillTable<MethodSemanticsRow>(mr, cliMetaDataTables._MethodSemantics);
 
-    // MethodImpl
-    FillTable<MethodImplRow>(mr, cliMetaDataTables._MethodImpl);
+// Placeholder for method bodies which are being parsed right now
+static const MethodBody methodBodyLoading;
 
-    // ModuleRef
-    cliMetaDataTables._ModuleRef.reserve(mr.mapTableLength[CLIMetadataTableItem::ModuleRef]);
-    for (uint32_t n = 0; n < mr.mapTableLength[CLIMetadataTableItem::ModuleRef]; ++n) {
-        u16string name;
-        mr.readString(name);
-        cliMetaDataTables._ModuleRef.push_back(name);
-    }
+// Threads which are waiting for method bodies are sleeping on one of these condition variables.
+static const size_t methodBodyLocksCount = 16;
+static mutex methodBodyLocks[methodBodyLocksCount];
+static condition_variable methodBodyLoaded[methodBodyLocksCount];
 
-    // TypeSpec
-    cliMetaDataTables._TypeSpec.reserve(mr.mapTableLength[CLIMetadataTableItem::TypeSpec]);
-    for (uint32_t n = 0; n < mr.mapTableLength[CLIMetadataTableItem::TypeSpec]; ++n) {
-        vector<uint32_t> signature;
-        mr.readSignature(signature);
-        cliMetaDataTables._TypeSpec.push_back(signature);
+AssemblyData::MethodBodies::MethodBodies(uint32_t methodsCount) : slots(new atomic<const MethodBody*>[methodsCount]), count(methodsCount) {
+    for (uint32_t n = 0; n < count; ++n) {
+        slots[n].store(nullptr, memory_order_relaxed);
     }
+}
 
-    // ImplMap
-    FillTable<ImplMapRow>(mr, cliMetaDataTables._ImplMap);
-
-    // FieldRVA
-    FillTable<FieldRVARow>(mr, cliMetaDataTables._FieldRVA);
-
-    // Assembly
-    FillTable<AssemblyRow>(mr, cliMetaDataTables._Assembly);
+void AssemblyData::MethodBodies::swap(MethodBodies& other) noexcept {
+    slots.swap(other.slots);
+    ::swap(count, other.count);
+}
 
-    // AssemblyProcessor
-    for (uint32_t n = 0; n < mr.mapTableLength[CLIMetadataTableItem::AssemblyProcessor]; ++n) {
-        cliMetaDataTables._AssemblyProcessor.push_back(reader.read_uint32());
+AssemblyData::MethodBodies::~MethodBodies() noexcept {
+    for (uint32_t n = 0; n < count; ++n) {
+        auto body = slots[n].load(memory_order_relaxed);
+        if (body != &methodBodyLoading) {
+            delete body;
+        }
     }
+}
 
-    // AssemblyOS
-    FillTable<AssemblyOSRow>(mr, cliMetaDataTables._AssemblyOS);
-
-    // AssemblyRef
-    FillTable<AssemblyRefRow>(mr, cliMetaDataTables._AssemblyRef);
-
-    // AssemblyRefProcessor
-    FillTable<AssemblyRefProcessorRow>(mr, cliMetaDataTables._AssemblyRefProcessor);
-
-    // AssemblyRefOS
-    FillTable<AssemblyRefOSRow>(mr, cliMetaDataTables._AssemblyRefOS);
-
-    // File
-    FillTable<FileRow>(mr, cliMetaDataTables._File);
+const MethodBody& AssemblyData::getMethodBody(uint32_t token) const
+{
+    auto index = (token & 0xFFFFFF) - 1;
+    if (index >= methodBodies.count) {
+        throw runtime_error("Invalid method token");
+    }
 
-    // ExportedType
-    FillTable<ExportedTypeRow>(mr, cliMetaDataTables._ExportedType);
+    // Fast path, body has already been parsed.
+    auto& slot = methodBodies.slots[index];
+    auto body = slot.load(memory_order_acquire);
+    if (body != nullptr && body != &methodBodyLoading) {
+        return *body;
+    }
 
-    // ManifestResource
-    FillTable<ManifestResourceRow>(mr, cliMetaDataTables._ManifestResource);
+    auto& lock = methodBodyLocks[index % methodBodyLocksCount];
+    auto& loaded = methodBodyLoaded[index % methodBodyLocksCount];
+
+    // Only one thread is parsing the body, others are waiting for this particular method.
+    const MethodBody* expected = nullptr;
+    if (!slot.compare_exchange_strong(expected, &methodBodyLoading, memory_order_acq_rel, memory_order_acquire)) {
+        unique_lock<mutex> guard(lock);
+        loaded.wait(guard, [&] {
+            body = slot.load(memory_order_acquire);
+            return body != &methodBodyLoading;
+        });
+        if (body == nullptr) {
+            // Parsing thread has failed, let's try again.
+            guard.unlock();
+            return getMethodBody(token);
+        }
+        return *body;
+    }
 
-    // NestedClass
-    FillTable<NestedClassRow>(mr, cliMetaDataTables._NestedClass);
+    unique_ptr<MethodBody> parsed;
+    try {
+        parsed.reset(loadMethodBody(index));
+    }
+    catch (...) {
+        {
+            lock_guard<mutex> guard(lock);
+            slot.store(nullptr, memory_order_release);
+        }
+        loaded.notify_all();
+        throw;
+    }
 
-    // GenericParam
-    FillTable<GenericParamRow>(mr, cliMetaDataTables._GenericParam);
+    {
+        lock_guard<mutex> guard(lock);
+        slot.store(parsed.get(), memory_order_release);
+    }
+    loaded.notify_all();
+    return *parsed.release();
+}
 
-    // MethodSpec
-    FillTable<MethodSpecRow>(mr, cliMetaDataTables._MethodSpec);
+// Get method information
+MethodBody* AssemblyData::loadMethodBody(uint32_t index) const
+{
+    // Header of the body is either parsed now or taken from the snapshot.
+    MetadataSnapshot::MethodEntry entry;
+    vector<ExceptionClause> clauses;
+    if (snapshot) {
+        entry = snapshot->getMethod(index);
+        snapshot->getClauses(entry, clauses);
+    } else {
+        entry = readMethodEntry(index, clauses);
+    }
 
-    // GenericParamConstraint
-    FillTable<GenericParamConstraintRow>(mr, cliMetaDataTables._GenericParamConstraint);
+    unique_ptr<MethodBody> result(new MethodBody());
+    MethodBody& methodBody = *result;
 
-    // Load method bodies.
-    for (uint32_t n = 0; n < mr.mapTableLength[CLIMetadataTableItem::MethodDef]; ++n) {
-        loadMethodBody(n);
+    if (entry.codeOffset == 0) {
+        // There is no code to search for, it looks like we have a virtual or PInvoke method here.
+        return result.release();
     }
-}
 
-// Get physical offset from the beginning of file.
-uint32_t AssemblyData::getDataOffset(uint32_t address) const
-{
-    for (const auto& section : sections) {
-        if (section.virtualAddress <= address && address < section.virtualAddress + section.virtualSize) {
-            return section.pointerToRawData + (address - section.virtualAddress);
-        }
+    // Check if there are local variable signatures present.
+    if (entry.localVarSigToken != 0) {
+        methodBody.localVarSig = cliMetaDataTables._StandAloneSig[(entry.localVarSigToken & 0x00FFFFFF) - 1].signature;
     }
 
-    // It looks like we weren't able to find anything
-    return numeric_limits<uint32_t>::max();
-}
+    methodBody.maxStack = entry.maxStack;
+    methodBody.initLocals = entry.initLocals != 0;
+    reader.read_bytes(methodBody.data, entry.codeOffset, entry.codeSize);
+    methodBody.exceptions = move(clauses);
 
-const MethodDefRow& AssemblyData::getMethodDef(uint32_t token) const
-{
-    return cliMetaDataTables._MethodDef[(token & 0xFFFFFF) - 1];
+    return result.release();
 }
 
-
-// Get method information
-void AssemblyData::loadMethodBody(uint32_t index)
+// Parse header and extra sections of the method body, exception clauses are appended to the clauses vector.
+MetadataSnapshot::MethodEntry AssemblyData::readMethodEntry(uint32_t index, vector<ExceptionClause>& clauses) const
 {
     using bflags = MethodBodyFlags;
     using eflags = ExceptionFlags;
 
-    MethodDefRow& methodDef = cliMetaDataTables._MethodDef[index];
-    MethodBody& methodBody = methodDef.methodBody;
+    const MethodDefRow& methodDef = cliMetaDataTables._MethodDef[index];
+    MetadataSnapshot::MethodEntry entry = {};
+    entry.firstClause = static_cast<uint32_t>(clauses.size());
 
     if (methodDef.rva == 0) {
-        // There is no code to search for, it looks like we have a virtual or PInvoke method here.
-        return;
+        return entry;
     }
 
+    // Own cursor, since the body could be parsed by several threads at once.
+    AssemblyReader bodyReader(reader);
+
     auto offset = getDataOffset(methodDef.rva);
-    auto format = bflags(reader[offset] & 0x03);
-    reader.seek(offset);
+    auto format = bflags(bodyReader[offset] & 0x03);
+    bodyReader.seek(offset);
 
     if (format == bflags::TinyFormat) {
         // "For a method to have its IL instructions formatted in a tiny format, the following must be true:
@@ -363,9 +477,9 @@ void AssemblyData::loadMethodBody(uint32_t index)
         //
         // - p.125 of ".NET Common Language Runtime Unleashed" by Kevin Burton
         //
-        methodBody.maxStack = 8;
-        auto length = reader.read_uint8() >> 2;
-        reader.read_bytes(methodBody.data, length);
+        entry.maxStack = 8;
+        entry.codeSize = bodyReader.read_uint8() >> 2;
+        entry.codeOffset = bodyReader.tell();
     } else if (format == bflags::FatFormat) {
         // "If any of the conditions specified for a tiny format are not true, then the method uses a
         // fat format. The fat format header has the following structure:
@@ -383,10 +497,10 @@ void AssemblyData::loadMethodBody(uint32_t index)
         //
         // - p.125 of ".NET Common Language Runtime Unleashed" by Kevin Burton
         //
-        auto flags = reader.read_uint16();
-        auto maxStack = reader.read_uint16();
-        auto codeSize = reader.read_uint32();
-        auto localVarSigTok = reader.read_uint32();
+        auto flags = bodyReader.read_uint16();
+        auto maxStack = bodyReader.read_uint16();
+        auto codeSize = bodyReader.read_uint32();
+        auto localVarSigTok = bodyReader.read_uint32();
 
         // Check if there are local variable signatures present.
         if (localVarSigTok != 0) {
@@ -395,15 +509,20 @@ void AssemblyData::loadMethodBody(uint32_t index)
                 throw runtime_error("Invalid localVarSigTok value.");
             }
 
-            methodBody.localVarSigs = cliMetaDataTables._StandAloneSig[(localVarSigTok & 0x00FFFFFF) - 1];
+            entry.localVarSigToken = localVarSigTok;
         }
 
-        methodBody.maxStack = maxStack;
-        reader.read_bytes(methodBody.data, codeSize);
+        entry.maxStack = maxStack;
+        entry.codeSize = codeSize;
+        entry.codeOffset = bodyReader.tell();
+        entry.initLocals = (flags & _u(bflags::InitLocals)) != 0 ? 1 : 0;
+        if (codeSize > bodyReader.size() - entry.codeOffset) {
+            throw runtime_error("Method body is out of image bounds.");
+        }
 
         if ((flags & _u(bflags::MoreSects)) != 0) {
-            reader.seek(reader.tell() + ((codeSize + 3) & ~3) - codeSize);
-            auto sectionHeader = reader.read_uint32();
+            bodyReader.seek(entry.codeOffset + ((codeSize + 3) & ~3));
+            auto sectionHeader = bodyReader.read_uint32();
             if ((sectionHeader & _u(eflags::MoreSects)) != 0 || (sectionHeader & _u(eflags::EHTable)) == 0) {
                 // Formally, section could be used for any kind of purposes. However, currently it's not used for anything except storing the information about exception blocks.
                 throw runtime_error("Section format is not supported");
@@ -412,34 +531,35 @@ void AssemblyData::loadMethodBody(uint32_t index)
                 auto count = ((sectionHeader >> 8) - 4) / 24;
                 for (uint32_t i = 0; i < count; i++) {
                     ExceptionClause clause;
-                    clause.flags = reader.read_uint32();
-                    clause.tryOffset = reader.read_uint32();
-                    clause.tryLength = reader.read_uint32();
-                    clause.handlerOffset = reader.read_uint32();
-                    clause.handlerLength = reader.read_uint32();
-                    clause.classTokenOrFilterOffset = reader.read_uint32();
-                    methodBody.exceptions.push_back(clause);
+                    clause.flags = bodyReader.read_uint32();
+                    clause.tryOffset = bodyReader.read_uint32();
+                    clause.tryLength = bodyReader.read_uint32();
+                    clause.handlerOffset = bodyReader.read_uint32();
+                    clause.handlerLength = bodyReader.read_uint32();
+                    clause.classTokenOrFilterOffset = bodyReader.read_uint32();
+                    clauses.push_back(clause);
                 }
             } else {
                 // Tiny section: 16-bit block and handler offsets, 8-bit block and handler length fields.
                 auto count = (((sectionHeader >> 8) & 0xFF) - 4) / 12;
                 for (uint32_t i = 0; i < count; i++) {
                     ExceptionClause clause;
-                    clause.flags = reader.read_uint16();
-                    clause.tryOffset = reader.read_uint16();
-                    clause.tryLength = reader.read_uint8();
-                    clause.handlerOffset = reader.read_uint16();
-                    clause.handlerLength = reader.read_uint8();
-                    clause.classTokenOrFilterOffset = reader.read_uint32();
-                    methodBody.exceptions.push_back(clause);
+                    clause.flags = bodyReader.read_uint16();
+                    clause.tryOffset = bodyReader.read_uint16();
+                    clause.tryLength = bodyReader.read_uint8();
+                    clause.handlerOffset = bodyReader.read_uint16();
+                    clause.handlerLength = bodyReader.read_uint8();
+                    clause.classTokenOrFilterOffset = bodyReader.read_uint32();
+                    clauses.push_back(clause);
                 }
             }
         }
-
-        methodBody.initLocals = ((flags & _u(bflags::InitLocals)) != 0);
     } else {
         throw runtime_error("Invalid body format.");
     }
+
+    entry.clausesCount = static_cast<uint32_t>(clauses.size()) - entry.firstClause;
+    return entry;
 }
 
 size_t AssemblyData::getMethodCount() const {
@@ -450,14 +570,304 @@ const Guid& AssemblyData::getGUID() const {
     return cliMetaDataTables._Module[0].guid;
 }
 
-const u16string& AssemblyData::getName() const {
+StringHandle AssemblyData::getName() const {
     return cliMetaDataTables._Assembly[0].name;
 } 
 
-const vector<AssemblyRefRow>& AssemblyData::getAssemblyRef() const {
+const MetadataTable<AssemblyRefRow>& AssemblyData::getAssemblyRef() const {
     return cliMetaDataTables._AssemblyRef;
 }
 
+const AssemblyLoadOptions& AssemblyData::getLoadOptions() const {
+    return loadOptions;
+}
+
+const StringHeap& AssemblyData::getStrings() const {
+    return strings;
+}
+
+const NameTable& AssemblyData::getNames() const {
+    return *names;
+}
+
+u16string AssemblyData::getUserString(uint32_t token) const {
+    // Blob of UTF-16 characters, followed by one byte which tells whether there are any special characters.
+    const string heapName = { '#', 'U', 'S' };
+    const auto heapSize = cliMetadata.getStreamSize(heapName);
+    const auto index = token & 0xFFFFFF;
+    if (index >= heapSize) {
+        throw runtime_error("Invalid #US heap offset");
+    }
+    auto offset = cliMetadata.getStreamOffset(heapName) + index;
+    uint32_t length;
+    offset += reader.read_varsize(length, offset);
+    if (length > heapSize - index || offset > reader.size() || length > reader.size() - offset) {
+        throw runtime_error("User string is out of #US heap bounds");
+    }
+
+    u16string result(length / 2, u'\0');
+    for (uint32_t n = 0; n < length / 2; ++n) {
+        result[n] = static_cast<char16_t>(reader.read_uint16(offset + n * 2));
+    }
+    return result;
+}
+
+void AssemblyData::BuildTypeIndexes() const {
+    call_once(typeIndexes->built, [this] {
+        const auto& typeDefs = cliMetaDataTables._TypeDef;
+        const auto& exportedTypes = cliMetaDataTables._ExportedType;
+
+        // Nested types are distinguished by their enclosing types.
+        vector<uint32_t> enclosing(typeDefs.size() + 1, 0);
+        for (size_t n = 0; n < cliMetaDataTables._NestedClass.size(); ++n) {
+            const auto& nested = cliMetaDataTables._NestedClass[n];
+            if (nested.nestedClass < enclosing.size()) {
+                enclosing[nested.nestedClass] = nested.enclosingClass;
+            }
+        }
+
+        TypeNameIndex typeDefIndex(static_cast<uint32_t>(typeDefs.size()));
+        for (uint32_t n = 0; n < typeDefs.size(); ++n) {
+            const auto& typeDef = typeDefs[n];
+            typeDefIndex.insert({ names->getId(typeDef.typeNamespace), names->getId(typeDef.typeName), enclosing[n + 1] }, n + 1);
+        }
+
+        TypeNameIndex exportedIndex(static_cast<uint32_t>(exportedTypes.size()));
+        for (uint32_t n = 0; n < exportedTypes.size(); ++n) {
+            const auto& exportedType = exportedTypes[n];
+            auto outer = exportedType.implementation.second == CLIMetadataTableItem::ExportedType ? exportedType.implementation.first : 0;
+            exportedIndex.insert({ names->getId(exportedType.typeNamespace), names->getId(exportedType.typeName), outer }, n + 1);
+        }
+
+        typeIndexes->typeDefs = move(typeDefIndex);
+        typeIndexes->exportedTypes = move(exportedIndex);
+    });
+}
+
+// Names which aren't present in this assembly can't be a part of any type name.
+bool AssemblyData::MakeTypeKey(const char* typeNamespace, uint32_t namespaceLength, const char* typeName, uint32_t nameLength, uint32_t enclosingType, TypeNameIndex::Key& key) const {
+    BuildTypeIndexes();
+    key.namespaceId = names->find(typeNamespace, namespaceLength);
+    key.nameId = names->find(typeName, nameLength);
+    key.enclosing = enclosingType;
+    return key.namespaceId != NameTable::notFound && key.nameId != NameTable::notFound;
+}
+
+uint32_t AssemblyData::findTypeDef(const string& typeNamespace, const string& typeName, uint32_t enclosingType) const {
+    TypeNameIndex::Key key;
+    if (!MakeTypeKey(typeNamespace.c_str(), static_cast<uint32_t>(typeNamespace.size()), typeName.c_str(), static_cast<uint32_t>(typeName.size()), enclosingType, key)) {
+        return 0;
+    }
+    return typeIndexes->typeDefs.find(key);
+}
+
+uint32_t AssemblyData::findTypeDef(const StringHeap& heap, StringHandle typeNamespace, StringHandle typeName, uint32_t enclosingType) const {
+    TypeNameIndex::Key key;
+    if (!MakeTypeKey(heap.c_str(typeNamespace), heap.length(typeNamespace), heap.c_str(typeName), heap.length(typeName), enclosingType, key)) {
+        return 0;
+    }
+    return typeIndexes->typeDefs.find(key);
+}
+
+uint32_t AssemblyData::findExportedType(const string& typeNamespace, const string& typeName, uint32_t enclosingType) const {
+    TypeNameIndex::Key key;
+    if (!MakeTypeKey(typeNamespace.c_str(), static_cast<uint32_t>(typeNamespace.size()), typeName.c_str(), static_cast<uint32_t>(typeName.size()), enclosingType, key)) {
+        return 0;
+    }
+    return typeIndexes->exportedTypes.find(key);
+}
+
+uint32_t AssemblyData::findExportedType(const StringHeap& heap, StringHandle typeNamespace, StringHandle typeName, uint32_t enclosingType) const {
+    TypeNameIndex::Key key;
+    if (!MakeTypeKey(heap.c_str(typeNamespace), heap.length(typeNamespace), heap.c_str(typeName), heap.length(typeName), enclosingType, key)) {
+        return 0;
+    }
+    return typeIndexes->exportedTypes.find(key);
+}
+
+// Lists must be sorted, malformed ones are clamped so ranges never overlap or leave the member table.
+static void buildMemberRanges(vector<uint32_t>& lists, uint32_t membersCount, vector<uint32_t>& owners) {
+    uint32_t previous = 1;
+    for (auto& first : lists) {
+        first = min(max(first, previous), membersCount + 1);
+        previous = first;
+    }
+    lists.push_back(membersCount + 1);
+
+    owners.assign(membersCount, 0);
+    for (uint32_t owner = 1; owner < lists.size(); ++owner) {
+        for (auto member = lists[owner - 1]; member < lists[owner]; ++member) {
+            owners[member - 1] = owner;
+        }
+    }
+}
+
+void AssemblyData::BuildMemberIndexes() const {
+    call_once(memberIndexes->built, [this] {
+        // Lists are the fifth and sixth columns of TypeDef and the sixth column of MethodDef, they're extracted
+        //  without decoding rows, which would intern names and signatures of every type and method.
+        const auto& layout = cliMetaDataTables._TypeDef.getLayout();
+        const auto& methodDefs = cliMetaDataTables._MethodDef;
+
+        auto& indexes = *memberIndexes;
+        indexes.fieldLists = layout.extractColumn(CLIMetadataTableItem::TypeDef, 4);
+        indexes.methodLists = layout.extractColumn(CLIMetadataTableItem::TypeDef, 5);
+        indexes.paramLists = layout.extractColumn(CLIMetadataTableItem::MethodDef, 5);
+
+        buildMemberRanges(indexes.fieldLists, static_cast<uint32_t>(cliMetaDataTables._FieldDef.size()), indexes.fieldOwners);
+        buildMemberRanges(indexes.methodLists, static_cast<uint32_t>(methodDefs.size()), indexes.methodOwners);
+        buildMemberRanges(indexes.paramLists, static_cast<uint32_t>(cliMetaDataTables._ParamDef.size()), indexes.paramOwners);
+    });
+}
+
+static AssemblyData::RowRange getMemberRange(const vector<uint32_t>& lists, uint32_t row) {
+    if (row == 0 || row >= lists.size()) {
+        throw runtime_error("Invalid metadata row index");
+    }
+    return{ lists[row - 1], lists[row] };
+}
+
+static uint32_t getMemberOwner(const vector<uint32_t>& owners, uint32_t row) {
+    if (row == 0 || row > owners.size()) {
+        throw runtime_error("Invalid metadata row index");
+    }
+    return owners[row - 1];
+}
+
+AssemblyData::RowRange AssemblyData::getFields(uint32_t typeDefRow) const {
+    BuildMemberIndexes();
+    return getMemberRange(memberIndexes->fieldLists, typeDefRow);
+}
+
+AssemblyData::RowRange AssemblyData::getMethods(uint32_t typeDefRow) const {
+    BuildMemberIndexes();
+    return getMemberRange(memberIndexes->methodLists, typeDefRow);
+}
+
+AssemblyData::RowRange AssemblyData::getParams(uint32_t methodDefRow) const {
+    BuildMemberIndexes();
+    return getMemberRange(memberIndexes->paramLists, methodDefRow);
+}
+
+uint32_t AssemblyData::getFieldOwner(uint32_t fieldRow) const {
+    BuildMemberIndexes();
+    return getMemberOwner(memberIndexes->fieldOwners, fieldRow);
+}
+
+uint32_t AssemblyData::getMethodOwner(uint32_t methodDefRow) const {
+    BuildMemberIndexes();
+    return getMemberOwner(memberIndexes->methodOwners, methodDefRow);
+}
+
+uint32_t AssemblyData::getParamOwner(uint32_t paramRow) const {
+    BuildMemberIndexes();
+    return getMemberOwner(memberIndexes->paramOwners, paramRow);
+}
+
+// Binary search of rows for which compare() returns zero, rows with negative result must go first.
+template<typename T, typename Compare>
+static AssemblyData::RowRange findSortedRows(const MetadataTable<T>& table, Compare compare) {
+    const auto rowsCount = static_cast<uint32_t>(table.size());
+
+    uint32_t first = 0;
+    for (auto count = rowsCount; count > 0; ) {
+        auto step = count / 2;
+        if (compare(table[first + step]) < 0) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    uint32_t last = first;
+    for (auto count = rowsCount - first; count > 0; ) {
+        auto step = count / 2;
+        if (compare(table[last + step]) <= 0) {
+            last += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    return{ first + 1, last + 1 };
+}
+
+static int compareIndex(uint32_t value, uint32_t target) {
+    return value < target ? -1 : (value > target ? 1 : 0);
+}
+
+// Coded indexes are sorted by their encoded value, so by row and then by tag of the table.
+static int compareCodedIndex(CLICodedIndex codedIndex, const pair<uint32_t, CLIMetadataTableItem>& value, const pair<uint32_t, CLIMetadataTableItem>& target) {
+    if (value.first != target.first) {
+        return value.first < target.first ? -1 : 1;
+    }
+    if (value.second == target.second) {
+        return 0;
+    }
+    return getCodedIndexTag(codedIndex, value.second) < getCodedIndexTag(codedIndex, target.second) ? -1 : 1;
+}
+
+AssemblyData::RowRange AssemblyData::getCustomAttributes(const pair<uint32_t, CLIMetadataTableItem>& parent) const {
+    getCodedIndexTag(CLICodedIndex::HasCustomAttribute, parent.second);
+    return findSortedRows(cliMetaDataTables._CustomAttribute, [&parent](const CustomAttributeRow& row) {
+        return compareCodedIndex(CLICodedIndex::HasCustomAttribute, row.parent, parent);
+    });
+}
+
+AssemblyData::RowRange AssemblyData::getConstants(const pair<uint32_t, CLIMetadataTableItem>& parent) const {
+    getCodedIndexTag(CLICodedIndex::HasConstant, parent.second);
+    return findSortedRows(cliMetaDataTables._Constant, [&parent](const ConstantRow& row) {
+        return compareCodedIndex(CLICodedIndex::HasConstant, row.parent, parent);
+    });
+}
+
+AssemblyData::RowRange AssemblyData::getMethodSemantics(const pair<uint32_t, CLIMetadataTableItem>& association) const {
+    getCodedIndexTag(CLICodedIndex::HasSemantics, association.second);
+    return findSortedRows(cliMetaDataTables._MethodSemantics, [&association](const MethodSemanticsRow& row) {
+        return compareCodedIndex(CLICodedIndex::HasSemantics, row.association, association);
+    });
+}
+
+AssemblyData::RowRange AssemblyData::getImplMaps(const pair<uint32_t, CLIMetadataTableItem>& memberForwarded) const {
+    getCodedIndexTag(CLICodedIndex::MemberForwarded, memberForwarded.second);
+    return findSortedRows(cliMetaDataTables._ImplMap, [&memberForwarded](const ImplMapRow& row) {
+        return compareCodedIndex(CLICodedIndex::MemberForwarded, row.memberForwarded, memberForwarded);
+    });
+}
+
+AssemblyData::RowRange AssemblyData::getGenericParams(const pair<uint32_t, CLIMetadataTableItem>& owner) const {
+    getCodedIndexTag(CLICodedIndex::TypeOrMethodDef, owner.second);
+    return findSortedRows(cliMetaDataTables._GenericParam, [&owner](const GenericParamRow& row) {
+        return compareCodedIndex(CLICodedIndex::TypeOrMethodDef, row.owner, owner);
+    });
+}
+
+AssemblyData::RowRange AssemblyData::getFieldRVAs(uint32_t fieldRow) const {
+    return findSortedRows(cliMetaDataTables._FieldRVA, [fieldRow](const FieldRVARow& row) {
+        return compareIndex(row.field, fieldRow);
+    });
+}
+
+AssemblyData::RowRange AssemblyData::getNestedClasses(uint32_t nestedClassRow) const {
+    return findSortedRows(cliMetaDataTables._NestedClass, [nestedClassRow](const NestedClassRow& row) {
+        return compareIndex(row.nestedClass, nestedClassRow);
+    });
+}
+
+AssemblyData::RowRange AssemblyData::getInterfaceImpls(uint32_t typeDefRow) const {
+    return findSortedRows(cliMetaDataTables._InterfaceImpl, [typeDefRow](const InterfaceImplRow& row) {
+        return compareIndex(row.classRef, typeDefRow);
+    });
+}
+
+AssemblyData::RowRange AssemblyData::getMethodImpls(uint32_t typeDefRow) const {
+    return findSortedRows(cliMetaDataTables._MethodImpl, [typeDefRow](const MethodImplRow& row) {
+        return compareIndex(row.classRef, typeDefRow);
+    });
+}
+
 const vector<uint16_t>& AssemblyData::getVersion() const {
     return cliMetaDataTables._Assembly[0].version;
 }
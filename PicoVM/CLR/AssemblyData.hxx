@@ -1,13 +1,38 @@
 #ifndef __ASSEMBLYDATA_HXX__
 #define __ASSEMBLYDATA_HXX__
 #include <cstdint>
+#include <string>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <mutex>
 
 #include "AssemblyReader.hxx"
 #include "CLIMetadata.hxx"
 #include "CLIMetadataTableRows.hxx"
 #include "CLIMethodBody.hxx"
 #include "CLISignature.hxx"
+#include "MetadataTable.hxx"
+#include "StringHeap.hxx"
+#include "NameTable.hxx"
+#include "MetadataSnapshot.hxx"
+#include "TypeNameIndex.hxx"
+
+// Assembly loading options
+struct AssemblyLoadOptions {
+    // Decode rows of metadata tables on first access instead of decoding all of them during loading.
+    bool lazyTables = true;
+    // Parse method bodies on first use instead of parsing all of them during loading.
+    bool lazyMethodBodies = true;
+    // Number of threads which are decoding tables and method bodies during eager loading, zero means one
+    //  thread per hardware thread. Result doesn't depend on the number of threads.
+    uint32_t decodeThreads = 1;
+    // Take decoded metadata from the snapshot file, the snapshot is written if there is no valid one yet.
+    bool useSnapshot = false;
+    // Directory for snapshot files, empty means next to the assembly file.
+    std::string snapshotDirectory;
+};
 
 class AssemblyData
 {
@@ -23,51 +48,51 @@ public:
 
     // In-memory representation of CLI metadata tables
     struct CLIMetaDataTables {
-        std::vector<ModuleRow> _Module;
-        std::vector<TypeRefRow> _TypeRef;
-        std::vector<TypeDefRow> _TypeDef;
-        std::vector<FieldDefRow> _FieldDef;
-        std::vector<MethodDefRow> _MethodDef;
-        std::vector<ParamDefRow> _ParamDef;
-        std::vector<InterfaceImplRow> _InterfaceImpl;
-        std::vector<MemberRefRow> _MemberRef;
-        std::vector<ConstantRow> _Constant;
-        std::vector<CustomAttributeRow> _CustomAttribute;
-        std::vector<FieldMarshalRow> _FieldMarshal;
-        std::vector<DeclSecurityRow> _DeclSecurity;
-        std::vector<ClassLayoutRow> _ClassLayout;
-        std::vector<FieldLayoutRow> _FieldLayout;
-        std::vector<std::vector<uint32_t> > _StandAloneSig;
-        std::vector<EventMapRow> _EventMap;
-        std::vector<EventRow> _Event;
-        std::vector<PropertyMapRow> _PropertyMap;
-        std::vector<PropertyRow> _Property;
-        std::vector<MethodSemanticsRow> _MethodSemantics;
-        std::vector<MethodImplRow> _MethodImpl;
-        std::vector<std::u16string> _ModuleRef;
-        std::vector<std::vector<uint32_t> > _TypeSpec;
-        std::vector<ImplMapRow> _ImplMap;
-        std::vector<FieldRVARow> _FieldRVA;
-        std::vector<AssemblyRow> _Assembly;
-        std::vector<uint32_t> _AssemblyProcessor;
-        std::vector<AssemblyOSRow> _AssemblyOS;
-        std::vector<AssemblyRefRow> _AssemblyRef;
-        std::vector<AssemblyRefProcessorRow> _AssemblyRefProcessor;
-        std::vector<AssemblyRefOSRow> _AssemblyRefOS;
-        std::vector<FileRow> _File;
-        std::vector<ExportedTypeRow> _ExportedType;
-        std::vector<ManifestResourceRow> _ManifestResource;
-        std::vector<NestedClassRow> _NestedClass;
-        std::vector<GenericParamRow> _GenericParam;
-        std::vector<MethodSpecRow> _MethodSpec;
-        std::vector<GenericParamConstraintRow> _GenericParamConstraint;
+        MetadataTable<ModuleRow> _Module;
+        MetadataTable<TypeRefRow> _TypeRef;
+        MetadataTable<TypeDefRow> _TypeDef;
+        MetadataTable<FieldDefRow> _FieldDef;
+        MetadataTable<MethodDefRow> _MethodDef;
+        MetadataTable<ParamDefRow> _ParamDef;
+        MetadataTable<InterfaceImplRow> _InterfaceImpl;
+        MetadataTable<MemberRefRow> _MemberRef;
+        MetadataTable<ConstantRow> _Constant;
+        MetadataTable<CustomAttributeRow> _CustomAttribute;
+        MetadataTable<FieldMarshalRow> _FieldMarshal;
+        MetadataTable<DeclSecurityRow> _DeclSecurity;
+        MetadataTable<ClassLayoutRow> _ClassLayout;
+        MetadataTable<FieldLayoutRow> _FieldLayout;
+        MetadataTable<StandAloneSigRow> _StandAloneSig;
+        MetadataTable<EventMapRow> _EventMap;
+        MetadataTable<EventRow> _Event;
+        MetadataTable<PropertyMapRow> _PropertyMap;
+        MetadataTable<PropertyRow> _Property;
+        MetadataTable<MethodSemanticsRow> _MethodSemantics;
+        MetadataTable<MethodImplRow> _MethodImpl;
+        MetadataTable<ModuleRefRow> _ModuleRef;
+        MetadataTable<TypeSpecRow> _TypeSpec;
+        MetadataTable<ImplMapRow> _ImplMap;
+        MetadataTable<FieldRVARow> _FieldRVA;
+        MetadataTable<AssemblyRow> _Assembly;
+        MetadataTable<AssemblyProcessorRow> _AssemblyProcessor;
+        MetadataTable<AssemblyOSRow> _AssemblyOS;
+        MetadataTable<AssemblyRefRow> _AssemblyRef;
+        MetadataTable<AssemblyRefProcessorRow> _AssemblyRefProcessor;
+        MetadataTable<AssemblyRefOSRow> _AssemblyRefOS;
+        MetadataTable<FileRow> _File;
+        MetadataTable<ExportedTypeRow> _ExportedType;
+        MetadataTable<ManifestResourceRow> _ManifestResource;
+        MetadataTable<NestedClassRow> _NestedClass;
+        MetadataTable<GenericParamRow> _GenericParam;
+        MetadataTable<MethodSpecRow> _MethodSpec;
+        MetadataTable<GenericParamConstraintRow> _GenericParamConstraint;
 
         ~CLIMetaDataTables() noexcept;
     } cliMetaDataTables;
 
     AssemblyData() = delete;
-    AssemblyData(std::string strFilePathName);
-    AssemblyData(const std::vector<uint8_t>& assembly_bytes);
+    AssemblyData(std::string strFilePathName, const AssemblyLoadOptions& options = AssemblyLoadOptions());
+    AssemblyData(const std::vector<uint8_t>& assembly_bytes, const AssemblyLoadOptions& options = AssemblyLoadOptions());
 
     AssemblyData(const AssemblyData& other) = default;
     AssemblyData(AssemblyData&& other) = default;
@@ -78,11 +103,59 @@ public:
     uint32_t getDataOffset(uint32_t address) const;
     size_t getMethodCount() const;
     const MethodDefRow& getMethodDef(uint32_t token) const;
+    const MethodBody& getMethodBody(uint32_t token) const;
 
     const Guid& getGUID() const;
-    const std::u16string& getName() const;
+    StringHandle getName() const;
     const std::vector<uint16_t>& getVersion() const;
-    const std::vector<AssemblyRefRow>& getAssemblyRef() const;
+    const MetadataTable<AssemblyRefRow>& getAssemblyRef() const;
+    // Options which the image has been loaded with
+    const AssemblyLoadOptions& getLoadOptions() const;
+
+    // #Strings heap and interned names
+    const StringHeap& getStrings() const;
+    const NameTable& getNames() const;
+    // Literal of ldstr instruction, given by its token or offset in #US heap
+    std::u16string getUserString(uint32_t token) const;
+
+    // One-based TypeDef row by namespace, name and one-based row of the enclosing TypeDef, zero if there is no such type.
+    //  Names could be given by handles into #Strings heap of any assembly.
+    uint32_t findTypeDef(const std::string& typeNamespace, const std::string& typeName, uint32_t enclosingType = 0) const;
+    uint32_t findTypeDef(const StringHeap& heap, StringHandle typeNamespace, StringHandle typeName, uint32_t enclosingType = 0) const;
+
+    // One-based row of type forwarder or exported type, enclosing type is a row of ExportedType table as well.
+    uint32_t findExportedType(const std::string& typeNamespace, const std::string& typeName, uint32_t enclosingType = 0) const;
+    uint32_t findExportedType(const StringHeap& heap, StringHandle typeNamespace, StringHandle typeName, uint32_t enclosingType = 0) const;
+
+    // One-based rows [first, last) of metadata table
+    struct RowRange {
+        uint32_t first;
+        uint32_t last;
+    };
+
+    // Fields and methods of one-based TypeDef row, parameters of one-based MethodDef row
+    RowRange getFields(uint32_t typeDefRow) const;
+    RowRange getMethods(uint32_t typeDefRow) const;
+    RowRange getParams(uint32_t methodDefRow) const;
+
+    // One-based row of the TypeDef or MethodDef which owns the member row, zero if there is no owner.
+    uint32_t getFieldOwner(uint32_t fieldRow) const;
+    uint32_t getMethodOwner(uint32_t methodDefRow) const;
+    uint32_t getParamOwner(uint32_t paramRow) const;
+
+    // Rows of tables which ECMA-335 requires to be sorted by their parent column, found by binary search. Parents
+    //  are given as one-based row and table of the coded index, range is empty if parent has no rows.
+    RowRange getCustomAttributes(const std::pair<uint32_t, CLIMetadataTableItem>& parent) const;
+    RowRange getConstants(const std::pair<uint32_t, CLIMetadataTableItem>& parent) const;
+    RowRange getMethodSemantics(const std::pair<uint32_t, CLIMetadataTableItem>& association) const;
+    RowRange getImplMaps(const std::pair<uint32_t, CLIMetadataTableItem>& memberForwarded) const;
+    RowRange getGenericParams(const std::pair<uint32_t, CLIMetadataTableItem>& owner) const;
+    // Same for the tables with simple index of TypeDef or FieldDef row
+    RowRange getFieldRVAs(uint32_t fieldRow) const;
+    RowRange getNestedClasses(uint32_t nestedClassRow) const;
+    // Interfaces and explicit overrides of one-based TypeDef row
+    RowRange getInterfaceImpls(uint32_t typeDefRow) const;
+    RowRange getMethodImpls(uint32_t typeDefRow) const;
 
 private:
     // Reader instance
@@ -90,19 +163,76 @@ private:
     // Image header
     ImageFileHeader fileHeader;
 
+    // Loading options
+    AssemblyLoadOptions loadOptions;
+
+    StringHeap strings;
+    std::shared_ptr<const NameTable> names;
+
+    // Snapshot which the tables were loaded from, if any
+    std::shared_ptr<const MetadataSnapshot> snapshot;
+
+    // Indexes of types by name, they are built on first lookup.
+    struct TypeIndexes {
+        std::once_flag built;
+        TypeNameIndex typeDefs;
+        TypeNameIndex exportedTypes;
+    };
+    std::shared_ptr<TypeIndexes> typeIndexes;
+
+    // Member lists of owners and owners of members, they are built on first use.
+    struct MemberIndexes {
+        std::once_flag built;
+        // Members of one-based owner row n are [lists[n - 1], lists[n]), the last item is the end of member table.
+        std::vector<uint32_t> fieldLists;
+        std::vector<uint32_t> methodLists;
+        std::vector<uint32_t> paramLists;
+        // Owner rows by zero-based member index
+        std::vector<uint32_t> fieldOwners;
+        std::vector<uint32_t> methodOwners;
+        std::vector<uint32_t> paramOwners;
+    };
+    std::shared_ptr<MemberIndexes> memberIndexes;
+
+    // Method bodies by MethodDef index, each of them is parsed on first use.
+    struct MethodBodies {
+        std::unique_ptr<std::atomic<const MethodBody*>[]> slots;
+        uint32_t count = 0;
+
+        MethodBodies() = default;
+        MethodBodies(uint32_t methodsCount);
+        // Copy doesn't share parsed bodies, they will be parsed again on demand.
+        MethodBodies(const MethodBodies& other) : MethodBodies(other.count) {}
+        MethodBodies(MethodBodies&& other) noexcept { swap(other); }
+        MethodBodies& operator=(MethodBodies other) noexcept { swap(other); return *this; }
+        void swap(MethodBodies& other) noexcept;
+        ~MethodBodies() noexcept;
+    } methodBodies;
+
     void InitAssembly(); // called from constructor
 
+    // Independent pieces of eager loading work
+    typedef std::vector<std::function<void()> > DecodeTasks;
+
     template<typename T1>
-    void FillTable(MetadataRowsReader& mr, std::vector<T1>& table) {
-        table.reserve(mr.mapTableLength[T1::tableID]);
-        for (uint32_t n = 0; n < mr.mapTableLength[T1::tableID]; ++n) {
-            T1 row(mr);
-            table.push_back(row);
+    void FillTable(const std::shared_ptr<const MetadataTablesLayout>& layout, MetadataTable<T1>& table, DecodeTasks& tasks) {
+        table = MetadataTable<T1>(layout);
+        if (!loadOptions.lazyTables) {
+            const auto* filled = &table;
+            for (uint32_t n = 0; n < table.getChunksCount(); ++n) {
+                tasks.push_back([filled, n] { filled->materializeChunk(n); });
+            }
         }
     }
 
     void FillTables();
-    void loadMethodBody(uint32_t index);
+    void RunDecodeTasks(const DecodeTasks& tasks) const;
+    void BuildTypeIndexes() const;
+    void BuildMemberIndexes() const;
+    bool MakeTypeKey(const char* typeNamespace, uint32_t namespaceLength, const char* typeName, uint32_t nameLength, uint32_t enclosingType, TypeNameIndex::Key& key) const;
+    void SaveSnapshot(const std::string& path, const MetadataSnapshot::Key& key, const MetadataTablesLayout& layout) const;
+    MethodBody* loadMethodBody(uint32_t index) const;
+    MetadataSnapshot::MethodEntry readMethodEntry(uint32_t index, std::vector<ExceptionClause>& clauses) const;
 };
 
 #endif
@@ -0,0 +1,163 @@
+#include <cstring>
+
+#include "AssemblyIdentity.hxx"
+#include "AssemblyData.hxx"
+#include "EnumCasting.hxx"
+
+using namespace std;
+
+// SHA-1 as described in FIPS 180-4, it's only needed for public key tokens.
+static void sha1(const uint8_t* data, size_t length, uint8_t (&digest)[20]) {
+    uint32_t h[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+    auto rotl = [](uint32_t x, uint32_t n) { return (x << n) | (x >> (32 - n)); };
+
+    // Message is padded by 0x80 byte, zeros and bit length, up to the multiple of 64 bytes.
+    const size_t blocksCount = (length + 9 + 63) / 64;
+    for (size_t block = 0; block < blocksCount; ++block) {
+        uint8_t chunk[64];
+        for (size_t n = 0; n < 64; ++n) {
+            const size_t position = block * 64 + n;
+            if (position < length) {
+                chunk[n] = data[position];
+            } else if (position == length) {
+                chunk[n] = 0x80;
+            } else if (block == blocksCount - 1 && n >= 56) {
+                chunk[n] = static_cast<uint8_t>((uint64_t(length) * 8) >> ((63 - n) * 8));
+            } else {
+                chunk[n] = 0;
+            }
+        }
+
+        uint32_t w[80];
+        for (uint32_t n = 0; n < 16; ++n) {
+            w[n] = (uint32_t(chunk[n * 4]) << 24) | (uint32_t(chunk[n * 4 + 1]) << 16) | (uint32_t(chunk[n * 4 + 2]) << 8) | chunk[n * 4 + 3];
+        }
+        for (uint32_t n = 16; n < 80; ++n) {
+            w[n] = rotl(w[n - 3] ^ w[n - 8] ^ w[n - 14] ^ w[n - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (uint32_t n = 0; n < 80; ++n) {
+            uint32_t f, k;
+            if (n < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5a827999;
+            } else if (n < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            } else if (n < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8f1bbcdc;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+            auto temp = rotl(a, 5) + f + e + k + w[n];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (uint32_t n = 0; n < 20; ++n) {
+        digest[n] = static_cast<uint8_t>(h[n / 4] >> ((3 - n % 4) * 8));
+    }
+}
+
+static void setVersion(uint16_t (&result)[4], const vector<uint16_t>& version) {
+    for (size_t n = 0; n < 4; ++n) {
+        result[n] = n < version.size() ? version[n] : 0;
+    }
+}
+
+AssemblyIdentity::AssemblyIdentity(const string& Name, const vector<uint16_t>& Version) : name(Name.c_str()), nameLength(static_cast<uint32_t>(Name.size())) {
+    setVersion(version, Version);
+}
+
+AssemblyIdentity AssemblyIdentity::ofAssembly(const AssemblyData& assembly) {
+    const auto& strings = assembly.getStrings();
+    const auto& row = assembly.cliMetaDataTables._Assembly[0];
+
+    AssemblyIdentity result;
+    result.name = strings.c_str(row.name);
+    result.nameLength = strings.length(row.name);
+    result.culture = strings.c_str(row.culture);
+    result.cultureLength = strings.length(row.culture);
+    setVersion(result.version, row.version);
+    result.publicKeyToken = getPublicKeyToken(row.publicKey);
+    return result;
+}
+
+AssemblyIdentity AssemblyIdentity::ofReference(const AssemblyData& assembly, const AssemblyRefRow& reference) {
+    const auto& strings = assembly.getStrings();
+
+    AssemblyIdentity result;
+    result.name = strings.c_str(reference.name);
+    result.nameLength = strings.length(reference.name);
+    result.culture = strings.c_str(reference.culture);
+    result.cultureLength = strings.length(reference.culture);
+    setVersion(result.version, reference.version);
+
+    // Reference holds either the full public key or its token.
+    if ((reference.flags & _u(AssemblyRow::AssemblyFlags::PublicKey)) != 0) {
+        result.publicKeyToken = getPublicKeyToken(reference.publicKeyOrToken);
+    } else if (reference.publicKeyOrToken.size() == 8) {
+        for (auto byte : reference.publicKeyOrToken) {
+            result.publicKeyToken = (result.publicKeyToken << 8) | byte;
+        }
+    }
+    return result;
+}
+
+uint64_t AssemblyIdentity::getPublicKeyToken(const vector<uint8_t>& publicKey) {
+    if (publicKey.empty()) {
+        return 0;
+    }
+
+    uint8_t digest[20];
+    sha1(publicKey.data(), publicKey.size(), digest);
+
+    uint64_t result = 0;
+    for (uint32_t n = 0; n < 8; ++n) {
+        result = (result << 8) | digest[19 - n];
+    }
+    return result;
+}
+
+AssemblyIdentity AssemblyIdentity::withoutToken() const {
+    AssemblyIdentity result(*this);
+    result.publicKeyToken = 0;
+    return result;
+}
+
+size_t AssemblyIdentity::hash() const {
+    // FNV-1a over name, culture, version and public key token
+    uint64_t result = 14695981039346656037ULL;
+    auto mix = [&result](const uint8_t* bytes, size_t length) {
+        for (size_t n = 0; n < length; ++n) {
+            result = (result ^ bytes[n]) * 1099511628211ULL;
+        }
+    };
+    mix(reinterpret_cast<const uint8_t*>(name), nameLength);
+    mix(reinterpret_cast<const uint8_t*>(culture), cultureLength);
+    mix(reinterpret_cast<const uint8_t*>(version), sizeof(version));
+    mix(reinterpret_cast<const uint8_t*>(&publicKeyToken), sizeof(publicKeyToken));
+    return static_cast<size_t>(result ^ (result >> 32));
+}
+
+bool AssemblyIdentity::operator==(const AssemblyIdentity& other) const {
+    return nameLength == other.nameLength && cultureLength == other.cultureLength
+        && memcmp(version, other.version, sizeof(version)) == 0
+        && memcmp(name, other.name, nameLength) == 0
+        && memcmp(culture, other.culture, cultureLength) == 0
+        && publicKeyToken == other.publicKeyToken;
+}
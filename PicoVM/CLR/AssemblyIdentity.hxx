@@ -0,0 +1,49 @@
+#ifndef __ASSEMBLYIDENTITY_HXX__
+#define __ASSEMBLYIDENTITY_HXX__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class AssemblyData;
+struct AssemblyRefRow;
+
+// Identity of assembly: simple name, version, culture and public key token. Strings are not copied, they point
+//  into the #Strings heap of assembly or into the caller's string, so identity of the reference is made without
+//  allocations. Identity must not outlive the storage of its strings.
+struct AssemblyIdentity {
+    const char* name = "";
+    uint32_t nameLength = 0;
+    // Empty for culture neutral assemblies
+    const char* culture = "";
+    uint32_t cultureLength = 0;
+    uint16_t version[4] = {};
+    // Zero if assembly isn't strong-named
+    uint64_t publicKeyToken = 0;
+
+    AssemblyIdentity() = default;
+    // Culture neutral identity without public key token
+    AssemblyIdentity(const std::string& Name, const std::vector<uint16_t>& Version);
+
+    // Identity of the loaded assembly, its public key token is calculated from the public key.
+    static AssemblyIdentity ofAssembly(const AssemblyData& assembly);
+    // Identity which is required by the AssemblyRef row of the assembly.
+    static AssemblyIdentity ofReference(const AssemblyData& assembly, const AssemblyRefRow& reference);
+
+    // Last 8 bytes of SHA-1 hash of the public key in reverse order, packed as big-endian integer.
+    static uint64_t getPublicKeyToken(const std::vector<uint8_t>& publicKey);
+
+    // Identity without public key token, so the reference without the token can be bound to strong-named assembly.
+    AssemblyIdentity withoutToken() const;
+
+    // Exact comparison, public key tokens must be equal.
+    size_t hash() const;
+    bool operator==(const AssemblyIdentity& other) const;
+};
+
+struct AssemblyIdentityHash {
+    size_t operator()(const AssemblyIdentity& identity) const { return identity.hash(); }
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstring>
 
 #include "AssemblyReader.hxx"
 #include "utf8.h"
@@ -6,7 +7,11 @@
 
 using namespace std;
 
-AssemblyReader::AssemblyReader(const vector<uint8_t>& pdata) : data(pdata)
+AssemblyReader::AssemblyReader(const vector<uint8_t>& pdata) : AssemblyReader(MappedImage::fromBytes(pdata))
+{
+}
+
+AssemblyReader::AssemblyReader(shared_ptr<const MappedImage> pimage) : image(pimage), data(pimage->data())
 {
 reset();
 }
@@ -17,23 +22,24 @@ AssemblyReader& AssemblyReader::operator=(const AssemblyReader& other) {
 }
 
 void AssemblyReader::swap(AssemblyReader& other) noexcept {
-    data.swap(other.data);
+    image.swap(other.image);
+    ::swap(data, other.data);
     ::swap(pc, other.pc);
 }
 
 void AssemblyReader::seek(uint32_t offset)
 {
-    pc = next(data.begin(), offset);
+    pc = data + offset;
 }
 
 void AssemblyReader::reset()
 {
-    pc = data.begin();
+    pc = data;
 }
 
 uint32_t AssemblyReader::tell()
 {
-    return static_cast<uint32_t>(distance(data.begin(), pc));
+    return static_cast<uint32_t>(pc - data);
 }
 
 const uint8_t& AssemblyReader::operator[](uint32_t offset) const
@@ -41,13 +47,32 @@ const uint8_t& AssemblyReader::operator[](uint32_t offset) const
     return data[offset];
 }
 
+uint32_t AssemblyReader::size() const
+{
+    return image ? image->size() : 0;
+}
+
+string AssemblyReader::path() const
+{
+    return image ? image->path() : string();
+}
+
+void AssemblyReader::advise(uint32_t offset, uint32_t length, MappedImage::Advice advice) const
+{
+    if (image) {
+        image->advise(offset, length, advice);
+    }
+}
+
 uint8_t  AssemblyReader::read_uint8() {
     return *(pc++);
 }
 
 uint16_t AssemblyReader::read_uint16()
 {
-    return static_cast<uint16_t>(*(pc++) | *(pc++) << 8);
+    auto value = static_cast<uint16_t>(pc[0] | pc[1] << 8);
+    pc += 2;
+    return value;
 }
 
 uint16_t AssemblyReader::read_uint16(uint32_t offset) const
@@ -57,40 +82,45 @@ uint16_t AssemblyReader::read_uint16(uint32_t offset) const
 
 uint32_t AssemblyReader::read_uint32()
 {
+    uint32_t value;
+    memcpy(&value, pc, sizeof(value));
     pc += 4;
-    return *reinterpret_cast<uint32_t*>(&(*(pc - 4)));
+    return value;
 }
 
 uint32_t AssemblyReader::read_uint32(uint32_t offset) const
 {
-    auto it = next(data.cbegin(), offset);
-    return static_cast<uint32_t>(*(it++) | *(it++) << 8 | *(it++) << 16 | *(it++) << 24);
+    auto it = data + offset;
+    return static_cast<uint32_t>(it[0] | it[1] << 8 | it[2] << 16 | it[3] << 24);
 }
 
 uint64_t AssemblyReader::read_uint64()
 {
+    uint64_t value;
+    memcpy(&value, pc, sizeof(value));
     pc += 8;
-    return *reinterpret_cast<uint64_t*>(&(*(pc - 8)));
+    return value;
 }
 
 uint64_t AssemblyReader::read_uint64(uint32_t offset) const
 {
-    auto it = next(data.cbegin(), offset);
-    return *reinterpret_cast<const uint64_t*>(&(*it));
+    uint64_t value;
+    memcpy(&value, data + offset, sizeof(value));
+    return value;
 }
 
 uint32_t AssemblyReader::read_asciiz(string& result, uint32_t limit)
 {
-    uint32_t offset = static_cast<uint32_t>(distance(data.begin(), pc));
+    uint32_t offset = tell();
     uint32_t read = read_asciiz(result, offset, limit);
-    pc = next(pc, read);
+    pc += read;
     return read;
 }
 
 uint32_t AssemblyReader::read_asciiz(string& result, uint32_t offset, uint32_t limit) const
 {
-    auto start_it = next(data.cbegin(), offset);
-    auto end_it = find(start_it, data.cend(), 0);
+    auto start_it = data + offset;
+    auto end_it = find(start_it, data + size(), 0);
     if (static_cast<uint32_t>(distance(start_it, end_it)) >= limit) {
         end_it = next(start_it, limit);
     }
@@ -101,16 +131,16 @@ uint32_t AssemblyReader::read_asciiz(string& result, uint32_t offset, uint32_t l
 
 uint32_t AssemblyReader::read_utf8z(u16string& result, uint32_t limit)
 {
-    uint32_t offset = static_cast<uint32_t>(distance(data.begin(), pc));
+    uint32_t offset = tell();
     uint32_t read = read_utf8z(result, offset, limit);
-    pc = next(pc, read);
+    pc += read;
     return read;
 }
 
 uint32_t AssemblyReader::read_utf8z(u16string& result, uint32_t offset, uint32_t limit) const
 {
-    auto start_it = next(data.cbegin(), offset);
-    auto end_it = find(start_it, data.cend(), 0);
+    auto start_it = data + offset;
+    auto end_it = find(start_it, data + size(), 0);
     if (static_cast<uint32_t>(distance(start_it, end_it)) >= limit) {
         end_it = next(start_it, limit);
     }
@@ -121,29 +151,28 @@ uint32_t AssemblyReader::read_utf8z(u16string& result, uint32_t offset, uint32_t
 
 void AssemblyReader::read_guid(Guid& result)
 {
-    result = Guid(pc, next(pc, 16));
-    pc = next(pc, 16);
+    result = Guid(pc);
+    pc += 16;
 }
 
 void AssemblyReader::read_guid(Guid& result, uint32_t offset) const
 {
-    auto start_it = next(data.cbegin(), offset);
-    result = Guid(start_it, next(start_it, 16));
+    result = Guid(data + offset);
 }
 
 void AssemblyReader::read_bytes(vector<uint8_t>& result, uint32_t length)
 {
     result.clear();
     auto start_it = pc;
-    pc = next(pc, length);
+    pc += length;
     result.assign(start_it, pc);
 }
 
 void AssemblyReader::read_bytes(vector<uint8_t>& result, uint32_t offset, uint32_t length) const
 {
     result.clear();
-    auto start_it = next(data.cbegin(), offset);
-    result.assign(start_it, next(start_it, length));
+    auto start_it = data + offset;
+    result.assign(start_it, start_it + length);
 }
 
 uint32_t AssemblyReader::read_varsize(uint32_t& code)
@@ -164,12 +193,12 @@ uint32_t AssemblyReader::read_varsize(uint32_t& code)
         //We don't recognize this encoding
         throw runtime_error("Invalid signature");
     }
-    return static_cast<uint32_t>(distance(it, pc));
+    return static_cast<uint32_t>(pc - it);
 }
 
 uint32_t AssemblyReader::read_varsize(uint32_t& code, uint32_t offset) const
 {
-    auto it_start = next(data.cbegin(), offset);
+    auto it_start = data + offset;
     auto it = it_start;
     uint8_t b1 = *(it++);
     if ((b1 & 0x80) == 0) {
@@ -216,22 +245,22 @@ uint32_t AssemblyReader::read_varsize(uint32_t& code, const vector<uint8_t>& _da
 
 void AssemblyReader::read_ntheader32(ImageNTHeader32& header32, uint32_t offset)
 {
-    header32 = *reinterpret_cast<ImageNTHeader32*>(&(*(data.begin() + offset)));
+    memcpy(&header32, data + offset, sizeof(header32));
 }
 
 void AssemblyReader::read_ntheader64(ImageNTHeader64& header64, uint32_t offset)
 {
-    header64 = *reinterpret_cast<ImageNTHeader64*>(&(*(data.begin() + offset)));
+    memcpy(&header64, data + offset, sizeof(header64));
 }
 
 void AssemblyReader::read_sectionheader(ImageSectionHeader& sectionheader, uint32_t offset)
 {
-    sectionheader = *reinterpret_cast<ImageSectionHeader*>(&(*(data.begin() + offset)));
+    memcpy(&sectionheader, data + offset, sizeof(sectionheader));
 }
 
 void AssemblyReader::read_cliheader(CLIHeader& cliheader, uint32_t offset)
 {
-    cliheader = *reinterpret_cast<CLIHeader*>(&(*(data.begin() + offset)));
+    memcpy(&cliheader, data + offset, sizeof(cliheader));
 }
 
 void AssemblyReader::read_directory(ImageDataDirectory& directory)
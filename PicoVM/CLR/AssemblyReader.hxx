@@ -2,18 +2,23 @@
 #define ASSEMBLYREADER_HXX
 #include <vector>
 #include <cstdint>
+#include <memory>
+#include <string>
 
 #include "crossguid/guid.hxx"
+#include "MappedImage.hxx"
 #include "ImageNTHeader32.hxx"
 #include "ImageNTHeader64.hxx"
 #include "ImageSectionHeader.hxx"
 #include "CLIHeader.hxx"
 
+// Reader is a cursor over read-only image, copies of reader are sharing the same image data.
 class AssemblyReader
 {
 public:
     AssemblyReader() = default;
     AssemblyReader(const std::vector<uint8_t>& data);
+    AssemblyReader(std::shared_ptr<const MappedImage> image);
     AssemblyReader(const AssemblyReader& other) = default;
     AssemblyReader(AssemblyReader&& other) = default;
 
@@ -29,6 +34,15 @@ public:
     // [] operator for better readability
     const uint8_t& operator[](uint32_t offset) const;
 
+    // Image size
+    uint32_t size() const;
+
+    // Path of the mapped file, empty for images in memory buffers
+    std::string path() const;
+
+    // Pass access pattern hint for the given range of image
+    void advise(uint32_t offset, uint32_t length, MappedImage::Advice advice) const;
+
     // Read unsigned integer
     uint8_t  read_uint8();
     uint16_t read_uint16();
@@ -85,8 +99,9 @@ public:
     void read_directory(ImageDataDirectory& directory, uint32_t offset) const;
 
 private:
-    std::vector<uint8_t> data;
-    std::vector<uint8_t>::iterator pc;
+    std::shared_ptr<const MappedImage> image;
+    const uint8_t* data = nullptr;
+    const uint8_t* pc = nullptr;
 };
 
 
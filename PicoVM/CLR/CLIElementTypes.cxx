@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <stdexcept>
 #include "CLIElementTypes.hxx"
 
 using namespace std;
@@ -2,6 +2,7 @@
 #define __CLIElementTypeS_HXX__
 #include <cstdint>
 #include <map>
+#include <string>
 
 enum struct CLIElementType : uint8_t {
     ELEMENT_TYPE_END=0x00, // Marks end of a list
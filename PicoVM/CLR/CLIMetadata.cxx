@@ -16,6 +16,19 @@ uint32_t CLIMetadata::getStreamOffset(const string& name) const
     return numeric_limits<uint32_t>::max();
 }
 
+// Get size of metadata stream, zero if there is no such stream.
+uint32_t CLIMetadata::getStreamSize(const string& name) const
+{
+    for (const auto& stream : streams) {
+        const auto& streamName = stream.name;
+        if (streamName.size() == name.size() && equal(begin(streamName), end(streamName), begin(name))) {
+            return stream.size;
+        }
+    }
+
+    return 0;
+}
+
 CLIMetadata::~CLIMetadata() noexcept
 {
 // This routine fix next warning
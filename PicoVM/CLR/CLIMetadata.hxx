@@ -18,6 +18,7 @@ struct CLIMetadata {
     uint16_t streamsCount = 0;
 
     uint32_t getStreamOffset(const std::string& name) const;
+    uint32_t getStreamSize(const std::string& name) const;
 
     ~CLIMetadata() noexcept;
 };
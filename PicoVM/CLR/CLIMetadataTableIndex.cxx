@@ -1,5 +1,6 @@
 #include "CLIMetadataTableIndex.hxx"
 #include <algorithm>
+#include <stdexcept>
 
 using namespace std;
 
@@ -12,3 +13,129 @@ string getTableName(const CLIMetadataTableItem& value)
 
     return (*it).second;
 }
+
+const vector<CLIMetadataTableItem>& getCodedIndexTables(CLICodedIndex codedIndex)
+{
+    switch (codedIndex) {
+    case CLICodedIndex::ResolutionScope: return resolutionScopeIndex;
+    case CLICodedIndex::TypeDefOrRef: return typeDefOrRef;
+    case CLICodedIndex::MemberRefParent: return memberRefParent;
+    case CLICodedIndex::HasConstant: return hasConstant;
+    case CLICodedIndex::HasCustomAttribute: return hasCustomAttribute;
+    case CLICodedIndex::CustomAttributeType: return customAttributeType;
+    case CLICodedIndex::HasFieldMarshall: return hasFieldMarshall;
+    case CLICodedIndex::HasDeclSecurity: return hasDeclSecurity;
+    case CLICodedIndex::HasSemantics: return hasSemantics;
+    case CLICodedIndex::MethodDefOrRef: return methodDefOrRef;
+    case CLICodedIndex::MemberForwarded: return memberForwardedIndex;
+    case CLICodedIndex::Implementation: return implementationIndex;
+    case CLICodedIndex::TypeOrMethodDef: return typeOrMethodDef;
+    default:
+        throw runtime_error("Incorrect coded index");
+    }
+}
+
+uint32_t getCodedIndexTag(CLICodedIndex codedIndex, CLIMetadataTableItem table)
+{
+    const auto& tables = getCodedIndexTables(codedIndex);
+    auto it = find(tables.begin(), tables.end(), table);
+    if (it == tables.end() || table == CLIMetadataTableItem::Unknown) {
+        throw runtime_error("Table can't be referenced by this coded index");
+    }
+    return static_cast<uint32_t>(it - tables.begin());
+}
+
+using ck = CLIMetadataColumn::Kind;
+using tt = CLIMetadataTableItem;
+using ci = CLICodedIndex;
+
+static CLIMetadataColumn column(CLIMetadataColumn::Kind kind) {
+    return { kind, tt::Unknown, ci::ResolutionScope };
+}
+
+static CLIMetadataColumn column(CLIMetadataTableItem table) {
+    return { ck::Index, table, ci::ResolutionScope };
+}
+
+static CLIMetadataColumn column(CLICodedIndex coded) {
+    return { ck::CodedIndex, tt::Unknown, coded };
+}
+
+const map<CLIMetadataTableItem, vector<CLIMetadataColumn> > cliMetadataTableColumns = {
+    // Generation, Name, Mvid, EncId, EncBaseId
+    { tt::Module, { column(ck::UInt16), column(ck::String), column(ck::Guid), column(ck::Guid), column(ck::Guid) } },
+    // ResolutionScope, TypeName, TypeNamespace
+    { tt::TypeRef, { column(ci::ResolutionScope), column(ck::String), column(ck::String) } },
+    // Flags, TypeName, TypeNamespace, Extends, FieldList, MethodList
+    { tt::TypeDef, { column(ck::UInt32), column(ck::String), column(ck::String), column(ci::TypeDefOrRef), column(tt::FieldDef), column(tt::MethodDef) } },
+    // Flags, Name, Signature
+    { tt::FieldDef, { column(ck::UInt16), column(ck::String), column(ck::Blob) } },
+    // RVA, ImplFlags, Flags, Name, Signature, ParamList
+    { tt::MethodDef, { column(ck::UInt32), column(ck::UInt16), column(ck::UInt16), column(ck::String), column(ck::Blob), column(tt::ParamDef) } },
+    // Flags, Sequence, Name
+    { tt::ParamDef, { column(ck::UInt16), column(ck::UInt16), column(ck::String) } },
+    // Class, Interface
+    { tt::InterfaceImpl, { column(tt::TypeDef), column(ci::TypeDefOrRef) } },
+    // Class, Name, Signature
+    { tt::MemberRef, { column(ci::MemberRefParent), column(ck::String), column(ck::Blob) } },
+    // Type (with padding byte), Parent, Value
+    { tt::Constant, { column(ck::UInt16), column(ci::HasConstant), column(ck::Blob) } },
+    // Parent, Type, Value
+    { tt::CustomAttribute, { column(ci::HasCustomAttribute), column(ci::CustomAttributeType), column(ck::Blob) } },
+    // Parent, NativeType
+    { tt::FieldMarshal, { column(ci::HasFieldMarshall), column(ck::Blob) } },
+    // Action, Parent, PermissionSet
+    { tt::DeclSecurity, { column(ck::UInt16), column(ci::HasDeclSecurity), column(ck::Blob) } },
+    // PackingSize, ClassSize, Parent
+    { tt::ClassLayout, { column(ck::UInt16), column(ck::UInt32), column(tt::TypeDef) } },
+    // Offset, Field
+    { tt::FieldLayout, { column(ck::UInt32), column(tt::FieldDef) } },
+    // Signature
+    { tt::StandAloneSig, { column(ck::Blob) } },
+    // Parent, EventList
+    { tt::EventMap, { column(tt::TypeDef), column(tt::Event) } },
+    // EventFlags, Name, EventType
+    { tt::Event, { column(ck::UInt16), column(ck::String), column(ci::TypeDefOrRef) } },
+    // Parent, PropertyList
+    { tt::PropertyMap, { column(tt::TypeDef), column(tt::Property) } },
+    // Flags, Name, Type
+    { tt::Property, { column(ck::UInt16), column(ck::String), column(ck::Blob) } },
+    // Semantics, Method, Association
+    { tt::MethodSemantics, { column(ck::UInt16), column(tt::MethodDef), column(ci::HasSemantics) } },
+    // Class, MethodBody, MethodDeclaration
+    { tt::MethodImpl, { column(tt::TypeDef), column(ci::MethodDefOrRef), column(ci::MethodDefOrRef) } },
+    // Name
+    { tt::ModuleRef, { column(ck::String) } },
+    // Signature
+    { tt::TypeSpec, { column(ck::Blob) } },
+    // MappingFlags, MemberForwarded, ImportName, ImportScope
+    { tt::ImplMap, { column(ck::UInt16), column(ci::MemberForwarded), column(ck::String), column(tt::ModuleRef) } },
+    // RVA, Field
+    { tt::FieldRVA, { column(ck::UInt32), column(tt::FieldDef) } },
+    // HashAlgId, MajorVersion, MinorVersion, BuildNumber, RevisionNumber, Flags, PublicKey, Name, Culture
+    { tt::Assembly, { column(ck::UInt32), column(ck::UInt16), column(ck::UInt16), column(ck::UInt16), column(ck::UInt16), column(ck::UInt32), column(ck::Blob), column(ck::String), column(ck::String) } },
+    // Processor
+    { tt::AssemblyProcessor, { column(ck::UInt32) } },
+    // OSPlatformID, OSMajorVersion, OSMinorVersion
+    { tt::AssemblyOS, { column(ck::UInt32), column(ck::UInt32), column(ck::UInt32) } },
+    // MajorVersion, MinorVersion, BuildNumber, RevisionNumber, Flags, PublicKeyOrToken, Name, Culture, HashValue
+    { tt::AssemblyRef, { column(ck::UInt16), column(ck::UInt16), column(ck::UInt16), column(ck::UInt16), column(ck::UInt32), column(ck::Blob), column(ck::String), column(ck::String), column(ck::Blob) } },
+    // Processor, AssemblyRef
+    { tt::AssemblyRefProcessor, { column(ck::UInt32), column(tt::AssemblyRef) } },
+    // OSPlatformID, OSMajorVersion, OSMinorVersion, AssemblyRef
+    { tt::AssemblyRefOS, { column(ck::UInt32), column(ck::UInt32), column(ck::UInt32), column(tt::AssemblyRef) } },
+    // Flags, Name, HashValue
+    { tt::File, { column(ck::UInt32), column(ck::String), column(ck::Blob) } },
+    // Flags, TypeDefId, TypeName, TypeNamespace, Implementation
+    { tt::ExportedType, { column(ck::UInt32), column(ck::UInt32), column(ck::String), column(ck::String), column(ci::Implementation) } },
+    // Offset, Flags, Name, Implementation
+    { tt::ManifestResource, { column(ck::UInt32), column(ck::UInt32), column(ck::String), column(ci::Implementation) } },
+    // NestedClass, EnclosingClass
+    { tt::NestedClass, { column(tt::TypeDef), column(tt::TypeDef) } },
+    // Number, Flags, Owner, Name
+    { tt::GenericParam, { column(ck::UInt16), column(ck::UInt16), column(ci::TypeOrMethodDef), column(ck::String) } },
+    // Method, Instantiation
+    { tt::MethodSpec, { column(ci::MethodDefOrRef), column(ck::Blob) } },
+    // Owner, Constraint
+    { tt::GenericParamConstraint, { column(tt::GenericParam), column(ci::TypeDefOrRef) } },
+};
@@ -1,5 +1,6 @@
 #ifndef CLIMETA_HXX
 #define CLIMETA_HXX
+#include <cstdint>
 #include <string>
 #include <map>
 #include <vector>
@@ -177,5 +178,53 @@ const std::vector<CLIMetadataTableItem> implementationIndex = { CLIMetadataTable
 // MethodDef      1
 const std::vector<CLIMetadataTableItem> typeOrMethodDef = { CLIMetadataTableItem::TypeDef, CLIMetadataTableItem::MethodDef };
 
+// Kinds of coded indexes, each of them is encoding a row of one of the tables listed above.
+enum struct CLICodedIndex : uint8_t {
+    ResolutionScope = 0,
+    TypeDefOrRef = 1,
+    MemberRefParent = 2,
+    HasConstant = 3,
+    HasCustomAttribute = 4,
+    CustomAttributeType = 5,
+    HasFieldMarshall = 6,
+    HasDeclSecurity = 7,
+    HasSemantics = 8,
+    MethodDefOrRef = 9,
+    MemberForwarded = 10,
+    Implementation = 11,
+    TypeOrMethodDef = 12
+};
+
+// Number of coded index kinds
+const uint32_t cliCodedIndexCount = 13;
+
+// Tables which are encoded by coded index, in the order of their tags.
+const std::vector<CLIMetadataTableItem>& getCodedIndexTables(CLICodedIndex codedIndex);
+
+// Tag of the table in coded index, throws if coded index can't refer to this table.
+uint32_t getCodedIndexTag(CLICodedIndex codedIndex, CLIMetadataTableItem table);
+
+// Description of metadata table column
+struct CLIMetadataColumn {
+    enum struct Kind : uint8_t {
+        UInt16 = 0,     // 2-byte constant
+        UInt32 = 1,     // 4-byte constant
+        String = 2,     // Index into #Strings heap
+        Guid = 3,       // Index into #GUID heap
+        Blob = 4,       // Index into #Blob heap
+        Index = 5,      // Index into another table
+        CodedIndex = 6  // Coded index into one of several tables
+    };
+
+    Kind kind;
+    // Target table for simple indexes
+    CLIMetadataTableItem table;
+    // Target tables for coded indexes
+    CLICodedIndex coded;
+};
+
+// Columns of metadata tables, in the order of their physical layout.
+extern const std::map<CLIMetadataTableItem, std::vector<CLIMetadataColumn> > cliMetadataTableColumns;
+
 
 #endif
@@ -1,17 +1,37 @@
 #include <sstream>
 #include <iomanip>
+#include <stdexcept>
+#include <cstring>
+#include <type_traits>
 
 #include "EnumCasting.hxx"
 #include "CLIMetadataTableRows.hxx"
+#include "ColumnKernels.hxx"
+#include "MetadataSnapshot.hxx"
 
 using namespace std;
 
-void MetadataRowsReader::Init(CLIMetadata& cliMetadata) {
+// Column loop for the given width of cells. Image is little endian, as well as all supported hosts.
+template<uint32_t Size>
+static void extractCells(const uint8_t* src, uint32_t rowSize, uint32_t count, uint32_t* dst, uint32_t stride) {
+    typedef typename conditional<Size == 4, uint32_t, uint16_t>::type cell_type;
+    for (uint32_t n = 0; n < count; ++n) {
+        cell_type value;
+        memcpy(&value, src, Size);
+        *dst = value;
+        src += rowSize;
+        dst += stride;
+    }
+}
+
+MetadataTablesLayout::MetadataTablesLayout(const AssemblyReader& Reader, const CLIMetadata& cliMetadata) : reader(Reader) {
     const auto metaHeaderOffset = cliMetadata.getStreamOffset({'#', '~'});
 
     stringStreamOffset = cliMetadata.getStreamOffset({'#', 'S', 't', 'r', 'i', 'n', 'g', 's'});
+    stringStreamSize = cliMetadata.getStreamSize({'#', 'S', 't', 'r', 'i', 'n', 'g', 's'});
     guidStreamOffset = cliMetadata.getStreamOffset({'#', 'G', 'U', 'I', 'D'});
     blobStreamOffset = cliMetadata.getStreamOffset({'#', 'B', 'l', 'o', 'b'});
+    signatures = make_shared<SignatureArena>(blobStreamOffset, cliMetadata.getStreamSize({'#', 'B', 'l', 'o', 'b'}));
 
     // Encodes how wide indexes into the various heaps are. Default width is 16 bit, indexes can be either 16 or 32 bit long.
     //
@@ -26,63 +46,223 @@ void MetadataRowsReader::Init(CLIMetadata& cliMetadata) {
     metaDataOffset = metaHeaderOffset + 24;
     reader.seek(metaDataOffset);
 
+    uint64_t known = 0;
     for (const auto& item : cliMetadataTableNames) {
-        auto bit = item.first;
-        if (((valid >> _u(bit)) & 1) != 0) {
-            // Load table length record for existent and valid table.
-            mapTableLength[bit] = reader.read_uint32();
-        } else {
-            mapTableLength[bit] = 0;
+        known |= uint64_t(1) << _u(item.first);
+    }
+
+    if ((valid & ~known) != 0) {
+        // Uncompressed or edit-and-continue tables, such as FieldPtr or EncLog.
+        throw runtime_error("Unsupported metadata tables layout.");
+    }
+
+    // Row counts of present tables, in the order of their identifiers.
+    for (uint32_t bit = 0; bit < maxTables; ++bit) {
+        if (((valid >> bit) & 1) != 0) {
+            tables[bit].rowCount = reader.read_uint32();
         }
     }
 
     stringsIsLong = (heapSizes & 0x01) != 0;
     guidIsLong = (heapSizes & 0x02) != 0;
     blobIsLong = (heapSizes & 0x04) != 0;
+
+    // Using 32 bit addresses if table has more than 0xffff rows.
+    for (auto& table : tables) {
+        table.isLongIndex = table.rowCount >= 0xffff;
+    }
+
+    // Coded indexes are 32 bit if the largest of tables doesn't fit into the bits which are left after the tag.
+    for (uint32_t n = 0; n < cliCodedIndexCount; ++n) {
+        auto& coded = codedIndexes[n];
+        coded.tables = &getCodedIndexTables(static_cast<CLICodedIndex>(n));
+
+        uint32_t shift = 0, bit = 1;
+        while (coded.tables->size() > bit) {
+            bit <<= 1;
+            ++shift;
+        }
+        coded.tagMask = bit - 1;
+        coded.tagBits = shift;
+
+        uint32_t max = 0;
+        for (const auto& tableID : *coded.tables) {
+            if (tableID != CLIMetadataTableItem::Unknown && max < getRowCount(tableID)) {
+                max = getRowCount(tableID);
+            }
+        }
+        coded.isLong = (uint64_t(max) << shift) >= 0xffff;
+    }
+
+    // Tables are following the row counts, one after another, in the order of their identifiers.
+    uint32_t offset = reader.tell();
+    for (const auto& item : cliMetadataTableColumns) {
+        auto& table = tables[_u(item.first)];
+        table.rowSize = 0;
+        for (const auto& column : item.second) {
+            ColumnInfo info;
+            info.offset = static_cast<uint8_t>(table.rowSize);
+            info.size = static_cast<uint8_t>(getColumnSize(column));
+            info.extract = info.size == 4 ? &extractCells<4> : &extractCells<2>;
+            table.columns.push_back(info);
+            table.rowSize += info.size;
+        }
+        table.offset = offset;
+        offset += table.rowSize * table.rowCount;
+    }
+
+    if (offset > reader.size()) {
+        throw runtime_error("Metadata tables are out of image bounds.");
+    }
+}
+
+uint32_t MetadataTablesLayout::getRowCount(CLIMetadataTableItem tableIndex) const {
+    return _u(tableIndex) < maxTables ? tables[_u(tableIndex)].rowCount : 0;
 }
 
-MetadataRowsReader::MetadataRowsReader(AssemblyReader& Reader, CLIMetadata& cliMetadata) : reader (Reader)
+uint32_t MetadataTablesLayout::getRowOffset(CLIMetadataTableItem tableIndex, uint32_t row) const {
+    const auto& table = tables[_u(tableIndex)];
+    return table.offset + table.rowSize * row;
+}
+
+bool MetadataTablesLayout::isLongIndex(CLIMetadataTableItem tableIndex) const {
+    return tables[_u(tableIndex)].isLongIndex;
+}
+
+bool MetadataTablesLayout::isLongIndex(CLICodedIndex codedIndex) const {
+    return codedIndexes[_u(codedIndex)].isLong;
+}
+
+uint32_t MetadataTablesLayout::readColumn(CLIMetadataTableItem tableIndex, uint32_t row, uint32_t column) const {
+    const auto& table = tables[_u(tableIndex)];
+    if (row >= table.rowCount || column >= table.columns.size()) {
+        throw runtime_error("Invalid metadata table cell");
+    }
+
+    const auto& info = table.columns[column];
+    auto offset = table.offset + table.rowSize * row + info.offset;
+    return info.size == 4 ? reader.read_uint32(offset) : reader.read_uint16(offset);
+}
+
+pair<uint32_t, CLIMetadataTableItem> MetadataTablesLayout::decodeIndex(CLICodedIndex codedIndex, uint32_t value) const {
+    const auto& coded = codedIndexes[_u(codedIndex)];
+    return{ value >> coded.tagBits, (*coded.tables)[value & coded.tagMask] };
+}
+
+void MetadataTablesLayout::extractColumn(CLIMetadataTableItem tableIndex, uint32_t column, uint32_t row, uint32_t count, uint32_t* dst) const {
+    const auto& table = tables[_u(tableIndex)];
+    if (column >= table.columns.size() || row > table.rowCount || count > table.rowCount - row) {
+        throw runtime_error("Invalid metadata table column");
+    }
+    if (count == 0) {
+        return;
+    }
+
+    const auto& info = table.columns[column];
+    auto offset = table.offset + table.rowSize * row + info.offset;
+    extractStridedColumn(&reader[offset], table.rowSize, info.size, count, dst, reader.size() - offset);
+}
+
+vector<uint32_t> MetadataTablesLayout::extractColumn(CLIMetadataTableItem tableIndex, uint32_t column) const {
+    vector<uint32_t> result(getRowCount(tableIndex));
+    extractColumn(tableIndex, column, 0, static_cast<uint32_t>(result.size()), result.data());
+    return result;
+}
+
+void MetadataTablesLayout::readCells(CLIMetadataTableItem tableIndex, uint32_t row, uint32_t count, uint32_t* dst) const {
+    const auto& table = tables[_u(tableIndex)];
+    if (row > table.rowCount || count > table.rowCount - row) {
+        throw runtime_error("Invalid metadata table row");
+    }
+
+    const auto columnsCount = static_cast<uint32_t>(table.columns.size());
+    if (table.cells != nullptr) {
+        if (count != 0) {
+            memcpy(dst, table.cells + row * columnsCount, count * columnsCount * sizeof(uint32_t));
+        }
+        return;
+    }
+
+    const uint8_t* rows = &reader[table.offset + table.rowSize * row];
+    for (uint32_t n = 0; n < columnsCount; ++n) {
+        const auto& column = table.columns[n];
+        column.extract(rows + column.offset, table.rowSize, count, dst + n, columnsCount);
+    }
+}
+
+void MetadataTablesLayout::attachSnapshot(shared_ptr<const MetadataSnapshot> Snapshot) {
+    snapshot = Snapshot;
+    for (uint32_t n = 0; n < maxTables; ++n) {
+        tables[n].cells = snapshot->getCells(static_cast<CLIMetadataTableItem>(n));
+    }
+}
+
+uint32_t MetadataTablesLayout::getColumnSize(const CLIMetadataColumn& column) const {
+    using ck = CLIMetadataColumn::Kind;
+
+    switch (column.kind) {
+    case ck::UInt16: return 2;
+    case ck::UInt32: return 4;
+    case ck::String: return stringsIsLong ? 4 : 2;
+    case ck::Guid: return guidIsLong ? 4 : 2;
+    case ck::Blob: return blobIsLong ? 4 : 2;
+    case ck::Index: return isLongIndex(column.table) ? 4 : 2;
+    case ck::CodedIndex: return isLongIndex(column.coded) ? 4 : 2;
+    default:
+        throw runtime_error("Invalid column kind");
+    }
+}
+
+MetadataRowsReader::MetadataRowsReader(const MetadataTablesLayout& Layout) : reader(Layout.reader), layout(Layout)
+{
+}
+
+MetadataRowsReader::~MetadataRowsReader() noexcept
 {
-    Init(cliMetadata);
 }
 
-MetadataRowsReader& MetadataRowsReader::operator=(const MetadataRowsReader& other) {
-    MetadataRowsReader(other).swap(*this);
-    return *this;
+void MetadataRowsReader::seek(CLIMetadataTableItem tableIndex, uint32_t row, uint32_t count) {
+    columnsCount = static_cast<uint32_t>(layout.tables[_u(tableIndex)].columns.size());
+    cells.resize(columnsCount * count);
+    if (count != 0) {
+        layout.readCells(tableIndex, row, count, cells.data());
+    }
+    rowStart = cell = 0;
 }
 
-void MetadataRowsReader::swap(MetadataRowsReader& other) noexcept {
-    reader.swap(other.reader);
-    mapTableLength.swap(other.mapTableLength);
-    ::swap(stringsIsLong, other.stringsIsLong);
-    ::swap(guidIsLong, other.guidIsLong);
-    ::swap(blobIsLong, blobIsLong);
-    ::swap(metaDataOffset, other.metaDataOffset);
-    ::swap(stringStreamOffset, other.stringStreamOffset);
-    ::swap(guidStreamOffset, other.guidStreamOffset);
-    ::swap(blobStreamOffset, other.blobStreamOffset);
+void MetadataRowsReader::nextRow() {
+    rowStart += columnsCount;
+    cell = rowStart;
 }
 
+uint16_t MetadataRowsReader::readUInt16() {
+    return static_cast<uint16_t>(cells[cell++]);
+}
 
-// Read 16 or 32 bit index and get the utf8 string at this index.
-void MetadataRowsReader::readString(u16string& result) {
-    uint32_t offset = stringsIsLong ? reader.read_uint32() : reader.read_uint16();
-    reader.read_utf8z(result, stringStreamOffset + offset, 0xffff);
+uint32_t MetadataRowsReader::readUInt32() {
+    return cells[cell++];
+}
+
+// Read index of the utf8 string, string itself stays in the heap.
+void MetadataRowsReader::readString(StringHandle& result) {
+    result.offset = cells[cell++];
+    if (result.offset != 0 && result.offset >= layout.stringStreamSize) {
+        throw runtime_error("Invalid #Strings heap offset");
+    }
 }
 
-// Read 16 or 32 bit index, fill result by unique ID from this index.
+// Read index, fill result by unique ID from this index.
 void MetadataRowsReader::readGuid(Guid& result) {
-    uint32_t index = guidIsLong ? reader.read_uint32() : reader.read_uint16();
+    uint32_t index = cells[cell++];
     if (index != 0) {
-        reader.read_guid(result, guidStreamOffset + ((index - 1) << 4));
+        reader.read_guid(result, layout.guidStreamOffset + ((index - 1) << 4));
     }
     // If index is zero then do nothing.
 }
 
-// Read 16 or 32 bit index, and fill the vector by binary data at this index.
+// Read index, and fill the vector by binary data at this index.
 void MetadataRowsReader::readBlob(vector<uint8_t>& result) {
-    uint32_t index = blobIsLong ? reader.read_uint32() : reader.read_uint16();
-    auto offset = blobStreamOffset + index;
+    auto offset = layout.blobStreamOffset + cells[cell++];
     uint32_t length;
     // Get length of the following data stream
     auto read = reader.read_varsize(length, offset);
@@ -90,53 +270,24 @@ void MetadataRowsReader::readBlob(vector<uint8_t>& result) {
     reader.read_bytes(result, offset + read, length);
 }
 
-// Pop 16 or 32 bit index, read binary data and parse it as a signature.
-void MetadataRowsReader::readSignature(vector<uint32_t>& result) {
-     vector<uint8_t> buffer;
-     readBlob(buffer);
-
-    // Signature is presented by a set of variable length 
-    //   integers, we're simply reading these numbers consequently.
-    uint32_t offset = 0;
-    while (offset < buffer.size()) {
-        uint32_t value;
-        uint32_t read = AssemblyReader::read_varsize(value, buffer, offset);
-        result.push_back(value);
-        offset += read;
-    }
+// Read index, signature at this index is parsed only once per assembly.
+void MetadataRowsReader::readSignature(const Signature*& result) {
+    result = layout.signatures->get(reader, layout.blobStreamOffset + cells[cell++]);
 }
 
 // Read row index.
-uint32_t MetadataRowsReader::readRowIndex(CLIMetadataTableItem tableIndex) {
-    // Using 32 bit addresses if table has more than 0xffff rows.
-    return mapTableLength[tableIndex] >= 0xffff ? reader.read_uint32() : reader.read_uint16();
+uint32_t MetadataRowsReader::readRowIndex(CLIMetadataTableItem) {
+    return cells[cell++];
 }
 
 // Decode polymorphic index
-pair<uint32_t, CLIMetadataTableItem> MetadataRowsReader::readRowIndexChoice(const vector<CLIMetadataTableItem>& tables) {
-    uint32_t max = 0;
-
-    for (const auto& tableID : tables) {
-        const auto& mapItem = mapTableLength.find(tableID);
-        if (tableID != CLIMetadataTableItem::Unknown && mapItem != mapTableLength.end() && max < (*mapItem).second) {
-            max = (*mapItem).second;
-        }
-    }
-
-    uint32_t shift = 0, bit = 1;
-    while (tables.size() > bit) {
-        bit <<= 1;
-        ++shift;
-    }
-
-    uint32_t index = (max << shift) >= 0xffff ? reader.read_uint32() : reader.read_uint16();
-
-    return{ index, tables[index & (bit - 1)] };
+pair<uint32_t, CLIMetadataTableItem> MetadataRowsReader::readRowIndexChoice(CLICodedIndex codedIndex) {
+    return layout.decodeIndex(codedIndex, cells[cell++]);
 }
 
 ModuleRow::ModuleRow(MetadataRowsReader& mr) {
     // Module generation, currently it is set to zero.
-    generation = mr.reader.read_uint16();
+    generation = mr.readUInt16();
 
     // Module name.
     mr.readString(name);
@@ -152,11 +303,11 @@ ModuleRow::ModuleRow(MetadataRowsReader& mr) {
     mr.readGuid(tmp); // endBaseId
 }
 
-string ModuleRow::str() const {
+string ModuleRow::str(const StringHeap& strings) const {
     ostringstream ss;
     ss << "Module(" << endl
        << " generation=" << dec << generation << endl
-       << " name=" << string(name.begin(), name.end()) << endl
+       << " name=" << strings.c_str(name) << endl
        << " guid=" << guid << endl
        << ")" << endl;
 
@@ -169,7 +320,7 @@ ModuleRow::~ModuleRow() noexcept
 
 TypeRefRow::TypeRefRow(MetadataRowsReader& mr) {
     // ResolutionScope coded index
-    resolutionScope = mr.readRowIndexChoice(resolutionScopeIndex);
+    resolutionScope = mr.readRowIndexChoice(CLICodedIndex::ResolutionScope);
 
     // Type name and namespace
     mr.readString(typeName);
@@ -182,12 +333,12 @@ TypeRefRow::~TypeRefRow() noexcept
 
 TypeDefRow::TypeDefRow(MetadataRowsReader& mr) {
     // 4-byte bit mask of type TypeAttributes
-    flags = mr.reader.read_uint32();
+    flags = mr.readUInt32();
     // Type name and namespace
     mr.readString(typeName);
     mr.readString(typeNamespace);
     // TypeDefOrRef coded index into TypeDef, TypeRef or TypeSpec
-    extendsType = mr.readRowIndexChoice(typeDefOrRef);
+    extendsType = mr.readRowIndexChoice(CLICodedIndex::TypeDefOrRef);
     // Index into FieldDef table
     fieldList = mr.readRowIndex(CLIMetadataTableItem::FieldDef);
     // Index into MethodDef table
@@ -200,7 +351,7 @@ TypeDefRow::~TypeDefRow() noexcept
 
 FieldDefRow::FieldDefRow(MetadataRowsReader& mr) {
     // 2-byte bit mask of type FieldAttributes
-    flags = mr.reader.read_uint16();
+    flags = mr.readUInt16();
     mr.readString(name);
     mr.readSignature(signature);
 }
@@ -210,10 +361,10 @@ FieldDefRow::~FieldDefRow() noexcept
 }
 
 MethodDefRow::MethodDefRow(MetadataRowsReader& mr) {
-    rva = mr.reader.read_uint32();
+    rva = mr.readUInt32();
     // 2-byte bit mask of type MethodImplAttributes
-    implFlags = mr.reader.read_uint16();
-    flags = mr.reader.read_uint16();
+    implFlags = mr.readUInt16();
+    flags = mr.readUInt16();
     mr.readString(name);
     mr.readSignature(signature);
     // Index into the ParamDef table
@@ -226,8 +377,8 @@ MethodDefRow::~MethodDefRow() noexcept
 
 ParamDefRow::ParamDefRow(MetadataRowsReader& mr) {
     // 2-byte bit mask of type ParamAttributes
-    flags = mr.reader.read_uint16();
-    sequence = mr.reader.read_uint16();
+    flags = mr.readUInt16();
+    sequence = mr.readUInt16();
     mr.readString(name);
 }
 
@@ -235,12 +386,12 @@ InterfaceImplRow::InterfaceImplRow(MetadataRowsReader& mr) {
     // Index into the TypeDef table
     classRef = mr.readRowIndex(CLIMetadataTableItem::TypeDef);
     // TypeDefOrRef index into TypeDef, TypeRef or TypeSpec
-    interfaceRef = mr.readRowIndexChoice(typeDefOrRef);
+    interfaceRef = mr.readRowIndexChoice(CLICodedIndex::TypeDefOrRef);
 }
 
 MemberRefRow::MemberRefRow(MetadataRowsReader& mr) {
     // MemberRefParent index into the TypeRef, ModuleRef, MethodDef, TypeSpec, or TypeDef tables
-    classRef = mr.readRowIndexChoice(memberRefParent);
+    classRef = mr.readRowIndexChoice(CLICodedIndex::MemberRefParent);
     mr.readString(name);
     mr.readSignature(signature);
 }
@@ -250,40 +401,40 @@ MemberRefRow::~MemberRefRow() noexcept
 }
 
 ConstantRow::ConstantRow(MetadataRowsReader& mr) {
-    type = mr.reader.read_uint16();
+    type = mr.readUInt16();
     // HasConstant index into the ParamDef or FieldDef or Property table
-    parent = mr.readRowIndexChoice(hasConstant);
+    parent = mr.readRowIndexChoice(CLICodedIndex::HasConstant);
     mr.readBlob(value);
 }
 
 CustomAttributeRow::CustomAttributeRow(MetadataRowsReader& mr) {
     // HasCustomAttribute index
-    parent = mr.readRowIndexChoice(hasCustomAttribute);
+    parent = mr.readRowIndexChoice(CLICodedIndex::HasCustomAttribute);
     // CustomAttributeType index
-    type = mr.readRowIndexChoice(customAttributeType);
+    type = mr.readRowIndexChoice(CLICodedIndex::CustomAttributeType);
     mr.readBlob(value);
 }
 
 FieldMarshalRow::FieldMarshalRow(MetadataRowsReader& mr) {
     // HasFieldMarshal index
-    parent = mr.readRowIndexChoice(hasFieldMarshall);
+    parent = mr.readRowIndexChoice(CLICodedIndex::HasFieldMarshall);
     mr.readBlob(nativeType);
 }
 
 DeclSecurityRow::DeclSecurityRow(MetadataRowsReader& mr) {
-    action = mr.reader.read_uint16();
-    parent = mr.readRowIndexChoice(hasDeclSecurity);
+    action = mr.readUInt16();
+    parent = mr.readRowIndexChoice(CLICodedIndex::HasDeclSecurity);
     mr.readBlob(permissionSet);
 }
 
 ClassLayoutRow::ClassLayoutRow(MetadataRowsReader& mr) {
-    packingSize = mr.reader.read_uint16();
-    classSize = mr.reader.read_uint32();
+    packingSize = mr.readUInt16();
+    classSize = mr.readUInt32();
     parent = mr.readRowIndex(CLIMetadataTableItem::TypeDef);
 }
 
 FieldLayoutRow::FieldLayoutRow(MetadataRowsReader& mr) {
-    offset = mr.reader.read_uint32();
+    offset = mr.readUInt32();
     parent = mr.readRowIndex(CLIMetadataTableItem::FieldDef);
 }
 
@@ -294,10 +445,10 @@ EventMapRow::EventMapRow(MetadataRowsReader& mr) {
 
 EventRow::EventRow(MetadataRowsReader& mr) {
     // 2-byte bit mask of type EventAttribute
-    eventFlags = mr.reader.read_uint16();
+    eventFlags = mr.readUInt16();
     mr.readString(name);
     // TypeDefOrRef index
-    eventType = mr.readRowIndexChoice(typeDefOrRef);
+    eventType = mr.readRowIndexChoice(CLICodedIndex::TypeDefOrRef);
 }
 
 PropertyMapRow::PropertyMapRow(MetadataRowsReader& mr) {
@@ -307,7 +458,7 @@ PropertyMapRow::PropertyMapRow(MetadataRowsReader& mr) {
 
 PropertyRow::PropertyRow(MetadataRowsReader& mr) {
     // 2-byte bit mask of type PropertyAttributes
-    flags = mr.reader.read_uint16();
+    flags = mr.readUInt16();
     mr.readString(name);
     // A signature from the Blob heap
     mr.readSignature(signature);
@@ -317,35 +468,47 @@ PropertyRow::~PropertyRow() noexcept
 {
 }
 
+StandAloneSigRow::StandAloneSigRow(MetadataRowsReader& mr) {
+    mr.readSignature(signature);
+}
+
 MethodSemanticsRow::MethodSemanticsRow(MetadataRowsReader& mr) {
     // 2-byte bit mask of type MethodSemanticsAttributes
-    semantics = mr.reader.read_uint16();
+    semantics = mr.readUInt16();
     // Index into the MethodDef table
     method = mr.readRowIndex(CLIMetadataTableItem::MethodDef);
     // HasSemantics index into the Event or Property table
-    association = mr.readRowIndexChoice(hasSemantics);
+    association = mr.readRowIndexChoice(CLICodedIndex::HasSemantics);
 }
 
 MethodImplRow::MethodImplRow(MetadataRowsReader& mr) {
     // Index into TypeDef table
     classRef = mr.readRowIndex(CLIMetadataTableItem::TypeDef);
     // Index into MethodDef or MemberRef table
-    methodBody = mr.readRowIndexChoice(methodDefOrRef);
-    methodDeclaration = mr.readRowIndexChoice(methodDefOrRef);
+    methodBody = mr.readRowIndexChoice(CLICodedIndex::MethodDefOrRef);
+    methodDeclaration = mr.readRowIndexChoice(CLICodedIndex::MethodDefOrRef);
+}
+
+ModuleRefRow::ModuleRefRow(MetadataRowsReader& mr) {
+    mr.readString(name);
+}
+
+TypeSpecRow::TypeSpecRow(MetadataRowsReader& mr) {
+    mr.readSignature(signature);
 }
 
 ImplMapRow::ImplMapRow(MetadataRowsReader& mr) {
     // 2-byte bit mask of type PInvokeAttributes
-    mappingFlags = mr.reader.read_uint16();
+    mappingFlags = mr.readUInt16();
     // MemberForwarded  index into the FieldDef or MethodDef table
-    memberForwarded = mr.readRowIndexChoice(memberForwardedIndex);
+    memberForwarded = mr.readRowIndexChoice(CLICodedIndex::MemberForwarded);
     mr.readString(importName);
     importScope = mr.readRowIndex(CLIMetadataTableItem::ModuleRef);
 }
 
 FieldRVARow::FieldRVARow(MetadataRowsReader& mr) {
     // The RVA in this table gives the location of the initial value for a Field.
-    rva = mr.reader.read_uint32();
+    rva = mr.readUInt32();
     // Index into FieldDef table
     field = mr.readRowIndex(CLIMetadataTableItem::FieldDef);
 }
@@ -353,17 +516,17 @@ FieldRVARow::FieldRVARow(MetadataRowsReader& mr) {
 AssemblyRow::AssemblyRow(MetadataRowsReader& mr) {
     version.clear();
     // 4-byte constant of type AssemblyHashAlgorithm
-    hashAlgId = mr.reader.read_uint32();
+    hashAlgId = mr.readUInt32();
     // MajorVersion
-    version.push_back(mr.reader.read_uint16());
+    version.push_back(mr.readUInt16());
     // MinorVersion
-    version.push_back(mr.reader.read_uint16());
+    version.push_back(mr.readUInt16());
     // BuildNumber
-    version.push_back(mr.reader.read_uint16());
+    version.push_back(mr.readUInt16());
     // RevisionNumber 
-    version.push_back(mr.reader.read_uint16());
+    version.push_back(mr.readUInt16());
     // 4-byte bit mask of type AssemblyFlags
-    flags = mr.reader.read_uint32();
+    flags = mr.readUInt32();
 
     mr.readBlob(publicKey);
     mr.readString(name);
@@ -374,25 +537,29 @@ AssemblyRow::~AssemblyRow() noexcept
 {
 }
 
+AssemblyProcessorRow::AssemblyProcessorRow(MetadataRowsReader& mr) {
+    processor = mr.readUInt32();
+}
+
 AssemblyOSRow::AssemblyOSRow(MetadataRowsReader& mr) {
-    osPlatformID = mr.reader.read_uint32();
-    osMajorVersion = mr.reader.read_uint32();
-    osMinorVersion = mr.reader.read_uint32();
+    osPlatformID = mr.readUInt32();
+    osMajorVersion = mr.readUInt32();
+    osMinorVersion = mr.readUInt32();
 }
 
 AssemblyRefRow::AssemblyRefRow(MetadataRowsReader& mr) {
     version.clear();
 
     // MajorVersion
-    version.push_back(mr.reader.read_uint16());
+    version.push_back(mr.readUInt16());
     // MinorVersion
-    version.push_back(mr.reader.read_uint16());
+    version.push_back(mr.readUInt16());
     // BuildNumber
-    version.push_back(mr.reader.read_uint16());
+    version.push_back(mr.readUInt16());
     // RevisionNumber
-    version.push_back(mr.reader.read_uint16());
+    version.push_back(mr.readUInt16());
     // 4-byte bit mask of type AssemblyFlags
-    flags = mr.reader.read_uint32();
+    flags = mr.readUInt32();
 
     mr.readBlob(publicKeyOrToken);
     mr.readString(name);
@@ -405,20 +572,20 @@ AssemblyRefRow::~AssemblyRefRow() noexcept
 }
 
 AssemblyRefProcessorRow::AssemblyRefProcessorRow(MetadataRowsReader& mr) {
-    processor = mr.reader.read_uint32();
+    processor = mr.readUInt32();
     assemblyRef = mr.readRowIndex(CLIMetadataTableItem::AssemblyRef);
 }
 
 AssemblyRefOSRow::AssemblyRefOSRow(MetadataRowsReader& mr) {
-    osPlatformID = mr.reader.read_uint32();
-    osMajorVersion = mr.reader.read_uint32();
-    osMinorVersion = mr.reader.read_uint32();
+    osPlatformID = mr.readUInt32();
+    osMajorVersion = mr.readUInt32();
+    osMinorVersion = mr.readUInt32();
     assemblyRef = mr.readRowIndex(CLIMetadataTableItem::AssemblyRef);
 }
 
 FileRow::FileRow(MetadataRowsReader& mr) {
     // 4-byte bit mask of type FileAttributes
-    flags = mr.reader.read_uint32();
+    flags = mr.readUInt32();
     mr.readString(name);
     mr.readBlob(hashValue);
 }
@@ -429,12 +596,12 @@ FileRow::~FileRow() noexcept
 
 ExportedTypeRow::ExportedTypeRow(MetadataRowsReader& mr) {
     // 4-byte bit mask of type TypeAttributes
-    flags = mr.reader.read_uint32();
+    flags = mr.readUInt32();
     // 4-byte index into a TypeDef table of another module in this Assembly
-    typeDefId = mr.reader.read_uint32();
+    typeDefId = mr.readUInt32();
     mr.readString(typeName);
     mr.readString(typeNamespace);
-    implementation = mr.readRowIndexChoice(implementationIndex);
+    implementation = mr.readRowIndexChoice(CLICodedIndex::Implementation);
 }
 
 ExportedTypeRow::~ExportedTypeRow() noexcept
@@ -442,11 +609,11 @@ ExportedTypeRow::~ExportedTypeRow() noexcept
 }
 
 ManifestResourceRow::ManifestResourceRow(MetadataRowsReader& mr) {
-    offset = mr.reader.read_uint32();
+    offset = mr.readUInt32();
     // 4-byte bit mask of type ManifestResourceAttributes
-    flags = mr.reader.read_uint32();
+    flags = mr.readUInt32();
     mr.readString(name);
-    implementation = mr.readRowIndexChoice(implementationIndex);
+    implementation = mr.readRowIndexChoice(CLICodedIndex::Implementation);
 }
 
 NestedClassRow::NestedClassRow(MetadataRowsReader& mr) {
@@ -456,23 +623,23 @@ NestedClassRow::NestedClassRow(MetadataRowsReader& mr) {
 
 GenericParamRow::GenericParamRow(MetadataRowsReader& mr) {
     // 2-byte index of the generic parameter
-    number = mr.reader.read_uint16();
+    number = mr.readUInt16();
     // 2-byte bitmask of type GenericParamAttributes
-    flags = mr.reader.read_uint16();
+    flags = mr.readUInt16();
     // TypeOrMethodDef index into the TypeDef or MethodDef table
-    owner = mr.readRowIndexChoice(typeOrMethodDef);
+    owner = mr.readRowIndexChoice(CLICodedIndex::TypeOrMethodDef);
     mr.readString(name);
 }
 
 MethodSpecRow::MethodSpecRow(MetadataRowsReader& mr) {
-    method = mr.readRowIndexChoice(methodDefOrRef);
+    method = mr.readRowIndexChoice(CLICodedIndex::MethodDefOrRef);
     mr.readSignature(instantiation);
 }
 
 GenericParamConstraintRow::GenericParamConstraintRow(MetadataRowsReader& mr) {
     // Index into the GenericParam table
     owner = mr.readRowIndex(CLIMetadataTableItem::GenericParam);
-    constraint = mr.readRowIndexChoice(typeDefOrRef);
+    constraint = mr.readRowIndexChoice(CLICodedIndex::TypeDefOrRef);
 }
 
 // Table identifiers
@@ -490,15 +657,19 @@ const CLIMetadataTableItem FieldMarshalRow::tableID;
 const CLIMetadataTableItem DeclSecurityRow::tableID;
 const CLIMetadataTableItem ClassLayoutRow::tableID;
 const CLIMetadataTableItem FieldLayoutRow::tableID;
+const CLIMetadataTableItem StandAloneSigRow::tableID;
 const CLIMetadataTableItem EventMapRow::tableID;
 const CLIMetadataTableItem EventRow::tableID;
 const CLIMetadataTableItem PropertyMapRow::tableID;
 const CLIMetadataTableItem PropertyRow::tableID;
 const CLIMetadataTableItem MethodSemanticsRow::tableID;
 const CLIMetadataTableItem MethodImplRow::tableID;
+const CLIMetadataTableItem ModuleRefRow::tableID;
+const CLIMetadataTableItem TypeSpecRow::tableID;
 const CLIMetadataTableItem ImplMapRow::tableID;
 const CLIMetadataTableItem FieldRVARow::tableID;
 const CLIMetadataTableItem AssemblyRow::tableID;
+const CLIMetadataTableItem AssemblyProcessorRow::tableID;
 const CLIMetadataTableItem AssemblyOSRow::tableID;
 const CLIMetadataTableItem AssemblyRefRow::tableID;
 const CLIMetadataTableItem AssemblyRefProcessorRow::tableID;
@@ -4,20 +4,65 @@
 #include <cstdint>
 #include <vector>
 #include <map>
+#include <memory>
 #include <string>
 
 #include "crossguid/guid.hxx"
 #include "CLIMetadata.hxx"
 #include "AssemblyReader.hxx"
 #include "CLIMetadataTableIndex.hxx"
-#include "CLIMethodBody.hxx"
+#include "StringHeap.hxx"
+#include "SignatureArena.hxx"
+
+class MetadataSnapshot;
+
+// Layout of metadata tables stream. It's computed once from the #~ stream header and then shared by all readers.
+//  Widths and offsets of all columns are known in advance, so any (table, row, column) cell could be read
+//  directly from the image without decoding anything else.
+struct MetadataTablesLayout {
+    // Maximum number of tables which is allowed by the #~ stream header
+    static const uint32_t maxTables = 64;
+
+    // Copy cells of one column from count rows into dst, using given stride for destination.
+    typedef void (*ColumnExtractor)(const uint8_t* src, uint32_t rowSize, uint32_t count, uint32_t* dst, uint32_t stride);
+
+    struct ColumnInfo {
+        // Offset from the beginning of row
+        uint8_t offset = 0;
+        // Either 2 or 4 bytes
+        uint8_t size = 0;
+        // Loop which is specialized for the width of this column
+        ColumnExtractor extract = nullptr;
+    };
 
-struct MetadataRowsReader {
-    AssemblyReader& reader;
-    std::map<CLIMetadataTableItem, uint32_t> mapTableLength;
+    struct TableInfo {
+        uint32_t rowCount = 0;
+        uint32_t rowSize = 0;
+        // Offset of the first row from the beginning of file
+        uint32_t offset = 0;
+        // Whether indexes of this table are 4 bytes long
+        bool isLongIndex = false;
+        std::vector<ColumnInfo> columns;
+        // Already extracted cells from the snapshot, row by row
+        const uint32_t* cells = nullptr;
+    };
+
+    struct CodedIndexInfo {
+        // Whether indexes are 4 bytes long
+        bool isLong = false;
+        // Mask and number of tag bits
+        uint32_t tagMask = 0;
+        uint32_t tagBits = 0;
+        const std::vector<CLIMetadataTableItem>* tables = nullptr;
+    };
+
+    AssemblyReader reader;
+    TableInfo tables[maxTables];
+    CodedIndexInfo codedIndexes[cliCodedIndexCount];
 
     uint32_t metaDataOffset = 0;
     uint32_t stringStreamOffset = 0;
+    uint32_t stringStreamSize = 0;
     uint32_t guidStreamOffset = 0;
     uint32_t blobStreamOffset = 0;
 
@@ -25,37 +70,86 @@ struct MetadataRowsReader {
     bool guidIsLong = false;
     bool blobIsLong = false;
 
+    // Parsed signatures, they are shared by all rows
+    std::shared_ptr<SignatureArena> signatures;
+
+    MetadataTablesLayout() = delete;
+    MetadataTablesLayout(const AssemblyReader& Reader, const CLIMetadata& cliMetadata);
+
+    uint32_t getRowCount(CLIMetadataTableItem tableIndex) const;
+    uint32_t getRowOffset(CLIMetadataTableItem tableIndex, uint32_t row) const;
+
+    // Width of row index and coded index values
+    bool isLongIndex(CLIMetadataTableItem tableIndex) const;
+    bool isLongIndex(CLICodedIndex codedIndex) const;
+
+    // Read raw value of the cell, which is either a constant, heap offset, row index or coded index.
+    uint32_t readColumn(CLIMetadataTableItem tableIndex, uint32_t row, uint32_t column) const;
+
+    // Split coded index value into the one-based row index and the table which is encoded by its tag.
+    std::pair<uint32_t, CLIMetadataTableItem> decodeIndex(CLICodedIndex codedIndex, uint32_t value) const;
+
+    // Extract one column of count rows into the dense array, using SIMD kernels where it's possible.
+    void extractColumn(CLIMetadataTableItem tableIndex, uint32_t column, uint32_t row, uint32_t count, uint32_t* dst) const;
+    std::vector<uint32_t> extractColumn(CLIMetadataTableItem tableIndex, uint32_t column) const;
+
+    // Extract all cells of count rows into dst, row by row.
+    void readCells(CLIMetadataTableItem tableIndex, uint32_t row, uint32_t count, uint32_t* dst) const;
+
+    // Take cells from the snapshot instead of extracting them from the image.
+    void attachSnapshot(std::shared_ptr<const MetadataSnapshot> Snapshot);
+
+private:
+    std::shared_ptr<const MetadataSnapshot> snapshot;
+
+    uint32_t getColumnSize(const CLIMetadataColumn& column) const;
+};
+
+// Reader of consecutive rows. Raw cells of all rows are extracted at once with the loops which are specialized
+//  for the widths of columns, so row constructors are just picking already decoded values one by one.
+struct MetadataRowsReader {
+    // Own cursor over the image
+    AssemblyReader reader;
+    const MetadataTablesLayout& layout;
+
     MetadataRowsReader() = delete;
-    MetadataRowsReader(AssemblyReader& Reader, CLIMetadata& cliMetadata);
-    MetadataRowsReader(const MetadataRowsReader& other) = default;
-    MetadataRowsReader(MetadataRowsReader&& other) = default;
+    MetadataRowsReader(const MetadataTablesLayout& Layout);
+    ~MetadataRowsReader() noexcept;
+
+    // Move to the beginning of the specified row and load cells of count rows
+    void seek(CLIMetadataTableItem tableIndex, uint32_t row, uint32_t count = 1);
 
-    MetadataRowsReader& operator=(const MetadataRowsReader& other);
+    // Move to the next loaded row
+    void nextRow();
 
-    void swap(MetadataRowsReader& other) noexcept;
+    uint16_t readUInt16();
+    uint32_t readUInt32();
     void readGuid(Guid& result);
     void readBlob(std::vector<uint8_t>& result);
-    void readString(std::u16string& result);
-    void readSignature(std::vector<uint32_t>& result);
+    void readString(StringHandle& result);
+    void readSignature(const Signature*& result);
 
     uint32_t readRowIndex(CLIMetadataTableItem tableIndex);
-    std::pair<uint32_t, CLIMetadataTableItem> readRowIndexChoice(const std::vector<CLIMetadataTableItem>& tables);
+    std::pair<uint32_t, CLIMetadataTableItem> readRowIndexChoice(CLICodedIndex codedIndex);
 
 private:
-    void Init(CLIMetadata& cliMetadata);
+    std::vector<uint32_t> cells;
+    uint32_t columnsCount = 0;
+    uint32_t rowStart = 0;
+    uint32_t cell = 0;
 };
 
 // A one row table representing the current assembly.
 struct ModuleRow {
     Guid guid;
-    std::u16string name;
+    StringHandle name;
     uint16_t generation = 0;
 
     static const CLIMetadataTableItem tableID = CLIMetadataTableItem::Module;
 
     ModuleRow() = default;
     ModuleRow(MetadataRowsReader& mr);
-    std::string str() const;
+    std::string str(const StringHeap& strings) const;
 
     ~ModuleRow() noexcept;
 };
@@ -63,8 +157,8 @@ struct ModuleRow {
 // Each row represents an imported class, its namespace, and the assembly which contains it.
 struct TypeRefRow {
     std::pair<uint32_t, CLIMetadataTableItem> resolutionScope;
-    std::u16string typeName;
-    std::u16string typeNamespace;
+    StringHandle typeName;
+    StringHandle typeNamespace;
 
     static const CLIMetadataTableItem tableID = CLIMetadataTableItem::TypeRef;
 
@@ -75,8 +169,8 @@ struct TypeRefRow {
 };
 
 struct TypeDefRow {
-    std::u16string typeName;
-    std::u16string typeNamespace;
+    StringHandle typeName;
+    StringHandle typeNamespace;
 
     // Index into TypeDef, TypeRef or TypeSpec table
     std::pair<uint32_t, CLIMetadataTableItem> extendsType;
@@ -145,8 +239,8 @@ struct TypeDefRow {
 struct FieldDefRow {
     // 2-byte bit mask of type FieldAttributes
     uint16_t flags = 0;
-    std::u16string name;
-    std::vector<uint32_t> signature;
+    StringHandle name;
+    const Signature* signature = nullptr;
 
     static const CLIMetadataTableItem tableID = CLIMetadataTableItem::FieldDef;
 
@@ -185,11 +279,8 @@ struct FieldDefRow {
 
 struct MethodDefRow {
     // Method name and signature
-    std::u16string name;
-    std::vector<uint32_t> signature;
-
-    // Method body data, in-memory only
-    MethodBody methodBody;
+    StringHandle name;
+    const Signature* signature = nullptr;
 
     // Index into ParamDef table
     uint32_t paramList = 0;
@@ -271,7 +362,7 @@ struct MethodDefRow {
 
 struct ParamDefRow {
     // Parameter name
-    std::u16string name;
+    StringHandle name;
     // 2-byte bit mask of type ParamAttributes
     uint16_t flags = 0;
     // Param record index
@@ -310,8 +401,8 @@ struct InterfaceImplRow {
 struct MemberRefRow {
     // Index into the TypeRef, ModuleRef, MethodDef, TypeSpec, or TypeDef
     std::pair<uint32_t, CLIMetadataTableItem> classRef;
-    std::u16string name;
-    std::vector<uint32_t> signature;
+    StringHandle name;
+    const Signature* signature = nullptr;
 
     static const CLIMetadataTableItem tableID = CLIMetadataTableItem::MemberRef;
 
@@ -402,7 +493,7 @@ struct EventMapRow {
 };
 
 struct EventRow {
-    std::u16string name;
+    StringHandle name;
     std::pair<uint32_t, CLIMetadataTableItem> eventType;
 
     // 2-byte bit mask of type EventAttribute
@@ -432,8 +523,8 @@ struct PropertyMapRow {
 };
 
 struct PropertyRow {
-    std::u16string name;
-    std::vector<uint32_t> signature;
+    StringHandle name;
+    const Signature* signature = nullptr;
 
     // 2-byte bit mask of type PropertyAttributes
     uint16_t flags = 0;
@@ -455,6 +546,16 @@ struct PropertyRow {
     ~PropertyRow() noexcept;
 };
 
+// Each row represents a signature that isn't referenced by any other table.
+struct StandAloneSigRow {
+    const Signature* signature = nullptr;
+
+    static const CLIMetadataTableItem tableID = CLIMetadataTableItem::StandAloneSig;
+
+    StandAloneSigRow() = default;
+    StandAloneSigRow(MetadataRowsReader& mr);
+};
+
 struct MethodSemanticsRow {
     uint32_t method = 0;
     std::pair<uint32_t, CLIMetadataTableItem> association;
@@ -488,9 +589,27 @@ struct MethodImplRow {
     MethodImplRow(MetadataRowsReader& mr);
 };
 
+struct ModuleRefRow {
+    StringHandle name;
+
+    static const CLIMetadataTableItem tableID = CLIMetadataTableItem::ModuleRef;
+
+    ModuleRefRow() = default;
+    ModuleRefRow(MetadataRowsReader& mr);
+};
+
+struct TypeSpecRow {
+    const Signature* signature = nullptr;
+
+    static const CLIMetadataTableItem tableID = CLIMetadataTableItem::TypeSpec;
+
+    TypeSpecRow() = default;
+    TypeSpecRow(MetadataRowsReader& mr);
+};
+
 struct ImplMapRow {
     std::pair<uint32_t, CLIMetadataTableItem> memberForwarded;
-    std::u16string importName;
+    StringHandle importName;
     // Index into the ModuleRef table
     uint32_t importScope = 0;
     // 2-byte bit mask of type PInvokeAttributes
@@ -551,8 +670,8 @@ struct AssemblyRow {
     // MajorVersion, MinorVersion, BuildNumber, RevisionNumber 
     std::vector<uint16_t> version;
     std::vector<uint8_t> publicKey;
-    std::u16string name;
-    std::u16string culture;
+    StringHandle name;
+    StringHandle culture;
 
     // 4-byte constant of type AssemblyHashAlgorithm
     uint32_t hashAlgId = 0;
@@ -599,6 +718,15 @@ struct AssemblyRow {
     ~AssemblyRow() noexcept;
 };
 
+struct AssemblyProcessorRow {
+    uint32_t processor = 0;
+
+    static const CLIMetadataTableItem tableID = CLIMetadataTableItem::AssemblyProcessor;
+
+    AssemblyProcessorRow() = default;
+    AssemblyProcessorRow(MetadataRowsReader& mr);
+};
+
 struct AssemblyOSRow {
     uint32_t osPlatformID = 0;
     uint32_t osMajorVersion = 0;
@@ -615,8 +743,8 @@ struct AssemblyRefRow {
     std::vector<uint16_t> version;
     std::vector<uint8_t> publicKeyOrToken;
     std::vector<uint8_t> hashValue;
-    std::u16string name;
-    std::u16string culture;
+    StringHandle name;
+    StringHandle culture;
 
     // 4-byte bit mask of type AssemblyFlags
     uint32_t flags = 0;
@@ -652,7 +780,7 @@ struct AssemblyRefOSRow {
 };
 
 struct FileRow {
-    std::u16string name;
+    StringHandle name;
     std::vector<uint8_t> hashValue;
 
     // 4-byte bit mask of type FileAttributes
@@ -673,8 +801,8 @@ struct FileRow {
 
 struct ExportedTypeRow {
     // Names of type and namespace
-    std::u16string typeName;
-    std::u16string typeNamespace;
+    StringHandle typeName;
+    StringHandle typeNamespace;
 
     // Implementation coded index
     std::pair<uint32_t, CLIMetadataTableItem> implementation;
@@ -692,7 +820,7 @@ struct ExportedTypeRow {
 };
 
 struct ManifestResourceRow {
-    std::u16string name;
+    StringHandle name;
     // Implementation coded index
     std::pair<uint32_t, CLIMetadataTableItem> implementation;
     
@@ -724,7 +852,7 @@ struct NestedClassRow {
 
 struct GenericParamRow {
     std::pair<uint32_t, CLIMetadataTableItem> owner;
-    std::u16string name;
+    StringHandle name;
 
     // 2-byte index of the generic parameter
     uint16_t number = 0;
@@ -756,7 +884,7 @@ struct GenericParamRow {
 
 struct MethodSpecRow {
     std::pair<uint32_t, CLIMetadataTableItem> method;
-    std::vector<uint32_t> instantiation;
+    const Signature* instantiation = nullptr;
 
     static const CLIMetadataTableItem tableID = CLIMetadataTableItem::MethodSpec;
 
@@ -19,9 +19,9 @@ string MethodBody::str(bool fPrintBody) const {
 
         ss << " maxStack=" << dec << maxStack << endl;
 
-        if (localVarSigs.size() > 0) {
+        if (localVarSig != nullptr && !localVarSig->empty()) {
             ss << " localVarSigs=(" << hex << setfill('0') << endl;
-            for (const auto signature : localVarSigs) {
+            for (const auto signature : *localVarSig) {
                 ss << "  " << setw(2) << signature << endl;
             }
             ss << " )" << endl;
@@ -63,7 +63,7 @@ MethodBody & MethodBody::operator=(const MethodBody & other)
 void MethodBody::swap(MethodBody & other) noexcept
 {
     ::swap(data, other.data);
-    ::swap(localVarSigs, other.localVarSigs);
+    ::swap(localVarSig, other.localVarSig);
     ::swap(exceptions, other.exceptions);
     ::swap(maxStack, other.maxStack);
     ::swap(initLocals, other.initLocals);
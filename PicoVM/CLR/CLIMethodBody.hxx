@@ -5,6 +5,8 @@
 #include <vector>
 #include <string>
 
+#include "SignatureArena.hxx"
+
 enum struct MethodBodyFlags : uint8_t {
     TinyFormat = 0x2, // Method header is Tiny.
     FatFormat = 0x3,  // Method header is Fat.
@@ -38,7 +40,8 @@ enum struct ExceptionClauseFlags : uint16_t {
 
 struct MethodBody {
     std::vector<uint8_t> data;
-    std::vector<uint32_t> localVarSigs;
+    // Owned by the signature arena of assembly, null if method has no locals
+    const Signature* localVarSig = nullptr;
     std::vector<ExceptionClause> exceptions;
     uint32_t maxStack = 0;
     bool initLocals = false;
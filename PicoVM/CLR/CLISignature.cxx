@@ -2,7 +2,7 @@
 
 using namespace std;
 
-ArrayShape::ArrayShape(vector<uint32_t>::const_iterator& it) {
+ArrayShape::ArrayShape(const uint32_t*& it) {
     type = static_cast<CLIElementType>(*(it++));
     rank = *(it++);
 
@@ -26,7 +26,7 @@ struct ArrayShape {
     uint32_t rank;
     CLIElementType type;
 
-    ArrayShape(std::vector<uint32_t>::const_iterator& it);
+    ArrayShape(const uint32_t*& it);
 };
 
 
@@ -0,0 +1,158 @@
+#include <cstring>
+
+#include "ColumnKernels.hxx"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLUMN_KERNELS_X86 1
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define COLUMN_KERNELS_X86 1
+#include <intrin.h>
+#include <immintrin.h>
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+using namespace std;
+
+// Plain loop, used for tails and on the platforms without SIMD kernels.
+static void extractScalar(const uint8_t* src, uint32_t stride, uint32_t size, uint32_t count, uint32_t* dst) {
+    if (size == 4) {
+        for (uint32_t n = 0; n < count; ++n, src += stride) {
+            memcpy(&dst[n], src, 4);
+        }
+    } else {
+        for (uint32_t n = 0; n < count; ++n, src += stride) {
+            uint16_t value;
+            memcpy(&value, src, 2);
+            dst[n] = value;
+        }
+    }
+}
+
+// Number of cells from which 4 bytes could be read without going out of bounds.
+static uint32_t getSafeCount(uint32_t stride, uint32_t count, uint32_t available) {
+    if (available < 4) {
+        return 0;
+    }
+    uint32_t safe = stride != 0 ? (available - 4) / stride + 1 : count;
+    return safe < count ? safe : count;
+}
+
+#ifdef COLUMN_KERNELS_X86
+
+// 16 bit cells are inserted into one register and widened by interleaving with zeros.
+TARGET_SSE2 static uint32_t extractSSE2(const uint8_t* src, uint32_t stride, uint32_t size, uint32_t count, uint32_t* dst) {
+    if (size != 2) {
+        // There is nothing to widen, scalar copy is as good as it gets without gather instructions.
+        return 0;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t n = 0;
+    for (; n + 8 <= count; n += 8, src += stride * 8) {
+        uint16_t cell;
+        __m128i packed = zero;
+        memcpy(&cell, src, 2);              packed = _mm_insert_epi16(packed, cell, 0);
+        memcpy(&cell, src + stride, 2);     packed = _mm_insert_epi16(packed, cell, 1);
+        memcpy(&cell, src + stride * 2, 2); packed = _mm_insert_epi16(packed, cell, 2);
+        memcpy(&cell, src + stride * 3, 2); packed = _mm_insert_epi16(packed, cell, 3);
+        memcpy(&cell, src + stride * 4, 2); packed = _mm_insert_epi16(packed, cell, 4);
+        memcpy(&cell, src + stride * 5, 2); packed = _mm_insert_epi16(packed, cell, 5);
+        memcpy(&cell, src + stride * 6, 2); packed = _mm_insert_epi16(packed, cell, 6);
+        memcpy(&cell, src + stride * 7, 2); packed = _mm_insert_epi16(packed, cell, 7);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), _mm_unpacklo_epi16(packed, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n + 4), _mm_unpackhi_epi16(packed, zero));
+    }
+    return n;
+}
+
+// Eight cells are loaded by one gather instruction, 16 bit cells are masked after that.
+TARGET_AVX2 static uint32_t extractAVX2(const uint8_t* src, uint32_t stride, uint32_t size, uint32_t count, uint32_t* dst) {
+    if (stride > 0x0fffffff) {
+        return 0;
+    }
+
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(stride)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i mask = _mm256_set1_epi32(size == 4 ? -1 : 0xffff);
+
+    uint32_t n = 0;
+    for (; n + 8 <= count; n += 8, src += stride * 8) {
+        __m256i cells = _mm256_i32gather_epi32(reinterpret_cast<const int*>(src), offsets, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + n), _mm256_and_si256(cells, mask));
+    }
+    return n;
+}
+
+static ColumnKernelISA detectISA() {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ColumnKernelISA::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return ColumnKernelISA::SSE2;
+    }
+    return ColumnKernelISA::Scalar;
+#else
+    int info[4];
+    __cpuid(info, 0);
+    auto maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        if ((info[1] & (1 << 5)) != 0) {
+            return ColumnKernelISA::AVX2;
+        }
+    }
+    return sse2 ? ColumnKernelISA::SSE2 : ColumnKernelISA::Scalar;
+#endif
+}
+
+#else
+
+static ColumnKernelISA detectISA() {
+    return ColumnKernelISA::Scalar;
+}
+
+#endif
+
+ColumnKernelISA getColumnKernelISA() {
+    static const ColumnKernelISA isa = detectISA();
+    return isa;
+}
+
+void extractStridedColumn(ColumnKernelISA isa, const uint8_t* src, uint32_t stride, uint32_t size, uint32_t count, uint32_t* dst, uint32_t available) {
+    uint32_t done = 0;
+
+#ifdef COLUMN_KERNELS_X86
+    // Kernels are reading 4 bytes of every cell, the last cells are left for scalar loop.
+    auto safe = getSafeCount(stride, count, available);
+
+    switch (isa) {
+    case ColumnKernelISA::AVX2:
+        done = extractAVX2(src, stride, size, safe, dst);
+        break;
+    case ColumnKernelISA::SSE2:
+        done = extractSSE2(src, stride, size, safe, dst);
+        break;
+    case ColumnKernelISA::Scalar:
+    default:
+        break;
+    }
+#else
+    (void)isa;
+    (void)available;
+    (void)getSafeCount;
+#endif
+
+    extractScalar(src + stride * done, stride, size, count - done, dst + done);
+}
+
+void extractStridedColumn(const uint8_t* src, uint32_t stride, uint32_t size, uint32_t count, uint32_t* dst, uint32_t available) {
+    extractStridedColumn(getColumnKernelISA(), src, stride, size, count, dst, available);
+}
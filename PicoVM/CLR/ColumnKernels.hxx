@@ -0,0 +1,23 @@
+#ifndef __COLUMNKERNELS_HXX__
+#define __COLUMNKERNELS_HXX__
+
+#include <cstdint>
+
+// Instruction set which is used by column extraction kernels
+enum struct ColumnKernelISA : uint8_t {
+    Scalar = 0,
+    SSE2 = 1,
+    AVX2 = 2
+};
+
+// Best instruction set which is supported by the current CPU, detected once.
+ColumnKernelISA getColumnKernelISA();
+
+// Copy count cells of 2 or 4 bytes, which are placed at the given stride, into the dense array of 32 bit values.
+//  Kernels may read up to 4 bytes from every cell, so caller passes the number of bytes which could be read from src.
+void extractStridedColumn(const uint8_t* src, uint32_t stride, uint32_t size, uint32_t count, uint32_t* dst, uint32_t available);
+
+// The same, using the given instruction set. Used for testing and benchmarking of the kernels.
+void extractStridedColumn(ColumnKernelISA isa, const uint8_t* src, uint32_t stride, uint32_t size, uint32_t count, uint32_t* dst, uint32_t available);
+
+#endif
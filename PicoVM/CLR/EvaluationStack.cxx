@@ -4,6 +4,7 @@
 #include "NumCasting.hxx"
 
 #include <cassert>
+#include <stdexcept>
 
 #if INTPTR_MAX == INT32_MAX
     #define THIS_IS_32_BIT
@@ -24,6 +25,23 @@ inline static size_t _pop_sz(vector<size_t>& data) {
 #define push_sz(v) data.push_back(v)
 #define pop_sz() _pop_sz(data)
 
+// Tag is removed in all builds, only its check depends on assertions.
+void EvaluationStack::pop_tag(CLIElementType type) {
+    const auto tag = pop_sz();
+    assert(tag == _u(type));
+    (void)tag;
+    (void)type;
+}
+
+inline size_t EvaluationStack::value_words(CLIElementType type) {
+#ifdef THIS_IS_32_BIT
+    return (type == CLIElementType::ELEMENT_TYPE_I8 || type == CLIElementType::ELEMENT_TYPE_R8) ? 2 : 1;
+#else
+    (void)type;
+    return 1;
+#endif
+}
+
 EvaluationStack::EvaluationStack(uint32_t nStackSize) {
     data.reserve(nStackSize / sizeof(size_t));
 }
@@ -81,22 +99,22 @@ void EvaluationStack::push_ref(size_t value) {
 }
 
 int8_t EvaluationStack::pop_int8() {
-    assert(pop_sz() == _u(CLIElementType::ELEMENT_TYPE_I1));
+    pop_tag(CLIElementType::ELEMENT_TYPE_I1);
     return static_cast<int8_t>(pop_sz());
 }
 
 int16_t EvaluationStack::pop_int16() {
-    assert(pop_sz() == _u(CLIElementType::ELEMENT_TYPE_I2));
+    pop_tag(CLIElementType::ELEMENT_TYPE_I2);
     return static_cast<int16_t>(pop_sz());
 }
 
 int32_t EvaluationStack::pop_int32() {
-    assert(pop_sz() == _u(CLIElementType::ELEMENT_TYPE_I4));
+    pop_tag(CLIElementType::ELEMENT_TYPE_I4);
     return static_cast<int32_t>(pop_sz());
 }
 
 int64_t EvaluationStack::pop_int64() {
-    assert(pop_sz() == _u(CLIElementType::ELEMENT_TYPE_I8));
+    pop_tag(CLIElementType::ELEMENT_TYPE_I8);
 
     uint64_t value;
 #ifdef THIS_IS_32_BIT
@@ -109,23 +127,23 @@ int64_t EvaluationStack::pop_int64() {
 }
 
 ptrdiff_t EvaluationStack::pop_nint() {
-    assert(pop_sz() == _u(CLIElementType::ELEMENT_TYPE_I));
+    pop_tag(CLIElementType::ELEMENT_TYPE_I);
     return pop_sz();
 }
 
 size_t EvaluationStack::pop_ref() {
-    assert(pop_sz() == _u(CLIElementType::ELEMENT_TYPE_U));
+    pop_tag(CLIElementType::ELEMENT_TYPE_U);
     return pop_sz();
 }
 
 float EvaluationStack::pop_float32() {
-    assert(pop_sz() == _u(CLIElementType::ELEMENT_TYPE_R4));
+    pop_tag(CLIElementType::ELEMENT_TYPE_R4);
     auto iv = static_cast<uint32_t>(pop_sz());
     return uintToFloat(iv);
 }
 
 double EvaluationStack::pop_float64() {
-    assert(pop_sz() == _u(CLIElementType::ELEMENT_TYPE_R8));
+    pop_tag(CLIElementType::ELEMENT_TYPE_R8);
     uint64_t lv = 0;
 #ifdef THIS_IS_32_BIT
     lv  = static_cast<uint64_t>(pop_sz()) << 32;
@@ -136,105 +154,79 @@ double EvaluationStack::pop_float64() {
     return ulongToDouble(lv);
 }
 
+// Values are copied and removed as their words are, without looking at their types beyond width.
 void EvaluationStack::dup() {
-    using elt = CLIElementType;
-    auto type = static_cast<elt>(data.back());
-
-    switch (type) {
-        case elt::ELEMENT_TYPE_I1:
-        {
-            auto v = pop_int8();
-            push_int8(v);
-            push_int8(v);
-        }
-        break;
-        case elt::ELEMENT_TYPE_I2:
-        {
-            auto v = pop_int16();
-            push_int16(v);
-            push_int16(v);
-        }
-        break;
-        case elt::ELEMENT_TYPE_I4:
-        {
-            auto v = pop_int32();
-            push_int32(v);
-            push_int32(v);
-        }
-        break;
-        case elt::ELEMENT_TYPE_I8:
-        {
-            auto v = pop_int64();
-            push_int64(v);
-            push_int64(v);
-        }
-        break;
+    const auto words = value_words(top()) + 1;
+    const auto position = data.size() - words;
+    for (size_t n = 0; n < words; ++n) {
+        push_sz(data[position + n]);
+    }
+}
 
-        case elt::ELEMENT_TYPE_I:
-        {
-            auto v = pop_nint();
-            push_nint(v);
-            push_nint(v);
-        }
-        break;
-        case elt::ELEMENT_TYPE_U:
-        {
-            auto v = pop_ref();
-            push_ref(v);
-            push_ref(v);
-        }
-        break;
+void EvaluationStack::pop() {
+    for (auto words = value_words(top()) + 1; words > 0; --words) {
+        data.pop_back();
+    }
+}
 
-        case elt::ELEMENT_TYPE_R4:
-        {
-            auto v = pop_float32();
-            push_float32(v);
-            push_float32(v);
-        }
-        break;
-        case elt::ELEMENT_TYPE_R8:
-        {
-            auto v = pop_float64();
-            push_float64(v);
-            push_float64(v);
-        }
-        break;
+CLIElementType EvaluationStack::top() const {
+    return static_cast<CLIElementType>(data.back());
+}
 
-        default:
-            throw runtime_error("Not yet implemented");
+void EvaluationStack::push_bits(uint64_t bits, CLIElementType type) {
+#ifdef THIS_IS_32_BIT
+    if (type == CLIElementType::ELEMENT_TYPE_I8 || type == CLIElementType::ELEMENT_TYPE_R8) {
+        push_sz(bits & 0xffffffff);
+        push_sz(bits >> 32);
+    } else {
+        push_sz(static_cast<size_t>(bits));
     }
+#else
+    push_sz(bits);
+#endif
+    push_sz(_u(type));
 }
 
-void EvaluationStack::pop() {
-using elt = CLIElementType;
-    auto type = static_cast<elt>(data.back());
-
-    switch (type) {
-        case elt::ELEMENT_TYPE_I1:
-            pop_int8();
-        break;
-        case elt::ELEMENT_TYPE_I2:
-            pop_int16();
-        break;
-        case elt::ELEMENT_TYPE_I4:
-            pop_int32();
-        break;
-        case elt::ELEMENT_TYPE_I8:
-            pop_int64();
-        break;
-        case elt::ELEMENT_TYPE_I:
-            pop_nint();
-        break;
-        case elt::ELEMENT_TYPE_U:
-            pop_ref();
-        break;
-        case elt::ELEMENT_TYPE_R4:
-            pop_float32();
-        break;
-        case elt::ELEMENT_TYPE_R8:
-            pop_float64();
-        break;
-
-        default:
-            throw runtime_error("Not yet implemented");
-    }}
+uint64_t EvaluationStack::pop_bits() {
+    auto type = static_cast<CLIElementType>(pop_sz());
+#ifdef THIS_IS_32_BIT
+    if (type == CLIElementType::ELEMENT_TYPE_I8 || type == CLIElementType::ELEMENT_TYPE_R8) {
+        uint64_t value = static_cast<uint64_t>(pop_sz()) << 32;
+        return value | pop_sz();
+    }
+    // Integers are sign-extended as they would be on 64-bit machine.
+    auto value = pop_sz();
+    if (type == CLIElementType::ELEMENT_TYPE_R4 || type == CLIElementType::ELEMENT_TYPE_U) {
+        return value;
+    }
+    return static_cast<uint64_t>(static_cast<int64_t>(static_cast<ptrdiff_t>(value)));
+#else
+    (void)type;
+    return pop_sz();
+#endif
+}
+
+uint64_t EvaluationStack::peek_bits(uint32_t depth) const {
+    auto position = data.size();
+    for (;;) {
+        auto type = static_cast<CLIElementType>(data[--position]);
+#ifdef THIS_IS_32_BIT
+        const auto words = (type == CLIElementType::ELEMENT_TYPE_I8 || type == CLIElementType::ELEMENT_TYPE_R8) ? 2 : 1;
+#else
+        const auto words = 1;
+        (void)type;
+#endif
+        position -= words;
+        if (depth-- == 0) {
+#ifdef THIS_IS_32_BIT
+            if (words == 2) {
+                return static_cast<uint64_t>(data[position + 1]) << 32 | data[position];
+            }
+            if (type != CLIElementType::ELEMENT_TYPE_R4 && type != CLIElementType::ELEMENT_TYPE_U) {
+                return static_cast<uint64_t>(static_cast<int64_t>(static_cast<ptrdiff_t>(data[position])));
+            }
+#endif
+            return data[position];
+        }
+    }
+}
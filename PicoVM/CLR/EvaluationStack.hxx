@@ -5,6 +5,9 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "CLIElementTypes.hxx"
+#include "NumCasting.hxx"
+
 struct EvaluationStack {
     std::vector<size_t> data;
 
@@ -32,6 +35,45 @@ struct EvaluationStack {
 
     void pop();
     void dup();
+
+    // Type of value on top of the stack
+    CLIElementType top() const;
+
+    // Value of any type as raw 64-bit pattern. Integers are sign-extended, floats are kept in their binary form.
+    void push_bits(uint64_t bits, CLIElementType type);
+    uint64_t pop_bits();
+    // Value below the given number of values from the top, zero is the top value.
+    uint64_t peek_bits(uint32_t depth) const;
+
+    // Values of the types which are known before execution, as for quickened instructions. Tags are
+    //  skipped without looking at them.
+    int32_t pop_unchecked_int32() { return static_cast<int32_t>(pop_unchecked_word()); }
+    ptrdiff_t pop_unchecked_nint() { return static_cast<ptrdiff_t>(pop_unchecked_word()); }
+    size_t pop_unchecked_ref() { return pop_unchecked_word(); }
+    int64_t pop_unchecked_int64();
+    double pop_unchecked_float64() { return ulongToDouble(static_cast<uint64_t>(pop_unchecked_int64())); }
+
+private:
+    // Remove the tag of top value, it must be of the given type.
+    void pop_tag(CLIElementType type);
+    // Number of words which are holding the value of the type, its tag isn't counted.
+    static size_t value_words(CLIElementType type);
+
+    size_t pop_unchecked_word() {
+        const auto value = data[data.size() - 2];
+        data.resize(data.size() - 2);
+        return value;
+    }
 };
 
+inline int64_t EvaluationStack::pop_unchecked_int64() {
+    if (sizeof(size_t) < sizeof(int64_t)) {
+        const auto size = data.size();
+        const auto value = static_cast<uint64_t>(data[size - 2]) << 32 | data[size - 3];
+        data.resize(size - 3);
+        return static_cast<int64_t>(value);
+    }
+    return static_cast<int64_t>(pop_unchecked_word());
+}
+
 #endif
@@ -1,11 +1,14 @@
 #include "ExecutionThread.hxx"
 #include "AppDomain.hxx"
-#include <iomanip>
+#include "TokenCache.hxx"
+#include "Interpreter.hxx"
+#include "RegisterInterpreter.hxx"
 
 using namespace std;
 
 ExecutionThread::ExecutionThread(AppDomain* appDomain) : domain(appDomain) {
     evaluationStack = EvaluationStack();
+    variables.reserve(65536);
 }
 
 bool ExecutionThread::run() {
@@ -16,50 +19,34 @@ bool ExecutionThread::run() {
         switch (frame->state) {
         case ExecutionState::FrameSetup:
         {
-            // frame->prevStackSize = static_cast<uint32_t>(evaluationStack.size());
             switch (frame->methodToken >> 24) {
             case 0x06: // MethodDef
             {
-                auto index = (frame->methodToken & 0xFFFFFF) - 1;
-                frame->methodDef = &clrData->cliMetaDataTables._MethodDef[index];
+                frame->method = &domain->getRuntimeMethod(clrData, frame->methodToken & 0xFFFFFF);
+                frame->methodDef = frame->method->methodDef;
                 frame->executingAssembly = frame->callingAssembly;
-                frame->state = ExecutionState::MethodBodyExecution;
+                frame->state = frame->method->native != nullptr ? ExecutionState::NativeMethodExecution : ExecutionState::MethodBodyExecution;
             }
             break;
             case 0x0A: // MemberRef
             {
+                // Resolved target is cached by the domain, so repeated calls are just a lookup.
                 auto index = (frame->methodToken & 0xFFFFFF) - 1;
-                auto memberRef = clrData->cliMetaDataTables._MemberRef[index];
-                auto signature = memberRef.signature;
-
-                switch (memberRef.classRef.second) {
-                case CLIMetadataTableItem::TypeRef: // TypeRef
-                {
-                    auto typeRef = clrData->cliMetaDataTables._TypeRef[memberRef.classRef.first];
-                    switch (typeRef.resolutionScope.second) {
-                    case CLIMetadataTableItem::AssemblyRef:
-                    {
-                        auto assemblyRef = clrData->cliMetaDataTables._AssemblyRef[typeRef.resolutionScope.first];
-                        try {
-                            frame->executingAssembly = domain->getAssembly(assemblyRef.name, assemblyRef.version);
-                            frame->state = ExecutionState::AssemblySet;
-                        }
-                        catch (runtime_error&) {
-                            const auto& id = domain->loadAssembly(assemblyRef.name, assemblyRef.version);
-                            frame->executingAssembly = domain->getAssembly(id);
-                            frame->state = ExecutionState::AssemblySet;
-                        }
-                    }
-                    break;
-                    default:
-                        throw runtime_error("Invalid method class assembly ref");
-                    }
+                if (index >= frame->tokens->memberRefs.size()) {
+                    throw runtime_error("Invalid method token");
                 }
-                break;
-                default:
-                    throw runtime_error("Invalid method class ref");
+                const auto* member = frame->tokens->memberRefs.get(index);
+                if (member == nullptr) {
+                    member = &domain->resolveMemberRef(clrData, index + 1);
                 }
-            };
+                if (member->methodDef == nullptr) {
+                    throw runtime_error("MemberRef token doesn't refer to a method");
+                }
+                frame->executingAssembly = member->assembly;
+                frame->methodDef = member->methodDef;
+                frame->method = &domain->getRuntimeMethod(member->assembly, member->token & 0xFFFFFF);
+                frame->state = ExecutionState::AssemblySet;
+            }
             break;
             case 0x2B: // MethodSpec
             default:
@@ -68,31 +55,37 @@ bool ExecutionThread::run() {
             result = true;
         };
         break;
+        case ExecutionState::AssemblySet:
+            frame->state = frame->method->native != nullptr ? ExecutionState::NativeMethodExecution : ExecutionState::MethodBodyExecution;
+            result = true;
+            break;
         case ExecutionState::MethodBodyExecution:
-            frame->instructionPointer = 0;
-            frame->state = ExecutionState::MethodExecution;
-            // TODO: decode methodDefSig and localVarSigs 
-
-            if (frame->localVarSigs.size() != 0) {
-                // TODO: process local variable signatures
+            // Arguments are taken from the evaluation stack, locals are zeroed.
+            if (!domain->options.registerCode || !RegisterInterpreter::enterFrame(*this, *frame)) {
+                Interpreter::enterFrame(*this, *frame);
             }
-
             result = true;
             break;
         case ExecutionState::WaitForAssembly:
-            // wait for assembly... do nothing
+            // Referenced assemblies are waited for one by one, when the frame setup resolves them.
+            frame->state = ExecutionState::FrameSetup;
+            result = true;
             break;
-        case ExecutionState::AssemblySet:
         case ExecutionState::NativeMethodExecution:
+            frame->method->native(*this);
+            frame->state = ExecutionState::Cleanup;
+            result = true;
+            break;
         case ExecutionState::MethodExecution:
-        case ExecutionState::Cleanup:
-            /*if (frame->locals.size() != 0) {
-                // TODO
-            }
-            if (frame->arguments.size() != 0) {
-                // TODO
+            // Frame is popped by the interpreter once it returns, together with the frames of its callees.
+            if (frame->registerCode != nullptr) {
+                RegisterInterpreter::execute(*this);
+            } else {
+                Interpreter::execute(*this);
             }
-            */
+            result = true;
+            break;
+        case ExecutionState::Cleanup:
             callStack.pop_back();
             result = true;
             break;
@@ -107,12 +100,34 @@ bool ExecutionThread::run() {
 }
 
 void ExecutionThread::setup(const Guid& guid) {
+    const auto* assembly = domain->getAssembly(guid);
+    const auto entryPoint = assembly->cliHeader.entryPointToken;
+
+    // Command line isn't passed to the program yet, string[] args is null.
+    const auto& signature = *assembly->getMethodDef(entryPoint).signature;
+    const auto parametersCount = signature.size() > 1 ? signature[1] : 0;
+    for (uint32_t n = 0; n < parametersCount; ++n) {
+        evaluationStack.push_ref(0);
+    }
+
+    setup(guid, entryPoint);
+}
+
+void ExecutionThread::setup(const Guid& guid, uint32_t methodToken) {
     CallStackItem frame;
     frame.appDomain = domain;
+    frame.thread = this;
     const auto* assembly = domain->getAssembly(guid);
     frame.callingAssembly = frame.executingAssembly = assembly;
-    frame.methodToken = assembly->cliHeader.entryPointToken;
+    frame.tokens = &domain->getTokenCache(assembly);
+    frame.methodToken = methodToken;
     frame.state = ExecutionState::FrameSetup;
+
+    if (domain->options.preloadReferences) {
+        // Entry point starts right away, referenced assemblies are loaded in background meanwhile.
+        domain->preloadReferences(guid);
+    }
+
     callStack.push_back(frame);
 }
 
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <vector>
 
 #include "crossguid/guid.hxx"
 #include "EvaluationStack.hxx"
@@ -21,25 +22,40 @@ enum struct ExecutionState : uint8_t {
 
 struct AppDomain; // forward declaration
 struct MethodDefRow;
+struct MethodBody;
 class AssemblyData;
+class Signature;
 struct ExecutionThread;
+struct TokenCache;
+struct RuntimeMethod;
+struct ThreadedCode;
+struct RegisterCode;
 
 struct CallStackItem {
     AppDomain* appDomain = nullptr;
     ExecutionThread* thread = nullptr;
     const AssemblyData* callingAssembly = nullptr;
     const AssemblyData* executingAssembly = nullptr;
+    // Resolved references of the calling assembly
+    TokenCache* tokens = nullptr;
     const MethodDefRow* methodDef = nullptr;
+    const MethodBody* methodBody = nullptr;
+    const RuntimeMethod* method = nullptr;
+    const ThreadedCode* code = nullptr;
+    // Null if the frame is executed from threaded code
+    const RegisterCode* registerCode = nullptr;
 
     uint32_t methodToken = 0;
-    //uint32_t prevStackSize = 0;
+    // Index of the next instruction in threaded or register code
     uint32_t instructionPointer = 0;
     uint32_t argumentsCount = 0;
-    
-    //std::vector<EvaluationStackItem> locals;
-    //std::vector<EvaluationStackItem> arguments;
-    std::vector<uint32_t> localVarSigs;
-    std::vector<uint32_t> methodDefSig;
+    // Arguments and locals, or registers of the frame are starting at this index of ExecutionThread::variables.
+    uint32_t variablesBase = 0;
+    // Size of evaluation stack after arguments were taken
+    size_t stackBase = 0;
+
+    const Signature* localVarSig = nullptr;
+    const Signature* methodDefSig = nullptr;
     ExecutionState state = ExecutionState::Undefined;
 };
 
@@ -48,9 +64,20 @@ struct ExecutionThread {
     AppDomain* domain = nullptr;
     std::deque<CallStackItem> callStack;
     EvaluationStack evaluationStack;
+    // Arguments and local variables of all frames
+    std::vector<uint64_t> variables;
+#ifdef CHECK_REGISTER_TYPES
+    // Stack types of the values in the registers of register code frames, if they are checked.
+    std::vector<CLIElementType> registerTags;
+#endif
+    // Number of dispatched instructions
+    uint64_t executedInstructions = 0;
 
     bool run();
+    // Call the entry point of assembly, its arguments are null.
     void setup(const Guid& guid);
+    // Call the method of assembly, arguments must be pushed to the evaluation stack before running the thread.
+    void setup(const Guid& guid, uint32_t methodToken);
     static std::shared_ptr<ExecutionThread> create(AppDomain* appDomain);
 
 private:
@@ -3,7 +3,11 @@
 #include "NumCasting.hxx"
 
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <stdexcept>
 #include <sstream>
 #include <iomanip>
 
@@ -237,7 +241,7 @@ enum struct tb : uint16_t {
     p_readonly = 0x1EFE, // Prefix 
 };
 
-map<uint16_t, int8_t> stackBehaviour {
+static const map<uint16_t, int8_t> stackBehaviour {
     { _u(sc::i_nop), 0 },
     { _u(sc::i_break), 0 },
     { _u(sc::i_ldarg_0), 1 },
@@ -462,65 +466,50 @@ map<uint16_t, int8_t> stackBehaviour {
     { _u(tb::p_readonly), 0 }
 };
 
-inline static int32_t read_int32(vector<uint8_t>::iterator& it) {
-    it += 4;
-    return *reinterpret_cast<int32_t*>(&(*(it - 4)));
-}
-
-inline static int64_t read_int64(vector<uint8_t>::iterator& it) {
-    it += 8;
-    return *reinterpret_cast<int64_t*>(&(*(it - 8)));
-}
+// Stack behaviour by opcode: one-byte opcodes first, then the second bytes of two-byte opcodes. The table is
+//  built once, so concurrent decoders are only reading it.
+static int8_t getStackBehaviour(uint16_t opcode) {
+    static const vector<int8_t> table = [] {
+        vector<int8_t> result(512, 0);
+        for (const auto& item : stackBehaviour) {
+            const auto isMultibyte = (item.first & 0xFF) == _u(sc::p_multibyte);
+            result[isMultibyte ? 256 + (item.first >> 8) : item.first] = item.second;
+        }
+        return result;
+    }();
 
-inline static float read_float(vector<uint8_t>::iterator& it) {
-    it += 4;
-    return *reinterpret_cast<float*>(&(*(it - 4)));
+    return table[(opcode & 0xFF) == _u(sc::p_multibyte) ? 256 + (opcode >> 8) : opcode];
 }
 
-inline static double read_double(vector<uint8_t>::iterator& it) {
-    it += 8;
-    return *reinterpret_cast<double*>(&(*(it - 8)));
+template<typename T>
+static T read_value(const uint8_t*& it, const uint8_t* end) {
+    if (end - it < static_cast<ptrdiff_t>(sizeof(T))) {
+        throw runtime_error("Instruction is truncated");
+    }
+    T value;
+    memcpy(&value, it, sizeof(T));
+    it += sizeof(T);
+    return value;
 }
 
-static bool is_branching(const tuple<Instruction, vector<argument>, int8_t >& instr, vector<ptrdiff_t>& targets) {
-
-    switch(get<0>(instr))
-    {
-        case Instruction::i_br:
-        case Instruction::i_brfalse:
-        case Instruction::i_brtrue:
-        case Instruction::i_beq:
-        case Instruction::i_bge:
-        case Instruction::i_bgt:
-        case Instruction::i_ble:
-        case Instruction::i_blt:
-        case Instruction::i_bne_un:
-        case Instruction::i_bge_un:
-        case Instruction::i_bgt_un:
-        case Instruction::i_ble_un:
-        case Instruction::i_blt_un:
-        case Instruction::i_leave:
-        {
-            auto target = get<1>(instr).begin()->get<ptrdiff_t>();
-            targets.push_back(target);
-            return true;
-        }
-        case Instruction::i_switch:
-        {
-            for (auto it = get<1>(instr).begin(); it != get<1>(instr).end(); ++it) {
-                auto target = it->get<ptrdiff_t>();
-                targets.push_back(target);
-            }
-
-            return true;
-        }
-        default:
-            return false;
+// Absolute offset of branch target, which is relative to the end of instruction
+static uint32_t branch_target(const uint8_t* it, const uint8_t* start, int32_t delta) {
+    auto target = (it - start) + static_cast<ptrdiff_t>(delta);
+    if (target < 0 || target > UINT32_MAX) {
+        throw runtime_error("Branch target is out of method body");
     }
+    return static_cast<uint32_t>(target);
 }
 
-static tuple<Instruction, vector<argument>, int8_t > loadOp(ptrdiff_t offset, vector<uint8_t>::iterator& it) {
-    auto opcode = static_cast<sc>(*(it++));
+// Decode one instruction at it. Branch targets are set to IL offsets, switch targets are written only if
+//  switchTargets isn't null, so the first pass could just count them.
+static void decodeOp(const uint8_t*& it, const uint8_t* start, const uint8_t* end, DecodedInstruction& instruction, uint32_t* switchTargets) {
+    instruction.offset = static_cast<uint32_t>(it - start);
+    instruction.operand.i8 = 0;
+
+    auto opcode = static_cast<sc>(read_value<uint8_t>(it, end));
+    instruction.opcode = static_cast<Instruction>(opcode);
+    instruction.stackBehaviour = getStackBehaviour(_u(opcode));
 
     switch(opcode) {
         // Predefined aliases for ldarg [uint16_t num] where num is between 0 and 3.
@@ -528,133 +517,91 @@ static tuple<Instruction, vector<argument>, int8_t > loadOp(ptrdiff_t offset, ve
         case sc::i_ldarg_1:
         case sc::i_ldarg_2:
         case sc::i_ldarg_3:
-        {
-            auto arg = static_cast<uint16_t>(_u(opcode) - _u(sc::i_ldarg_0));
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldarg, { arg }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.opcode = Instruction::i_ldarg;
+            instruction.operand.variable = static_cast<uint16_t>(_u(opcode) - _u(sc::i_ldarg_0));
+            break;
 
         // Predefined aliases for ldloc [uint16_t num] where num is between 0 and 3.
         case sc::i_ldloc_0:
         case sc::i_ldloc_1:
         case sc::i_ldloc_2:
         case sc::i_ldloc_3:
-        {
-            auto arg = static_cast<uint16_t>(_u(opcode) - _u(sc::i_ldloc_0));
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldloc, { arg }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.opcode = Instruction::i_ldloc;
+            instruction.operand.variable = static_cast<uint16_t>(_u(opcode) - _u(sc::i_ldloc_0));
+            break;
 
         // Predefined aliases for stloc [uint16_t num] where num is between 0 and 3.
         case sc::i_stloc_0:
         case sc::i_stloc_1:
         case sc::i_stloc_2:
         case sc::i_stloc_3:
-        {
-            auto arg = static_cast<uint16_t>(_u(opcode) - _u(sc::i_stloc_0));
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_stloc, { arg }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.opcode = Instruction::i_stloc;
+            instruction.operand.variable = static_cast<uint16_t>(_u(opcode) - _u(sc::i_stloc_0));
+            break;
 
         // Predefined aliases for ldc.i4 [int32_t num] where num is between -1 and 8.
         case sc::i_ldc_i4_m1:
         case sc::i_ldc_i4_0:
         case sc::i_ldc_i4_1:
         case sc::i_ldc_i4_2:
+        case sc::i_ldc_i4_3:
         case sc::i_ldc_i4_4:
         case sc::i_ldc_i4_5:
         case sc::i_ldc_i4_6:
         case sc::i_ldc_i4_7:
         case sc::i_ldc_i4_8:
-        {
-            int32_t arg = _u(opcode) - _u(sc::i_ldc_i4_0);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldc_i4, { arg }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.opcode = Instruction::i_ldc_i4;
+            instruction.operand.i4 = _u(opcode) - _u(sc::i_ldc_i4_0);
+            break;
 
-        // Load argument (short version)
-        // ldarg.s [uint8_t argnum]
+        // Short versions of argument and local variable instructions
+        // <instruction> [uint8_t num]
         case sc::i_ldarg_s:
-        {
-            uint16_t arg = *(it++);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldarg, { arg }, stackBehaviour[_u(opcode)]);
-        }
-
-        // Load argument address (short version)
-        // ldarga.s [uint8_t argnum]
         case sc::i_ldarga_s:
-        {
-            uint16_t arg = *(it++);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldarga, { arg }, stackBehaviour[_u(opcode)]);
-        }
-
-        // Save argument (short version)
-        // starg.s [uint8_t argnum]
         case sc::i_starg_s:
-        {
-            uint16_t arg = *(it++);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_starg, { arg }, stackBehaviour[_u(opcode)]);
-        }
-
-        // Load local variable (short version)
-        // ldloc.s [uint8_t varnum]
         case sc::i_ldloc_s:
-        {
-            uint16_t arg = *(it++);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldloc, { arg }, stackBehaviour[_u(opcode)]);
-        }
-
-        // Load local variable address (short version)
-        // ldloca.s [uint8_t varnum]
         case sc::i_ldloca_s:
-        {
-            uint16_t arg = *(it++);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldloca, { arg }, stackBehaviour[_u(opcode)]);
-        }
-
-        // Save local variable (short version)
-        // stloc.s [uint8_t varnum]
         case sc::i_stloc_s:
         {
-            uint16_t arg = *(it++);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_stloc, { arg }, stackBehaviour[_u(opcode)]);
+            static const Instruction longForms[] = {
+                Instruction::i_ldarg, Instruction::i_ldarga, Instruction::i_starg,
+                Instruction::i_ldloc, Instruction::i_ldloca, Instruction::i_stloc
+            };
+            instruction.opcode = longForms[_u(opcode) - _u(sc::i_ldarg_s)];
+            instruction.operand.variable = read_value<uint8_t>(it, end);
         }
+        break;
 
         // Load integer as int32_t (short version)
         // ldc.i4.s [int8_t smallint]
         case sc::i_ldc_i4_s:
-        {
-            int32_t arg = static_cast<int8_t>(*(it++));
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldc_i4, { arg }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.opcode = Instruction::i_ldc_i4;
+            instruction.operand.i4 = read_value<int8_t>(it, end);
+            break;
 
         // Load integer as int32_t
         // ldc.i4 [int32_t int]
         case sc::i_ldc_i4:
-        {
-            auto arg = read_int32(it);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldc_i4, { arg }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.operand.i4 = read_value<int32_t>(it, end);
+            break;
 
         // Load integer as int64_t
         // ldc.i8 [int64_t int]
         case sc::i_ldc_i8:
-        {
-            auto arg = read_int64(it);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldc_i8, { arg }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.operand.i8 = read_value<int64_t>(it, end);
+            break;
 
         // Load float as double
         // ldc.r4 [float num]
         case sc::i_ldc_r4:
-        {
-            auto arg = read_float(it);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldc_r4, { arg }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.operand.r4 = read_value<float>(it, end);
+            break;
 
         // Load double
         // ldc.r8 [double num]
         case sc::i_ldc_r8:
-        {
-            auto arg = read_double(it);
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_ldc_r8, { arg }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.operand.r8 = read_value<double>(it, end);
+            break;
 
         // Short representations of branching opcodes
         // xx [int8_t target]
@@ -672,18 +619,21 @@ static tuple<Instruction, vector<argument>, int8_t > loadOp(ptrdiff_t offset, ve
         case sc::i_ble_un_s:
         case sc::i_blt_un_s:
         {
-            auto newcode = _u(sc::i_br) + (_u(opcode) - _u(sc::i_br_s));
-            auto target = static_cast<int8_t>(*(it++));
-            return tuple<Instruction, vector<argument>, int8_t >(static_cast<Instruction>(newcode), { offset + 2 + target }, stackBehaviour[_u(opcode)]);
+            instruction.opcode = static_cast<Instruction>(_u(sc::i_br) + (_u(opcode) - _u(sc::i_br_s)));
+            auto delta = read_value<int8_t>(it, end);
+            instruction.operand.target = branch_target(it, start, delta);
         }
+        break;
 
         // Leave protected region of code
         // leave.s [int8_t offset]
         case sc::i_leave_s:
         {
-            auto target = static_cast<int8_t>(*(it++));
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_leave, { offset + 2 + target }, stackBehaviour[_u(opcode)]);
+            instruction.opcode = Instruction::i_leave;
+            auto delta = read_value<int8_t>(it, end);
+            instruction.operand.target = branch_target(it, start, delta);
         }
+        break;
 
         // Leave normal representation of branching opcodes as is.
         // xx [int32_t target]
@@ -702,30 +652,34 @@ static tuple<Instruction, vector<argument>, int8_t > loadOp(ptrdiff_t offset, ve
         case sc::i_blt_un:
 
         // Leave protected region of code
-        // leave.s [int32_t offset]
+        // leave [int32_t offset]
         case sc::i_leave:
         {
-            auto target = read_int32(it);
-            return tuple<Instruction, vector<argument>, int8_t >(static_cast<Instruction>(opcode), { offset + 5 + target }, stackBehaviour[_u(opcode)]);
+            auto delta = read_value<int32_t>(it, end);
+            instruction.operand.target = branch_target(it, start, delta);
         }
+        break;
 
         // Jump table instruction
-        // switbh [uint32_t num] [int32_t offset1, int32_t offset2, ..., int32_t offsetN]
+        // switch [uint32_t num] [int32_t offset1, int32_t offset2, ..., int32_t offsetN]
         case sc::i_switch:
         {
-            // Switbh table size
-            auto table_size = read_int32(it);
-            auto instr_size = 1 + 4 * (table_size + 1);
-            vector<argument> args = { };
-
-            // Jump targets collection
-            for (auto i = 0; i < table_size; ++i) {
-                auto target = read_int32(it);
-                args.push_back(offset + instr_size + target);
+            auto count = read_value<uint32_t>(it, end);
+            if (static_cast<uint64_t>(end - it) < static_cast<uint64_t>(count) * 4) {
+                throw runtime_error("Instruction is truncated");
+            }
+            instruction.operand.table.count = count;
+
+            // Targets are relative to the end of the whole instruction
+            const auto* next = it + static_cast<size_t>(count) * 4;
+            for (uint32_t n = 0; n < count; ++n) {
+                auto delta = read_value<int32_t>(it, end);
+                if (switchTargets != nullptr) {
+                    switchTargets[n] = branch_target(next, start, delta);
+                }
             }
-
-            return tuple<Instruction, vector<argument>, int8_t >(Instruction::i_switch, args, stackBehaviour[_u(opcode)]);
         }
+        break;
 
         // Some object model instructions
         // <instruction> [int32_t Token]
@@ -756,32 +710,17 @@ static tuple<Instruction, vector<argument>, int8_t > loadOp(ptrdiff_t offset, ve
         case sc::i_call:
         case sc::i_calli:
         case sc::i_callvirt:
-        {
-            auto token = static_cast<uint32_t>(read_int32(it));
-            return tuple<Instruction, vector<argument>, int8_t >(static_cast<Instruction>(opcode), { token }, stackBehaviour[_u(opcode)]);
-        }
+            instruction.operand.token = read_value<uint32_t>(it, end);
+            break;
 
         // All two-byte instructions and instruction modifiers are marked by 0xFE prefix
         case sc::p_multibyte:
         {
-            auto lopcode = tb(static_cast<uint16_t>(_u(sc::p_multibyte) | *(it++) << 8));
+            auto lopcode = tb(static_cast<uint16_t>(_u(sc::p_multibyte) | read_value<uint8_t>(it, end) << 8));
+            instruction.opcode = static_cast<Instruction>(lopcode);
+            instruction.stackBehaviour = getStackBehaviour(_u(lopcode));
 
             switch (lopcode) {
-                // Argumentless instruction
-                case tb::i_arglist:
-                case tb::i_rethrow:
-                case tb::i_ceq:
-                case tb::i_cgt:
-                case tb::i_clt:
-                case tb::i_cgt_un:
-                case tb::i_clt_un:
-                case tb::i_cpblk:
-                case tb::i_initblk:
-                case tb::i_localloc:
-                case tb::i_endfilter:
-                case tb::i_refanytype:
-                    return tuple<Instruction, vector<argument>, int8_t >(static_cast<Instruction>(lopcode), {}, stackBehaviour[_u(lopcode)]);
-
                 // Local variable and argument operations
                 // <instruction> [uint16_t index]
                 case tb::i_ldloc:
@@ -790,10 +729,8 @@ static tuple<Instruction, vector<argument>, int8_t > loadOp(ptrdiff_t offset, ve
                 case tb::i_ldarga:
                 case tb::i_starg:
                 case tb::i_stloc:
-                {
-                    auto arg = static_cast<uint16_t>(*(it++) | *(it++) << 8);
-                    return tuple<Instruction, vector<argument>, int8_t >(static_cast<Instruction>(lopcode), { arg }, stackBehaviour[_u(lopcode)]);
-                }
+                    instruction.operand.variable = read_value<uint16_t>(it, end);
+                    break;
 
                 // Object model instructions
                 // <instruction> [int32_t Token]
@@ -801,43 +738,114 @@ static tuple<Instruction, vector<argument>, int8_t > loadOp(ptrdiff_t offset, ve
                 case tb::i_ldftn:
                 case tb::i_ldvirtftn:
                 case tb::i_initobj:
-                {
-                    auto token = static_cast<uint32_t>(read_int32(it));
-                    return tuple<Instruction, vector<argument>, int8_t >(static_cast<Instruction>(lopcode), { token }, stackBehaviour[_u(lopcode)]);
-                }
+                    instruction.operand.token = read_value<uint32_t>(it, end);
+                    break;
 
-                // Prefixes
-                case tb::p_unaligned:
-                case tb::p_volatile:
-                case tb::p_tail:
+                // Prefixes are decoded as separate instructions which are followed by the prefixed one.
+                // constrained. [int32_t Token]
                 case tb::p_constrained:
+                    instruction.operand.token = read_value<uint32_t>(it, end);
+                    break;
+
+                // unaligned. [uint8_t alignment], no. [uint8_t checks]
+                case tb::p_unaligned:
                 case tb::p_no:
-                case tb::p_readonly: {}
+                    instruction.operand.i4 = read_value<uint8_t>(it, end);
+                    break;
+
+                // Argumentless instructions and prefixes
+                default:
+                    break;
             }
         }
+        break;
 
         default:
             // Direct conversion of parameterless instructions
-            return tuple<Instruction, vector<argument>, int8_t >(static_cast<Instruction>(opcode), {}, stackBehaviour[_u(opcode)]);
+            break;
     }
 }
 
+// Index of the instruction which starts at the given offset, instructions are sorted by their offsets.
+static uint32_t resolve_target(const DecodedInstruction* first, const DecodedInstruction* last, uint32_t offset) {
+    auto found = lower_bound(first, last, offset, [](const DecodedInstruction& instruction, uint32_t value) {
+        return instruction.offset < value;
+    });
+    if (found == last || found->offset != offset) {
+        throw runtime_error("Branch target isn't at instruction boundary");
+    }
+    return static_cast<uint32_t>(found - first);
+}
+
 shared_ptr<InstructionTree> InstructionTree::MakeTree(const vector<uint8_t>& methodData) {
-    auto treeObj = new InstructionTree();
-    vector<uint8_t> data = methodData;
+    return MakeTree(methodData.data(), methodData.size());
+}
 
-    for(auto it = data.begin(); it != data.end(); ) {
-        auto offset = distance(data.begin(), it);
-        auto op = loadOp(offset, it);
-        treeObj->tree[offset] = op;
+shared_ptr<InstructionTree> InstructionTree::MakeTree(const uint8_t* data, size_t size) {
+    shared_ptr<InstructionTree> treeObj(new InstructionTree());
+    const auto* end = data + size;
+
+    // Instructions and switch targets are counted first, so both are stored in one allocation.
+    uint32_t instructionsCount = 0, targetsCount = 0;
+    DecodedInstruction scratch;
+    for (auto it = data; it != end; ++instructionsCount) {
+        decodeOp(it, data, end, scratch, nullptr);
+        if (scratch.opcode == Instruction::i_switch) {
+            targetsCount += scratch.operand.table.count;
+        }
+    }
+
+    const auto targetRecords = (static_cast<size_t>(targetsCount) * sizeof(uint32_t) + sizeof(DecodedInstruction) - 1) / sizeof(DecodedInstruction);
+    treeObj->storage.reset(new DecodedInstruction[instructionsCount + targetRecords]);
+    treeObj->count = instructionsCount;
+    treeObj->switchTargets = reinterpret_cast<uint32_t*>(treeObj->storage.get() + instructionsCount);
+
+    auto* instructions = treeObj->storage.get();
+    auto* targets = treeObj->switchTargets;
+    uint32_t index = 0, targetIndex = 0;
+    for (auto it = data; it != end; ++index) {
+        auto& instruction = instructions[index];
+        decodeOp(it, data, end, instruction, targets + targetIndex);
+        if (instruction.opcode == Instruction::i_switch) {
+            instruction.operand.table.first = targetIndex;
+            targetIndex += instruction.operand.table.count;
+        }
+    }
 
-        vector<ptrdiff_t> vtargets;
-        if (is_branching(op, vtargets)) {
-            treeObj->targets.insert(treeObj->targets.end(), vtargets.begin(), vtargets.end());
+    // Offsets of branch targets are replaced by indexes of instructions.
+    const auto* last = instructions + instructionsCount;
+    for (auto* instruction = instructions; instruction != last; ++instruction) {
+        if (isBranch(instruction->opcode)) {
+            instruction->operand.target = resolve_target(instructions, last, instruction->operand.target);
         }
     }
+    for (uint32_t n = 0; n < targetsCount; ++n) {
+        targets[n] = resolve_target(instructions, last, targets[n]);
+    }
 
-    return shared_ptr<InstructionTree>(treeObj);
+    return treeObj;
+}
+
+bool InstructionTree::isBranch(Instruction opcode) {
+    switch (opcode) {
+    case Instruction::i_br:
+    case Instruction::i_brfalse:
+    case Instruction::i_brtrue:
+    case Instruction::i_beq:
+    case Instruction::i_bge:
+    case Instruction::i_bgt:
+    case Instruction::i_ble:
+    case Instruction::i_blt:
+    case Instruction::i_bne_un:
+    case Instruction::i_bge_un:
+    case Instruction::i_bgt_un:
+    case Instruction::i_ble_un:
+    case Instruction::i_blt_un:
+    case Instruction::i_leave:
+        return true;
+    default:
+        return false;
+    }
 }
 
 string InstructionTree::str() const {
@@ -845,12 +853,11 @@ string InstructionTree::str() const {
 
     ostringstream s;
 
-    for (const auto &item : tree) {
-        auto instr = get<0>(item.second);
-        auto args = get<1>(item.second);
-        auto offset = item.first;
+    for (const auto& instruction : *this) {
+        auto instr = instruction.opcode;
+        const auto& operand = instruction.operand;
 
-        s << hex << setw(4) << setfill('0') << offset;
+        s << hex << setw(4) << setfill('0') << instruction.offset;
 
         switch (instr) {
         // Local variable and argument operations
@@ -873,15 +880,15 @@ string InstructionTree::str() const {
                 throw runtime_error("We shouldn't be here.");
             }
 
-            s << " " << dec << args.begin()->get<uint16_t>();
+            s << " " << dec << operand.variable;
         }
         break;
 
         // Load number
-        case i::i_ldc_i4: s << ": ldc_i4 " << dec << args.begin()->get<int32_t>(); break;
-        case i::i_ldc_i8: s << ": ldc_i8 " << dec << args.begin()->get<int64_t>(); break;
-        case i::i_ldc_r4: s << ": ldc_r4 " << dec << args.begin()->get<float>(); break;
-        case i::i_ldc_r8: s << ": ldc_r8 " << dec << args.begin()->get<double>(); break;
+        case i::i_ldc_i4: s << ": ldc_i4 " << dec << operand.i4; break;
+        case i::i_ldc_i8: s << ": ldc_i8 " << dec << operand.i8; break;
+        case i::i_ldc_r4: s << ": ldc_r4 " << dec << operand.r4; break;
+        case i::i_ldc_r8: s << ": ldc_r8 " << dec << operand.r8; break;
 
         // Branching
         case i::i_br:
@@ -918,7 +925,7 @@ string InstructionTree::str() const {
                 throw runtime_error("We shouldn't be here.");
             }
 
-            s << " " << hex << args.begin()->get<ptrdiff_t>();
+            s << " " << hex << storage[operand.target].offset;
         }
         break;
 
@@ -927,12 +934,13 @@ string InstructionTree::str() const {
         case i::i_switch:
         {
             s << ": switch [" << hex << setw(4) << setfill('0');
-            for (const auto& elem : args) {
-                if (&elem != &args[0]) {
+            const auto* targets = getSwitchTargets(instruction);
+            for (uint32_t n = 0; n < operand.table.count; ++n) {
+                if (n != 0) {
                     s << ", ";
                 }
 
-                s << elem.get<ptrdiff_t>();
+                s << storage[targets[n]].offset;
             }
             s << "]";
         }
@@ -1066,6 +1074,14 @@ string InstructionTree::str() const {
         case i::i_ldnull: s << ": ldnull"; break;
         case i::i_refanytype: s << ": refanytype"; break;
 
+        // Prefixes
+        case i::i_unaligned: s << ": unaligned. " << dec << operand.i4; break;
+        case i::i_volatile: s << ": volatile."; break;
+        case i::i_tail: s << ": tail."; break;
+        case i::i_constrained: s << ": constrained. <" << operand.token << ">"; break;
+        case i::i_no: s << ": no. " << dec << operand.i4; break;
+        case i::i_readonly: s << ": readonly."; break;
+
         // Some object model instructions
         // <instruction> [uint32_t Token]
         case i::i_box: 
@@ -1136,7 +1152,7 @@ string InstructionTree::str() const {
                     throw runtime_error("We shouldn't be here.");
             }
 
-            s << " <" << args.begin()->get<uint32_t>() << ">";
+            s << " <" << operand.token << ">";
         }
         break;
 
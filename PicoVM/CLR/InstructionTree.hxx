@@ -1,15 +1,10 @@
 #ifndef __INSTRUCTIONTREE_HXX_
 #define __INSTRUCTIONTREE_HXX_
 
-#include <map>
-#include <tuple>
 #include <memory>
 #include <vector>
 #include <string>
 #include <cstdint>
-#include <mapbox/variant.hpp>
-
-typedef mapbox::util::variant<int8_t, int16_t, int32_t, int64_t, uint8_t, uint16_t, uint32_t, uint64_t, float, double> argument;
 
 // Enum for internal representation of instructions
 enum struct Instruction : uint16_t {
@@ -185,6 +180,14 @@ enum struct Instruction : uint16_t {
     i_sizeof = 0x1CFE,
     i_refanytype = 0x1DFE,
 
+    // Prefixes are kept as separate instructions, which are preceding the prefixed ones.
+    i_unaligned = 0x12FE,
+    i_volatile = 0x13FE,
+    i_tail = 0x14FE,
+    i_constrained = 0x16FE,
+    i_no = 0x19FE,
+    i_readonly = 0x1EFE,
+
     // These instructions are non-standard, their purpose is to be used internally by the VM in order to optimize evaluation.
 
     // Integer arithmetics. 
@@ -241,12 +244,62 @@ enum struct Instruction : uint16_t {
     i_lshr_un = 0x0264,
     i_lnot = 0x0266,
 
+    // Comparison operators, low byte is the second byte of IL opcode with high bits set
+    i_iceq = 0x01F1,
+    i_icgt = 0x01F2,
+    i_icgt_un = 0x01F3,
+    i_iclt = 0x01F4,
+    i_iclt_un = 0x01F5,
+    i_lceq = 0x02F1,
+    i_lcgt = 0x02F2,
+    i_lcgt_un = 0x02F3,
+    i_lclt = 0x02F4,
+    i_lclt_un = 0x02F5,
+    i_fceq = 0x03F1,
+    i_fcgt = 0x03F2,
+    i_fcgt_un = 0x03F3,
+    i_fclt = 0x03F4,
+    i_fclt_un = 0x03F5,
+
+    // Conditional branches
+    i_ibeq = 0x013B,
+    i_ibge = 0x013C,
+    i_ibgt = 0x013D,
+    i_ible = 0x013E,
+    i_iblt = 0x013F,
+    i_ibne_un = 0x0140,
+    i_ibge_un = 0x0141,
+    i_ibgt_un = 0x0142,
+    i_ible_un = 0x0143,
+    i_iblt_un = 0x0144,
+    i_lbeq = 0x023B,
+    i_lbge = 0x023C,
+    i_lbgt = 0x023D,
+    i_lble = 0x023E,
+    i_lblt = 0x023F,
+    i_lbne_un = 0x0240,
+    i_lbge_un = 0x0241,
+    i_lbgt_un = 0x0242,
+    i_lble_un = 0x0243,
+    i_lblt_un = 0x0244,
+    i_fbeq = 0x033B,
+    i_fbge = 0x033C,
+    i_fbgt = 0x033D,
+    i_fble = 0x033E,
+    i_fblt = 0x033F,
+    i_fbne_un = 0x0340,
+    i_fbge_un = 0x0341,
+    i_fbgt_un = 0x0342,
+    i_fble_un = 0x0343,
+    i_fblt_un = 0x0344,
+
     // Conversion operators
     i_i2b = 0x0167,
     i_i2ub = 0x01D2,
     i_i2s = 0x0168,
     i_i2us = 0x01D1,
     i_i2l = 0x016A,
+    i_i2ul = 0x016E,
     i_i2f = 0x016B,
     i_i2d = 0x016C,
     i_l2b = 0x0267,
@@ -257,9 +310,9 @@ enum struct Instruction : uint16_t {
     i_l2f = 0x026B,
     i_l2d = 0x026C,
     i_ui2f = 0x046B,
-    i_ui2d = 0x046B,
+    i_ui2d = 0x046C,
     i_ul2f = 0x056B,
-    i_ul2d = 0x056B,
+    i_ul2d = 0x056C,
     i_f2b = 0x0367,
     i_f2ub = 0x03D2,
     i_f2s = 0x0368,
@@ -309,18 +362,61 @@ enum struct Instruction : uint16_t {
     i_f2ul_ovf = 0x05BA,
 };
 
+// Decoded instruction with its operand in place. Short forms are expanded, and branch targets are indexes of
+//  the instructions in the same stream.
+struct DecodedInstruction {
+    struct Table {
+        // Range of switch targets, see InstructionTree::getSwitchTargets()
+        uint32_t first;
+        uint32_t count;
+    };
+
+    // IL offset of the instruction
+    uint32_t offset;
+    Instruction opcode;
+    // Change of evaluation stack depth, if it's known without looking at the operand
+    int8_t stackBehaviour;
+
+    union {
+        int32_t i4;
+        int64_t i8;
+        float r4;
+        double r8;
+        // Index of argument or local variable
+        uint16_t variable;
+        // Metadata token
+        uint32_t token;
+        // Index of branch target
+        uint32_t target;
+        Table table;
+    } operand;
+};
+
+// Method body decoded into one contiguous array. Instructions are followed by the switch targets, both of
+//  them are allocated at once, and the IL itself isn't copied.
 struct InstructionTree {
-    // Branch targets, will be suitable for linking
-    std::vector<ptrdiff_t> targets;
-    // offset -> (Operation code, [arg1, arg2, ...], stack activity)
-    typedef std::map<ptrdiff_t, std::tuple<Instruction, std::vector<argument>, int8_t > > TreeMap;
+    typedef const DecodedInstruction* const_iterator;
+
+    const_iterator begin() const { return storage.get(); }
+    const_iterator end() const { return storage.get() + count; }
+    size_t size() const { return count; }
+    const DecodedInstruction& operator[](size_t index) const { return storage[index]; }
+    DecodedInstruction& operator[](size_t index) { return storage[index]; }
+
+    // Indexes of instructions which are targets of the switch
+    const uint32_t* getSwitchTargets(const DecodedInstruction& instruction) const { return switchTargets + instruction.operand.table.first; }
 
     std::string str() const;
 
+    static bool isBranch(Instruction opcode);
+
     static std::shared_ptr<InstructionTree> MakeTree(const std::vector<uint8_t>& methodData);
+    static std::shared_ptr<InstructionTree> MakeTree(const uint8_t* data, size_t size);
 
 private:
-    TreeMap tree;
+    std::unique_ptr<DecodedInstruction[]> storage;
+    uint32_t* switchTargets = nullptr;
+    uint32_t count = 0;
 };
 
 #endif
@@ -0,0 +1,1883 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "Interpreter.hxx"
+#include "AppDomain.hxx"
+#include "Arithmetic.hxx"
+#include "EnumCasting.hxx"
+#include "InstructionTree.hxx"
+#include "Intrinsics.hxx"
+#include "ManagedHeap.hxx"
+#include "NumCasting.hxx"
+#include "Quickening.hxx"
+
+#if defined(__GNUC__) && !defined(USE_SWITCH_DISPATCH)
+    #define THREADED_DISPATCH
+#endif
+
+using namespace std;
+using et = CLIElementType;
+
+static inline bool isFloat(CLIElementType type) {
+    return type == et::ELEMENT_TYPE_R4 || type == et::ELEMENT_TYPE_R8;
+}
+
+// Whether integer of this stack type takes 64 bits
+static inline bool isWide(CLIElementType type) {
+    return type == et::ELEMENT_TYPE_I8 || (sizeof(size_t) == 8 && (type == et::ELEMENT_TYPE_I || type == et::ELEMENT_TYPE_U));
+}
+
+static double toDouble(uint64_t bits, CLIElementType type) {
+    switch (type) {
+    case et::ELEMENT_TYPE_R4:
+        return uintToFloat(static_cast<uint32_t>(bits));
+    case et::ELEMENT_TYPE_R8:
+        return ulongToDouble(bits);
+    case et::ELEMENT_TYPE_U:
+        return static_cast<double>(bits);
+    default:
+        return static_cast<double>(static_cast<int64_t>(bits));
+    }
+}
+
+// Integers are kept sign-extended, unsigned instructions are seeing only the bits of their width.
+static inline uint64_t toUnsigned(uint64_t bits, CLIElementType type) {
+    return isWide(type) ? bits : static_cast<uint32_t>(bits);
+}
+
+// Type of the result of binary numeric operation, ECMA-335 III.1.5 table 2. References are tracked as U.
+static CLIElementType getResultType(CLIElementType left, CLIElementType right) {
+    if (left == right) {
+        return left;
+    }
+    if (isFloat(left) && isFloat(right)) {
+        return et::ELEMENT_TYPE_R8;
+    }
+    const auto leftInteger = left == et::ELEMENT_TYPE_I4 || left == et::ELEMENT_TYPE_I;
+    const auto rightInteger = right == et::ELEMENT_TYPE_I4 || right == et::ELEMENT_TYPE_I;
+    if (leftInteger && rightInteger) {
+        return et::ELEMENT_TYPE_I;
+    }
+    if ((left == et::ELEMENT_TYPE_U && rightInteger) || (right == et::ELEMENT_TYPE_U && leftInteger)) {
+        return et::ELEMENT_TYPE_U;
+    }
+    throw runtime_error("Invalid operand types");
+}
+
+static void pushInteger(EvaluationStack& stack, CLIElementType type, int64_t value) {
+    switch (type) {
+    case et::ELEMENT_TYPE_I4:
+        stack.push_int32(static_cast<int32_t>(value));
+        break;
+    case et::ELEMENT_TYPE_I8:
+        stack.push_int64(value);
+        break;
+    case et::ELEMENT_TYPE_U:
+        stack.push_ref(static_cast<size_t>(value));
+        break;
+    default:
+        stack.push_nint(static_cast<ptrdiff_t>(value));
+        break;
+    }
+}
+
+static void pushFloat(EvaluationStack& stack, CLIElementType type, double value) {
+    if (type == et::ELEMENT_TYPE_R4) {
+        stack.push_float32(static_cast<float>(value));
+    } else {
+        stack.push_float64(value);
+    }
+}
+
+// Integer value on top of the stack, floats are truncated towards zero.
+static int64_t popInteger(EvaluationStack& stack) {
+    const auto type = stack.top();
+    const auto bits = stack.pop_bits();
+    return isFloat(type) ? truncateSigned(toDouble(bits, type)) : static_cast<int64_t>(bits);
+}
+
+// Same as popInteger, but integers are zero-extended from their width.
+static uint64_t popUnsigned(EvaluationStack& stack) {
+    const auto type = stack.top();
+    const auto bits = stack.pop_bits();
+    return isFloat(type) ? truncateUnsigned(toDouble(bits, type)) : toUnsigned(bits, type);
+}
+
+// Binary numeric instruction. Integer operation is given the type of result, so it could take care of width.
+template<typename IntegerOperation, typename FloatOperation>
+static void binaryOperation(EvaluationStack& stack, IntegerOperation integerOperation, FloatOperation floatOperation) {
+    const auto rightType = stack.top();
+    const auto right = stack.pop_bits();
+    const auto leftType = stack.top();
+    const auto left = stack.pop_bits();
+    const auto type = getResultType(leftType, rightType);
+    if (isFloat(type)) {
+        pushFloat(stack, type, floatOperation(toDouble(left, leftType), toDouble(right, rightType)));
+    } else {
+        pushInteger(stack, type, integerOperation(left, right, type));
+    }
+}
+
+static double noFloatOperation(double, double) {
+    throw runtime_error("Invalid operand types");
+}
+
+// Shift amount is masked by the width of value, ECMA-335 leaves larger amounts unspecified.
+template<typename ShiftOperation>
+static void shiftOperation(EvaluationStack& stack, ShiftOperation operation) {
+    const auto amount = static_cast<uint32_t>(stack.pop_bits());
+    const auto type = stack.top();
+    const auto value = stack.pop_bits();
+    if (isFloat(type)) {
+        throw runtime_error("Invalid operand types");
+    }
+    pushInteger(stack, type, operation(value, amount & (isWide(type) ? 63 : 31), type));
+}
+
+static void checkDivision(uint64_t left, uint64_t right, CLIElementType type) {
+    if (right == 0) {
+        throw runtime_error("Division by zero");
+    }
+    const auto minimal = isWide(type) ? static_cast<uint64_t>(INT64_MIN) : static_cast<uint64_t>(static_cast<int64_t>(INT32_MIN));
+    if (left == minimal && static_cast<int64_t>(right) == -1) {
+        throw runtime_error("Arithmetic overflow");
+    }
+}
+
+// Comparison of two values on top of the stack: -1, 0 or 1, and 2 if floats are unordered.
+static int compareValues(EvaluationStack& stack, bool isUnsigned) {
+    const auto rightType = stack.top();
+    const auto right = stack.pop_bits();
+    const auto leftType = stack.top();
+    const auto left = stack.pop_bits();
+    const auto type = getResultType(leftType, rightType);
+    if (isFloat(type)) {
+        const auto leftValue = toDouble(left, leftType);
+        const auto rightValue = toDouble(right, rightType);
+        return leftValue < rightValue ? -1 : leftValue > rightValue ? 1 : leftValue == rightValue ? 0 : 2;
+    }
+    if (isUnsigned || type == et::ELEMENT_TYPE_U) {
+        const auto leftValue = toUnsigned(left, type);
+        const auto rightValue = toUnsigned(right, type);
+        return leftValue < rightValue ? -1 : leftValue > rightValue ? 1 : 0;
+    }
+    const auto leftValue = static_cast<int64_t>(left);
+    const auto rightValue = static_cast<int64_t>(right);
+    return leftValue < rightValue ? -1 : leftValue > rightValue ? 1 : 0;
+}
+
+// Value as it's kept in variable of given type: small integers are truncated and extended back, floats are
+//  converted into the precision of variable.
+static uint64_t toVariable(uint64_t bits, CLIElementType valueType, CLIElementType variableType) {
+    switch (variableType) {
+    case et::ELEMENT_TYPE_I1:
+        return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(bits)));
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_U1:
+        return static_cast<uint8_t>(bits);
+    case et::ELEMENT_TYPE_I2:
+        return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(bits)));
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_U2:
+        return static_cast<uint16_t>(bits);
+    case et::ELEMENT_TYPE_I4:
+    case et::ELEMENT_TYPE_U4:
+        return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(bits)));
+    case et::ELEMENT_TYPE_R4:
+        return valueType == et::ELEMENT_TYPE_R4 ? bits : floatToUInt(static_cast<float>(toDouble(bits, valueType)));
+    case et::ELEMENT_TYPE_R8:
+        return valueType == et::ELEMENT_TYPE_R8 ? bits : doubleToULong(toDouble(bits, valueType));
+    default:
+        return bits;
+    }
+}
+
+// Arrays and indexes are taking one slot, so they are popped without looking at their tags.
+template<typename Stack>
+static ArrayObject* popArray(Stack& stack) {
+    const auto reference = stack.pop_unchecked_ref();
+    if (reference == 0) {
+        throw runtime_error("Null reference");
+    }
+    return reinterpret_cast<ArrayObject*>(reference);
+}
+
+// Address of array element, index and array are taken from the stack.
+template<typename Stack>
+static uint8_t* popElement(Stack& stack, CLIElementType elementType) {
+    const auto index = static_cast<int64_t>(stack.pop_unchecked_nint());
+    auto* array = popArray(stack);
+    if (index < 0 || static_cast<uint64_t>(index) >= array->length) {
+        throw runtime_error("Index out of range");
+    }
+    if (ManagedHeap::getElementSize(elementType) != array->elementSize) {
+        throw runtime_error("Array type mismatch");
+    }
+    return array->data() + static_cast<size_t>(index) * array->elementSize;
+}
+
+static void loadElement(EvaluationStack& stack, const uint8_t* element, CLIElementType elementType) {
+    switch (elementType) {
+    case et::ELEMENT_TYPE_I1:
+        stack.push_int32(*reinterpret_cast<const int8_t*>(element));
+        break;
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_U1:
+        stack.push_int32(*element);
+        break;
+    case et::ELEMENT_TYPE_I2:
+        stack.push_int32(*reinterpret_cast<const int16_t*>(element));
+        break;
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_U2:
+        stack.push_int32(*reinterpret_cast<const uint16_t*>(element));
+        break;
+    case et::ELEMENT_TYPE_I4:
+    case et::ELEMENT_TYPE_U4:
+        stack.push_int32(*reinterpret_cast<const int32_t*>(element));
+        break;
+    case et::ELEMENT_TYPE_I8:
+    case et::ELEMENT_TYPE_U8:
+        stack.push_int64(*reinterpret_cast<const int64_t*>(element));
+        break;
+    case et::ELEMENT_TYPE_R4:
+        stack.push_float32(*reinterpret_cast<const float*>(element));
+        break;
+    case et::ELEMENT_TYPE_R8:
+        stack.push_float64(*reinterpret_cast<const double*>(element));
+        break;
+    case et::ELEMENT_TYPE_I:
+    case et::ELEMENT_TYPE_U:
+        stack.push_nint(*reinterpret_cast<const ptrdiff_t*>(element));
+        break;
+    default:
+        stack.push_ref(*reinterpret_cast<const size_t*>(element));
+        break;
+    }
+}
+
+static void storeElement(uint8_t* element, CLIElementType elementType, uint64_t bits, CLIElementType valueType) {
+    switch (elementType) {
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_I1:
+    case et::ELEMENT_TYPE_U1:
+        *element = static_cast<uint8_t>(bits);
+        break;
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_I2:
+    case et::ELEMENT_TYPE_U2:
+        *reinterpret_cast<uint16_t*>(element) = static_cast<uint16_t>(bits);
+        break;
+    case et::ELEMENT_TYPE_I4:
+    case et::ELEMENT_TYPE_U4:
+        *reinterpret_cast<uint32_t*>(element) = static_cast<uint32_t>(bits);
+        break;
+    case et::ELEMENT_TYPE_I8:
+    case et::ELEMENT_TYPE_U8:
+        *reinterpret_cast<uint64_t*>(element) = bits;
+        break;
+    case et::ELEMENT_TYPE_R4:
+        *reinterpret_cast<float*>(element) = static_cast<float>(toDouble(bits, valueType));
+        break;
+    case et::ELEMENT_TYPE_R8:
+        *reinterpret_cast<double*>(element) = toDouble(bits, valueType);
+        break;
+    default:
+        *reinterpret_cast<size_t*>(element) = static_cast<size_t>(bits);
+        break;
+    }
+}
+
+// Values which are pushed and popped by the operations of one superinstruction are kept in its locals. Their
+//  positions are known when the handler is compiled, so they are getting into registers. Values below them are
+//  taken from the evaluation stack, and the rest is pushed there when superinstruction is done.
+class SuperinstructionStack {
+public:
+    explicit SuperinstructionStack(EvaluationStack& Stack) : stack(Stack) {}
+
+    void push_int32(int32_t value) { push_bits(static_cast<uint64_t>(static_cast<int64_t>(value)), et::ELEMENT_TYPE_I4); }
+    void push_int64(int64_t value) { push_bits(static_cast<uint64_t>(value), et::ELEMENT_TYPE_I8); }
+    void push_nint(ptrdiff_t value) { push_bits(static_cast<uint64_t>(static_cast<int64_t>(value)), et::ELEMENT_TYPE_I); }
+    void push_ref(size_t value) { push_bits(value, et::ELEMENT_TYPE_U); }
+    void push_float32(float value) { push_bits(floatToUInt(value), et::ELEMENT_TYPE_R4); }
+    void push_float64(double value) { push_bits(doubleToULong(value), et::ELEMENT_TYPE_R8); }
+
+    void push_bits(uint64_t bits, CLIElementType type) {
+        values[count] = bits;
+        types[count] = type;
+        ++count;
+    }
+
+    uint64_t pop_bits() { return count > 0 ? values[--count] : stack.pop_bits(); }
+    int32_t pop_unchecked_int32() { return count > 0 ? static_cast<int32_t>(values[--count]) : stack.pop_unchecked_int32(); }
+    int64_t pop_unchecked_int64() { return count > 0 ? static_cast<int64_t>(values[--count]) : stack.pop_unchecked_int64(); }
+    ptrdiff_t pop_unchecked_nint() { return count > 0 ? static_cast<ptrdiff_t>(values[--count]) : stack.pop_unchecked_nint(); }
+    size_t pop_unchecked_ref() { return count > 0 ? static_cast<size_t>(values[--count]) : stack.pop_unchecked_ref(); }
+    double pop_unchecked_float64() { return count > 0 ? ulongToDouble(values[--count]) : stack.pop_unchecked_float64(); }
+
+    void pop() {
+        if (count > 0) {
+            --count;
+        } else {
+            stack.pop();
+        }
+    }
+
+    void dup() {
+        if (count > 0) {
+            push_bits(values[count - 1], types[count - 1]);
+        } else {
+            stack.dup();
+        }
+    }
+
+    void flush() {
+        for (size_t index = 0; index < count; ++index) {
+            stack.push_bits(values[index], types[index]);
+        }
+        count = 0;
+    }
+
+private:
+    EvaluationStack& stack;
+    // Every operation pushes one value at most.
+    uint64_t values[4];
+    CLIElementType types[4];
+    size_t count = 0;
+};
+
+// Operations which are touching only the evaluation stack, variables and operands of their instructions. Both
+//  their own handlers and superinstructions are made of them, with EvaluationStack or SuperinstructionStack.
+//  Result is true if the jump to the target of instruction is taken.
+#if defined(__GNUC__)
+    #define OPERATION_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+    #define OPERATION_INLINE __forceinline
+#else
+    #define OPERATION_INLINE inline
+#endif
+#define OPERATION(name) template<typename Stack> static OPERATION_INLINE bool execute_##name
+
+OPERATION(op_nop)(Stack&, uint64_t*, const ThreadedInstruction*) {
+    return false;
+}
+
+OPERATION(op_ldvar)(Stack& stack, uint64_t* variables, const ThreadedInstruction* ip) {
+    stack.push_bits(variables[ip->operand.variable.index], ip->operand.variable.stackType);
+    return false;
+}
+
+// Variables of integer and reference types are getting values of their own stack type.
+OPERATION(op_stvar_i4)(Stack& stack, uint64_t* variables, const ThreadedInstruction* ip) {
+    variables[ip->operand.variable.index] = toVariable(static_cast<uint64_t>(static_cast<int64_t>(stack.pop_unchecked_int32())), et::ELEMENT_TYPE_I4, ip->operand.variable.type);
+    return false;
+}
+
+OPERATION(op_stvar_i8)(Stack& stack, uint64_t* variables, const ThreadedInstruction* ip) {
+    variables[ip->operand.variable.index] = static_cast<uint64_t>(stack.pop_unchecked_int64());
+    return false;
+}
+
+OPERATION(op_stvar_ref)(Stack& stack, uint64_t* variables, const ThreadedInstruction* ip) {
+    variables[ip->operand.variable.index] = stack.pop_unchecked_ref();
+    return false;
+}
+
+OPERATION(op_ldc_i4)(Stack& stack, uint64_t*, const ThreadedInstruction* ip) {
+    stack.push_int32(ip->operand.i4);
+    return false;
+}
+
+OPERATION(op_ldc_i8)(Stack& stack, uint64_t*, const ThreadedInstruction* ip) {
+    stack.push_int64(ip->operand.i8);
+    return false;
+}
+
+OPERATION(op_ldc_r4)(Stack& stack, uint64_t*, const ThreadedInstruction* ip) {
+    stack.push_float32(ip->operand.r4);
+    return false;
+}
+
+OPERATION(op_ldc_r8)(Stack& stack, uint64_t*, const ThreadedInstruction* ip) {
+    stack.push_float64(ip->operand.r8);
+    return false;
+}
+
+OPERATION(op_ldnull)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    stack.push_ref(0);
+    return false;
+}
+
+OPERATION(op_dup)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    stack.dup();
+    return false;
+}
+
+OPERATION(op_pop)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    stack.pop();
+    return false;
+}
+
+OPERATION(op_br)(Stack&, uint64_t*, const ThreadedInstruction*) {
+    return true;
+}
+
+OPERATION(op_brfalse)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    return stack.pop_bits() == 0;
+}
+
+OPERATION(op_brtrue)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    return stack.pop_bits() != 0;
+}
+
+OPERATION(op_ldlen)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    stack.push_nint(static_cast<ptrdiff_t>(popArray(stack)->length));
+    return false;
+}
+
+// Quickened instructions, types of their operands are known before execution.
+#define TYPED_BINARY(name, type, pop, push, expression) \
+    OPERATION(name)(Stack& stack, uint64_t*, const ThreadedInstruction*) { \
+        const type right = stack.pop(); \
+        const type left = stack.pop(); \
+        stack.push(expression); \
+        return false; \
+    }
+#define TYPED_UNARY(name, type, pop, push, expression) \
+    OPERATION(name)(Stack& stack, uint64_t*, const ThreadedInstruction*) { \
+        const type value = stack.pop(); \
+        stack.push(expression); \
+        return false; \
+    }
+#define TYPED_SHIFT(name, type, pop, push, expression) \
+    OPERATION(name)(Stack& stack, uint64_t*, const ThreadedInstruction*) { \
+        const auto amount = stack.pop_unchecked_int32(); \
+        const type value = stack.pop(); \
+        stack.push(expression); \
+        return false; \
+    }
+#define TYPED_BRANCH(name, type, pop, condition) \
+    OPERATION(name)(Stack& stack, uint64_t*, const ThreadedInstruction*) { \
+        const type right = stack.pop(); \
+        const type left = stack.pop(); \
+        return condition; \
+    }
+#define INTEGER_OPERATIONS(prefix, type, pop, push) \
+    TYPED_BINARY(op_##prefix##add, type, pop, push, wrappingAdd(left, right)) \
+    TYPED_BINARY(op_##prefix##sub, type, pop, push, wrappingSub(left, right)) \
+    TYPED_BINARY(op_##prefix##mul, type, pop, push, wrappingMul(left, right)) \
+    TYPED_BINARY(op_##prefix##div, type, pop, push, checkedDiv(left, right)) \
+    TYPED_BINARY(op_##prefix##div_un, type, pop, push, unsignedDiv(left, right)) \
+    TYPED_BINARY(op_##prefix##rem, type, pop, push, checkedRem(left, right)) \
+    TYPED_BINARY(op_##prefix##rem_un, type, pop, push, unsignedRem(left, right)) \
+    TYPED_BINARY(op_##prefix##and, type, pop, push, left & right) \
+    TYPED_BINARY(op_##prefix##or, type, pop, push, left | right) \
+    TYPED_BINARY(op_##prefix##xor, type, pop, push, left ^ right) \
+    TYPED_SHIFT(op_##prefix##shl, type, pop, push, shiftLeft(value, amount)) \
+    TYPED_SHIFT(op_##prefix##shr, type, pop, push, shiftRight(value, amount)) \
+    TYPED_SHIFT(op_##prefix##shr_un, type, pop, push, shiftRightUnsigned(value, amount)) \
+    TYPED_UNARY(op_##prefix##neg, type, pop, push, wrappingNeg(value)) \
+    TYPED_UNARY(op_##prefix##not, type, pop, push, ~value) \
+    TYPED_BINARY(op_##prefix##ceq, type, pop, push_int32, left == right) \
+    TYPED_BINARY(op_##prefix##cgt, type, pop, push_int32, left > right) \
+    TYPED_BINARY(op_##prefix##cgt_un, type, pop, push_int32, unsignedLess(right, left)) \
+    TYPED_BINARY(op_##prefix##clt, type, pop, push_int32, left < right) \
+    TYPED_BINARY(op_##prefix##clt_un, type, pop, push_int32, unsignedLess(left, right)) \
+    TYPED_BRANCH(op_##prefix##beq, type, pop, left == right) \
+    TYPED_BRANCH(op_##prefix##bge, type, pop, left >= right) \
+    TYPED_BRANCH(op_##prefix##bgt, type, pop, left > right) \
+    TYPED_BRANCH(op_##prefix##ble, type, pop, left <= right) \
+    TYPED_BRANCH(op_##prefix##blt, type, pop, left < right) \
+    TYPED_BRANCH(op_##prefix##bne_un, type, pop, left != right) \
+    TYPED_BRANCH(op_##prefix##bge_un, type, pop, !unsignedLess(left, right)) \
+    TYPED_BRANCH(op_##prefix##bgt_un, type, pop, unsignedLess(right, left)) \
+    TYPED_BRANCH(op_##prefix##ble_un, type, pop, !unsignedLess(right, left)) \
+    TYPED_BRANCH(op_##prefix##blt_un, type, pop, unsignedLess(left, right))
+
+INTEGER_OPERATIONS(i, int32_t, pop_unchecked_int32, push_int32)
+INTEGER_OPERATIONS(l, int64_t, pop_unchecked_int64, push_int64)
+
+// Unsigned and unordered comparisons are true for NaN operands.
+TYPED_BINARY(op_fadd, double, pop_unchecked_float64, push_float64, left + right)
+TYPED_BINARY(op_fsub, double, pop_unchecked_float64, push_float64, left - right)
+TYPED_BINARY(op_fmul, double, pop_unchecked_float64, push_float64, left * right)
+TYPED_BINARY(op_fdiv, double, pop_unchecked_float64, push_float64, left / right)
+TYPED_BINARY(op_frem, double, pop_unchecked_float64, push_float64, fmod(left, right))
+TYPED_UNARY(op_fneg, double, pop_unchecked_float64, push_float64, -value)
+TYPED_BINARY(op_fceq, double, pop_unchecked_float64, push_int32, left == right)
+TYPED_BINARY(op_fcgt, double, pop_unchecked_float64, push_int32, left > right)
+TYPED_BINARY(op_fcgt_un, double, pop_unchecked_float64, push_int32, !(left <= right))
+TYPED_BINARY(op_fclt, double, pop_unchecked_float64, push_int32, left < right)
+TYPED_BINARY(op_fclt_un, double, pop_unchecked_float64, push_int32, !(left >= right))
+TYPED_BRANCH(op_fbeq, double, pop_unchecked_float64, left == right)
+TYPED_BRANCH(op_fbge, double, pop_unchecked_float64, left >= right)
+TYPED_BRANCH(op_fbgt, double, pop_unchecked_float64, left > right)
+TYPED_BRANCH(op_fble, double, pop_unchecked_float64, left <= right)
+TYPED_BRANCH(op_fblt, double, pop_unchecked_float64, left < right)
+TYPED_BRANCH(op_fbne_un, double, pop_unchecked_float64, !(left == right))
+TYPED_BRANCH(op_fbge_un, double, pop_unchecked_float64, !(left < right))
+TYPED_BRANCH(op_fbgt_un, double, pop_unchecked_float64, !(left <= right))
+TYPED_BRANCH(op_fble_un, double, pop_unchecked_float64, !(left > right))
+TYPED_BRANCH(op_fblt_un, double, pop_unchecked_float64, !(left >= right))
+
+// Conversions are giving the same results as polymorphic ones.
+TYPED_UNARY(op_i2b, int32_t, pop_unchecked_int32, push_int32, static_cast<int8_t>(value))
+TYPED_UNARY(op_i2ub, int32_t, pop_unchecked_int32, push_int32, static_cast<uint8_t>(value))
+TYPED_UNARY(op_i2s, int32_t, pop_unchecked_int32, push_int32, static_cast<int16_t>(value))
+TYPED_UNARY(op_i2us, int32_t, pop_unchecked_int32, push_int32, static_cast<uint16_t>(value))
+TYPED_UNARY(op_i2l, int32_t, pop_unchecked_int32, push_int64, value)
+TYPED_UNARY(op_i2ul, int32_t, pop_unchecked_int32, push_int64, static_cast<uint32_t>(value))
+TYPED_UNARY(op_i2f, int32_t, pop_unchecked_int32, push_float32, static_cast<float>(static_cast<double>(value)))
+TYPED_UNARY(op_i2d, int32_t, pop_unchecked_int32, push_float64, value)
+TYPED_UNARY(op_ui2d, int32_t, pop_unchecked_int32, push_float64, static_cast<uint32_t>(value))
+TYPED_UNARY(op_l2b, int64_t, pop_unchecked_int64, push_int32, static_cast<int8_t>(value))
+TYPED_UNARY(op_l2ub, int64_t, pop_unchecked_int64, push_int32, static_cast<uint8_t>(value))
+TYPED_UNARY(op_l2s, int64_t, pop_unchecked_int64, push_int32, static_cast<int16_t>(value))
+TYPED_UNARY(op_l2us, int64_t, pop_unchecked_int64, push_int32, static_cast<uint16_t>(value))
+TYPED_UNARY(op_l2i, int64_t, pop_unchecked_int64, push_int32, static_cast<int32_t>(value))
+TYPED_UNARY(op_l2f, int64_t, pop_unchecked_int64, push_float32, static_cast<float>(static_cast<double>(value)))
+TYPED_UNARY(op_l2d, int64_t, pop_unchecked_int64, push_float64, static_cast<double>(value))
+TYPED_UNARY(op_ul2d, int64_t, pop_unchecked_int64, push_float64, static_cast<double>(static_cast<uint64_t>(value)))
+TYPED_UNARY(op_f2b, double, pop_unchecked_float64, push_int32, static_cast<int8_t>(truncateSigned(value)))
+TYPED_UNARY(op_f2ub, double, pop_unchecked_float64, push_int32, static_cast<uint8_t>(truncateSigned(value)))
+TYPED_UNARY(op_f2s, double, pop_unchecked_float64, push_int32, static_cast<int16_t>(truncateSigned(value)))
+TYPED_UNARY(op_f2us, double, pop_unchecked_float64, push_int32, static_cast<uint16_t>(truncateSigned(value)))
+TYPED_UNARY(op_f2i, double, pop_unchecked_float64, push_int32, static_cast<int32_t>(truncateSigned(value)))
+TYPED_UNARY(op_f2ui, double, pop_unchecked_float64, push_int32, static_cast<int32_t>(static_cast<uint32_t>(truncateUnsigned(value))))
+TYPED_UNARY(op_f2l, double, pop_unchecked_float64, push_int64, truncateSigned(value))
+TYPED_UNARY(op_f2ul, double, pop_unchecked_float64, push_int64, static_cast<int64_t>(truncateUnsigned(value)))
+TYPED_UNARY(op_d2f, double, pop_unchecked_float64, push_float32, static_cast<float>(value))
+
+#undef TYPED_BINARY
+#undef TYPED_UNARY
+#undef TYPED_SHIFT
+#undef TYPED_BRANCH
+#undef INTEGER_OPERATIONS
+
+// Array elements of the most common types
+OPERATION(op_ldelem_i4)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    stack.push_int32(*reinterpret_cast<const int32_t*>(popElement(stack, et::ELEMENT_TYPE_I4)));
+    return false;
+}
+
+OPERATION(op_ldelem_i8)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    stack.push_int64(*reinterpret_cast<const int64_t*>(popElement(stack, et::ELEMENT_TYPE_I8)));
+    return false;
+}
+
+OPERATION(op_ldelem_r8)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    stack.push_float64(*reinterpret_cast<const double*>(popElement(stack, et::ELEMENT_TYPE_R8)));
+    return false;
+}
+
+OPERATION(op_ldelem_ref)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    stack.push_ref(*reinterpret_cast<const size_t*>(popElement(stack, et::ELEMENT_TYPE_CLASS)));
+    return false;
+}
+
+OPERATION(op_stelem_i4)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    const auto value = stack.pop_unchecked_int32();
+    *reinterpret_cast<int32_t*>(popElement(stack, et::ELEMENT_TYPE_I4)) = value;
+    return false;
+}
+
+OPERATION(op_stelem_i8)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    const auto value = stack.pop_unchecked_int64();
+    *reinterpret_cast<int64_t*>(popElement(stack, et::ELEMENT_TYPE_I8)) = value;
+    return false;
+}
+
+OPERATION(op_stelem_ref)(Stack& stack, uint64_t*, const ThreadedInstruction*) {
+    const auto value = stack.pop_unchecked_ref();
+    *reinterpret_cast<size_t*>(popElement(stack, et::ELEMENT_TYPE_CLASS)) = value;
+    return false;
+}
+
+#undef OPERATION_INLINE
+#undef OPERATION
+
+CallStackItem Interpreter::makeFrame(ExecutionThread& thread, const RuntimeMethod& method) {
+    CallStackItem frame;
+    frame.appDomain = thread.domain;
+    frame.thread = &thread;
+    frame.callingAssembly = frame.executingAssembly = method.assembly;
+    frame.tokens = method.tokens;
+    frame.methodDef = method.methodDef;
+    frame.method = &method;
+    frame.methodToken = 0x06000000 | method.methodDefRow;
+    frame.state = ExecutionState::MethodBodyExecution;
+    return frame;
+}
+
+void Interpreter::execute(ExecutionThread& thread) {
+    run(&thread);
+}
+
+const void* const* Interpreter::run(ExecutionThread* thread) {
+#ifdef THREADED_DISPATCH
+    #define INTERPRETER_OPCODE_HANDLER(name) &&L_##name,
+#else
+    #define INTERPRETER_OPCODE_HANDLER(name) reinterpret_cast<const void*>(static_cast<uintptr_t>(InterpreterOpcode::name)),
+#endif
+    #define SUPERINSTRUCTION_HANDLER(name, length, first, second, third, fourth) INTERPRETER_OPCODE_HANDLER(name)
+    static const void* const handlers[] = {
+        INTERPRETER_OPCODES(INTERPRETER_OPCODE_HANDLER)
+        SUPERINSTRUCTIONS(SUPERINSTRUCTION_HANDLER)
+    };
+    #undef INTERPRETER_OPCODE_HANDLER
+    #undef SUPERINSTRUCTION_HANDLER
+
+    if (thread == nullptr) {
+        return handlers;
+    }
+
+    auto& stack = thread->evaluationStack;
+    auto& callStack = thread->callStack;
+    const auto depth = callStack.size();
+    auto* frame = &callStack.back();
+    const ThreadedInstruction* code = nullptr;
+    const uint32_t* switchTargets = nullptr;
+    uint64_t* variables = nullptr;
+    const RuntimeMethod* callee = nullptr;
+    uint64_t executed = 0;
+
+// Variables are reloaded after every call, since the callee could reallocate them.
+#define LOAD_FRAME() \
+    do { \
+        code = frame->code->instructions.data(); \
+        switchTargets = frame->code->switchTargets.data(); \
+        variables = thread->variables.data() + frame->variablesBase; \
+    } while (0)
+
+#ifdef THREADED_DISPATCH
+    #define HANDLER(name) L_##name:
+    #define DISPATCH() do { ++executed; goto *ip->handler; } while (0)
+#else
+    #define HANDLER(name) case InterpreterOpcode::name:
+    #define DISPATCH() do { ++executed; goto dispatch; } while (0)
+#endif
+#define NEXT() do { ++ip; DISPATCH(); } while (0)
+#define JUMP(index) do { ip = code + (index); DISPATCH(); } while (0)
+#define BRANCH(condition) do { if (condition) JUMP(ip->operand.target); NEXT(); } while (0)
+
+    LOAD_FRAME();
+    const ThreadedInstruction* ip = code + frame->instructionPointer;
+    DISPATCH();
+
+#ifndef THREADED_DISPATCH
+dispatch:
+    switch (static_cast<InterpreterOpcode>(reinterpret_cast<uintptr_t>(ip->handler))) {
+#endif
+
+    HANDLER(op_unsupported)
+        throw runtime_error("Unsupported instruction " + to_string(ip->operand.i4));
+
+    HANDLER(op_stvar)
+    {
+        const auto type = stack.top();
+        variables[ip->operand.variable.index] = toVariable(stack.pop_bits(), type, ip->operand.variable.type);
+        NEXT();
+    }
+
+    HANDLER(op_ldstr)
+        stack.push_ref(reinterpret_cast<size_t>(ip->operand.object));
+        NEXT();
+
+    HANDLER(op_callvirt)
+    {
+        callee = ip->operand.method;
+        const auto object = static_cast<size_t>(stack.peek_bits(static_cast<uint32_t>(callee->arguments.size() - 1)));
+        if (object == 0) {
+            throw runtime_error("Null reference");
+        }
+        const auto* objectType = reinterpret_cast<const ObjectHeader*>(object)->methodTable;
+        if (objectType != nullptr) {
+            callee = &thread->domain->resolveVirtualMethod(*objectType, *callee);
+        }
+        goto invoke;
+    }
+
+    HANDLER(op_call)
+        callee = ip->operand.method;
+    invoke:
+        if (callee->native != nullptr) {
+            callee->native(*thread);
+            NEXT();
+        }
+        frame->instructionPointer = static_cast<uint32_t>(ip - code) + 1;
+        callStack.push_back(makeFrame(*thread, *callee));
+        frame = &callStack.back();
+        enterFrame(*thread, *frame);
+        LOAD_FRAME();
+        ip = code;
+        DISPATCH();
+
+    HANDLER(op_ret)
+        thread->variables.resize(frame->variablesBase);
+        callStack.pop_back();
+        if (callStack.size() < depth) {
+            thread->executedInstructions += executed;
+            return handlers;
+        }
+        frame = &callStack.back();
+        LOAD_FRAME();
+        ip = code + frame->instructionPointer;
+        DISPATCH();
+
+    HANDLER(op_beq)
+        BRANCH(compareValues(stack, false) == 0);
+
+    HANDLER(op_bge)
+    {
+        const auto result = compareValues(stack, false);
+        BRANCH(result == 0 || result == 1);
+    }
+
+    HANDLER(op_bgt)
+        BRANCH(compareValues(stack, false) == 1);
+
+    HANDLER(op_ble)
+    {
+        const auto result = compareValues(stack, false);
+        BRANCH(result == 0 || result == -1);
+    }
+
+    HANDLER(op_blt)
+        BRANCH(compareValues(stack, false) == -1);
+
+    // Unsigned branches are taken for unordered floats as well.
+    HANDLER(op_bne_un)
+        BRANCH(compareValues(stack, true) != 0);
+
+    HANDLER(op_bge_un)
+        BRANCH(compareValues(stack, true) != -1);
+
+    HANDLER(op_bgt_un)
+    {
+        const auto result = compareValues(stack, true);
+        BRANCH(result == 1 || result == 2);
+    }
+
+    HANDLER(op_ble_un)
+        BRANCH(compareValues(stack, true) != 1);
+
+    HANDLER(op_blt_un)
+    {
+        const auto result = compareValues(stack, true);
+        BRANCH(result == -1 || result == 2);
+    }
+
+    HANDLER(op_switch)
+    {
+        const auto value = static_cast<uint32_t>(stack.pop_bits());
+        if (value < ip->operand.table.count) {
+            JUMP(switchTargets[ip->operand.table.first + value]);
+        }
+        NEXT();
+    }
+
+    // Leave from the regions of finally and fault handlers is unsupported, the others are just emptying the stack.
+    HANDLER(op_leave)
+        stack.data.resize(frame->stackBase);
+        JUMP(ip->operand.target);
+
+    HANDLER(op_add)
+        binaryOperation(stack,
+            [](uint64_t left, uint64_t right, CLIElementType) { return static_cast<int64_t>(left + right); },
+            [](double left, double right) { return left + right; });
+        NEXT();
+
+    HANDLER(op_sub)
+        binaryOperation(stack,
+            [](uint64_t left, uint64_t right, CLIElementType) { return static_cast<int64_t>(left - right); },
+            [](double left, double right) { return left - right; });
+        NEXT();
+
+    HANDLER(op_mul)
+        binaryOperation(stack,
+            [](uint64_t left, uint64_t right, CLIElementType) { return static_cast<int64_t>(left * right); },
+            [](double left, double right) { return left * right; });
+        NEXT();
+
+    HANDLER(op_div)
+        binaryOperation(stack,
+            [](uint64_t left, uint64_t right, CLIElementType type) {
+                checkDivision(left, right, type);
+                return static_cast<int64_t>(left) / static_cast<int64_t>(right);
+            },
+            [](double left, double right) { return left / right; });
+        NEXT();
+
+    HANDLER(op_div_un)
+        binaryOperation(stack,
+            [](uint64_t left, uint64_t right, CLIElementType type) {
+                if (toUnsigned(right, type) == 0) {
+                    throw runtime_error("Division by zero");
+                }
+                return static_cast<int64_t>(toUnsigned(left, type) / toUnsigned(right, type));
+            },
+            noFloatOperation);
+        NEXT();
+
+    HANDLER(op_rem)
+        binaryOperation(stack,
+            [](uint64_t left, uint64_t right, CLIElementType type) {
+                checkDivision(left, right, type);
+                return static_cast<int64_t>(left) % static_cast<int64_t>(right);
+            },
+            [](double left, double right) { return fmod(left, right); });
+        NEXT();
+
+    HANDLER(op_rem_un)
+        binaryOperation(stack,
+            [](uint64_t left, uint64_t right, CLIElementType type) {
+                if (toUnsigned(right, type) == 0) {
+                    throw runtime_error("Division by zero");
+                }
+                return static_cast<int64_t>(toUnsigned(left, type) % toUnsigned(right, type));
+            },
+            noFloatOperation);
+        NEXT();
+
+    HANDLER(op_and)
+        binaryOperation(stack, [](uint64_t left, uint64_t right, CLIElementType) { return static_cast<int64_t>(left & right); }, noFloatOperation);
+        NEXT();
+
+    HANDLER(op_or)
+        binaryOperation(stack, [](uint64_t left, uint64_t right, CLIElementType) { return static_cast<int64_t>(left | right); }, noFloatOperation);
+        NEXT();
+
+    HANDLER(op_xor)
+        binaryOperation(stack, [](uint64_t left, uint64_t right, CLIElementType) { return static_cast<int64_t>(left ^ right); }, noFloatOperation);
+        NEXT();
+
+    HANDLER(op_shl)
+        shiftOperation(stack, [](uint64_t value, uint32_t amount, CLIElementType) { return static_cast<int64_t>(value << amount); });
+        NEXT();
+
+    HANDLER(op_shr)
+        shiftOperation(stack, [](uint64_t value, uint32_t amount, CLIElementType) { return static_cast<int64_t>(value) >> amount; });
+        NEXT();
+
+    HANDLER(op_shr_un)
+        shiftOperation(stack, [](uint64_t value, uint32_t amount, CLIElementType type) { return static_cast<int64_t>(toUnsigned(value, type) >> amount); });
+        NEXT();
+
+    HANDLER(op_neg)
+    {
+        const auto type = stack.top();
+        const auto value = stack.pop_bits();
+        if (isFloat(type)) {
+            pushFloat(stack, type, -toDouble(value, type));
+        } else {
+            pushInteger(stack, type, static_cast<int64_t>(0 - value));
+        }
+        NEXT();
+    }
+
+    HANDLER(op_not)
+    {
+        const auto type = stack.top();
+        const auto value = stack.pop_bits();
+        if (isFloat(type)) {
+            throw runtime_error("Invalid operand types");
+        }
+        pushInteger(stack, type, static_cast<int64_t>(~value));
+        NEXT();
+    }
+
+    HANDLER(op_ceq)
+        stack.push_int32(compareValues(stack, false) == 0);
+        NEXT();
+
+    HANDLER(op_cgt)
+        stack.push_int32(compareValues(stack, false) == 1);
+        NEXT();
+
+    HANDLER(op_cgt_un)
+    {
+        const auto result = compareValues(stack, true);
+        stack.push_int32(result == 1 || result == 2);
+        NEXT();
+    }
+
+    HANDLER(op_clt)
+        stack.push_int32(compareValues(stack, false) == -1);
+        NEXT();
+
+    HANDLER(op_clt_un)
+    {
+        const auto result = compareValues(stack, true);
+        stack.push_int32(result == -1 || result == 2);
+        NEXT();
+    }
+
+    HANDLER(op_conv_i1)
+        stack.push_int32(static_cast<int8_t>(popInteger(stack)));
+        NEXT();
+
+    HANDLER(op_conv_i2)
+        stack.push_int32(static_cast<int16_t>(popInteger(stack)));
+        NEXT();
+
+    HANDLER(op_conv_i4)
+        stack.push_int32(static_cast<int32_t>(popInteger(stack)));
+        NEXT();
+
+    HANDLER(op_conv_i8)
+        stack.push_int64(popInteger(stack));
+        NEXT();
+
+    HANDLER(op_conv_u1)
+        stack.push_int32(static_cast<uint8_t>(popInteger(stack)));
+        NEXT();
+
+    HANDLER(op_conv_u2)
+        stack.push_int32(static_cast<uint16_t>(popInteger(stack)));
+        NEXT();
+
+    HANDLER(op_conv_u4)
+        stack.push_int32(static_cast<int32_t>(static_cast<uint32_t>(popUnsigned(stack))));
+        NEXT();
+
+    HANDLER(op_conv_u8)
+        stack.push_int64(static_cast<int64_t>(popUnsigned(stack)));
+        NEXT();
+
+    HANDLER(op_conv_i)
+        stack.push_nint(static_cast<ptrdiff_t>(popInteger(stack)));
+        NEXT();
+
+    HANDLER(op_conv_u)
+        stack.push_nint(static_cast<ptrdiff_t>(popUnsigned(stack)));
+        NEXT();
+
+    HANDLER(op_conv_r4)
+    {
+        const auto type = stack.top();
+        stack.push_float32(static_cast<float>(toDouble(stack.pop_bits(), type)));
+        NEXT();
+    }
+
+    HANDLER(op_conv_r8)
+    {
+        const auto type = stack.top();
+        stack.push_float64(toDouble(stack.pop_bits(), type));
+        NEXT();
+    }
+
+    HANDLER(op_conv_r_un)
+    {
+        const auto type = stack.top();
+        const auto value = stack.pop_bits();
+        stack.push_float64(isFloat(type) ? toDouble(value, type) : static_cast<double>(toUnsigned(value, type)));
+        NEXT();
+    }
+
+    HANDLER(op_newarr)
+    {
+        const auto length = popInteger(stack);
+        if (length < 0) {
+            throw runtime_error("Array length is negative");
+        }
+        stack.push_ref(reinterpret_cast<size_t>(thread->domain->heap.newArray(ip->operand.elementType, static_cast<size_t>(length))));
+        NEXT();
+    }
+
+    HANDLER(op_ldelem)
+    {
+        const auto* element = popElement(stack, ip->operand.elementType);
+        loadElement(stack, element, ip->operand.elementType);
+        NEXT();
+    }
+
+    HANDLER(op_stelem)
+    {
+        const auto type = stack.top();
+        const auto value = stack.pop_bits();
+        storeElement(popElement(stack, ip->operand.elementType), ip->operand.elementType, value, type);
+        NEXT();
+    }
+
+    HANDLER(op_throw)
+    HANDLER(op_rethrow)
+        throw runtime_error("Managed exceptions aren't supported yet");
+
+// Operations are jumping to the target of their instruction when they are returning true.
+#define OPERATION_HANDLER(name) \
+    HANDLER(name) \
+        if (execute_##name(stack, variables, ip)) { \
+            JUMP(ip->operand.target); \
+        } \
+        NEXT();
+
+    INTERPRETER_OPERATIONS(OPERATION_HANDLER)
+    INTERPRETER_JUMPS(OPERATION_HANDLER)
+
+#undef OPERATION_HANDLER
+
+// Superinstructions are executing the operations of several instructions with one dispatch. Instructions after
+//  the first one are kept in the code with their own handlers, since they could be branch targets.
+#define SUPERINSTRUCTION_STEP(name, length, index) \
+    if (index < length && execute_##name(top, variables, ip + index)) { \
+        top.flush(); \
+        executed += index; \
+        JUMP(ip[index].operand.target); \
+    }
+#define SUPERINSTRUCTION_HANDLER(name, length, first, second, third, fourth) \
+    HANDLER(name) \
+    { \
+        SuperinstructionStack top(stack); \
+        SUPERINSTRUCTION_STEP(first, length, 0) \
+        SUPERINSTRUCTION_STEP(second, length, 1) \
+        SUPERINSTRUCTION_STEP(third, length, 2) \
+        SUPERINSTRUCTION_STEP(fourth, length, 3) \
+        top.flush(); \
+        executed += length - 1; \
+        ip += length; \
+        DISPATCH(); \
+    }
+
+    SUPERINSTRUCTIONS(SUPERINSTRUCTION_HANDLER)
+
+#undef SUPERINSTRUCTION_STEP
+#undef SUPERINSTRUCTION_HANDLER
+
+#ifndef THREADED_DISPATCH
+    default:
+        throw runtime_error("Invalid interpreter opcode");
+    }
+#endif
+
+#undef LOAD_FRAME
+#undef HANDLER
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+#undef BRANCH
+}
+
+void Interpreter::enterFrame(ExecutionThread& thread, CallStackItem& frame) {
+    const auto& method = *frame.method;
+    const auto& code = getCode(*thread.domain, method);
+    frame.code = &code;
+    frame.methodBody = code.body;
+    frame.localVarSig = code.body->localVarSig;
+    frame.methodDefSig = method.methodDef->signature;
+
+    // Locals are zero-filled as if the method had InitLocals flag.
+    auto& variables = thread.variables;
+    auto& stack = thread.evaluationStack;
+    const auto argumentsCount = static_cast<uint32_t>(method.arguments.size());
+    frame.variablesBase = static_cast<uint32_t>(variables.size());
+    variables.resize(variables.size() + argumentsCount + code.locals.size());
+    auto* arguments = variables.data() + frame.variablesBase;
+    for (auto n = argumentsCount; n-- > 0; ) {
+        const auto type = stack.top();
+        arguments[n] = toVariable(stack.pop_bits(), type, method.arguments[n].type);
+    }
+
+    frame.argumentsCount = argumentsCount;
+    frame.stackBase = stack.data.size();
+    frame.instructionPointer = 0;
+    frame.state = ExecutionState::MethodExecution;
+}
+
+const ThreadedCode& Interpreter::getCode(AppDomain& domain, const RuntimeMethod& method) {
+    auto& cache = method.tokens->methodCode;
+    auto cached = cache.get(method.methodDefRow - 1);
+    if (cached != nullptr) {
+        return *cached;
+    }
+    return *cache.publish(method.methodDefRow - 1, compile(domain, method));
+}
+
+static uint32_t readItem(const uint32_t*& it, const uint32_t* end) {
+    if (it == end) {
+        throw runtime_error("Invalid signature");
+    }
+    return *it++;
+}
+
+static void skipType(const uint32_t*& it, const uint32_t* end) {
+    switch (static_cast<et>(readItem(it, end))) {
+    case et::ELEMENT_TYPE_PTR:
+    case et::ELEMENT_TYPE_BYREF:
+    case et::ELEMENT_TYPE_SZARRAY:
+    case et::ELEMENT_TYPE_PINNED:
+    case et::ELEMENT_TYPE_SENTINEL:
+        skipType(it, end);
+        break;
+    case et::ELEMENT_TYPE_CMOD_REQD:
+    case et::ELEMENT_TYPE_CMOD_OPT:
+        readItem(it, end);
+        skipType(it, end);
+        break;
+    case et::ELEMENT_TYPE_VALUETYPE:
+    case et::ELEMENT_TYPE_CLASS:
+    case et::ELEMENT_TYPE_VAR:
+    case et::ELEMENT_TYPE_MVAR:
+        readItem(it, end);
+        break;
+    case et::ELEMENT_TYPE_ARRAY:
+    {
+        // Type, rank, sizes and lower bounds
+        skipType(it, end);
+        readItem(it, end);
+        for (auto sizes = readItem(it, end); sizes > 0; --sizes) {
+            readItem(it, end);
+        }
+        for (auto bounds = readItem(it, end); bounds > 0; --bounds) {
+            readItem(it, end);
+        }
+        break;
+    }
+    case et::ELEMENT_TYPE_GENERICINST:
+    {
+        skipType(it, end);
+        for (auto arguments = readItem(it, end); arguments > 0; --arguments) {
+            skipType(it, end);
+        }
+        break;
+    }
+    case et::ELEMENT_TYPE_FNPTR:
+    {
+        const auto flags = readItem(it, end);
+        if ((flags & _u(CLISignatureFlags::SIG_GENERIC)) != 0) {
+            readItem(it, end);
+        }
+        auto parameters = readItem(it, end);
+        skipType(it, end);
+        for (; parameters > 0; --parameters) {
+            skipType(it, end);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static VariableType makeVariableType(CLIElementType type) {
+    switch (type) {
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_I1:
+    case et::ELEMENT_TYPE_U1:
+    case et::ELEMENT_TYPE_I2:
+    case et::ELEMENT_TYPE_U2:
+    case et::ELEMENT_TYPE_I4:
+    case et::ELEMENT_TYPE_U4:
+        return VariableType(et::ELEMENT_TYPE_I4, type);
+    case et::ELEMENT_TYPE_I8:
+    case et::ELEMENT_TYPE_U8:
+        return VariableType(et::ELEMENT_TYPE_I8, type);
+    case et::ELEMENT_TYPE_R4:
+    case et::ELEMENT_TYPE_R8:
+        return VariableType(type, type);
+    case et::ELEMENT_TYPE_I:
+    case et::ELEMENT_TYPE_U:
+        return VariableType(et::ELEMENT_TYPE_I, type);
+    case et::ELEMENT_TYPE_CLASS:
+        return VariableType(et::ELEMENT_TYPE_U, type);
+    default:
+        return VariableType(et::ELEMENT_TYPE_VALUETYPE, type);
+    }
+}
+
+// Element type of the values of TypeDef row. Primitive types of mscorlib and enums are kept in one stack slot,
+//  other value types aren't supported yet, and all remaining types are references.
+static CLIElementType getTypeElement(AppDomain& domain, const AssemblyData* assembly, uint32_t typeDefRow) {
+    static const pair<const char*, CLIElementType> primitives[] = {
+        { "Boolean", et::ELEMENT_TYPE_BOOLEAN },
+        { "Char", et::ELEMENT_TYPE_CHAR },
+        { "SByte", et::ELEMENT_TYPE_I1 },
+        { "Byte", et::ELEMENT_TYPE_U1 },
+        { "Int16", et::ELEMENT_TYPE_I2 },
+        { "UInt16", et::ELEMENT_TYPE_U2 },
+        { "Int32", et::ELEMENT_TYPE_I4 },
+        { "UInt32", et::ELEMENT_TYPE_U4 },
+        { "Int64", et::ELEMENT_TYPE_I8 },
+        { "UInt64", et::ELEMENT_TYPE_U8 },
+        { "Single", et::ELEMENT_TYPE_R4 },
+        { "Double", et::ELEMENT_TYPE_R8 },
+        { "IntPtr", et::ELEMENT_TYPE_I },
+        { "UIntPtr", et::ELEMENT_TYPE_U },
+        // Base types of value types are classes themselves
+        { "ValueType", et::ELEMENT_TYPE_CLASS },
+        { "Enum", et::ELEMENT_TYPE_CLASS },
+    };
+
+    const auto& typeDefs = assembly->cliMetaDataTables._TypeDef;
+    if (typeDefRow == 0 || typeDefRow > typeDefs.size()) {
+        throw runtime_error("Invalid TypeDef index");
+    }
+    const auto& typeDef = typeDefs[typeDefRow - 1];
+    const auto& strings = assembly->getStrings();
+    if (strings.equals(typeDef.typeNamespace, "System")) {
+        for (const auto& primitive : primitives) {
+            if (strings.equals(typeDef.typeName, primitive.first)) {
+                return primitive.second;
+            }
+        }
+    }
+
+    const auto& extends = typeDef.extendsType;
+    pair<const AssemblyData*, uint32_t> parent;
+    switch (extends.second) {
+    case CLIMetadataTableItem::TypeDef:
+        parent = make_pair(assembly, extends.first);
+        break;
+    case CLIMetadataTableItem::TypeRef:
+        parent = domain.resolveTypeRef(assembly, extends.first);
+        break;
+    default:
+        // Interfaces, System.Object and types with generic parents
+        return et::ELEMENT_TYPE_CLASS;
+    }
+    if (parent.second == 0) {
+        return et::ELEMENT_TYPE_CLASS;
+    }
+
+    const auto& parentDef = parent.first->cliMetaDataTables._TypeDef[parent.second - 1];
+    const auto& parentStrings = parent.first->getStrings();
+    if (!parentStrings.equals(parentDef.typeNamespace, "System")) {
+        return et::ELEMENT_TYPE_CLASS;
+    }
+    if (parentStrings.equals(parentDef.typeName, "ValueType")) {
+        return et::ELEMENT_TYPE_VALUETYPE;
+    }
+    if (parentStrings.equals(parentDef.typeName, "Enum")) {
+        // Underlying type is the type of the only instance field
+        const auto fields = assembly->getFields(typeDefRow);
+        for (auto row = fields.first; row < fields.last; ++row) {
+            const auto& field = assembly->cliMetaDataTables._FieldDef[row - 1];
+            if ((field.flags & _u(FieldDefRow::FieldAttributes::Static)) == 0 && field.signature->size() > 1) {
+                return static_cast<CLIElementType>((*field.signature)[1]);
+            }
+        }
+        throw runtime_error("Enum has no underlying type");
+    }
+    return et::ELEMENT_TYPE_CLASS;
+}
+
+// Element type of TypeDef, TypeRef or TypeSpec token of instruction
+static CLIElementType getTokenElement(AppDomain& domain, const AssemblyData* assembly, uint32_t token) {
+    const auto row = token & 0xFFFFFF;
+    switch (static_cast<CLIMetadataTableItem>(token >> 24)) {
+    case CLIMetadataTableItem::TypeDef:
+        return getTypeElement(domain, assembly, row);
+    case CLIMetadataTableItem::TypeRef:
+    {
+        const auto resolved = domain.resolveTypeRef(assembly, row);
+        return getTypeElement(domain, resolved.first, resolved.second);
+    }
+    case CLIMetadataTableItem::TypeSpec:
+    {
+        const auto& typeSpecs = assembly->cliMetaDataTables._TypeSpec;
+        if (row == 0 || row > typeSpecs.size() || typeSpecs[row - 1].signature->empty()) {
+            throw runtime_error("Invalid TypeSpec index");
+        }
+        const auto& signature = *typeSpecs[row - 1].signature;
+        switch (static_cast<et>(signature[0])) {
+        case et::ELEMENT_TYPE_GENERICINST:
+            return signature.size() > 1 && signature[1] == _u(et::ELEMENT_TYPE_CLASS) ? et::ELEMENT_TYPE_CLASS : et::ELEMENT_TYPE_VALUETYPE;
+        case et::ELEMENT_TYPE_PTR:
+        case et::ELEMENT_TYPE_FNPTR:
+            return et::ELEMENT_TYPE_I;
+        case et::ELEMENT_TYPE_VAR:
+        case et::ELEMENT_TYPE_MVAR:
+            return et::ELEMENT_TYPE_VALUETYPE;
+        default:
+            return et::ELEMENT_TYPE_CLASS;
+        }
+    }
+    default:
+        throw runtime_error("Invalid type token");
+    }
+}
+
+// Type of argument or local variable, iterator is moved past the type.
+static VariableType readVariableType(AppDomain& domain, const AssemblyData* assembly, const uint32_t*& it, const uint32_t* end) {
+    const auto start = it;
+    const auto element = static_cast<et>(readItem(it, end));
+    switch (element) {
+    case et::ELEMENT_TYPE_CMOD_REQD:
+    case et::ELEMENT_TYPE_CMOD_OPT:
+        readItem(it, end);
+        return readVariableType(domain, assembly, it, end);
+    case et::ELEMENT_TYPE_PINNED:
+        return readVariableType(domain, assembly, it, end);
+    case et::ELEMENT_TYPE_STRING:
+    case et::ELEMENT_TYPE_OBJECT:
+    case et::ELEMENT_TYPE_CLASS:
+    case et::ELEMENT_TYPE_SZARRAY:
+    case et::ELEMENT_TYPE_ARRAY:
+        it = start;
+        skipType(it, end);
+        return makeVariableType(et::ELEMENT_TYPE_CLASS);
+    case et::ELEMENT_TYPE_GENERICINST:
+    {
+        const auto isClass = it != end && *it == _u(et::ELEMENT_TYPE_CLASS);
+        it = start;
+        skipType(it, end);
+        return makeVariableType(isClass ? et::ELEMENT_TYPE_CLASS : et::ELEMENT_TYPE_VALUETYPE);
+    }
+    case et::ELEMENT_TYPE_PTR:
+    case et::ELEMENT_TYPE_BYREF:
+    case et::ELEMENT_TYPE_FNPTR:
+        it = start;
+        skipType(it, end);
+        return makeVariableType(et::ELEMENT_TYPE_I);
+    case et::ELEMENT_TYPE_VALUETYPE:
+    {
+        // TypeDefOrRef coded index
+        const auto encoded = readItem(it, end);
+        switch (encoded & 3) {
+        case 0:
+            return makeVariableType(getTypeElement(domain, assembly, encoded >> 2));
+        case 1:
+        {
+            const auto resolved = domain.resolveTypeRef(assembly, encoded >> 2);
+            return makeVariableType(getTypeElement(domain, resolved.first, resolved.second));
+        }
+        default:
+            return makeVariableType(et::ELEMENT_TYPE_VALUETYPE);
+        }
+    }
+    case et::ELEMENT_TYPE_VAR:
+    case et::ELEMENT_TYPE_MVAR:
+        readItem(it, end);
+        return makeVariableType(et::ELEMENT_TYPE_VALUETYPE);
+    default:
+        return makeVariableType(element);
+    }
+}
+
+unique_ptr<RuntimeMethod> Interpreter::makeMethod(AppDomain& domain, const AssemblyData* assembly, uint32_t methodDefRow) {
+    const auto& methodDefs = assembly->cliMetaDataTables._MethodDef;
+    if (methodDefRow == 0 || methodDefRow > methodDefs.size()) {
+        throw runtime_error("Invalid MethodDef index");
+    }
+
+    unique_ptr<RuntimeMethod> result(new RuntimeMethod());
+    result->assembly = assembly;
+    result->methodDefRow = methodDefRow;
+    result->methodDef = &methodDefs[methodDefRow - 1];
+    result->tokens = &domain.getTokenCache(assembly);
+    result->isVirtual = (result->methodDef->flags & _u(MethodDefRow::MethodAttribute::Virtual)) != 0;
+    if (result->isVirtual) {
+        // Slot is found once, so calls are dispatched without resolving the method again.
+        const auto& declaringType = domain.getMethodTable(assembly, assembly->getMethodOwner(methodDefRow));
+        result->slot = declaringType.getSlot(methodDefRow);
+        result->interfaceType = declaringType.isInterface ? &declaringType : nullptr;
+    }
+
+    // Flags [GenParamCount] ParamCount RetType Param*
+    const auto& signature = *result->methodDef->signature;
+    auto it = signature.begin();
+    const auto end = signature.end();
+    const auto flags = readItem(it, end);
+    if ((flags & _u(CLISignatureFlags::SIG_GENERIC)) != 0) {
+        readItem(it, end);
+    }
+    auto parameters = readItem(it, end);
+    if (it != end && *it == _u(et::ELEMENT_TYPE_VOID)) {
+        ++it;
+    } else {
+        result->result = readVariableType(domain, assembly, it, end);
+    }
+    if ((flags & _u(CLISignatureFlags::SIG_HASTHIS)) != 0 && (flags & _u(CLISignatureFlags::SIG_EXPLICITTHIS)) == 0) {
+        result->arguments.push_back(makeVariableType(et::ELEMENT_TYPE_CLASS));
+    }
+    for (; parameters > 0; --parameters) {
+        result->arguments.push_back(readVariableType(domain, assembly, it, end));
+    }
+
+    result->native = findIntrinsic(*assembly, methodDefRow);
+    return result;
+}
+
+// Target of call instruction, null if it can't be called by the interpreter yet.
+static const RuntimeMethod* resolveCall(AppDomain& domain, const AssemblyData* assembly, uint32_t token) {
+    switch (static_cast<CLIMetadataTableItem>(token >> 24)) {
+    case CLIMetadataTableItem::MethodDef:
+        return &domain.getRuntimeMethod(assembly, token & 0xFFFFFF);
+    case CLIMetadataTableItem::MemberRef:
+    {
+        const auto& member = domain.resolveMemberRef(assembly, token & 0xFFFFFF);
+        if (member.methodDef == nullptr) {
+            throw runtime_error("MemberRef token doesn't refer to a method");
+        }
+        return &domain.getRuntimeMethod(member.assembly, member.token & 0xFFFFFF);
+    }
+    default:
+        // Generic method instantiations
+        return nullptr;
+    }
+}
+
+#ifndef DISABLE_SUPERINSTRUCTIONS
+// Superinstructions with their sequences of operations
+struct Superinstruction {
+    InterpreterOpcode opcode;
+    size_t length;
+    InterpreterOpcode operations[4];
+};
+
+#define SUPERINSTRUCTION_ITEM(name, length, first, second, third, fourth) \
+    { InterpreterOpcode::name, length, { InterpreterOpcode::first, InterpreterOpcode::second, InterpreterOpcode::third, InterpreterOpcode::fourth } },
+static const vector<Superinstruction> superinstructions = {
+    SUPERINSTRUCTIONS(SUPERINSTRUCTION_ITEM)
+};
+#undef SUPERINSTRUCTION_ITEM
+
+// Handlers of superinstructions are chosen from the end of method, so every instruction starts the sequence which
+//  needs the least dispatches to reach the end when it's executed straight. Only handlers are replaced, so the
+//  branches into the middle of superinstruction are executing the rest of it one by one.
+static void makeSuperinstructions(ThreadedCode& code, const vector<InterpreterOpcode>& opcodes, const void* const* handlers) {
+    vector<size_t> dispatches(opcodes.size() + 1);
+    for (auto index = opcodes.size(); index-- > 0; ) {
+        const Superinstruction* best = nullptr;
+        dispatches[index] = dispatches[index + 1] + 1;
+        for (const auto& candidate : superinstructions) {
+            if (index + candidate.length <= opcodes.size()
+                && dispatches[index + candidate.length] + 1 < dispatches[index]
+                && equal(candidate.operations, candidate.operations + candidate.length, opcodes.begin() + index)) {
+                dispatches[index] = dispatches[index + candidate.length] + 1;
+                best = &candidate;
+            }
+        }
+        if (best != nullptr) {
+            code.instructions[index].handler = handlers[_u(best->opcode)];
+        }
+    }
+}
+#endif
+
+unique_ptr<ThreadedCode> Interpreter::compile(AppDomain& domain, const RuntimeMethod& method) {
+    vector<InterpreterOpcode> opcodes;
+    auto result = translate(domain, method, opcodes);
+#ifndef DISABLE_SUPERINSTRUCTIONS
+    makeSuperinstructions(*result, opcodes, run(nullptr));
+#endif
+    return result;
+}
+
+// Finally and fault handlers aren't executed yet, so leave from their protected regions is rejected instead of
+//  skipping them.
+static bool leavesFinallyRegion(const MethodBody& body, uint32_t offset, uint32_t targetOffset) {
+    for (const auto& clause : body.exceptions) {
+        if ((clause.flags & (_u(ExceptionClauseFlags::ClauseFinally) | _u(ExceptionClauseFlags::ClauseFault))) == 0) {
+            continue;
+        }
+        const auto inside = [&](uint32_t position) { return position >= clause.tryOffset && position - clause.tryOffset < clause.tryLength; };
+        if (inside(offset) && !inside(targetOffset)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+unique_ptr<ThreadedCode> Interpreter::translate(AppDomain& domain, const RuntimeMethod& method, vector<InterpreterOpcode>& opcodes, StackTypes* stackTypes) {
+    using i = Instruction;
+    using op = InterpreterOpcode;
+
+    const auto* assembly = method.assembly;
+    if (method.methodDef->rva == 0) {
+        throw runtime_error("Method has no body: " + assembly->getStrings().utf8(method.methodDef->name));
+    }
+
+    unique_ptr<ThreadedCode> result(new ThreadedCode());
+    auto& code = *result;
+    code.body = &assembly->getMethodBody(0x06000000 | method.methodDefRow);
+
+    // LOCAL_SIG Count Type*
+    if (code.body->localVarSig != nullptr) {
+        const auto& signature = *code.body->localVarSig;
+        auto it = signature.begin();
+        const auto end = signature.end();
+        readItem(it, end);
+        for (auto count = readItem(it, end); count > 0; --count) {
+            code.locals.push_back(readVariableType(domain, assembly, it, end));
+        }
+    }
+
+    // Threaded code has one instruction per decoded one, so the branch targets are kept as they are.
+    const auto tree = InstructionTree::MakeTree(code.body->data);
+
+    QuickeningContext context;
+    context.arguments = &method.arguments;
+    context.locals = &code.locals;
+    context.resolveCall = [&](uint32_t token) { return resolveCall(domain, assembly, token); };
+    context.resolveElement = [&](uint32_t token) { return getTokenElement(domain, assembly, token); };
+#ifndef DISABLE_QUICKENING
+    const auto inferred = quicken(*tree, context, stackTypes);
+#else
+    const auto inferred = stackTypes != nullptr && inferStackTypes(*tree, context, *stackTypes);
+#endif
+    if (stackTypes != nullptr && !inferred) {
+        stackTypes->states.clear();
+        stackTypes->reached.clear();
+    }
+
+    const auto* handlers = run(nullptr);
+    const auto argumentsCount = static_cast<uint32_t>(method.arguments.size());
+    code.instructions.reserve(tree->size());
+    opcodes.clear();
+    opcodes.reserve(tree->size());
+
+    for (const auto& decoded : *tree) {
+        const auto instruction = decoded.opcode;
+        const auto& operand = decoded.operand;
+
+        ThreadedInstruction translated;
+        translated.operand.i8 = 0;
+        auto opcode = op::op_unsupported;
+
+        switch (instruction) {
+        case i::i_nop:
+        case i::i_break:
+        // Alignment, volatility and tail calls are making no difference for the interpreter.
+        case i::i_unaligned:
+        case i::i_volatile:
+        case i::i_tail:
+        case i::i_readonly:
+        case i::i_no:
+            opcode = op::op_nop;
+            break;
+
+        case i::i_ldarg:
+        case i::i_starg:
+        case i::i_ldloc:
+        case i::i_stloc:
+        {
+            const auto number = operand.variable;
+            const auto isArgument = instruction == i::i_ldarg || instruction == i::i_starg;
+            const auto& types = isArgument ? method.arguments : code.locals;
+            if (number >= types.size()) {
+                throw runtime_error("Invalid variable index");
+            }
+            const auto& type = types[number];
+            if (type.stackType == et::ELEMENT_TYPE_VALUETYPE) {
+                break;
+            }
+            translated.operand.variable.index = isArgument ? number : argumentsCount + number;
+            translated.operand.variable.stackType = type.stackType;
+            translated.operand.variable.type = type.type;
+            if (instruction == i::i_ldarg || instruction == i::i_ldloc) {
+                opcode = op::op_ldvar;
+                break;
+            }
+            // Only floats could get values of the other stack type, they are converted by the stored value tag.
+            switch (type.stackType) {
+            case et::ELEMENT_TYPE_I4:
+                opcode = op::op_stvar_i4;
+                break;
+            case et::ELEMENT_TYPE_I8:
+                opcode = op::op_stvar_i8;
+                break;
+            case et::ELEMENT_TYPE_I:
+            case et::ELEMENT_TYPE_U:
+                opcode = op::op_stvar_ref;
+                break;
+            default:
+                opcode = op::op_stvar;
+                break;
+            }
+            break;
+        }
+
+        case i::i_ldc_i4:
+            translated.operand.i4 = operand.i4;
+            opcode = op::op_ldc_i4;
+            break;
+        case i::i_ldc_i8:
+            translated.operand.i8 = operand.i8;
+            opcode = op::op_ldc_i8;
+            break;
+        case i::i_ldc_r4:
+            translated.operand.r4 = operand.r4;
+            opcode = op::op_ldc_r4;
+            break;
+        case i::i_ldc_r8:
+            translated.operand.r8 = operand.r8;
+            opcode = op::op_ldc_r8;
+            break;
+        case i::i_ldnull:
+            opcode = op::op_ldnull;
+            break;
+        case i::i_ldstr:
+            translated.operand.object = domain.heap.getLiteral(assembly, operand.token);
+            opcode = op::op_ldstr;
+            break;
+        case i::i_dup:
+            opcode = op::op_dup;
+            break;
+        case i::i_pop:
+            opcode = op::op_pop;
+            break;
+
+        case i::i_call:
+        case i::i_callvirt:
+        {
+            const auto* callee = resolveCall(domain, assembly, operand.token);
+            if (callee == nullptr) {
+                break;
+            }
+            translated.operand.method = callee;
+            opcode = instruction == i::i_call ? op::op_call : op::op_callvirt;
+            break;
+        }
+        case i::i_ret:
+            opcode = op::op_ret;
+            break;
+
+        case i::i_br:
+        case i::i_brfalse:
+        case i::i_brtrue:
+        case i::i_beq:
+        case i::i_bge:
+        case i::i_bgt:
+        case i::i_ble:
+        case i::i_blt:
+        case i::i_bne_un:
+        case i::i_bge_un:
+        case i::i_bgt_un:
+        case i::i_ble_un:
+        case i::i_blt_un:
+            // Branch instructions are following the same order in both enums.
+            translated.operand.target = operand.target;
+            opcode = static_cast<op>(_u(op::op_br) + (_u(instruction) - _u(i::i_br)));
+            break;
+        case i::i_leave:
+            translated.operand.target = operand.target;
+            if (!leavesFinallyRegion(*code.body, decoded.offset, operand.target < tree->size() ? (*tree)[operand.target].offset : UINT32_MAX)) {
+                opcode = op::op_leave;
+            }
+            break;
+        case i::i_switch:
+            translated.operand.table.first = static_cast<uint32_t>(code.switchTargets.size());
+            translated.operand.table.count = operand.table.count;
+            {
+                const auto* targets = tree->getSwitchTargets(decoded);
+                code.switchTargets.insert(code.switchTargets.end(), targets, targets + operand.table.count);
+            }
+            opcode = op::op_switch;
+            break;
+
+        case i::i_add: opcode = op::op_add; break;
+        case i::i_sub: opcode = op::op_sub; break;
+        case i::i_mul: opcode = op::op_mul; break;
+        case i::i_div: opcode = op::op_div; break;
+        case i::i_div_un: opcode = op::op_div_un; break;
+        case i::i_rem: opcode = op::op_rem; break;
+        case i::i_rem_un: opcode = op::op_rem_un; break;
+        case i::i_and: opcode = op::op_and; break;
+        case i::i_or: opcode = op::op_or; break;
+        case i::i_xor: opcode = op::op_xor; break;
+        case i::i_shl: opcode = op::op_shl; break;
+        case i::i_shr: opcode = op::op_shr; break;
+        case i::i_shr_un: opcode = op::op_shr_un; break;
+        case i::i_neg: opcode = op::op_neg; break;
+        case i::i_not: opcode = op::op_not; break;
+
+        case i::i_ceq: opcode = op::op_ceq; break;
+        case i::i_cgt: opcode = op::op_cgt; break;
+        case i::i_cgt_un: opcode = op::op_cgt_un; break;
+        case i::i_clt: opcode = op::op_clt; break;
+        case i::i_clt_un: opcode = op::op_clt_un; break;
+
+        case i::i_conv_i1: opcode = op::op_conv_i1; break;
+        case i::i_conv_i2: opcode = op::op_conv_i2; break;
+        case i::i_conv_i4: opcode = op::op_conv_i4; break;
+        case i::i_conv_i8: opcode = op::op_conv_i8; break;
+        case i::i_conv_u1: opcode = op::op_conv_u1; break;
+        case i::i_conv_u2: opcode = op::op_conv_u2; break;
+        case i::i_conv_u4: opcode = op::op_conv_u4; break;
+        case i::i_conv_u8: opcode = op::op_conv_u8; break;
+        case i::i_conv_i: opcode = op::op_conv_i; break;
+        case i::i_conv_u: opcode = op::op_conv_u; break;
+        case i::i_conv_r4: opcode = op::op_conv_r4; break;
+        case i::i_conv_r8: opcode = op::op_conv_r8; break;
+        case i::i_conv_r_un: opcode = op::op_conv_r_un; break;
+
+        case i::i_newarr:
+            translated.operand.elementType = getTokenElement(domain, assembly, operand.token);
+            opcode = op::op_newarr;
+            break;
+        case i::i_ldlen:
+            opcode = op::op_ldlen;
+            break;
+
+        case i::i_ldelem_i1: translated.operand.elementType = et::ELEMENT_TYPE_I1; opcode = op::op_ldelem; break;
+        case i::i_ldelem_u1: translated.operand.elementType = et::ELEMENT_TYPE_U1; opcode = op::op_ldelem; break;
+        case i::i_ldelem_i2: translated.operand.elementType = et::ELEMENT_TYPE_I2; opcode = op::op_ldelem; break;
+        case i::i_ldelem_u2: translated.operand.elementType = et::ELEMENT_TYPE_U2; opcode = op::op_ldelem; break;
+        case i::i_ldelem_i4: opcode = op::op_ldelem_i4; break;
+        case i::i_ldelem_u4: opcode = op::op_ldelem_i4; break;
+        case i::i_ldelem_i8: opcode = op::op_ldelem_i8; break;
+        case i::i_ldelem_i: translated.operand.elementType = et::ELEMENT_TYPE_I; opcode = op::op_ldelem; break;
+        case i::i_ldelem_r4: translated.operand.elementType = et::ELEMENT_TYPE_R4; opcode = op::op_ldelem; break;
+        case i::i_ldelem_r8: opcode = op::op_ldelem_r8; break;
+        case i::i_ldelem_ref: opcode = op::op_ldelem_ref; break;
+        case i::i_stelem_i: translated.operand.elementType = et::ELEMENT_TYPE_I; opcode = op::op_stelem; break;
+        case i::i_stelem_i1: translated.operand.elementType = et::ELEMENT_TYPE_I1; opcode = op::op_stelem; break;
+        case i::i_stelem_i2: translated.operand.elementType = et::ELEMENT_TYPE_I2; opcode = op::op_stelem; break;
+        case i::i_stelem_i4: opcode = op::op_stelem_i4; break;
+        case i::i_stelem_i8: opcode = op::op_stelem_i8; break;
+        case i::i_stelem_r4: translated.operand.elementType = et::ELEMENT_TYPE_R4; opcode = op::op_stelem; break;
+        case i::i_stelem_r8: translated.operand.elementType = et::ELEMENT_TYPE_R8; opcode = op::op_stelem; break;
+        case i::i_stelem_ref: opcode = op::op_stelem_ref; break;
+        case i::i_ldelem:
+        case i::i_stelem:
+            translated.operand.elementType = getTokenElement(domain, assembly, operand.token);
+            opcode = instruction == i::i_ldelem ? op::op_ldelem : op::op_stelem;
+            break;
+
+        // Quickened instructions
+        case i::i_iadd: opcode = op::op_iadd; break;
+        case i::i_isub: opcode = op::op_isub; break;
+        case i::i_imul: opcode = op::op_imul; break;
+        case i::i_idiv: opcode = op::op_idiv; break;
+        case i::i_idiv_un: opcode = op::op_idiv_un; break;
+        case i::i_irem: opcode = op::op_irem; break;
+        case i::i_irem_un: opcode = op::op_irem_un; break;
+        case i::i_iand: opcode = op::op_iand; break;
+        case i::i_ior: opcode = op::op_ior; break;
+        case i::i_ixor: opcode = op::op_ixor; break;
+        case i::i_ishl: opcode = op::op_ishl; break;
+        case i::i_ishr: opcode = op::op_ishr; break;
+        case i::i_ishr_un: opcode = op::op_ishr_un; break;
+        case i::i_ineg: opcode = op::op_ineg; break;
+        case i::i_inot: opcode = op::op_inot; break;
+
+        case i::i_ladd: opcode = op::op_ladd; break;
+        case i::i_lsub: opcode = op::op_lsub; break;
+        case i::i_lmul: opcode = op::op_lmul; break;
+        case i::i_ldiv: opcode = op::op_ldiv; break;
+        case i::i_ldiv_un: opcode = op::op_ldiv_un; break;
+        case i::i_lrem: opcode = op::op_lrem; break;
+        case i::i_lrem_un: opcode = op::op_lrem_un; break;
+        case i::i_land: opcode = op::op_land; break;
+        case i::i_lor: opcode = op::op_lor; break;
+        case i::i_lxor: opcode = op::op_lxor; break;
+        case i::i_lshl: opcode = op::op_lshl; break;
+        case i::i_lshr: opcode = op::op_lshr; break;
+        case i::i_lshr_un: opcode = op::op_lshr_un; break;
+        case i::i_lneg: opcode = op::op_lneg; break;
+        case i::i_lnot: opcode = op::op_lnot; break;
+
+        case i::i_fadd: opcode = op::op_fadd; break;
+        case i::i_fsub: opcode = op::op_fsub; break;
+        case i::i_fmul: opcode = op::op_fmul; break;
+        case i::i_fdiv: opcode = op::op_fdiv; break;
+        case i::i_frem: opcode = op::op_frem; break;
+        case i::i_fneg: opcode = op::op_fneg; break;
+
+        case i::i_iceq: opcode = op::op_iceq; break;
+        case i::i_icgt: opcode = op::op_icgt; break;
+        case i::i_icgt_un: opcode = op::op_icgt_un; break;
+        case i::i_iclt: opcode = op::op_iclt; break;
+        case i::i_iclt_un: opcode = op::op_iclt_un; break;
+        case i::i_lceq: opcode = op::op_lceq; break;
+        case i::i_lcgt: opcode = op::op_lcgt; break;
+        case i::i_lcgt_un: opcode = op::op_lcgt_un; break;
+        case i::i_lclt: opcode = op::op_lclt; break;
+        case i::i_lclt_un: opcode = op::op_lclt_un; break;
+        case i::i_fceq: opcode = op::op_fceq; break;
+        case i::i_fcgt: opcode = op::op_fcgt; break;
+        case i::i_fcgt_un: opcode = op::op_fcgt_un; break;
+        case i::i_fclt: opcode = op::op_fclt; break;
+        case i::i_fclt_un: opcode = op::op_fclt_un; break;
+
+        case i::i_i2b: opcode = op::op_i2b; break;
+        case i::i_i2ub: opcode = op::op_i2ub; break;
+        case i::i_i2s: opcode = op::op_i2s; break;
+        case i::i_i2us: opcode = op::op_i2us; break;
+        case i::i_i2l: opcode = op::op_i2l; break;
+        case i::i_i2ul: opcode = op::op_i2ul; break;
+        case i::i_i2f: opcode = op::op_i2f; break;
+        case i::i_i2d: opcode = op::op_i2d; break;
+        case i::i_ui2d: opcode = op::op_ui2d; break;
+        case i::i_l2b: opcode = op::op_l2b; break;
+        case i::i_l2ub: opcode = op::op_l2ub; break;
+        case i::i_l2s: opcode = op::op_l2s; break;
+        case i::i_l2us: opcode = op::op_l2us; break;
+        case i::i_l2i: opcode = op::op_l2i; break;
+        case i::i_l2f: opcode = op::op_l2f; break;
+        case i::i_l2d: opcode = op::op_l2d; break;
+        case i::i_ul2d: opcode = op::op_ul2d; break;
+        case i::i_f2b: opcode = op::op_f2b; break;
+        case i::i_f2ub: opcode = op::op_f2ub; break;
+        case i::i_f2s: opcode = op::op_f2s; break;
+        case i::i_f2us: opcode = op::op_f2us; break;
+        case i::i_f2i: opcode = op::op_f2i; break;
+        case i::i_f2ui: opcode = op::op_f2ui; break;
+        case i::i_f2l: opcode = op::op_f2l; break;
+        case i::i_f2ul: opcode = op::op_f2ul; break;
+        case i::i_d2f: opcode = op::op_d2f; break;
+
+        case i::i_ibeq:
+        case i::i_ibge:
+        case i::i_ibgt:
+        case i::i_ible:
+        case i::i_iblt:
+        case i::i_ibne_un:
+        case i::i_ibge_un:
+        case i::i_ibgt_un:
+        case i::i_ible_un:
+        case i::i_iblt_un:
+            translated.operand.target = operand.target;
+            opcode = static_cast<op>(_u(op::op_ibeq) + (_u(instruction) - _u(i::i_ibeq)));
+            break;
+        case i::i_lbeq:
+        case i::i_lbge:
+        case i::i_lbgt:
+        case i::i_lble:
+        case i::i_lblt:
+        case i::i_lbne_un:
+        case i::i_lbge_un:
+        case i::i_lbgt_un:
+        case i::i_lble_un:
+        case i::i_lblt_un:
+            translated.operand.target = operand.target;
+            opcode = static_cast<op>(_u(op::op_lbeq) + (_u(instruction) - _u(i::i_lbeq)));
+            break;
+        case i::i_fbeq:
+        case i::i_fbge:
+        case i::i_fbgt:
+        case i::i_fble:
+        case i::i_fblt:
+        case i::i_fbne_un:
+        case i::i_fbge_un:
+        case i::i_fbgt_un:
+        case i::i_fble_un:
+        case i::i_fblt_un:
+            translated.operand.target = operand.target;
+            opcode = static_cast<op>(_u(op::op_fbeq) + (_u(instruction) - _u(i::i_fbeq)));
+            break;
+
+        case i::i_throw:
+            opcode = op::op_throw;
+            break;
+        case i::i_rethrow:
+            opcode = op::op_rethrow;
+            break;
+
+        default:
+            break;
+        }
+
+        if (opcode == op::op_unsupported) {
+            translated.operand.i4 = _u(instruction);
+        }
+        translated.handler = handlers[_u(opcode)];
+        code.instructions.push_back(translated);
+        opcodes.push_back(opcode);
+    }
+
+    return result;
+}
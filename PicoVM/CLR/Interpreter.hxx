@@ -0,0 +1,390 @@
+#ifndef __INTERPRETER_HXX__
+#define __INTERPRETER_HXX__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "RuntimeMethod.hxx"
+#include "Superinstructions.hxx"
+
+struct AppDomain;
+struct CallStackItem;
+struct ExecutionThread;
+struct StackTypes;
+
+// Operations of the interpreter loop. Short forms of IL instructions are expanded, arguments and locals are
+//  addressed as one array of variables, and the typed forms of ldelem and stelem which aren't quickened are
+//  sharing one handler. Operations with i, l and f prefixes are the quickened forms for int32, int64 and
+//  float64 operands, they are taking values from the stack without looking at their tags.
+#define INTERPRETER_OPCODES(OP) \
+    OP(op_nop) \
+    OP(op_unsupported) \
+    OP(op_ldvar) \
+    OP(op_stvar) \
+    OP(op_ldc_i4) \
+    OP(op_ldc_i8) \
+    OP(op_ldc_r4) \
+    OP(op_ldc_r8) \
+    OP(op_ldnull) \
+    OP(op_ldstr) \
+    OP(op_dup) \
+    OP(op_pop) \
+    OP(op_call) \
+    OP(op_callvirt) \
+    OP(op_ret) \
+    OP(op_br) \
+    OP(op_brfalse) \
+    OP(op_brtrue) \
+    OP(op_beq) \
+    OP(op_bge) \
+    OP(op_bgt) \
+    OP(op_ble) \
+    OP(op_blt) \
+    OP(op_bne_un) \
+    OP(op_bge_un) \
+    OP(op_bgt_un) \
+    OP(op_ble_un) \
+    OP(op_blt_un) \
+    OP(op_switch) \
+    OP(op_leave) \
+    OP(op_add) \
+    OP(op_sub) \
+    OP(op_mul) \
+    OP(op_div) \
+    OP(op_div_un) \
+    OP(op_rem) \
+    OP(op_rem_un) \
+    OP(op_and) \
+    OP(op_or) \
+    OP(op_xor) \
+    OP(op_shl) \
+    OP(op_shr) \
+    OP(op_shr_un) \
+    OP(op_neg) \
+    OP(op_not) \
+    OP(op_ceq) \
+    OP(op_cgt) \
+    OP(op_cgt_un) \
+    OP(op_clt) \
+    OP(op_clt_un) \
+    OP(op_conv_i1) \
+    OP(op_conv_i2) \
+    OP(op_conv_i4) \
+    OP(op_conv_i8) \
+    OP(op_conv_u1) \
+    OP(op_conv_u2) \
+    OP(op_conv_u4) \
+    OP(op_conv_u8) \
+    OP(op_conv_i) \
+    OP(op_conv_u) \
+    OP(op_conv_r4) \
+    OP(op_conv_r8) \
+    OP(op_conv_r_un) \
+    OP(op_newarr) \
+    OP(op_ldlen) \
+    OP(op_ldelem) \
+    OP(op_stelem) \
+    OP(op_throw) \
+    OP(op_rethrow) \
+    OP(op_stvar_i4) \
+    OP(op_stvar_i8) \
+    OP(op_stvar_ref) \
+    OP(op_iadd) \
+    OP(op_isub) \
+    OP(op_imul) \
+    OP(op_idiv) \
+    OP(op_idiv_un) \
+    OP(op_irem) \
+    OP(op_irem_un) \
+    OP(op_iand) \
+    OP(op_ior) \
+    OP(op_ixor) \
+    OP(op_ishl) \
+    OP(op_ishr) \
+    OP(op_ishr_un) \
+    OP(op_ineg) \
+    OP(op_inot) \
+    OP(op_ladd) \
+    OP(op_lsub) \
+    OP(op_lmul) \
+    OP(op_ldiv) \
+    OP(op_ldiv_un) \
+    OP(op_lrem) \
+    OP(op_lrem_un) \
+    OP(op_land) \
+    OP(op_lor) \
+    OP(op_lxor) \
+    OP(op_lshl) \
+    OP(op_lshr) \
+    OP(op_lshr_un) \
+    OP(op_lneg) \
+    OP(op_lnot) \
+    OP(op_fadd) \
+    OP(op_fsub) \
+    OP(op_fmul) \
+    OP(op_fdiv) \
+    OP(op_frem) \
+    OP(op_fneg) \
+    OP(op_iceq) \
+    OP(op_icgt) \
+    OP(op_icgt_un) \
+    OP(op_iclt) \
+    OP(op_iclt_un) \
+    OP(op_lceq) \
+    OP(op_lcgt) \
+    OP(op_lcgt_un) \
+    OP(op_lclt) \
+    OP(op_lclt_un) \
+    OP(op_fceq) \
+    OP(op_fcgt) \
+    OP(op_fcgt_un) \
+    OP(op_fclt) \
+    OP(op_fclt_un) \
+    OP(op_ibeq) \
+    OP(op_ibge) \
+    OP(op_ibgt) \
+    OP(op_ible) \
+    OP(op_iblt) \
+    OP(op_ibne_un) \
+    OP(op_ibge_un) \
+    OP(op_ibgt_un) \
+    OP(op_ible_un) \
+    OP(op_iblt_un) \
+    OP(op_lbeq) \
+    OP(op_lbge) \
+    OP(op_lbgt) \
+    OP(op_lble) \
+    OP(op_lblt) \
+    OP(op_lbne_un) \
+    OP(op_lbge_un) \
+    OP(op_lbgt_un) \
+    OP(op_lble_un) \
+    OP(op_lblt_un) \
+    OP(op_fbeq) \
+    OP(op_fbge) \
+    OP(op_fbgt) \
+    OP(op_fble) \
+    OP(op_fblt) \
+    OP(op_fbne_un) \
+    OP(op_fbge_un) \
+    OP(op_fbgt_un) \
+    OP(op_fble_un) \
+    OP(op_fblt_un) \
+    OP(op_i2b) \
+    OP(op_i2ub) \
+    OP(op_i2s) \
+    OP(op_i2us) \
+    OP(op_i2l) \
+    OP(op_i2ul) \
+    OP(op_i2f) \
+    OP(op_i2d) \
+    OP(op_ui2d) \
+    OP(op_l2b) \
+    OP(op_l2ub) \
+    OP(op_l2s) \
+    OP(op_l2us) \
+    OP(op_l2i) \
+    OP(op_l2f) \
+    OP(op_l2d) \
+    OP(op_ul2d) \
+    OP(op_f2b) \
+    OP(op_f2ub) \
+    OP(op_f2s) \
+    OP(op_f2us) \
+    OP(op_f2i) \
+    OP(op_f2ui) \
+    OP(op_f2l) \
+    OP(op_f2ul) \
+    OP(op_d2f) \
+    OP(op_ldelem_i4) \
+    OP(op_ldelem_i8) \
+    OP(op_ldelem_r8) \
+    OP(op_ldelem_ref) \
+    OP(op_stelem_i4) \
+    OP(op_stelem_i8) \
+    OP(op_stelem_ref)
+
+// Operations which are touching only the evaluation stack, variables and their own operands. Their handlers are
+//  made from the same code as superinstructions, which are executing sequences of them with one dispatch.
+#define INTERPRETER_OPERATIONS(OP) \
+    OP(op_nop) \
+    OP(op_ldvar) \
+    OP(op_ldc_i4) \
+    OP(op_ldc_i8) \
+    OP(op_ldc_r4) \
+    OP(op_ldc_r8) \
+    OP(op_ldnull) \
+    OP(op_dup) \
+    OP(op_pop) \
+    OP(op_ldlen) \
+    OP(op_stvar_i4) \
+    OP(op_stvar_i8) \
+    OP(op_stvar_ref) \
+    OP(op_iadd) \
+    OP(op_isub) \
+    OP(op_imul) \
+    OP(op_idiv) \
+    OP(op_idiv_un) \
+    OP(op_irem) \
+    OP(op_irem_un) \
+    OP(op_iand) \
+    OP(op_ior) \
+    OP(op_ixor) \
+    OP(op_ishl) \
+    OP(op_ishr) \
+    OP(op_ishr_un) \
+    OP(op_ineg) \
+    OP(op_inot) \
+    OP(op_ladd) \
+    OP(op_lsub) \
+    OP(op_lmul) \
+    OP(op_ldiv) \
+    OP(op_ldiv_un) \
+    OP(op_lrem) \
+    OP(op_lrem_un) \
+    OP(op_land) \
+    OP(op_lor) \
+    OP(op_lxor) \
+    OP(op_lshl) \
+    OP(op_lshr) \
+    OP(op_lshr_un) \
+    OP(op_lneg) \
+    OP(op_lnot) \
+    OP(op_fadd) \
+    OP(op_fsub) \
+    OP(op_fmul) \
+    OP(op_fdiv) \
+    OP(op_frem) \
+    OP(op_fneg) \
+    OP(op_iceq) \
+    OP(op_icgt) \
+    OP(op_icgt_un) \
+    OP(op_iclt) \
+    OP(op_iclt_un) \
+    OP(op_lceq) \
+    OP(op_lcgt) \
+    OP(op_lcgt_un) \
+    OP(op_lclt) \
+    OP(op_lclt_un) \
+    OP(op_fceq) \
+    OP(op_fcgt) \
+    OP(op_fcgt_un) \
+    OP(op_fclt) \
+    OP(op_fclt_un) \
+    OP(op_i2b) \
+    OP(op_i2ub) \
+    OP(op_i2s) \
+    OP(op_i2us) \
+    OP(op_i2l) \
+    OP(op_i2ul) \
+    OP(op_i2f) \
+    OP(op_i2d) \
+    OP(op_ui2d) \
+    OP(op_l2b) \
+    OP(op_l2ub) \
+    OP(op_l2s) \
+    OP(op_l2us) \
+    OP(op_l2i) \
+    OP(op_l2f) \
+    OP(op_l2d) \
+    OP(op_ul2d) \
+    OP(op_f2b) \
+    OP(op_f2ub) \
+    OP(op_f2s) \
+    OP(op_f2us) \
+    OP(op_f2i) \
+    OP(op_f2ui) \
+    OP(op_f2l) \
+    OP(op_f2ul) \
+    OP(op_d2f) \
+    OP(op_ldelem_i4) \
+    OP(op_ldelem_i8) \
+    OP(op_ldelem_r8) \
+    OP(op_ldelem_ref) \
+    OP(op_stelem_i4) \
+    OP(op_stelem_i8) \
+    OP(op_stelem_ref)
+
+// Operations which are jumping to their targets if their conditions are true. They could only be the last ones
+//  in superinstructions.
+#define INTERPRETER_JUMPS(OP) \
+    OP(op_br) \
+    OP(op_brfalse) \
+    OP(op_brtrue) \
+    OP(op_ibeq) \
+    OP(op_ibge) \
+    OP(op_ibgt) \
+    OP(op_ible) \
+    OP(op_iblt) \
+    OP(op_ibne_un) \
+    OP(op_ibge_un) \
+    OP(op_ibgt_un) \
+    OP(op_ible_un) \
+    OP(op_iblt_un) \
+    OP(op_lbeq) \
+    OP(op_lbge) \
+    OP(op_lbgt) \
+    OP(op_lble) \
+    OP(op_lblt) \
+    OP(op_lbne_un) \
+    OP(op_lbge_un) \
+    OP(op_lbgt_un) \
+    OP(op_lble_un) \
+    OP(op_lblt_un) \
+    OP(op_fbeq) \
+    OP(op_fbge) \
+    OP(op_fbgt) \
+    OP(op_fble) \
+    OP(op_fblt) \
+    OP(op_fbne_un) \
+    OP(op_fbge_un) \
+    OP(op_fbgt_un) \
+    OP(op_fble_un) \
+    OP(op_fblt_un)
+
+#define INTERPRETER_OPCODE_ENUM(name) name,
+#define SUPERINSTRUCTION_ENUM(name, length, first, second, third, fourth) name,
+
+enum struct InterpreterOpcode : uint16_t {
+    INTERPRETER_OPCODES(INTERPRETER_OPCODE_ENUM)
+    SUPERINSTRUCTIONS(SUPERINSTRUCTION_ENUM)
+    count
+};
+
+// Direct-threaded interpreter of IL. Methods are decoded on their first call into arrays of instructions, which
+//  are holding the addresses of their handlers, so dispatch is one indirect jump. Compilers without computed
+//  goto, or builds with USE_SWITCH_DISPATCH defined, are using switch over handler numbers instead.
+//  Frequent sequences of operations are executed by superinstructions from Superinstructions.hxx, which is
+//  generated by opcodestats tool, unless DISABLE_SUPERINSTRUCTIONS is defined.
+class Interpreter
+{
+public:
+    // Run the frame on top of the call stack until it returns. Calls of interpreted methods are handled by
+    //  the same loop, native methods are called directly.
+    static void execute(ExecutionThread& thread);
+
+    // Take arguments of the frame from the evaluation stack and allocate its local variables.
+    static void enterFrame(ExecutionThread& thread, CallStackItem& frame);
+
+    // Signature layout and native implementation of the method, it's cached by the domain.
+    static std::unique_ptr<RuntimeMethod> makeMethod(AppDomain& domain, const AssemblyData* assembly, uint32_t methodDefRow);
+
+    // Threaded code of interpreted method, it's decoded on first use.
+    static const ThreadedCode& getCode(AppDomain& domain, const RuntimeMethod& method);
+
+    // Threaded code of method before superinstructions are made, and the operations of its instructions. Types of
+    //  the evaluation stack are given if they are asked for, they are empty if they can't be inferred.
+    static std::unique_ptr<ThreadedCode> translate(AppDomain& domain, const RuntimeMethod& method, std::vector<InterpreterOpcode>& opcodes, StackTypes* stackTypes = nullptr);
+
+    // Frame of interpreted or native method which is called by the interpreter. Frame is set up as if it was
+    //  created from MethodDef token of the callee.
+    static CallStackItem makeFrame(ExecutionThread& thread, const RuntimeMethod& method);
+
+private:
+    static std::unique_ptr<ThreadedCode> compile(AppDomain& domain, const RuntimeMethod& method);
+    // Handler addresses by opcode, loop returns them when it's called without thread.
+    static const void* const* run(ExecutionThread* thread);
+};
+
+#endif
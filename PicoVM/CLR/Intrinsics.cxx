@@ -0,0 +1,147 @@
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "Intrinsics.hxx"
+#include "AssemblyData.hxx"
+#include "EnumCasting.hxx"
+#include "ExecutionThread.hxx"
+#include "ManagedHeap.hxx"
+#include "utf8.h"
+
+using namespace std;
+using et = CLIElementType;
+
+static void writeUtf16(ostream& output, const char16_t* chars, size_t length) {
+    string result;
+    utf8::unchecked::utf16to8(chars, chars + length, back_inserter(result));
+    output << result;
+}
+
+// Value on top of the stack, formatted as it would be by ToString() of its type
+static void writeValue(ostream& output, EvaluationStack& stack, CLIElementType type) {
+    switch (type) {
+    case et::ELEMENT_TYPE_BOOLEAN:
+        output << (stack.pop_int32() != 0 ? "True" : "False");
+        break;
+    case et::ELEMENT_TYPE_CHAR:
+    {
+        const auto value = static_cast<char16_t>(stack.pop_int32());
+        writeUtf16(output, &value, 1);
+        break;
+    }
+    case et::ELEMENT_TYPE_I4:
+        output << stack.pop_int32();
+        break;
+    case et::ELEMENT_TYPE_U4:
+        output << static_cast<uint32_t>(stack.pop_int32());
+        break;
+    case et::ELEMENT_TYPE_I8:
+        output << stack.pop_int64();
+        break;
+    case et::ELEMENT_TYPE_U8:
+        output << static_cast<uint64_t>(stack.pop_int64());
+        break;
+    case et::ELEMENT_TYPE_R4:
+    {
+        ostringstream formatted;
+        formatted.precision(7);
+        formatted << stack.pop_float32();
+        output << formatted.str();
+        break;
+    }
+    case et::ELEMENT_TYPE_R8:
+    {
+        ostringstream formatted;
+        formatted.precision(15);
+        formatted << stack.pop_float64();
+        output << formatted.str();
+        break;
+    }
+    case et::ELEMENT_TYPE_STRING:
+    {
+        // Null string is written as empty one
+        const auto* value = reinterpret_cast<const StringObject*>(stack.pop_ref());
+        if (value != nullptr) {
+            writeUtf16(output, value->chars(), value->length);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+template<CLIElementType type>
+static void consoleWrite(ExecutionThread& thread) {
+    writeValue(cout, thread.evaluationStack, type);
+}
+
+template<CLIElementType type>
+static void consoleWriteLine(ExecutionThread& thread) {
+    writeValue(cout, thread.evaluationStack, type);
+    cout << '\n';
+}
+
+struct Intrinsic {
+    const char* typeNamespace;
+    const char* typeName;
+    const char* name;
+    // Type of the only parameter, END if method has no parameters
+    CLIElementType parameter;
+    NativeMethod method;
+};
+
+static const Intrinsic intrinsics[] = {
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_END, consoleWriteLine<et::ELEMENT_TYPE_END> },
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_BOOLEAN, consoleWriteLine<et::ELEMENT_TYPE_BOOLEAN> },
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_CHAR, consoleWriteLine<et::ELEMENT_TYPE_CHAR> },
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_I4, consoleWriteLine<et::ELEMENT_TYPE_I4> },
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_U4, consoleWriteLine<et::ELEMENT_TYPE_U4> },
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_I8, consoleWriteLine<et::ELEMENT_TYPE_I8> },
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_U8, consoleWriteLine<et::ELEMENT_TYPE_U8> },
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_R4, consoleWriteLine<et::ELEMENT_TYPE_R4> },
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_R8, consoleWriteLine<et::ELEMENT_TYPE_R8> },
+    { "System", "Console", "WriteLine", et::ELEMENT_TYPE_STRING, consoleWriteLine<et::ELEMENT_TYPE_STRING> },
+    { "System", "Console", "Write", et::ELEMENT_TYPE_BOOLEAN, consoleWrite<et::ELEMENT_TYPE_BOOLEAN> },
+    { "System", "Console", "Write", et::ELEMENT_TYPE_CHAR, consoleWrite<et::ELEMENT_TYPE_CHAR> },
+    { "System", "Console", "Write", et::ELEMENT_TYPE_I4, consoleWrite<et::ELEMENT_TYPE_I4> },
+    { "System", "Console", "Write", et::ELEMENT_TYPE_U4, consoleWrite<et::ELEMENT_TYPE_U4> },
+    { "System", "Console", "Write", et::ELEMENT_TYPE_I8, consoleWrite<et::ELEMENT_TYPE_I8> },
+    { "System", "Console", "Write", et::ELEMENT_TYPE_U8, consoleWrite<et::ELEMENT_TYPE_U8> },
+    { "System", "Console", "Write", et::ELEMENT_TYPE_R4, consoleWrite<et::ELEMENT_TYPE_R4> },
+    { "System", "Console", "Write", et::ELEMENT_TYPE_R8, consoleWrite<et::ELEMENT_TYPE_R8> },
+    { "System", "Console", "Write", et::ELEMENT_TYPE_STRING, consoleWrite<et::ELEMENT_TYPE_STRING> },
+};
+
+NativeMethod findIntrinsic(const AssemblyData& assembly, uint32_t methodDefRow) {
+    const auto& methodDef = assembly.cliMetaDataTables._MethodDef[methodDefRow - 1];
+    const auto owner = assembly.getMethodOwner(methodDefRow);
+    if (owner == 0) {
+        return nullptr;
+    }
+    const auto& typeDef = assembly.cliMetaDataTables._TypeDef[owner - 1];
+    const auto& strings = assembly.getStrings();
+
+    // Static methods which return nothing: DEFAULT ParamCount VOID [Param]
+    const auto& signature = *methodDef.signature;
+    if (signature.size() < 3 || signature[0] != _u(CLISignatureFlags::SIG_METHOD_DEFAULT) || signature[2] != _u(et::ELEMENT_TYPE_VOID)) {
+        return nullptr;
+    }
+    CLIElementType parameter;
+    if (signature[1] == 0 && signature.size() == 3) {
+        parameter = et::ELEMENT_TYPE_END;
+    } else if (signature[1] == 1 && signature.size() == 4) {
+        parameter = static_cast<CLIElementType>(signature[3]);
+    } else {
+        return nullptr;
+    }
+
+    for (const auto& intrinsic : intrinsics) {
+        if (intrinsic.parameter == parameter && strings.equals(methodDef.name, intrinsic.name) && strings.equals(typeDef.typeName, intrinsic.typeName) && strings.equals(typeDef.typeNamespace, intrinsic.typeNamespace)) {
+            return intrinsic.method;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,14 @@
+#ifndef __INTRINSICS_HXX__
+#define __INTRINSICS_HXX__
+
+#include <cstdint>
+
+#include "RuntimeMethod.hxx"
+
+class AssemblyData;
+
+// Native implementation of the library method, null if method has to be interpreted. Methods of System.Console
+//  are implemented natively until the runtime is able to run their managed implementations.
+NativeMethod findIntrinsic(const AssemblyData& assembly, uint32_t methodDefRow);
+
+#endif
@@ -0,0 +1,93 @@
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include "ManagedHeap.hxx"
+#include "AssemblyData.hxx"
+
+using namespace std;
+
+ArrayObject* ManagedHeap::newArray(CLIElementType elementType, size_t length) {
+    const auto elementSize = getElementSize(elementType);
+    if (elementSize == 0) {
+        throw runtime_error("Arrays of value types aren't supported");
+    }
+    if (length > (SIZE_MAX - sizeof(ArrayObject)) / elementSize) {
+        throw runtime_error("Array is too large");
+    }
+
+    lock_guard<mutex> guard(lock);
+    auto result = new (allocate(sizeof(ArrayObject) + length * elementSize)) ArrayObject();
+    result->elementType = elementType;
+    result->elementSize = elementSize;
+    result->length = length;
+    return result;
+}
+
+StringObject* ManagedHeap::newString(const u16string& value) {
+    lock_guard<mutex> guard(lock);
+    auto result = new (allocate(sizeof(StringObject) + value.size() * sizeof(char16_t))) StringObject();
+    result->length = value.size();
+    memcpy(result->chars(), value.data(), value.size() * sizeof(char16_t));
+    return result;
+}
+
+const StringObject* ManagedHeap::getLiteral(const AssemblyData* assembly, uint32_t token) {
+    const auto key = make_pair(assembly, token);
+    {
+        lock_guard<mutex> guard(lock);
+        auto known = literals.find(key);
+        if (known != literals.end()) {
+            return (*known).second;
+        }
+    }
+
+    auto value = assembly->getUserString(token);
+
+    lock_guard<mutex> guard(lock);
+    auto known = literals.find(key);
+    if (known != literals.end()) {
+        return (*known).second;
+    }
+    auto result = new (allocate(sizeof(StringObject) + value.size() * sizeof(char16_t))) StringObject();
+    result->length = value.size();
+    memcpy(result->chars(), value.data(), value.size() * sizeof(char16_t));
+    literals.emplace(key, result);
+    return result;
+}
+
+uint32_t ManagedHeap::getElementSize(CLIElementType elementType) {
+    using et = CLIElementType;
+
+    switch (elementType) {
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_I1:
+    case et::ELEMENT_TYPE_U1:
+        return 1;
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_I2:
+    case et::ELEMENT_TYPE_U2:
+        return 2;
+    case et::ELEMENT_TYPE_I4:
+    case et::ELEMENT_TYPE_U4:
+    case et::ELEMENT_TYPE_R4:
+        return 4;
+    case et::ELEMENT_TYPE_I8:
+    case et::ELEMENT_TYPE_U8:
+    case et::ELEMENT_TYPE_R8:
+        return 8;
+    case et::ELEMENT_TYPE_I:
+    case et::ELEMENT_TYPE_U:
+    case et::ELEMENT_TYPE_CLASS:
+        return sizeof(size_t);
+    default:
+        return 0;
+    }
+}
+
+// Caller must hold the lock. Memory is zero-filled and aligned for any primitive type.
+void* ManagedHeap::allocate(size_t size) {
+    const auto words = (size + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    objects.emplace_back(new uint64_t[words]());
+    return objects.back().get();
+}
@@ -0,0 +1,69 @@
+#ifndef __MANAGEDHEAP_HXX__
+#define __MANAGEDHEAP_HXX__
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CLIElementTypes.hxx"
+
+class AssemblyData;
+class MethodTable;
+
+// Common part of all managed objects, references on the evaluation stack are pointers to it.
+struct ObjectHeader {
+    // Null if type of object isn't loaded
+    const MethodTable* methodTable = nullptr;
+};
+
+// Single-dimensional zero-based array, elements are following the header.
+struct ArrayObject : ObjectHeader {
+    // Primitive type of elements, ELEMENT_TYPE_CLASS for references
+    CLIElementType elementType = CLIElementType::ELEMENT_TYPE_END;
+    uint32_t elementSize = 0;
+    size_t length = 0;
+
+    uint8_t* data() { return reinterpret_cast<uint8_t*>(this + 1); }
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+};
+
+// Immutable string of UTF-16 characters, which are following the header.
+struct StringObject : ObjectHeader {
+    size_t length = 0;
+
+    char16_t* chars() { return reinterpret_cast<char16_t*>(this + 1); }
+    const char16_t* chars() const { return reinterpret_cast<const char16_t*>(this + 1); }
+};
+
+// Storage of managed objects of the domain. There is no garbage collector yet, so objects are living until
+//  the heap is destroyed. Allocation is safe to use from several threads.
+class ManagedHeap
+{
+public:
+    ManagedHeap() = default;
+    ManagedHeap(const ManagedHeap& other) = delete;
+    ManagedHeap& operator=(const ManagedHeap& other) = delete;
+
+    // Zero-filled array
+    ArrayObject* newArray(CLIElementType elementType, size_t length);
+    StringObject* newString(const std::u16string& value);
+
+    // String literal of ldstr instruction, the same object is returned for every use of the literal.
+    const StringObject* getLiteral(const AssemblyData* assembly, uint32_t token);
+
+    // Size of element of array or variable of given type, zero for value types which aren't primitive.
+    static uint32_t getElementSize(CLIElementType elementType);
+
+private:
+    void* allocate(size_t size);
+
+    std::mutex lock;
+    std::vector<std::unique_ptr<uint64_t[]> > objects;
+    std::map<std::pair<const AssemblyData*, uint32_t>, const StringObject*> literals;
+};
+
+#endif
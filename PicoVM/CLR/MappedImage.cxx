@@ -0,0 +1,179 @@
+#include <map>
+#include <mutex>
+#include <limits>
+#include <stdexcept>
+#include <cstdlib>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+#include "MappedImage.hxx"
+
+using namespace std;
+
+// Images which are currently alive, by absolute path
+static map<string, weak_ptr<const MappedImage> > openImages;
+static mutex openImagesMutex;
+
+string MappedImage::getCanonicalPath(const string& strFilePathName) {
+#ifdef WIN32
+    char buffer[_MAX_PATH];
+    if (_fullpath(buffer, strFilePathName.c_str(), _MAX_PATH) == nullptr) {
+        throw runtime_error("Unable to open assembly file");
+    }
+    return buffer;
+#else
+    char buffer[PATH_MAX];
+    if (realpath(strFilePathName.c_str(), buffer) == nullptr) {
+        throw runtime_error("Unable to open assembly file");
+    }
+    return buffer;
+#endif
+}
+
+shared_ptr<const MappedImage> MappedImage::open(const string& strFilePathName) {
+    auto absolutePath = getCanonicalPath(strFilePathName);
+
+    lock_guard<mutex> lock(openImagesMutex);
+
+    auto it = openImages.find(absolutePath);
+    if (it != openImages.end()) {
+        auto existing = (*it).second.lock();
+        if (existing) {
+            return existing;
+        }
+        openImages.erase(it);
+    }
+
+    shared_ptr<MappedImage> image(new MappedImage());
+    image->filePath = absolutePath;
+
+#ifdef WIN32
+    HANDLE file = CreateFileA(absolutePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw runtime_error("Unable to open assembly file");
+    }
+    image->fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart > numeric_limits<uint32_t>::max()) {
+        throw runtime_error("Unable to open assembly file");
+    }
+    image->length = static_cast<uint32_t>(fileSize.QuadPart);
+
+    if (image->length != 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            throw runtime_error("Unable to map assembly file");
+        }
+        image->mappingHandle = mapping;
+
+        auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            throw runtime_error("Unable to map assembly file");
+        }
+        image->base = static_cast<const uint8_t*>(view);
+        image->isMapped = true;
+    }
+#else
+    int fd = ::open(absolutePath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw runtime_error("Unable to open assembly file");
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || static_cast<uint64_t>(fileStat.st_size) > numeric_limits<uint32_t>::max()) {
+        close(fd);
+        throw runtime_error("Unable to open assembly file");
+    }
+    image->length = static_cast<uint32_t>(fileStat.st_size);
+
+    if (image->length != 0) {
+        void* view = mmap(nullptr, image->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Unable to map assembly file");
+        }
+        image->base = static_cast<const uint8_t*>(view);
+        image->isMapped = true;
+    }
+
+    // Mapping stays valid after the descriptor is closed.
+    close(fd);
+#endif
+
+    openImages[absolutePath] = image;
+    return image;
+}
+
+shared_ptr<const MappedImage> MappedImage::fromBytes(const vector<uint8_t>& bytes) {
+    if (bytes.size() > numeric_limits<uint32_t>::max()) {
+        throw runtime_error("Assembly image is too large");
+    }
+
+    shared_ptr<MappedImage> image(new MappedImage());
+    image->buffer = bytes;
+    image->base = image->buffer.data();
+    image->length = static_cast<uint32_t>(image->buffer.size());
+    return image;
+}
+
+void MappedImage::advise(uint32_t offset, uint32_t rangeLength, Advice advice) const {
+    if (!isMapped || offset >= length) {
+        return;
+    }
+
+    if (rangeLength > length - offset) {
+        rangeLength = length - offset;
+    }
+
+#ifdef WIN32
+    // There is no portable equivalent of madvise() on Windows, the system cache manager does the job for us.
+    (void)advice;
+#else
+    // madvise() wants page aligned address
+    static const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    auto start = reinterpret_cast<uintptr_t>(base + offset);
+    auto alignedStart = start & ~(pageSize - 1);
+    auto alignedLength = rangeLength + (start - alignedStart);
+
+    int flag = MADV_NORMAL;
+    switch (advice) {
+    case Advice::Sequential: flag = MADV_SEQUENTIAL; break;
+    case Advice::Random: flag = MADV_RANDOM; break;
+    case Advice::WillNeed: flag = MADV_WILLNEED; break;
+    case Advice::Normal:
+    default:
+        break;
+    }
+
+    // This is just a hint, so errors are not critical for us.
+    madvise(reinterpret_cast<void*>(alignedStart), alignedLength, flag);
+#endif
+}
+
+MappedImage::~MappedImage() noexcept
+{
+#ifdef WIN32
+    if (isMapped) {
+        UnmapViewOfFile(base);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != nullptr) {
+        CloseHandle(fileHandle);
+    }
+#else
+    if (isMapped) {
+        munmap(const_cast<uint8_t*>(base), length);
+    }
+#endif
+}
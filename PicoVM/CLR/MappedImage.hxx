@@ -0,0 +1,62 @@
+#ifndef __MAPPEDIMAGE_HXX__
+#define __MAPPEDIMAGE_HXX__
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only view of the assembly image bytes. Images which are opened by path are memory-mapped,
+//  so the resident size is proportional to the number of pages which are actually touched. Every
+//  open() call for the same file returns the same instance while it's alive.
+class MappedImage
+{
+public:
+    // Access pattern hints for the kernel
+    enum struct Advice : uint8_t {
+        Normal = 0,
+        Sequential = 1,
+        Random = 2,
+        WillNeed = 3
+    };
+
+    MappedImage(const MappedImage& other) = delete;
+    MappedImage& operator=(const MappedImage& other) = delete;
+    ~MappedImage() noexcept;
+
+    // Map the file or return an existing mapping of the same file.
+    static std::shared_ptr<const MappedImage> open(const std::string& strFilePathName);
+
+    // Absolute path with all symbolic links resolved, throws if file doesn't exist.
+    static std::string getCanonicalPath(const std::string& strFilePathName);
+
+    // Create image from the memory buffer.
+    static std::shared_ptr<const MappedImage> fromBytes(const std::vector<uint8_t>& bytes);
+
+    const uint8_t* data() const { return base; }
+    uint32_t size() const { return length; }
+
+    // Absolute path of the mapped file, empty for images created from memory buffers.
+    const std::string& path() const { return filePath; }
+
+    // Pass access pattern hint for the given range of image. Hints are ignored for memory buffers.
+    void advise(uint32_t offset, uint32_t rangeLength, Advice advice) const;
+
+private:
+    MappedImage() = default;
+
+    const uint8_t* base = nullptr;
+    uint32_t length = 0;
+    bool isMapped = false;
+
+    std::vector<uint8_t> buffer;
+    std::string filePath;
+
+#ifdef WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+#endif
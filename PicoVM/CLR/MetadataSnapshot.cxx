@@ -0,0 +1,330 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "MetadataSnapshot.hxx"
+#include "EnumCasting.hxx"
+
+using namespace std;
+
+const uint32_t MetadataSnapshot::formatVersion;
+
+static const char snapshotMagic[8] = { 'P', 'V', 'M', 'S', 'N', 'A', 'P', 0 };
+static const uint32_t snapshotByteOrder = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint8_t mvid[16];
+    uint64_t metadataHash;
+    int64_t modificationTime;
+    uint32_t imageSize;
+    uint32_t methodsCount;
+    uint32_t methodsOffset;
+    uint32_t clausesCount;
+    uint32_t clausesOffset;
+    uint32_t namesCount;
+    uint32_t nameSlotsCount;
+    uint32_t offsetSlotsOffset;
+    uint32_t nameSlotsOffset;
+    uint32_t reserved;
+};
+
+struct SnapshotTable {
+    uint32_t rowCount;
+    uint32_t columnsCount;
+    uint32_t cellsOffset;
+    uint32_t reserved;
+};
+
+// Exception clause is stored as six 32-bit values
+static const uint32_t clauseCells = 6;
+
+// FNV-1a over 64-bit words in four independent lanes, so multiplications aren't waiting for each other.
+//  The tail is mixed byte by byte.
+static uint64_t hashBytes(const uint8_t* data, uint32_t size) {
+    const uint64_t prime = 1099511628211ull;
+    uint64_t lanes[4] = { 14695981039346656037ull, 14695981039346656037ull ^ 1, 14695981039346656037ull ^ 2, 14695981039346656037ull ^ 3 };
+    uint32_t n = 0;
+    for (; n + 32 <= size; n += 32) {
+        for (uint32_t lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            memcpy(&word, data + n + lane * 8, 8);
+            lanes[lane] = (lanes[lane] ^ word) * prime;
+            lanes[lane] ^= lanes[lane] >> 32;
+        }
+    }
+    uint64_t hash = size;
+    for (auto lane : lanes) {
+        hash = (hash ^ lane) * prime;
+    }
+    for (; n < size; ++n) {
+        hash = (hash ^ data[n]) * prime;
+    }
+    return hash;
+}
+
+static uint32_t align8(uint32_t offset) {
+    return (offset + 7) & ~7u;
+}
+
+// Modification time of the file in seconds, zero if it's unknown.
+static int64_t getModificationTime(const string& path) {
+    if (path.empty()) {
+        return 0;
+    }
+#ifdef WIN32
+    struct _stat64 info;
+    return _stat64(path.c_str(), &info) == 0 ? static_cast<int64_t>(info.st_mtime) : 0;
+#else
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<int64_t>(info.st_mtime) : 0;
+#endif
+}
+
+// Image isn't hashed as a whole, so using the snapshot doesn't touch its pages. Changes of the file are detected
+//  by its size and modification time, changes of the metadata shape are detected by the hash of #~ header.
+MetadataSnapshot::Key MetadataSnapshot::makeKey(const MetadataTablesLayout& layout) {
+    Key key = {};
+    key.imageSize = layout.reader.size();
+    key.modificationTime = getModificationTime(layout.reader.path());
+
+    vector<uint32_t> shape = { layout.stringStreamOffset, layout.stringStreamSize, layout.guidStreamOffset, layout.blobStreamOffset };
+    for (const auto& table : layout.tables) {
+        shape.push_back(table.rowCount);
+    }
+    // Header of #~ stream is 24 bytes long, it's followed by row counts.
+    const auto headerOffset = layout.metaDataOffset - 24;
+    key.metadataHash = hashBytes(&layout.reader[headerOffset], 24) ^ hashBytes(reinterpret_cast<const uint8_t*>(shape.data()), static_cast<uint32_t>(shape.size() * sizeof(uint32_t)));
+
+    // Mvid is the third column of the only row of Module table.
+    auto index = layout.readColumn(CLIMetadataTableItem::Module, 0, 2);
+    if (index != 0) {
+        uint64_t offset = layout.guidStreamOffset + (uint64_t(index - 1) << 4);
+        if (offset + sizeof(key.mvid) > key.imageSize) {
+            throw runtime_error("Invalid #GUID heap index");
+        }
+        memcpy(key.mvid, &layout.reader[static_cast<uint32_t>(offset)], sizeof(key.mvid));
+    }
+    return key;
+}
+
+string MetadataSnapshot::getPath(const string& directory, const string& assemblyPath, const Key& key) {
+    ostringstream ss;
+    if (directory.empty()) {
+        ss << assemblyPath;
+    } else {
+        ss << directory;
+        if (directory.back() != '/' && directory.back() != '\\') {
+            ss << '/';
+        }
+        auto separator = assemblyPath.find_last_of("/\\");
+        ss << (separator == string::npos ? assemblyPath : assemblyPath.substr(separator + 1));
+    }
+
+    ss << '.' << hex << setfill('0');
+    for (auto byte : key.mvid) {
+        ss << setw(2) << static_cast<uint32_t>(byte);
+    }
+    ss << '.' << setw(16) << key.metadataHash << ".pvms";
+    return ss.str();
+}
+
+shared_ptr<const MetadataSnapshot> MetadataSnapshot::open(const string& path, const Key& key, const MetadataTablesLayout& layout) {
+    shared_ptr<const MappedImage> file;
+    try {
+        file = MappedImage::open(path);
+    }
+    catch (const runtime_error&) {
+        // There is no snapshot yet.
+        return nullptr;
+    }
+
+    const auto* base = file->data();
+    const uint64_t size = file->size();
+    auto inBounds = [size](uint64_t offset, uint64_t length) { return offset <= size && length <= size - offset && (offset & 3) == 0; };
+
+    if (!inBounds(0, sizeof(SnapshotHeader) + sizeof(SnapshotTable) * MetadataTablesLayout::maxTables)) {
+        return nullptr;
+    }
+
+    SnapshotHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0 || header.version != formatVersion || header.byteOrder != snapshotByteOrder) {
+        return nullptr;
+    }
+    if (memcmp(header.mvid, key.mvid, sizeof(key.mvid)) != 0 || header.metadataHash != key.metadataHash
+        || header.modificationTime != key.modificationTime || header.imageSize != key.imageSize) {
+        return nullptr;
+    }
+
+    shared_ptr<MetadataSnapshot> snapshot(new MetadataSnapshot());
+
+    // Tables must have the same shape as the ones which are described by layout.
+    const auto* tables = reinterpret_cast<const SnapshotTable*>(base + sizeof(SnapshotHeader));
+    for (uint32_t n = 0; n < MetadataTablesLayout::maxTables; ++n) {
+        const auto& table = tables[n];
+        const auto& info = layout.tables[n];
+        if (table.rowCount != info.rowCount || table.columnsCount != info.columns.size()) {
+            return nullptr;
+        }
+        if (!inBounds(table.cellsOffset, uint64_t(table.rowCount) * table.columnsCount * sizeof(uint32_t))) {
+            return nullptr;
+        }
+        if (table.rowCount != 0) {
+            snapshot->cells[n] = reinterpret_cast<const uint32_t*>(base + table.cellsOffset);
+        }
+    }
+
+    if (header.methodsCount != layout.getRowCount(CLIMetadataTableItem::MethodDef)
+        || !inBounds(header.methodsOffset, uint64_t(header.methodsCount) * sizeof(MethodEntry))
+        || !inBounds(header.clausesOffset, uint64_t(header.clausesCount) * clauseCells * sizeof(uint32_t))) {
+        return nullptr;
+    }
+
+    snapshot->methods = reinterpret_cast<const MethodEntry*>(base + header.methodsOffset);
+    snapshot->clauses = reinterpret_cast<const uint32_t*>(base + header.clausesOffset);
+    snapshot->methodsCount = header.methodsCount;
+    snapshot->clausesCount = header.clausesCount;
+    snapshot->imageSize = key.imageSize;
+
+    // Probing stops at empty slots, so there must be some. Offsets of strings are checked by the heap when they're
+    //  read, so slots aren't scanned here.
+    const uint64_t slotsSize = uint64_t(header.nameSlotsCount) * 2 * sizeof(uint32_t);
+    if (header.nameSlotsCount == 0 || (header.nameSlotsCount & (header.nameSlotsCount - 1)) != 0 || header.namesCount >= header.nameSlotsCount
+        || !inBounds(header.offsetSlotsOffset, slotsSize) || !inBounds(header.nameSlotsOffset, slotsSize)) {
+        return nullptr;
+    }
+    auto& nameTables = snapshot->nameTables;
+    nameTables.offsetSlots = reinterpret_cast<const uint32_t*>(base + header.offsetSlotsOffset);
+    nameTables.nameSlots = reinterpret_cast<const uint32_t*>(base + header.nameSlotsOffset);
+    nameTables.slotsCount = header.nameSlotsCount;
+    nameTables.namesCount = header.namesCount;
+
+    snapshot->file = file;
+    return snapshot;
+}
+
+void MetadataSnapshot::write(const string& path, const Key& key, const MetadataTablesLayout& layout, const vector<MethodEntry>& methods, const vector<ExceptionClause>& clauses, const NameTable& names) {
+    vector<uint32_t> offsetSlots, nameSlots;
+    auto namesCount = names.makeFlatTables(offsetSlots, nameSlots);
+
+    SnapshotHeader header = {};
+    SnapshotTable tables[MetadataTablesLayout::maxTables] = {};
+
+    uint32_t offset = sizeof(header) + sizeof(tables);
+    for (uint32_t n = 0; n < MetadataTablesLayout::maxTables; ++n) {
+        tables[n].rowCount = layout.tables[n].rowCount;
+        tables[n].columnsCount = static_cast<uint32_t>(layout.tables[n].columns.size());
+        tables[n].cellsOffset = offset = align8(offset);
+        offset += tables[n].rowCount * tables[n].columnsCount * sizeof(uint32_t);
+    }
+
+    memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = formatVersion;
+    header.byteOrder = snapshotByteOrder;
+    memcpy(header.mvid, key.mvid, sizeof(key.mvid));
+    header.metadataHash = key.metadataHash;
+    header.modificationTime = key.modificationTime;
+    header.imageSize = key.imageSize;
+    header.methodsCount = static_cast<uint32_t>(methods.size());
+    header.methodsOffset = offset = align8(offset);
+    offset += header.methodsCount * sizeof(MethodEntry);
+    header.clausesCount = static_cast<uint32_t>(clauses.size());
+    header.clausesOffset = offset = align8(offset);
+    offset += header.clausesCount * clauseCells * sizeof(uint32_t);
+    header.namesCount = namesCount;
+    header.nameSlotsCount = static_cast<uint32_t>(offsetSlots.size() / 2);
+    header.offsetSlotsOffset = offset = align8(offset);
+    offset += static_cast<uint32_t>(offsetSlots.size() * sizeof(uint32_t));
+    header.nameSlotsOffset = offset = align8(offset);
+    offset += static_cast<uint32_t>(nameSlots.size() * sizeof(uint32_t));
+
+    vector<uint8_t> buffer(offset);
+    memcpy(&buffer[0], &header, sizeof(header));
+    memcpy(&buffer[sizeof(header)], tables, sizeof(tables));
+    for (uint32_t n = 0; n < MetadataTablesLayout::maxTables; ++n) {
+        if (tables[n].rowCount != 0) {
+            auto tableIndex = static_cast<CLIMetadataTableItem>(n);
+            layout.readCells(tableIndex, 0, tables[n].rowCount, reinterpret_cast<uint32_t*>(&buffer[tables[n].cellsOffset]));
+        }
+    }
+    if (!methods.empty()) {
+        memcpy(&buffer[header.methodsOffset], methods.data(), methods.size() * sizeof(MethodEntry));
+    }
+    auto* clauseCell = reinterpret_cast<uint32_t*>(&buffer[header.clausesOffset]);
+    for (const auto& clause : clauses) {
+        *clauseCell++ = clause.flags;
+        *clauseCell++ = clause.tryOffset;
+        *clauseCell++ = clause.tryLength;
+        *clauseCell++ = clause.handlerOffset;
+        *clauseCell++ = clause.handlerLength;
+        *clauseCell++ = clause.classTokenOrFilterOffset;
+    }
+    memcpy(&buffer[header.offsetSlotsOffset], offsetSlots.data(), offsetSlots.size() * sizeof(uint32_t));
+    memcpy(&buffer[header.nameSlotsOffset], nameSlots.data(), nameSlots.size() * sizeof(uint32_t));
+
+    // Several processes may be writing the same snapshot at once, each of them is using its own temporary file.
+#ifdef WIN32
+    auto temporaryPath = path + "." + to_string(_getpid()) + ".tmp";
+#else
+    auto temporaryPath = path + "." + to_string(getpid()) + ".tmp";
+#endif
+    {
+        ofstream stream(temporaryPath, ios::binary | ios::trunc);
+        stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        if (!stream) {
+            stream.close();
+            remove(temporaryPath.c_str());
+            throw runtime_error("Unable to write metadata snapshot");
+        }
+    }
+
+    if (rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        remove(temporaryPath.c_str());
+        throw runtime_error("Unable to write metadata snapshot");
+    }
+}
+
+const uint32_t* MetadataSnapshot::getCells(CLIMetadataTableItem tableIndex) const {
+    return _u(tableIndex) < MetadataTablesLayout::maxTables ? cells[_u(tableIndex)] : nullptr;
+}
+
+const MetadataSnapshot::MethodEntry& MetadataSnapshot::getMethod(uint32_t index) const {
+    if (index >= methodsCount) {
+        throw runtime_error("Invalid method index");
+    }
+    // Bodies are extracted without parsing their headers again, so the entry must point into the image.
+    const auto& method = methods[index];
+    if (uint64_t(method.codeOffset) + method.codeSize > imageSize
+        || method.firstClause > clausesCount || method.clausesCount > clausesCount - method.firstClause) {
+        throw runtime_error("Invalid method entry in metadata snapshot");
+    }
+    return method;
+}
+
+void MetadataSnapshot::getClauses(const MethodEntry& method, vector<ExceptionClause>& result) const {
+    const auto* clauseCell = clauses + method.firstClause * clauseCells;
+    for (uint32_t n = 0; n < method.clausesCount; ++n) {
+        ExceptionClause clause;
+        clause.flags = *clauseCell++;
+        clause.tryOffset = *clauseCell++;
+        clause.tryLength = *clauseCell++;
+        clause.handlerOffset = *clauseCell++;
+        clause.handlerLength = *clauseCell++;
+        clause.classTokenOrFilterOffset = *clauseCell++;
+        result.push_back(clause);
+    }
+}
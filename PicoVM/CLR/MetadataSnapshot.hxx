@@ -0,0 +1,91 @@
+#ifndef __METADATASNAPSHOT_HXX__
+#define __METADATASNAPSHOT_HXX__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedImage.hxx"
+#include "CLIMetadataTableRows.hxx"
+#include "CLIMethodBody.hxx"
+#include "NameTable.hxx"
+
+// Persistent image of the decoded metadata: cells of all tables, already widened to 32 bits, the index of
+//  method bodies and the name table. Snapshot is keyed by module version id, size and modification time of the
+//  assembly file, and hash of the metadata header, so the rest of image isn't read when snapshot is used.
+//  It's loaded with a single mmap() and pointer fix-up, so all processes which are using the same assembly
+//  share its pages.
+//
+// File layout: header, directory of tables, cells of every table row by row, method entries, exception clauses
+//  and flat name tables. All values are in the host byte order, snapshot made on the host with another byte
+//  order is rejected.
+class MetadataSnapshot
+{
+public:
+    static const uint32_t formatVersion = 2;
+
+    // Snapshot is valid only for the image with the same key
+    struct Key {
+        uint8_t mvid[16];
+        // Header of #~ stream with row counts, and placement of heaps
+        uint64_t metadataHash;
+        // Zero for images which aren't loaded from files
+        int64_t modificationTime;
+        uint32_t imageSize;
+    };
+
+    // Parsed header of the method body
+    struct MethodEntry {
+        // Offset of IL code from the beginning of image, zero if there is no body
+        uint32_t codeOffset;
+        uint32_t codeSize;
+        uint32_t localVarSigToken;
+        // Range of exception clauses
+        uint32_t firstClause;
+        uint32_t clausesCount;
+        uint16_t maxStack;
+        uint16_t initLocals;
+    };
+
+    MetadataSnapshot(const MetadataSnapshot& other) = delete;
+    MetadataSnapshot& operator=(const MetadataSnapshot& other) = delete;
+
+    // Module version id, size and modification time of the file and hash of the metadata header. Only the pages
+    //  of metadata header are read.
+    static Key makeKey(const MetadataTablesLayout& layout);
+
+    // Snapshot file name for the assembly, either in the given directory or next to the assembly itself.
+    static std::string getPath(const std::string& directory, const std::string& assemblyPath, const Key& key);
+
+    // Map the snapshot file, returns null if file doesn't exist or it doesn't match the key and layout. Only the
+    //  header and directory are checked here, entries are checked when they're used, so pages of the snapshot
+    //  are touched on demand as well.
+    static std::shared_ptr<const MetadataSnapshot> open(const std::string& path, const Key& key, const MetadataTablesLayout& layout);
+
+    // Write the snapshot under temporary name and rename it, so readers never see a partially written file.
+    static void write(const std::string& path, const Key& key, const MetadataTablesLayout& layout, const std::vector<MethodEntry>& methods, const std::vector<ExceptionClause>& clauses, const NameTable& names);
+
+    // Cells of the table row by row, or null if table is empty
+    const uint32_t* getCells(CLIMetadataTableItem tableIndex) const;
+
+    uint32_t getMethodsCount() const { return methodsCount; }
+    const MethodEntry& getMethod(uint32_t index) const;
+    void getClauses(const MethodEntry& method, std::vector<ExceptionClause>& result) const;
+
+    const NameTable::FlatTables& getNameTables() const { return nameTables; }
+
+private:
+    MetadataSnapshot() = default;
+
+    std::shared_ptr<const MappedImage> file;
+    const uint32_t* cells[MetadataTablesLayout::maxTables] = {};
+    const MethodEntry* methods = nullptr;
+    const uint32_t* clauses = nullptr;
+    uint32_t methodsCount = 0;
+    uint32_t clausesCount = 0;
+    uint32_t imageSize = 0;
+    NameTable::FlatTables nameTables;
+};
+
+#endif
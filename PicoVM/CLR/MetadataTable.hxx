@@ -0,0 +1,136 @@
+#ifndef __METADATATABLE_HXX__
+#define __METADATATABLE_HXX__
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "CLIMetadataTableRows.hxx"
+
+// Metadata table which is decoding its rows on first access.
+//
+// Rows are decoded by chunks of chunkSize rows. Decoded chunk is published with atomic compare-and-swap, so
+//  concurrent readers never block each other. If two threads are decoding the same chunk simultaneously then
+//  one of results is discarded. Published chunks are never moved or freed until the table is destroyed, so
+//  references to rows are stable.
+template<typename T>
+class MetadataTable
+{
+public:
+    static const uint32_t chunkSize = 64;
+
+    MetadataTable() = default;
+
+    MetadataTable(std::shared_ptr<const MetadataTablesLayout> tablesLayout) : layout(tablesLayout) {
+        rowCount = layout->getRowCount(T::tableID);
+        chunksCount = (rowCount + chunkSize - 1) / chunkSize;
+        chunks.reset(new std::atomic<Chunk*>[chunksCount]);
+        for (uint32_t n = 0; n < chunksCount; ++n) {
+            chunks[n].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // Copy shares the layout, already decoded rows are copied.
+    MetadataTable(const MetadataTable& other) : layout(other.layout), rowCount(other.rowCount), chunksCount(other.chunksCount) {
+        chunks.reset(new std::atomic<Chunk*>[chunksCount]);
+        for (uint32_t n = 0; n < chunksCount; ++n) {
+            auto chunk = other.chunks[n].load(std::memory_order_acquire);
+            chunks[n].store(chunk != nullptr ? new Chunk(*chunk) : nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    MetadataTable(MetadataTable&& other) noexcept {
+        swap(other);
+    }
+
+    MetadataTable& operator=(MetadataTable other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    void swap(MetadataTable& other) noexcept {
+        layout.swap(other.layout);
+        std::swap(rowCount, other.rowCount);
+        std::swap(chunksCount, other.chunksCount);
+        chunks.swap(other.chunks);
+    }
+
+    ~MetadataTable() noexcept {
+        for (uint32_t n = 0; n < chunksCount; ++n) {
+            delete chunks[n].load(std::memory_order_relaxed);
+        }
+    }
+
+    size_t size() const { return rowCount; }
+    bool empty() const { return rowCount == 0; }
+
+    // Layout of tables, columns could be read from it without decoding rows.
+    const MetadataTablesLayout& getLayout() const { return *layout; }
+
+    // Get row by zero-based index, decoding it if necessary.
+    const T& operator[](size_t index) const {
+        return getChunk(static_cast<uint32_t>(index / chunkSize))[index % chunkSize];
+    }
+
+    // Mutable access to row, not thread safe. Should only be used during assembly initialization.
+    T& at(size_t index) {
+        return getChunk(static_cast<uint32_t>(index / chunkSize))[index % chunkSize];
+    }
+
+    // Decode all rows at once.
+    void materialize() const {
+        for (uint32_t n = 0; n < chunksCount; ++n) {
+            getChunk(n);
+        }
+    }
+
+    // Chunks are independent, so they may be decoded by different threads.
+    uint32_t getChunksCount() const { return chunksCount; }
+    void materializeChunk(uint32_t chunkIndex) const {
+        getChunk(chunkIndex);
+    }
+
+private:
+    typedef std::vector<T> Chunk;
+
+    Chunk& getChunk(uint32_t chunkIndex) const {
+        auto chunk = chunks[chunkIndex].load(std::memory_order_acquire);
+        if (chunk != nullptr) {
+            return *chunk;
+        }
+
+        // Decode rows of this chunk, which are placed sequentially.
+        auto first = chunkIndex * chunkSize;
+        auto count = std::min(chunkSize, rowCount - first);
+        std::unique_ptr<Chunk> decoded(new Chunk());
+        decoded->reserve(count);
+
+        MetadataRowsReader mr(*layout);
+        mr.seek(T::tableID, first, count);
+        for (uint32_t n = 0; n < count; ++n) {
+            decoded->emplace_back(mr);
+            mr.nextRow();
+        }
+
+        // Publish decoded chunk, unless some other thread has already done it.
+        Chunk* expected = nullptr;
+        if (chunks[chunkIndex].compare_exchange_strong(expected, decoded.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return *decoded.release();
+        }
+
+        return *expected;
+    }
+
+    std::shared_ptr<const MetadataTablesLayout> layout;
+    uint32_t rowCount = 0;
+    uint32_t chunksCount = 0;
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks;
+};
+
+template<typename T>
+const uint32_t MetadataTable<T>::chunkSize;
+
+#endif
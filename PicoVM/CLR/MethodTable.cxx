@@ -0,0 +1,82 @@
+#include <stdexcept>
+
+#include "MethodTable.hxx"
+
+using namespace std;
+
+const uint32_t MethodTable::noSlot;
+
+uint32_t MethodTable::getSlot(uint32_t methodDefRow) const {
+    auto index = methodDefRow - firstMethod;
+    if (methodDefRow < firstMethod || index >= methodSlots.size()) {
+        throw runtime_error("Method isn't declared by this type");
+    }
+    return methodSlots[index];
+}
+
+void MethodTable::setMethodSlots(uint32_t FirstMethod, vector<uint32_t> Slots) {
+    firstMethod = FirstMethod;
+    methodSlots = move(Slots);
+}
+
+void MethodTable::addInterface(const MethodTable* interfaceType, const vector<uint32_t>& slots) {
+    interfaces.push_back({ interfaceType, static_cast<uint32_t>(interfaceSlots.size()) });
+    interfaceSlots.insert(interfaceSlots.end(), slots.begin(), slots.end());
+}
+
+static uint32_t hashInterface(const MethodTable* interfaceType) {
+    // Tables are heap allocated, so low bits of address are always the same.
+    auto value = reinterpret_cast<uintptr_t>(interfaceType) >> 4;
+    return static_cast<uint32_t>(value * 2654435761u) ^ static_cast<uint32_t>(value >> 29);
+}
+
+void MethodTable::finish() {
+    runtimeMethods.reset(new atomic<const RuntimeMethod*>[vtable.size()]);
+    for (size_t n = 0; n < vtable.size(); ++n) {
+        runtimeMethods[n].store(nullptr, memory_order_relaxed);
+    }
+
+    // At most half of slots are used, so probe sequences stay short.
+    uint32_t slotsCount = 1;
+    while (slotsCount < interfaces.size() * 2) {
+        slotsCount <<= 1;
+    }
+    interfaceMap.assign(slotsCount, 0);
+
+    const auto mask = slotsCount - 1;
+    for (uint32_t n = 0; n < interfaces.size(); ++n) {
+        auto slot = hashInterface(interfaces[n].interfaceType) & mask;
+        while (interfaceMap[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        interfaceMap[slot] = n + 1;
+    }
+}
+
+const MethodTable::InterfaceEntry* MethodTable::findInterface(const MethodTable* interfaceType) const {
+    if (interfaces.empty()) {
+        return nullptr;
+    }
+
+    const auto mask = static_cast<uint32_t>(interfaceMap.size()) - 1;
+    for (auto slot = hashInterface(interfaceType) & mask; interfaceMap[slot] != 0; slot = (slot + 1) & mask) {
+        const auto& entry = interfaces[interfaceMap[slot] - 1];
+        if (entry.interfaceType == interfaceType) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const MethodHandle* MethodTable::findInterfaceMethod(const MethodTable* interfaceType, uint32_t interfaceSlot) const {
+    auto slot = findInterfaceSlot(interfaceType, interfaceSlot);
+    return slot != noSlot ? &vtable[slot] : nullptr;
+}
+
+uint32_t MethodTable::findInterfaceSlot(const MethodTable* interfaceType, uint32_t interfaceSlot) const {
+    const auto* entry = findInterface(interfaceType);
+    if (entry == nullptr || interfaceSlot >= interfaceType->vtable.size()) {
+        return noSlot;
+    }
+    return interfaceSlots[entry->first + interfaceSlot];
+}
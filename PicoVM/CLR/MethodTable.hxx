@@ -0,0 +1,87 @@
+#ifndef __METHODTABLE_HXX__
+#define __METHODTABLE_HXX__
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class AssemblyData;
+struct RuntimeMethod;
+
+// Method definition in the assembly which defines it
+struct MethodHandle {
+    const AssemblyData* assembly = nullptr;
+    // One-based MethodDef row, zero if there is no method
+    uint32_t methodDefRow = 0;
+
+    MethodHandle() = default;
+    MethodHandle(const AssemblyData* Assembly, uint32_t MethodDefRow) : assembly(Assembly), methodDefRow(MethodDefRow) {}
+
+    bool operator==(const MethodHandle& other) const { return assembly == other.assembly && methodDefRow == other.methodDefRow; }
+    bool operator!=(const MethodHandle& other) const { return !(*this == other); }
+};
+
+// Virtual dispatch data of the loaded type. Virtual call is an indexed load from the vtable, interface call is
+//  a probe of the small hash table of implemented interfaces and an indexed load. Tables are built by the
+//  domain when type is first used, they are immutable after that.
+class MethodTable
+{
+public:
+    static const uint32_t noSlot = 0xFFFFFFFF;
+
+    const AssemblyData* assembly = nullptr;
+    uint32_t typeDefRow = 0;
+    // Null for System.Object and interfaces
+    const MethodTable* parent = nullptr;
+    bool isInterface = false;
+
+    // Implementations by slot, slots of the parent type go first. Interfaces have slots of their own methods.
+    std::vector<MethodHandle> vtable;
+
+    // Slot of method which is declared by this type, noSlot if it isn't virtual.
+    uint32_t getSlot(uint32_t methodDefRow) const;
+
+    // Implementation of the method in the interface slot, null if type doesn't implement this interface.
+    const MethodHandle* findInterfaceMethod(const MethodTable* interfaceType, uint32_t interfaceSlot) const;
+    // Vtable slot of the same implementation, noSlot if there is none.
+    uint32_t findInterfaceSlot(const MethodTable* interfaceType, uint32_t interfaceSlot) const;
+
+    // Runtime method of the implementation in the slot, null until the domain publishes it on first dispatch.
+    //  Every thread publishes the same method, so the slot is just overwritten.
+    const RuntimeMethod* getRuntimeMethod(uint32_t slot) const { return runtimeMethods[slot].load(std::memory_order_acquire); }
+    void publishRuntimeMethod(uint32_t slot, const RuntimeMethod* method) const { runtimeMethods[slot].store(method, std::memory_order_release); }
+
+    // Implemented interfaces, including the ones of parent types and of other interfaces. Every interface has
+    //  vtable slots which are implementing its methods, in the order of interface slots.
+    uint32_t getInterfacesCount() const { return static_cast<uint32_t>(interfaces.size()); }
+    const MethodTable* getInterface(uint32_t index) const { return interfaces[index].interfaceType; }
+    const uint32_t* getInterfaceSlots(uint32_t index) const { return interfaceSlots.data() + interfaces[index].first; }
+
+    // Table is filled by the domain: declared methods first, then interfaces, and then it's finished by building
+    //  the hash table of interfaces. Vtable mustn't change after that.
+    void setMethodSlots(uint32_t FirstMethod, std::vector<uint32_t> Slots);
+    void addInterface(const MethodTable* interfaceType, const std::vector<uint32_t>& slots);
+    void finish();
+
+private:
+    struct InterfaceEntry {
+        const MethodTable* interfaceType;
+        // Index of the first vtable slot in interfaceSlots
+        uint32_t first;
+    };
+
+    uint32_t firstMethod = 0;
+    std::vector<uint32_t> methodSlots;
+
+    std::vector<InterfaceEntry> interfaces;
+    std::vector<uint32_t> interfaceSlots;
+    // Open addressing table of indexes into interfaces plus one, zero for empty slots
+    std::vector<uint32_t> interfaceMap;
+    // Resolved implementations by vtable slot
+    std::unique_ptr<std::atomic<const RuntimeMethod*>[]> runtimeMethods;
+
+    const InterfaceEntry* findInterface(const MethodTable* interfaceType) const;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include <cstring>
+
+#include "NameTable.hxx"
+
+using namespace std;
+
+const uint32_t NameTable::notFound;
+
+bool NameTable::NameKey::operator==(const NameKey& other) const {
+    return length == other.length && memcmp(str, other.str, length) == 0;
+}
+
+size_t NameTable::NameKeyHash::operator()(const NameKey& key) const {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (uint32_t n = 0; n < key.length; ++n) {
+        hash = (hash ^ static_cast<uint8_t>(key.str[n])) * 16777619u;
+    }
+    return hash;
+}
+
+// Hash of the heap offset for the flat table
+static uint32_t hashOffset(uint32_t offset) {
+    return offset * 2654435761u;
+}
+
+NameTable::NameTable(const StringHeap& Strings) : strings(Strings) {
+}
+
+NameTable::NameTable(const StringHeap& Strings, const FlatTables& Flat) : strings(Strings), flat(Flat) {
+}
+
+NameTable::NameKey NameTable::getKey(StringHandle handle) const {
+    return { strings.c_str(handle), strings.length(handle) };
+}
+
+uint32_t NameTable::findOffset(StringHandle handle) const {
+    auto it = offsetIds.find(handle.offset);
+    return it != offsetIds.end() ? (*it).second : notFound;
+}
+
+uint32_t NameTable::findName(const NameKey& key) const {
+    auto it = nameIds.find(key);
+    return it != nameIds.end() ? (*it).second : notFound;
+}
+
+uint32_t NameTable::findFlat(StringHandle handle) const {
+    const auto mask = flat.slotsCount - 1;
+    auto slot = hashOffset(handle.offset) & mask;
+    for (uint32_t n = 0; n < flat.slotsCount; ++n, slot = (slot + 1) & mask) {
+        const auto* pair = &flat.offsetSlots[slot * 2];
+        if (pair[1] == notFound || pair[0] == handle.offset) {
+            return pair[1];
+        }
+    }
+    return notFound;
+}
+
+uint32_t NameTable::findFlat(const NameKey& key) const {
+    const auto mask = flat.slotsCount - 1;
+    auto slot = static_cast<uint32_t>(NameKeyHash()(key)) & mask;
+    for (uint32_t n = 0; n < flat.slotsCount; ++n, slot = (slot + 1) & mask) {
+        const auto* pair = &flat.nameSlots[slot * 2];
+        if (pair[1] == notFound) {
+            return notFound;
+        }
+        StringHandle handle;
+        handle.offset = pair[0];
+        if (getKey(handle) == key) {
+            return pair[1];
+        }
+    }
+    return notFound;
+}
+
+uint32_t NameTable::makeFlatTables(vector<uint32_t>& offsetSlots, vector<uint32_t>& nameSlots) const {
+    call_once(built, &NameTable::build, this);
+
+    // At most half of slots are used, so probe sequences stay short.
+    uint32_t slotsCount = 1;
+    while (slotsCount < offsetIds.size() * 2) {
+        slotsCount <<= 1;
+    }
+    const auto mask = slotsCount - 1;
+    offsetSlots.assign(slotsCount * 2, notFound);
+    nameSlots.assign(slotsCount * 2, notFound);
+
+    for (const auto& item : offsetIds) {
+        auto slot = hashOffset(item.first) & mask;
+        while (offsetSlots[slot * 2 + 1] != notFound) {
+            slot = (slot + 1) & mask;
+        }
+        offsetSlots[slot * 2] = item.first;
+        offsetSlots[slot * 2 + 1] = item.second;
+    }
+
+    const char* base = strings.c_str(StringHandle());
+    for (const auto& item : nameIds) {
+        auto slot = static_cast<uint32_t>(NameKeyHash()(item.first)) & mask;
+        while (nameSlots[slot * 2 + 1] != notFound) {
+            slot = (slot + 1) & mask;
+        }
+        nameSlots[slot * 2] = static_cast<uint32_t>(item.first.str - base);
+        nameSlots[slot * 2 + 1] = item.second;
+    }
+    return static_cast<uint32_t>(nameIds.size());
+}
+
+size_t NameTable::getNamesCount() const {
+    return flat.slotsCount != 0 ? flat.namesCount : nameIds.size();
+}
+
+void NameTable::build() const {
+    if (flat.slotsCount != 0) {
+        // Flat tables are already there.
+        return;
+    }
+
+    // Heap is a sequence of zero terminated strings, the first one is always empty.
+    uint32_t offset = 0;
+    while (offset < strings.size()) {
+        StringHandle handle;
+        handle.offset = offset;
+        auto key = getKey(handle);
+        auto it = nameIds.insert(make_pair(key, static_cast<uint32_t>(nameIds.size()))).first;
+        offsetIds[offset] = (*it).second;
+        offset += key.length + 1;
+    }
+}
+
+uint32_t NameTable::getId(StringHandle handle) const {
+    call_once(built, &NameTable::build, this);
+
+    auto id = flat.slotsCount != 0 ? findFlat(handle) : findOffset(handle);
+    if (id != notFound) {
+        return id;
+    }
+
+    auto key = getKey(handle);
+    id = flat.slotsCount != 0 ? findFlat(key) : findName(key);
+    if (id != notFound) {
+        return id;
+    }
+
+    lock_guard<mutex> guard(suffixLock);
+
+    auto suffixIt = suffixIds.find(handle.offset);
+    if (suffixIt != suffixIds.end()) {
+        return (*suffixIt).second;
+    }
+
+    id = static_cast<uint32_t>(getNamesCount() + suffixNameIds.size());
+    id = (*suffixNameIds.insert(make_pair(key, id)).first).second;
+    suffixIds[handle.offset] = id;
+    return id;
+}
+
+uint32_t NameTable::find(const string& utf8) const {
+    return find(utf8.c_str(), static_cast<uint32_t>(utf8.size()));
+}
+
+uint32_t NameTable::find(const char* utf8, uint32_t length) const {
+    call_once(built, &NameTable::build, this);
+
+    NameKey key = { utf8, length };
+    auto id = flat.slotsCount != 0 ? findFlat(key) : findName(key);
+    if (id != notFound) {
+        return id;
+    }
+
+    lock_guard<mutex> guard(suffixLock);
+    auto suffixIt = suffixNameIds.find(key);
+    return suffixIt != suffixNameIds.end() ? (*suffixIt).second : notFound;
+}
+
+size_t NameTable::size() const {
+    call_once(built, &NameTable::build, this);
+
+    lock_guard<mutex> guard(suffixLock);
+    return getNamesCount() + suffixNameIds.size();
+}
@@ -0,0 +1,83 @@
+#ifndef __NAMETABLE_HXX__
+#define __NAMETABLE_HXX__
+
+#include <cstdint>
+#include <string>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "StringHeap.hxx"
+
+// Per-assembly table which maps every distinct #Strings heap entry to a small integer id, so name
+//  equality becomes an integer comparison. The table is built on first use and is safe for concurrent
+//  readers.
+class NameTable
+{
+public:
+    static const uint32_t notFound = 0xffffffff;
+
+    // Open addressing tables of (heap offset, id) pairs, such as the ones which are kept in metadata snapshot.
+    //  The first one is keyed by offset, the second one is keyed by string contents. Empty slots have notFound
+    //  id, number of slots is a power of two.
+    struct FlatTables {
+        const uint32_t* offsetSlots = nullptr;
+        const uint32_t* nameSlots = nullptr;
+        uint32_t slotsCount = 0;
+        uint32_t namesCount = 0;
+    };
+
+    NameTable(const StringHeap& Strings);
+    // Table which is using prebuilt flat tables, their memory must outlive this table.
+    NameTable(const StringHeap& Strings, const FlatTables& Flat);
+    NameTable(const NameTable& other) = delete;
+    NameTable& operator=(const NameTable& other) = delete;
+
+    // Id of the string, equal strings always have equal ids.
+    uint32_t getId(StringHandle handle) const;
+
+    // Id of the UTF-8 string, or notFound if there is no such string in this assembly.
+    uint32_t find(const std::string& utf8) const;
+    uint32_t find(const char* utf8, uint32_t length) const;
+
+    // Number of distinct names which have been seen so far
+    size_t size() const;
+
+    // Build flat tables for all strings which are beginning right after zero terminator, returns number of names.
+    uint32_t makeFlatTables(std::vector<uint32_t>& offsetSlots, std::vector<uint32_t>& nameSlots) const;
+
+private:
+    struct NameKey {
+        const char* str;
+        uint32_t length;
+
+        bool operator==(const NameKey& other) const;
+    };
+
+    struct NameKeyHash {
+        size_t operator()(const NameKey& key) const;
+    };
+
+    void build() const;
+    NameKey getKey(StringHandle handle) const;
+    uint32_t findOffset(StringHandle handle) const;
+    uint32_t findName(const NameKey& key) const;
+    uint32_t findFlat(StringHandle handle) const;
+    uint32_t findFlat(const NameKey& key) const;
+    size_t getNamesCount() const;
+
+    StringHeap strings;
+    FlatTables flat;
+
+    mutable std::once_flag built;
+    // Ids of heap entries which are beginning right after zero terminator, filled by build().
+    mutable std::unordered_map<uint32_t, uint32_t> offsetIds;
+    mutable std::unordered_map<NameKey, uint32_t, NameKeyHash> nameIds;
+
+    // References into the middle of strings, e.g. when compiler is sharing the common suffixes.
+    mutable std::mutex suffixLock;
+    mutable std::unordered_map<uint32_t, uint32_t> suffixIds;
+    mutable std::unordered_map<NameKey, uint32_t, NameKeyHash> suffixNameIds;
+};
+
+#endif
@@ -30,8 +30,8 @@ inline float uintToFloat(uint32_t value) {
         float f;
         uint32_t i;
     } u;
-    u.f = value;
-    return u.i;
+    u.i = value;
+    return u.f;
 }
 
 inline double ulongToDouble(uint64_t value) {
@@ -0,0 +1,621 @@
+#include "Quickening.hxx"
+#include "EnumCasting.hxx"
+
+using namespace std;
+using et = CLIElementType;
+using i = Instruction;
+
+// Stack type of value which is loaded from array element
+static CLIElementType getElementStackType(CLIElementType type) {
+    switch (type) {
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_I1:
+    case et::ELEMENT_TYPE_U1:
+    case et::ELEMENT_TYPE_I2:
+    case et::ELEMENT_TYPE_U2:
+    case et::ELEMENT_TYPE_I4:
+    case et::ELEMENT_TYPE_U4:
+        return et::ELEMENT_TYPE_I4;
+    case et::ELEMENT_TYPE_I8:
+    case et::ELEMENT_TYPE_U8:
+        return et::ELEMENT_TYPE_I8;
+    case et::ELEMENT_TYPE_R4:
+    case et::ELEMENT_TYPE_R8:
+        return type;
+    case et::ELEMENT_TYPE_I:
+    case et::ELEMENT_TYPE_U:
+        return et::ELEMENT_TYPE_I;
+    case et::ELEMENT_TYPE_CLASS:
+        return et::ELEMENT_TYPE_U;
+    default:
+        return et::ELEMENT_TYPE_END;
+    }
+}
+
+// Type of the result of binary numeric operation, ECMA-335 III.1.5 table 2
+static CLIElementType getResultType(CLIElementType left, CLIElementType right) {
+    if (left == right) {
+        return left;
+    }
+    const auto leftFloat = left == et::ELEMENT_TYPE_R4 || left == et::ELEMENT_TYPE_R8;
+    const auto rightFloat = right == et::ELEMENT_TYPE_R4 || right == et::ELEMENT_TYPE_R8;
+    if (leftFloat && rightFloat) {
+        return et::ELEMENT_TYPE_R8;
+    }
+    const auto leftInteger = left == et::ELEMENT_TYPE_I4 || left == et::ELEMENT_TYPE_I;
+    const auto rightInteger = right == et::ELEMENT_TYPE_I4 || right == et::ELEMENT_TYPE_I;
+    if (leftInteger && rightInteger) {
+        return et::ELEMENT_TYPE_I;
+    }
+    if ((left == et::ELEMENT_TYPE_U && rightInteger) || (right == et::ELEMENT_TYPE_U && leftInteger)) {
+        return et::ELEMENT_TYPE_U;
+    }
+    return et::ELEMENT_TYPE_END;
+}
+
+// High byte of typed instructions: 1 for int32 operands, 2 for int64 and 3 for float64, or 0 if operands
+//  aren't of the same known type.
+static uint16_t getFamily(CLIElementType left, CLIElementType right) {
+    if (left != right) {
+        return 0;
+    }
+    switch (left) {
+    case et::ELEMENT_TYPE_I4:
+        return 1;
+    case et::ELEMENT_TYPE_I8:
+        return 2;
+    case et::ELEMENT_TYPE_R8:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+static Instruction getConversion(Instruction opcode, CLIElementType source) {
+    switch (source) {
+    case et::ELEMENT_TYPE_I4:
+        switch (opcode) {
+        case i::i_conv_i1: return i::i_i2b;
+        case i::i_conv_u1: return i::i_i2ub;
+        case i::i_conv_i2: return i::i_i2s;
+        case i::i_conv_u2: return i::i_i2us;
+        case i::i_conv_i4: return i::i_nop;
+        case i::i_conv_u4: return i::i_nop;
+        case i::i_conv_i8: return i::i_i2l;
+        case i::i_conv_u8: return i::i_i2ul;
+        case i::i_conv_r4: return i::i_i2f;
+        case i::i_conv_r8: return i::i_i2d;
+        case i::i_conv_r_un: return i::i_ui2d;
+        default: return opcode;
+        }
+    case et::ELEMENT_TYPE_I8:
+        switch (opcode) {
+        case i::i_conv_i1: return i::i_l2b;
+        case i::i_conv_u1: return i::i_l2ub;
+        case i::i_conv_i2: return i::i_l2s;
+        case i::i_conv_u2: return i::i_l2us;
+        case i::i_conv_i4: return i::i_l2i;
+        case i::i_conv_u4: return i::i_l2i;
+        case i::i_conv_i8: return i::i_nop;
+        case i::i_conv_u8: return i::i_nop;
+        case i::i_conv_r4: return i::i_l2f;
+        case i::i_conv_r8: return i::i_l2d;
+        case i::i_conv_r_un: return i::i_ul2d;
+        default: return opcode;
+        }
+    case et::ELEMENT_TYPE_R8:
+        switch (opcode) {
+        case i::i_conv_i1: return i::i_f2b;
+        case i::i_conv_u1: return i::i_f2ub;
+        case i::i_conv_i2: return i::i_f2s;
+        case i::i_conv_u2: return i::i_f2us;
+        case i::i_conv_i4: return i::i_f2i;
+        case i::i_conv_u4: return i::i_f2ui;
+        case i::i_conv_i8: return i::i_f2l;
+        case i::i_conv_u8: return i::i_f2ul;
+        case i::i_conv_r4: return i::i_d2f;
+        case i::i_conv_r8: return i::i_nop;
+        case i::i_conv_r_un: return i::i_nop;
+        default: return opcode;
+        }
+    default:
+        return opcode;
+    }
+}
+
+// Short forms of ldelem and stelem for the element type of their token
+static Instruction getElementAccess(Instruction opcode, CLIElementType elementType) {
+    const auto load = opcode == i::i_ldelem;
+    switch (elementType) {
+    case et::ELEMENT_TYPE_I1: return load ? i::i_ldelem_i1 : i::i_stelem_i1;
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_U1: return load ? i::i_ldelem_u1 : i::i_stelem_i1;
+    case et::ELEMENT_TYPE_I2: return load ? i::i_ldelem_i2 : i::i_stelem_i2;
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_U2: return load ? i::i_ldelem_u2 : i::i_stelem_i2;
+    case et::ELEMENT_TYPE_I4: return load ? i::i_ldelem_i4 : i::i_stelem_i4;
+    case et::ELEMENT_TYPE_U4: return load ? i::i_ldelem_u4 : i::i_stelem_i4;
+    case et::ELEMENT_TYPE_I8:
+    case et::ELEMENT_TYPE_U8: return load ? i::i_ldelem_i8 : i::i_stelem_i8;
+    case et::ELEMENT_TYPE_I:
+    case et::ELEMENT_TYPE_U: return load ? i::i_ldelem_i : i::i_stelem_i;
+    case et::ELEMENT_TYPE_R4: return load ? i::i_ldelem_r4 : i::i_stelem_r4;
+    case et::ELEMENT_TYPE_R8: return load ? i::i_ldelem_r8 : i::i_stelem_r8;
+    case et::ELEMENT_TYPE_CLASS: return load ? i::i_ldelem_ref : i::i_stelem_ref;
+    default: return opcode;
+    }
+}
+
+// States of branch targets are merged until nothing changes.
+bool inferStackTypes(const InstructionTree& tree, const QuickeningContext& context, StackTypes& stackTypes) {
+    auto& states = stackTypes.states;
+    auto& reached = stackTypes.reached;
+    const auto count = static_cast<uint32_t>(tree.size());
+    states.assign(count, StackState());
+    reached.assign(count, false);
+    if (count == 0) {
+        return true;
+    }
+
+    vector<uint32_t> worklist;
+    vector<bool> queued(count, false);
+    const auto merge = [&](uint32_t target, const StackState& stack) {
+        if (target >= count) {
+            return false;
+        }
+        auto& state = states[target];
+        auto changed = false;
+        if (!reached[target]) {
+            reached[target] = true;
+            state = stack;
+            changed = true;
+        } else {
+            if (state.size() != stack.size()) {
+                return false;
+            }
+            for (size_t n = 0; n < stack.size(); ++n) {
+                if (state[n] != stack[n] && state[n] != et::ELEMENT_TYPE_END) {
+                    state[n] = et::ELEMENT_TYPE_END;
+                    changed = true;
+                }
+            }
+        }
+        if (changed && !queued[target]) {
+            queued[target] = true;
+            worklist.push_back(target);
+        }
+        return true;
+    };
+
+    merge(0, StackState());
+    while (!worklist.empty()) {
+        const auto index = worklist.back();
+        worklist.pop_back();
+        queued[index] = false;
+
+        const auto& instruction = tree[index];
+        auto stack = states[index];
+        auto fallsThrough = true;
+
+        const auto pop = [&stack](size_t number) {
+            if (stack.size() < number) {
+                return false;
+            }
+            stack.resize(stack.size() - number);
+            return true;
+        };
+
+        switch (instruction.opcode) {
+        case i::i_nop:
+        case i::i_break:
+        case i::i_unaligned:
+        case i::i_volatile:
+        case i::i_tail:
+        case i::i_readonly:
+        case i::i_no:
+            break;
+
+        case i::i_ldarg:
+        case i::i_ldloc:
+        case i::i_starg:
+        case i::i_stloc:
+        {
+            const auto isArgument = instruction.opcode == i::i_ldarg || instruction.opcode == i::i_starg;
+            const auto& types = isArgument ? *context.arguments : *context.locals;
+            if (instruction.operand.variable >= types.size()) {
+                return false;
+            }
+            const auto type = types[instruction.operand.variable].stackType;
+            if (type == et::ELEMENT_TYPE_VALUETYPE) {
+                return false;
+            }
+            if (instruction.opcode == i::i_ldarg || instruction.opcode == i::i_ldloc) {
+                stack.push_back(type);
+            } else if (!pop(1)) {
+                return false;
+            }
+            break;
+        }
+
+        case i::i_ldc_i4:
+            stack.push_back(et::ELEMENT_TYPE_I4);
+            break;
+        case i::i_ldc_i8:
+            stack.push_back(et::ELEMENT_TYPE_I8);
+            break;
+        case i::i_ldc_r4:
+            stack.push_back(et::ELEMENT_TYPE_R4);
+            break;
+        case i::i_ldc_r8:
+            stack.push_back(et::ELEMENT_TYPE_R8);
+            break;
+        case i::i_ldnull:
+        case i::i_ldstr:
+            stack.push_back(et::ELEMENT_TYPE_U);
+            break;
+
+        case i::i_dup:
+            if (stack.empty()) {
+                return false;
+            }
+            stack.push_back(stack.back());
+            break;
+        case i::i_pop:
+            if (!pop(1)) {
+                return false;
+            }
+            break;
+
+        case i::i_call:
+        case i::i_callvirt:
+        {
+            const auto* callee = context.resolveCall(instruction.operand.token);
+            if (callee == nullptr || callee->result.stackType == et::ELEMENT_TYPE_VALUETYPE || !pop(callee->arguments.size())) {
+                return false;
+            }
+            if (callee->result.stackType != et::ELEMENT_TYPE_END) {
+                stack.push_back(callee->result.stackType);
+            }
+            break;
+        }
+
+        case i::i_ret:
+        case i::i_rethrow:
+            fallsThrough = false;
+            break;
+        case i::i_throw:
+            if (!pop(1)) {
+                return false;
+            }
+            fallsThrough = false;
+            break;
+
+        case i::i_br:
+            if (!merge(instruction.operand.target, stack)) {
+                return false;
+            }
+            fallsThrough = false;
+            break;
+        case i::i_leave:
+            if (!merge(instruction.operand.target, StackState())) {
+                return false;
+            }
+            fallsThrough = false;
+            break;
+        case i::i_brfalse:
+        case i::i_brtrue:
+            if (!pop(1) || !merge(instruction.operand.target, stack)) {
+                return false;
+            }
+            break;
+        case i::i_beq:
+        case i::i_bge:
+        case i::i_bgt:
+        case i::i_ble:
+        case i::i_blt:
+        case i::i_bne_un:
+        case i::i_bge_un:
+        case i::i_bgt_un:
+        case i::i_ble_un:
+        case i::i_blt_un:
+            if (!pop(2) || !merge(instruction.operand.target, stack)) {
+                return false;
+            }
+            break;
+        case i::i_switch:
+        {
+            if (!pop(1)) {
+                return false;
+            }
+            const auto* targets = tree.getSwitchTargets(instruction);
+            for (uint32_t n = 0; n < instruction.operand.table.count; ++n) {
+                if (!merge(targets[n], stack)) {
+                    return false;
+                }
+            }
+            break;
+        }
+
+        case i::i_add:
+        case i::i_sub:
+        case i::i_mul:
+        case i::i_div:
+        case i::i_div_un:
+        case i::i_rem:
+        case i::i_rem_un:
+        case i::i_and:
+        case i::i_or:
+        case i::i_xor:
+        {
+            if (stack.size() < 2) {
+                return false;
+            }
+            const auto type = getResultType(stack[stack.size() - 2], stack.back());
+            pop(2);
+            stack.push_back(type);
+            break;
+        }
+        case i::i_shl:
+        case i::i_shr:
+        case i::i_shr_un:
+            if (!pop(1) || stack.empty()) {
+                return false;
+            }
+            break;
+        case i::i_neg:
+        case i::i_not:
+            if (stack.empty()) {
+                return false;
+            }
+            break;
+
+        case i::i_ceq:
+        case i::i_cgt:
+        case i::i_cgt_un:
+        case i::i_clt:
+        case i::i_clt_un:
+            if (!pop(2)) {
+                return false;
+            }
+            stack.push_back(et::ELEMENT_TYPE_I4);
+            break;
+
+        case i::i_conv_i1:
+        case i::i_conv_i2:
+        case i::i_conv_i4:
+        case i::i_conv_u1:
+        case i::i_conv_u2:
+        case i::i_conv_u4:
+        case i::i_conv_i8:
+        case i::i_conv_u8:
+        case i::i_conv_i:
+        case i::i_conv_u:
+        case i::i_conv_r4:
+        case i::i_conv_r8:
+        case i::i_conv_r_un:
+        {
+            if (!pop(1)) {
+                return false;
+            }
+            const auto opcode = instruction.opcode;
+            if (opcode == i::i_conv_i8 || opcode == i::i_conv_u8) {
+                stack.push_back(et::ELEMENT_TYPE_I8);
+            } else if (opcode == i::i_conv_i || opcode == i::i_conv_u) {
+                stack.push_back(et::ELEMENT_TYPE_I);
+            } else if (opcode == i::i_conv_r4) {
+                stack.push_back(et::ELEMENT_TYPE_R4);
+            } else if (opcode == i::i_conv_r8 || opcode == i::i_conv_r_un) {
+                stack.push_back(et::ELEMENT_TYPE_R8);
+            } else {
+                stack.push_back(et::ELEMENT_TYPE_I4);
+            }
+            break;
+        }
+
+        case i::i_newarr:
+            if (!pop(1)) {
+                return false;
+            }
+            stack.push_back(et::ELEMENT_TYPE_U);
+            break;
+        case i::i_ldlen:
+            if (!pop(1)) {
+                return false;
+            }
+            stack.push_back(et::ELEMENT_TYPE_I);
+            break;
+
+        case i::i_ldelem_i1:
+        case i::i_ldelem_u1:
+        case i::i_ldelem_i2:
+        case i::i_ldelem_u2:
+        case i::i_ldelem_i4:
+        case i::i_ldelem_u4:
+            if (!pop(2)) {
+                return false;
+            }
+            stack.push_back(et::ELEMENT_TYPE_I4);
+            break;
+        case i::i_ldelem_i8:
+            if (!pop(2)) {
+                return false;
+            }
+            stack.push_back(et::ELEMENT_TYPE_I8);
+            break;
+        case i::i_ldelem_i:
+            if (!pop(2)) {
+                return false;
+            }
+            stack.push_back(et::ELEMENT_TYPE_I);
+            break;
+        case i::i_ldelem_r4:
+            if (!pop(2)) {
+                return false;
+            }
+            stack.push_back(et::ELEMENT_TYPE_R4);
+            break;
+        case i::i_ldelem_r8:
+            if (!pop(2)) {
+                return false;
+            }
+            stack.push_back(et::ELEMENT_TYPE_R8);
+            break;
+        case i::i_ldelem_ref:
+            if (!pop(2)) {
+                return false;
+            }
+            stack.push_back(et::ELEMENT_TYPE_U);
+            break;
+        case i::i_ldelem:
+        {
+            const auto type = getElementStackType(context.resolveElement(instruction.operand.token));
+            if (type == et::ELEMENT_TYPE_END || !pop(2)) {
+                return false;
+            }
+            stack.push_back(type);
+            break;
+        }
+
+        case i::i_stelem_i:
+        case i::i_stelem_i1:
+        case i::i_stelem_i2:
+        case i::i_stelem_i4:
+        case i::i_stelem_i8:
+        case i::i_stelem_r4:
+        case i::i_stelem_r8:
+        case i::i_stelem_ref:
+        case i::i_stelem:
+            if (!pop(3)) {
+                return false;
+            }
+            break;
+
+        default:
+            // Instructions which aren't executed by the interpreter yet
+            return false;
+        }
+
+        if (fallsThrough && !merge(index + 1, stack)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool quicken(InstructionTree& tree, const QuickeningContext& context, StackTypes* stackTypes) {
+    StackTypes inferred;
+    auto& result = stackTypes != nullptr ? *stackTypes : inferred;
+    if (!inferStackTypes(tree, context, result)) {
+        return false;
+    }
+    const auto& states = result.states;
+    const auto& reached = result.reached;
+
+    for (size_t index = 0; index < tree.size(); ++index) {
+        if (!reached[index]) {
+            continue;
+        }
+        auto& instruction = tree[index];
+        const auto& stack = states[index];
+        const auto top = stack.empty() ? et::ELEMENT_TYPE_END : stack.back();
+        const auto second = stack.size() < 2 ? et::ELEMENT_TYPE_END : stack[stack.size() - 2];
+        const auto opcode = instruction.opcode;
+
+        switch (opcode) {
+        // Typed arithmetic and branches are keeping low byte of the IL opcode
+        case i::i_add:
+        case i::i_sub:
+        case i::i_mul:
+        case i::i_div:
+        case i::i_rem:
+        case i::i_beq:
+        case i::i_bge:
+        case i::i_bgt:
+        case i::i_ble:
+        case i::i_blt:
+        case i::i_bne_un:
+        case i::i_bge_un:
+        case i::i_bgt_un:
+        case i::i_ble_un:
+        case i::i_blt_un:
+        {
+            const auto family = getFamily(second, top);
+            if (family != 0) {
+                instruction.opcode = static_cast<Instruction>(family << 8 | _u(opcode));
+            }
+            break;
+        }
+        case i::i_div_un:
+        case i::i_rem_un:
+        case i::i_and:
+        case i::i_or:
+        case i::i_xor:
+        {
+            const auto family = getFamily(second, top);
+            if (family == 1 || family == 2) {
+                instruction.opcode = static_cast<Instruction>(family << 8 | _u(opcode));
+            }
+            break;
+        }
+        case i::i_shl:
+        case i::i_shr:
+        case i::i_shr_un:
+        {
+            const auto family = getFamily(second, second);
+            if ((family == 1 || family == 2) && (top == et::ELEMENT_TYPE_I4 || top == et::ELEMENT_TYPE_I)) {
+                instruction.opcode = static_cast<Instruction>(family << 8 | _u(opcode));
+            }
+            break;
+        }
+        case i::i_neg:
+        case i::i_not:
+        {
+            const auto family = getFamily(top, top);
+            if (family == 1 || family == 2 || (family == 3 && opcode == i::i_neg)) {
+                instruction.opcode = static_cast<Instruction>(family << 8 | _u(opcode));
+            }
+            break;
+        }
+
+        // Comparisons are two-byte instructions, their typed forms are using 0xF0 | second byte.
+        case i::i_ceq:
+        case i::i_cgt:
+        case i::i_cgt_un:
+        case i::i_clt:
+        case i::i_clt_un:
+        {
+            const auto family = getFamily(second, top);
+            if (family != 0) {
+                instruction.opcode = static_cast<Instruction>(family << 8 | 0xF0 | _u(opcode) >> 8);
+            }
+            break;
+        }
+
+        case i::i_conv_i1:
+        case i::i_conv_i2:
+        case i::i_conv_i4:
+        case i::i_conv_u1:
+        case i::i_conv_u2:
+        case i::i_conv_u4:
+        case i::i_conv_i8:
+        case i::i_conv_u8:
+        case i::i_conv_r4:
+        case i::i_conv_r8:
+        case i::i_conv_r_un:
+            instruction.opcode = getConversion(opcode, top);
+            break;
+
+        case i::i_ldelem:
+        case i::i_stelem:
+            instruction.opcode = getElementAccess(opcode, context.resolveElement(instruction.operand.token));
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return true;
+}
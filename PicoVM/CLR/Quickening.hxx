@@ -0,0 +1,46 @@
+#ifndef __QUICKENING_HXX__
+#define __QUICKENING_HXX__
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "CLIElementTypes.hxx"
+#include "InstructionTree.hxx"
+#include "RuntimeMethod.hxx"
+
+// Metadata which the quickening pass can't infer from the instructions themselves
+struct QuickeningContext {
+    const std::vector<VariableType>* arguments = nullptr;
+    const std::vector<VariableType>* locals = nullptr;
+    // Target of call or callvirt token, null if it can't be called
+    std::function<const RuntimeMethod*(uint32_t token)> resolveCall;
+    // Element type of ldelem or stelem token, ELEMENT_TYPE_CLASS for references
+    std::function<CLIElementType(uint32_t token)> resolveElement;
+};
+
+// Types of values on the evaluation stack: I4, I8, I, U for references, R4 and R8. END is used for the values
+//  which are getting different types from different paths.
+typedef std::vector<CLIElementType> StackState;
+
+// Evaluation stack before every instruction of the method
+struct StackTypes {
+    std::vector<StackState> states;
+    // False for the instructions which aren't reachable from the start of the method
+    std::vector<bool> reached;
+};
+
+// Infer types of the evaluation stack before every instruction. Returns false if method uses an instruction which
+//  isn't modelled, or its stack depth isn't consistent.
+bool inferStackTypes(const InstructionTree& tree, const QuickeningContext& context, StackTypes& stackTypes);
+
+// Infer types of the evaluation stack before every instruction, and rewrite arithmetic, comparisons, conditional
+//  branches and conversions into their typed forms (i_iadd, i_ladd, i_fadd, i_i2l and so on), so they wouldn't
+//  look at type tags during execution. Floating point forms are used for float64 operands only.
+//
+// Instructions with operands of unknown or mixed types, and the code which isn't reachable from the start of the
+//  method, are left as they are. If method uses an instruction which isn't modelled, or its stack depth isn't
+//  consistent, nothing is rewritten and false is returned. Inferred types are given to the caller if it asks for them.
+bool quicken(InstructionTree& tree, const QuickeningContext& context, StackTypes* stackTypes = nullptr);
+
+#endif
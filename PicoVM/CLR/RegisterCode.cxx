@@ -0,0 +1,690 @@
+#include <algorithm>
+#include <map>
+
+#include "RegisterCode.hxx"
+#include "CLIMethodBody.hxx"
+#include "EnumCasting.hxx"
+#include "Interpreter.hxx"
+#include "NumCasting.hxx"
+#include "Quickening.hxx"
+
+using namespace std;
+using et = CLIElementType;
+using op = InterpreterOpcode;
+using rop = RegisterOpcode;
+
+// Width of the operations for values of stack type. Native integers and references are taking the width of pointer.
+enum struct Family : uint8_t {
+    None = 0,
+    Int32 = 1,
+    Int64 = 2,
+    Float64 = 3
+};
+
+static Family getFamily(CLIElementType type) {
+    switch (type) {
+    case et::ELEMENT_TYPE_I4:
+        return Family::Int32;
+    case et::ELEMENT_TYPE_I8:
+        return Family::Int64;
+    case et::ELEMENT_TYPE_I:
+    case et::ELEMENT_TYPE_U:
+        return sizeof(size_t) == 8 ? Family::Int64 : Family::Int32;
+    case et::ELEMENT_TYPE_R8:
+        return Family::Float64;
+    default:
+        return Family::None;
+    }
+}
+
+// Family of binary operation. Int32 values are kept sign-extended in registers, so they are mixed with native
+//  integers by the operations of pointer width, ECMA-335 III.1.5 table 2.
+static Family getFamily(CLIElementType left, CLIElementType right) {
+    const auto isNative = [](CLIElementType type) { return type == et::ELEMENT_TYPE_I || type == et::ELEMENT_TYPE_U; };
+    if ((left == et::ELEMENT_TYPE_I4 && isNative(right)) || (isNative(left) && right == et::ELEMENT_TYPE_I4)) {
+        return getFamily(et::ELEMENT_TYPE_I);
+    }
+    const auto family = getFamily(left);
+    return family == getFamily(right) ? family : Family::None;
+}
+
+// Register operations of int32, int64 and float64 families for polymorphic operation, count if there is none.
+struct TypedForms {
+    InterpreterOpcode generic;
+    RegisterOpcode forms[3];
+};
+
+static const TypedForms operations[] = {
+    { op::op_add, { rop::r_iadd, rop::r_ladd, rop::r_fadd } },
+    { op::op_sub, { rop::r_isub, rop::r_lsub, rop::r_fsub } },
+    { op::op_mul, { rop::r_imul, rop::r_lmul, rop::r_fmul } },
+    { op::op_div, { rop::r_idiv, rop::r_ldiv, rop::r_fdiv } },
+    { op::op_div_un, { rop::r_idiv_un, rop::r_ldiv_un, rop::count } },
+    { op::op_rem, { rop::r_irem, rop::r_lrem, rop::r_frem } },
+    { op::op_rem_un, { rop::r_irem_un, rop::r_lrem_un, rop::count } },
+    { op::op_and, { rop::r_iand, rop::r_land, rop::count } },
+    { op::op_or, { rop::r_ior, rop::r_lor, rop::count } },
+    { op::op_xor, { rop::r_ixor, rop::r_lxor, rop::count } },
+    { op::op_shl, { rop::r_ishl, rop::r_lshl, rop::count } },
+    { op::op_shr, { rop::r_ishr, rop::r_lshr, rop::count } },
+    { op::op_shr_un, { rop::r_ishr_un, rop::r_lshr_un, rop::count } },
+    { op::op_neg, { rop::r_ineg, rop::r_lneg, rop::r_fneg } },
+    { op::op_not, { rop::r_inot, rop::r_lnot, rop::count } },
+    { op::op_ceq, { rop::r_iceq, rop::r_lceq, rop::r_fceq } },
+    { op::op_cgt, { rop::r_icgt, rop::r_lcgt, rop::r_fcgt } },
+    { op::op_cgt_un, { rop::r_icgt_un, rop::r_lcgt_un, rop::r_fcgt_un } },
+    { op::op_clt, { rop::r_iclt, rop::r_lclt, rop::r_fclt } },
+    { op::op_clt_un, { rop::r_iclt_un, rop::r_lclt_un, rop::r_fclt_un } },
+    { op::op_beq, { rop::r_ibeq, rop::r_lbeq, rop::r_fbeq } },
+    { op::op_bge, { rop::r_ibge, rop::r_lbge, rop::r_fbge } },
+    { op::op_bgt, { rop::r_ibgt, rop::r_lbgt, rop::r_fbgt } },
+    { op::op_ble, { rop::r_ible, rop::r_lble, rop::r_fble } },
+    { op::op_blt, { rop::r_iblt, rop::r_lblt, rop::r_fblt } },
+    { op::op_bne_un, { rop::r_ibne_un, rop::r_lbne_un, rop::r_fbne_un } },
+    { op::op_bge_un, { rop::r_ibge_un, rop::r_lbge_un, rop::r_fbge_un } },
+    { op::op_bgt_un, { rop::r_ibgt_un, rop::r_lbgt_un, rop::r_fbgt_un } },
+    { op::op_ble_un, { rop::r_ible_un, rop::r_lble_un, rop::r_fble_un } },
+    { op::op_blt_un, { rop::r_iblt_un, rop::r_lblt_un, rop::r_fblt_un } }
+};
+
+// Conversions by the family of source value, r_move if the bits are kept as they are.
+static const TypedForms conversions[] = {
+    { op::op_conv_i1, { rop::r_i2b, rop::r_l2b, rop::r_f2b } },
+    { op::op_conv_u1, { rop::r_i2ub, rop::r_l2ub, rop::r_f2ub } },
+    { op::op_conv_i2, { rop::r_i2s, rop::r_l2s, rop::r_f2s } },
+    { op::op_conv_u2, { rop::r_i2us, rop::r_l2us, rop::r_f2us } },
+    { op::op_conv_i4, { rop::r_move, rop::r_l2i, rop::r_f2i } },
+    { op::op_conv_u4, { rop::r_move, rop::r_l2i, rop::r_f2ui } },
+    { op::op_conv_i8, { rop::r_move, rop::r_move, rop::r_f2l } },
+    { op::op_conv_u8, { rop::r_i2ul, rop::r_move, rop::r_f2ul } },
+    { op::op_conv_r4, { rop::r_i2f, rop::r_l2f, rop::r_d2f } },
+    { op::op_conv_r8, { rop::r_i2d, rop::r_l2d, rop::r_move } },
+    { op::op_conv_r_un, { rop::r_ui2d, rop::r_ul2d, rop::r_move } }
+};
+
+template<size_t N>
+static RegisterOpcode findForm(const TypedForms (&forms)[N], InterpreterOpcode opcode, Family family) {
+    if (family == Family::None) {
+        return rop::count;
+    }
+    for (const auto& item : forms) {
+        if (item.generic == opcode) {
+            return item.forms[_u(family) - 1];
+        }
+    }
+    return rop::count;
+}
+
+// Register operation of quickened operation, count if it isn't quickened.
+static RegisterOpcode getRegisterForm(InterpreterOpcode opcode) {
+    switch (opcode) {
+#define REGISTER_FORM(name) case op::op_##name: return rop::r_##name;
+    REGISTER_BINARY(REGISTER_FORM)
+    REGISTER_UNARY(REGISTER_FORM)
+    REGISTER_BRANCHES(REGISTER_FORM)
+#undef REGISTER_FORM
+    case op::op_i2l:
+        return rop::r_move;
+    default:
+        return rop::count;
+    }
+}
+
+// Register operation of polymorphic operation for the types of its operands, count if register code has none.
+static RegisterOpcode getTypedForm(InterpreterOpcode opcode, CLIElementType second, CLIElementType top) {
+    switch (opcode) {
+    case op::op_conv_i:
+        return findForm(conversions, sizeof(size_t) == 8 ? op::op_conv_i8 : op::op_conv_i4, getFamily(top));
+    case op::op_conv_u:
+        return findForm(conversions, sizeof(size_t) == 8 ? op::op_conv_u8 : op::op_conv_u4, getFamily(top));
+    case op::op_conv_i1:
+    case op::op_conv_i2:
+    case op::op_conv_i4:
+    case op::op_conv_i8:
+    case op::op_conv_u1:
+    case op::op_conv_u2:
+    case op::op_conv_u4:
+    case op::op_conv_u8:
+    case op::op_conv_r4:
+    case op::op_conv_r8:
+    case op::op_conv_r_un:
+        return findForm(conversions, opcode, getFamily(top));
+    case op::op_neg:
+    case op::op_not:
+        return findForm(operations, opcode, getFamily(top));
+    // Shift amount is int32 or native integer, only its low bits are used.
+    case op::op_shl:
+    case op::op_shr:
+    case op::op_shr_un:
+        if (top != et::ELEMENT_TYPE_I4 && top != et::ELEMENT_TYPE_I) {
+            return rop::count;
+        }
+        return findForm(operations, opcode, getFamily(second));
+    default:
+        return findForm(operations, opcode, getFamily(second, top));
+    }
+}
+
+// Operation which gives the value of stack type as it's kept in variable or argument, as the interpreter does it
+//  by toVariable(). Floats are taken only by the variables of the same type, count is returned for the others.
+static RegisterOpcode getStoreForm(CLIElementType valueType, const VariableType& variable) {
+    const auto isFloat = [](CLIElementType type) { return type == et::ELEMENT_TYPE_R4 || type == et::ELEMENT_TYPE_R8; };
+    if (isFloat(valueType) || isFloat(variable.stackType)) {
+        return valueType == variable.stackType ? rop::r_move : rop::count;
+    }
+    switch (variable.type) {
+    case et::ELEMENT_TYPE_I1:
+        return rop::r_i2b;
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_U1:
+        return rop::r_i2ub;
+    case et::ELEMENT_TYPE_I2:
+        return rop::r_i2s;
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_U2:
+        return rop::r_i2us;
+    case et::ELEMENT_TYPE_I4:
+    case et::ELEMENT_TYPE_U4:
+        return valueType == et::ELEMENT_TYPE_I4 ? rop::r_move : rop::r_l2i;
+    default:
+        return rop::r_move;
+    }
+}
+
+// Bits of the value which is loaded by constant instruction, the same as it's pushed to the evaluation stack.
+static bool getConstant(InterpreterOpcode opcode, const ThreadedInstruction& instruction, uint64_t& bits) {
+    switch (opcode) {
+    case op::op_ldc_i4:
+        bits = static_cast<uint64_t>(static_cast<int64_t>(instruction.operand.i4));
+        return true;
+    case op::op_ldc_i8:
+        bits = static_cast<uint64_t>(instruction.operand.i8);
+        return true;
+    case op::op_ldc_r4:
+        bits = floatToUInt(instruction.operand.r4);
+        return true;
+    case op::op_ldc_r8:
+        bits = doubleToULong(instruction.operand.r8);
+        return true;
+    case op::op_ldnull:
+        bits = 0;
+        return true;
+    case op::op_ldstr:
+        bits = reinterpret_cast<size_t>(instruction.operand.object);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool hasTarget(InterpreterOpcode opcode) {
+    return (opcode >= op::op_br && opcode <= op::op_blt_un) || opcode == op::op_leave || (opcode >= op::op_ibeq && opcode <= op::op_fblt_un);
+}
+
+static bool isBinary(RegisterOpcode opcode) {
+    return opcode >= rop::r_iadd && opcode < rop::r_ineg;
+}
+
+static bool isUnary(RegisterOpcode opcode) {
+    return opcode >= rop::r_ineg && opcode < rop::r_ibeq;
+}
+
+// Finally and fault handlers aren't executed by any engine yet.
+static bool hasFinallyHandlers(const MethodBody& body) {
+    for (const auto& clause : body.exceptions) {
+        if ((clause.flags & (_u(ExceptionClauseFlags::ClauseFinally) | _u(ExceptionClauseFlags::ClauseFault))) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Evaluation stack is simulated with the registers which are holding its values. Loads of variables and
+//  constants are just pushing their registers, and the values are copied into the stack registers only when they
+//  are leaving the block, or their variable is overwritten while they are still on the stack.
+class RegisterTranslator {
+public:
+    RegisterTranslator(const RuntimeMethod& Method, const ThreadedCode& Threaded, const vector<InterpreterOpcode>& Opcodes,
+        const StackTypes& Types, RegisterCode& Code, vector<RegisterOpcode>& RegisterOpcodes) :
+        method(Method), threaded(Threaded), opcodes(Opcodes), types(Types), code(Code), registerOpcodes(RegisterOpcodes) {}
+
+    bool translate();
+
+private:
+    static const size_t noProducer = SIZE_MAX;
+
+    const RuntimeMethod& method;
+    const ThreadedCode& threaded;
+    const vector<InterpreterOpcode>& opcodes;
+    const StackTypes& types;
+    RegisterCode& code;
+    vector<RegisterOpcode>& registerOpcodes;
+
+    map<uint64_t, uint32_t> constants;
+    uint32_t stackBase = 0;
+    // Registers of the values on evaluation stack
+    vector<uint32_t> stack;
+    // Instruction which has computed the value on top of the stack, it could write into variable instead.
+    size_t producer = noProducer;
+    // Instructions with branch targets and the indexes of their targets in threaded code
+    vector<pair<size_t, uint32_t>> fixups;
+    // Types of evaluation stack before the instruction which is translated, and the type of its result
+    const StackState* state = nullptr;
+    CLIElementType resultType = et::ELEMENT_TYPE_END;
+
+    uint32_t slot(size_t depth) const { return stackBase + static_cast<uint32_t>(depth); }
+
+    RegisterInstruction& emit(RegisterOpcode opcode, uint32_t destination, uint32_t left, uint32_t right) {
+        RegisterInstruction instruction;
+        instruction.handler = nullptr;
+        instruction.destination = destination;
+        instruction.left = left;
+        instruction.right = right;
+        instruction.operand.method = nullptr;
+        code.instructions.push_back(instruction);
+        registerOpcodes.push_back(opcode);
+#ifdef CHECK_REGISTER_TYPES
+        code.types.push_back(RegisterTypes{ et::ELEMENT_TYPE_END, et::ELEMENT_TYPE_END, et::ELEMENT_TYPE_END, false, false });
+#endif
+        producer = noProducer;
+        return code.instructions.back();
+    }
+
+    // Types of the registers of last instruction, they are kept for CHECK_REGISTER_TYPES builds only.
+    void describe(CLIElementType destination, CLIElementType left, CLIElementType right) {
+#ifdef CHECK_REGISTER_TYPES
+        auto& described = code.types.back();
+        described.destination = destination;
+        described.left = left;
+        described.right = right;
+#else
+        (void)destination;
+        (void)left;
+        (void)right;
+#endif
+    }
+
+    void emitJump(RegisterOpcode opcode, uint32_t left, uint32_t right, uint32_t target) {
+        emit(opcode, 0, left, right);
+        fixups.emplace_back(code.instructions.size() - 1, target);
+    }
+
+    uint32_t pop() {
+        const auto value = stack.back();
+        stack.pop_back();
+        return value;
+    }
+
+    RegisterInstruction& pushResult(RegisterOpcode opcode, uint32_t left, uint32_t right, CLIElementType leftType,
+        CLIElementType rightType = et::ELEMENT_TYPE_END) {
+        const auto destination = slot(stack.size());
+        auto& instruction = emit(opcode, destination, left, right);
+        describe(resultType, leftType, rightType);
+        stack.push_back(destination);
+        producer = code.instructions.size() - 1;
+        return instruction;
+    }
+
+    // Value at the depth is moved into its own stack register, it's converted to the type if form isn't move.
+    void settle(size_t depth, RegisterOpcode form, CLIElementType type) {
+        const auto target = slot(depth);
+        if (form == rop::r_move && stack[depth] == target) {
+            return;
+        }
+        emit(form, target, stack[depth], 0);
+        describe(type, (*state)[depth], et::ELEMENT_TYPE_END);
+        stack[depth] = target;
+    }
+
+    void settle(size_t depth) {
+        settle(depth, rop::r_move, (*state)[depth]);
+    }
+
+    // Stack registers are written from the top, values could only refer to the registers below their own.
+    void settleAll() {
+        for (auto depth = stack.size(); depth-- > 0; ) {
+            settle(depth);
+        }
+    }
+
+    bool store(const ThreadedInstruction::Variable& variable, CLIElementType valueType);
+    bool call(const ThreadedInstruction& instruction, InterpreterOpcode opcode);
+};
+
+bool RegisterTranslator::store(const ThreadedInstruction::Variable& variable, CLIElementType valueType) {
+    const auto form = getStoreForm(valueType, VariableType(variable.stackType, variable.type));
+    if (form == rop::count) {
+        return false;
+    }
+    const auto value = pop();
+    const auto produced = producer != noProducer && code.instructions[producer].destination == value
+        && find(stack.begin(), stack.end(), value) == stack.end();
+
+    // Values below which are referring to the variable are keeping its old value.
+    for (size_t depth = 0; depth < stack.size(); ++depth) {
+        if (stack[depth] == variable.index) {
+            settle(depth);
+        }
+    }
+
+    if (form == rop::r_move && produced && producer == code.instructions.size() - 1) {
+        code.instructions[producer].destination = variable.index;
+#ifdef CHECK_REGISTER_TYPES
+        code.types[producer].destination = variable.stackType;
+#endif
+        producer = noProducer;
+    } else if (form != rop::r_move || value != variable.index) {
+        emit(form, variable.index, value, 0);
+        describe(variable.stackType, valueType, et::ELEMENT_TYPE_END);
+    }
+    return true;
+}
+
+bool RegisterTranslator::call(const ThreadedInstruction& instruction, InterpreterOpcode opcode) {
+    const auto* callee = instruction.operand.method;
+    const auto count = callee->arguments.size();
+    if (stack.size() < count) {
+        return false;
+    }
+    const auto first = stack.size() - count;
+    for (auto depth = stack.size(); depth-- > first; ) {
+        const auto& argument = callee->arguments[depth - first];
+        const auto form = getStoreForm((*state)[depth], argument);
+        if (form == rop::count) {
+            return false;
+        }
+        settle(depth, form, argument.stackType);
+    }
+    stack.resize(first);
+
+    // Callee frame starts at the register of its first argument, and its result is written to the same register.
+    auto& translated = emit(opcode == op::op_call ? rop::r_call : rop::r_callvirt, slot(first), slot(first), 0);
+    translated.operand.method = callee;
+    describe(callee->result.stackType, opcode == op::op_callvirt ? callee->arguments[0].stackType : et::ELEMENT_TYPE_END, et::ELEMENT_TYPE_END);
+#ifdef CHECK_REGISTER_TYPES
+    code.types.back().writesOnReturn = true;
+#endif
+    if (callee->result.stackType != et::ELEMENT_TYPE_END) {
+        stack.push_back(slot(first));
+        producer = code.instructions.size() - 1;
+    }
+    return true;
+}
+
+bool RegisterTranslator::translate() {
+    const auto count = opcodes.size();
+    if (count == 0 || types.reached.size() != count) {
+        return false;
+    }
+
+    // Constants are collected first, so the stack registers could follow them. There are as many of the stack
+    //  registers as the body declares, deeper stack is invalid code.
+    code.argumentsCount = static_cast<uint32_t>(method.arguments.size());
+    code.localsCount = static_cast<uint32_t>(threaded.locals.size());
+    const auto variablesCount = code.argumentsCount + code.localsCount;
+    size_t maxDepth = 0;
+    vector<bool> labels(count, false);
+    for (size_t index = 0; index < count; ++index) {
+        if (!types.reached[index]) {
+            continue;
+        }
+        maxDepth = max(maxDepth, types.states[index].size());
+        const auto& instruction = threaded.instructions[index];
+        uint64_t bits = 0;
+        if (getConstant(opcodes[index], instruction, bits) && constants.count(bits) == 0) {
+            constants[bits] = variablesCount + static_cast<uint32_t>(code.constants.size());
+            code.constants.push_back(bits);
+        }
+        if (hasTarget(opcodes[index])) {
+            labels[instruction.operand.target] = true;
+        } else if (opcodes[index] == op::op_switch) {
+            for (uint32_t n = 0; n < instruction.operand.table.count; ++n) {
+                labels[threaded.switchTargets[instruction.operand.table.first + n]] = true;
+            }
+        }
+    }
+    if (maxDepth > threaded.body->maxStack) {
+        return false;
+    }
+    stackBase = variablesCount + static_cast<uint32_t>(code.constants.size());
+    code.registersCount = stackBase + threaded.body->maxStack;
+
+    vector<uint32_t> starts(count, 0);
+    auto fallsThrough = false;
+    for (size_t index = 0; index < count; ++index) {
+        if (!types.reached[index]) {
+            fallsThrough = false;
+            continue;
+        }
+        state = &types.states[index];
+        const auto next = index + 1;
+        resultType = next < count && types.reached[next] && !types.states[next].empty() ? types.states[next].back() : et::ELEMENT_TYPE_END;
+        if (labels[index] || !fallsThrough) {
+            // All paths are meeting with the values in their stack registers.
+            if (fallsThrough) {
+                settleAll();
+            }
+            stack.clear();
+            for (size_t depth = 0; depth < state->size(); ++depth) {
+                stack.push_back(slot(depth));
+            }
+            producer = noProducer;
+        }
+        starts[index] = static_cast<uint32_t>(code.instructions.size());
+
+        const auto& instruction = threaded.instructions[index];
+        const auto opcode = opcodes[index];
+        const auto height = state->size();
+        const auto top = height < 1 ? et::ELEMENT_TYPE_END : (*state)[height - 1];
+        const auto second = height < 2 ? et::ELEMENT_TYPE_END : (*state)[height - 2];
+        const auto third = height < 3 ? et::ELEMENT_TYPE_END : (*state)[height - 3];
+        uint64_t bits = 0;
+        fallsThrough = true;
+
+        switch (opcode) {
+        case op::op_nop:
+            break;
+
+        case op::op_ldvar:
+            stack.push_back(instruction.operand.variable.index);
+            break;
+        case op::op_stvar:
+        case op::op_stvar_i4:
+        case op::op_stvar_i8:
+        case op::op_stvar_ref:
+            if (!store(instruction.operand.variable, top)) {
+                return false;
+            }
+            break;
+
+        case op::op_ldc_i4:
+        case op::op_ldc_i8:
+        case op::op_ldc_r4:
+        case op::op_ldc_r8:
+        case op::op_ldnull:
+        case op::op_ldstr:
+            getConstant(opcode, instruction, bits);
+            stack.push_back(constants[bits]);
+            break;
+        case op::op_dup:
+            stack.push_back(stack.back());
+            break;
+        case op::op_pop:
+            pop();
+            break;
+
+        case op::op_call:
+        case op::op_callvirt:
+            if (!call(instruction, opcode)) {
+                return false;
+            }
+            break;
+        case op::op_ret:
+            if (method.result.stackType == et::ELEMENT_TYPE_END) {
+                emit(rop::r_ret_void, 0, 0, 0);
+            } else {
+                emit(rop::r_ret, 0, stack.back(), 0);
+                describe(et::ELEMENT_TYPE_END, top, et::ELEMENT_TYPE_END);
+            }
+            fallsThrough = false;
+            break;
+        case op::op_throw:
+        case op::op_rethrow:
+            emit(rop::r_throw, 0, 0, 0);
+            fallsThrough = false;
+            break;
+
+        case op::op_br:
+            settleAll();
+            emitJump(rop::r_br, 0, 0, instruction.operand.target);
+            fallsThrough = false;
+            break;
+        // Threaded code keeps leave only when it doesn't exit the region of finally or fault handler, but IL
+        //  offsets aren't known here, so methods with such handlers are left to threaded code entirely.
+        case op::op_leave:
+            if (hasFinallyHandlers(*threaded.body)) {
+                return false;
+            }
+            stack.clear();
+            emitJump(rop::r_br, 0, 0, instruction.operand.target);
+            fallsThrough = false;
+            break;
+        case op::op_brfalse:
+        case op::op_brtrue:
+        {
+            const auto value = pop();
+            settleAll();
+            emitJump(opcode == op::op_brfalse ? rop::r_brfalse : rop::r_brtrue, value, 0, instruction.operand.target);
+            describe(et::ELEMENT_TYPE_END, top, et::ELEMENT_TYPE_END);
+            break;
+        }
+        case op::op_switch:
+        {
+            const auto value = pop();
+            settleAll();
+            auto& translated = emit(rop::r_switch, 0, value, 0);
+            describe(et::ELEMENT_TYPE_END, top, et::ELEMENT_TYPE_END);
+            translated.operand.table.first = static_cast<uint32_t>(code.switchTargets.size());
+            translated.operand.table.count = instruction.operand.table.count;
+            const auto* targets = threaded.switchTargets.data() + instruction.operand.table.first;
+            code.switchTargets.insert(code.switchTargets.end(), targets, targets + instruction.operand.table.count);
+            break;
+        }
+
+        case op::op_newarr:
+        {
+            const auto family = getFamily(top);
+            if (family != Family::Int32 && family != Family::Int64) {
+                return false;
+            }
+            const auto length = pop();
+            pushResult(rop::r_newarr, length, 0, top).operand.elementType = instruction.operand.elementType;
+            break;
+        }
+        case op::op_ldlen:
+            pushResult(rop::r_ldlen, pop(), 0, top);
+            break;
+
+        case op::op_ldelem:
+        case op::op_ldelem_i4:
+        case op::op_ldelem_i8:
+        case op::op_ldelem_r8:
+        case op::op_ldelem_ref:
+        {
+            const auto element = pop();
+            const auto array = pop();
+            auto form = rop::r_ldelem;
+            switch (opcode) {
+            case op::op_ldelem_i4: form = rop::r_ldelem_i4; break;
+            case op::op_ldelem_i8: form = rop::r_ldelem_i8; break;
+            case op::op_ldelem_r8: form = rop::r_ldelem_r8; break;
+            case op::op_ldelem_ref: form = rop::r_ldelem_ref; break;
+            default: break;
+            }
+            pushResult(form, array, element, second, top).operand.elementType = instruction.operand.elementType;
+            break;
+        }
+        case op::op_stelem:
+        case op::op_stelem_i4:
+        case op::op_stelem_i8:
+        case op::op_stelem_ref:
+        {
+            // Float elements are taking the values of their own type only.
+            const auto elementType = instruction.operand.elementType;
+            if (opcode == op::op_stelem && (elementType == et::ELEMENT_TYPE_R4 || elementType == et::ELEMENT_TYPE_R8) && top != elementType) {
+                return false;
+            }
+            const auto value = pop();
+            const auto element = pop();
+            const auto array = pop();
+            auto form = rop::r_stelem;
+            switch (opcode) {
+            case op::op_stelem_i4: form = rop::r_stelem_i4; break;
+            case op::op_stelem_i8: form = rop::r_stelem_i8; break;
+            case op::op_stelem_ref: form = rop::r_stelem_ref; break;
+            default: break;
+            }
+            emit(form, value, array, element).operand.elementType = elementType;
+            describe(top, third, second);
+#ifdef CHECK_REGISTER_TYPES
+            code.types.back().readsDestination = true;
+#endif
+            break;
+        }
+
+        default:
+        {
+            // Arithmetic, comparisons, conversions and conditional branches, polymorphic ones are getting the
+            //  forms for the types of their operands.
+            auto form = getRegisterForm(opcode);
+            if (form == rop::count) {
+                form = getTypedForm(opcode, second, top);
+            }
+            if (form == rop::count) {
+                return false;
+            }
+            if (form == rop::r_move) {
+                // Conversion which keeps the bits of value
+            } else if (isBinary(form)) {
+                const auto right = pop();
+                const auto left = pop();
+                pushResult(form, left, right, second, top);
+            } else if (isUnary(form)) {
+                pushResult(form, pop(), 0, top);
+            } else {
+                const auto right = pop();
+                const auto left = pop();
+                settleAll();
+                emitJump(form, left, right, instruction.operand.target);
+                describe(et::ELEMENT_TYPE_END, second, top);
+            }
+            break;
+        }
+        }
+    }
+
+    for (const auto& fixup : fixups) {
+        code.instructions[fixup.first].operand.target = starts[fixup.second];
+    }
+    for (auto& target : code.switchTargets) {
+        target = starts[target];
+    }
+    return true;
+}
+
+unique_ptr<RegisterCode> translateRegisters(const RuntimeMethod& method, const ThreadedCode& threaded,
+    const vector<InterpreterOpcode>& opcodes, const StackTypes& types, vector<RegisterOpcode>& registerOpcodes) {
+    unique_ptr<RegisterCode> result(new RegisterCode());
+    result->threaded = &threaded;
+    registerOpcodes.clear();
+    RegisterTranslator translator(method, threaded, opcodes, types, *result, registerOpcodes);
+    if (!translator.translate()) {
+        result->instructions.clear();
+        result->switchTargets.clear();
+#ifdef CHECK_REGISTER_TYPES
+        result->types.clear();
+#endif
+        registerOpcodes.clear();
+    }
+    return result;
+}
@@ -0,0 +1,137 @@
+#ifndef __REGISTERCODE_HXX__
+#define __REGISTERCODE_HXX__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "RuntimeMethod.hxx"
+
+enum struct InterpreterOpcode : uint16_t;
+struct StackTypes;
+
+// Operations of register code with two source registers and one destination. Prefixes are the same as for the
+//  quickened operations of threaded code: i for int32, l for int64 and f for float64 operands.
+#define REGISTER_BINARY(OP) \
+    OP(iadd) OP(isub) OP(imul) OP(idiv) OP(idiv_un) OP(irem) OP(irem_un) OP(iand) OP(ior) OP(ixor) \
+    OP(ishl) OP(ishr) OP(ishr_un) OP(iceq) OP(icgt) OP(icgt_un) OP(iclt) OP(iclt_un) \
+    OP(ladd) OP(lsub) OP(lmul) OP(ldiv) OP(ldiv_un) OP(lrem) OP(lrem_un) OP(land) OP(lor) OP(lxor) \
+    OP(lshl) OP(lshr) OP(lshr_un) OP(lceq) OP(lcgt) OP(lcgt_un) OP(lclt) OP(lclt_un) \
+    OP(fadd) OP(fsub) OP(fmul) OP(fdiv) OP(frem) OP(fceq) OP(fcgt) OP(fcgt_un) OP(fclt) OP(fclt_un)
+
+// Operations with one source register, conversions are named as in threaded code. Int32 values are kept
+//  sign-extended in registers, so there is no i2l.
+#define REGISTER_UNARY(OP) \
+    OP(ineg) OP(inot) OP(lneg) OP(lnot) OP(fneg) \
+    OP(i2b) OP(i2ub) OP(i2s) OP(i2us) OP(i2ul) OP(i2f) OP(i2d) OP(ui2d) \
+    OP(l2b) OP(l2ub) OP(l2s) OP(l2us) OP(l2i) OP(l2f) OP(l2d) OP(ul2d) \
+    OP(f2b) OP(f2ub) OP(f2s) OP(f2us) OP(f2i) OP(f2ui) OP(f2l) OP(f2ul) OP(d2f)
+
+// Conditional branches which are comparing two registers
+#define REGISTER_BRANCHES(OP) \
+    OP(ibeq) OP(ibge) OP(ibgt) OP(ible) OP(iblt) OP(ibne_un) OP(ibge_un) OP(ibgt_un) OP(ible_un) OP(iblt_un) \
+    OP(lbeq) OP(lbge) OP(lbgt) OP(lble) OP(lblt) OP(lbne_un) OP(lbge_un) OP(lbgt_un) OP(lble_un) OP(lblt_un) \
+    OP(fbeq) OP(fbge) OP(fbgt) OP(fble) OP(fblt) OP(fbne_un) OP(fbge_un) OP(fbgt_un) OP(fble_un) OP(fblt_un)
+
+// All operations of register code. Lists of binary, unary and branch operations are following each other, so
+//  their kinds are told by ranges of opcodes. Element access is reading array from left register and index from
+//  right one, stores are taking their value from destination register.
+#define REGISTER_OPCODES(OP) \
+    OP(move) \
+    OP(call) \
+    OP(callvirt) \
+    OP(ret) \
+    OP(ret_void) \
+    OP(br) \
+    OP(brfalse) \
+    OP(brtrue) \
+    OP(switch) \
+    OP(throw) \
+    OP(newarr) \
+    OP(ldlen) \
+    OP(ldelem) \
+    OP(stelem) \
+    OP(ldelem_i4) \
+    OP(ldelem_i8) \
+    OP(ldelem_r8) \
+    OP(ldelem_ref) \
+    OP(stelem_i4) \
+    OP(stelem_i8) \
+    OP(stelem_ref) \
+    REGISTER_BINARY(OP) \
+    REGISTER_UNARY(OP) \
+    REGISTER_BRANCHES(OP)
+
+#define REGISTER_OPCODE_ENUM(name) r_##name,
+
+enum struct RegisterOpcode : uint16_t {
+    REGISTER_OPCODES(REGISTER_OPCODE_ENUM)
+    count
+};
+
+// Three-address instruction. Registers are numbered within the frame: arguments, locals, constants and then one
+//  register per slot of the evaluation stack, as many as MethodBody::maxStack declares.
+struct RegisterInstruction {
+    // Address of handler, or number of handler if the loop is compiled without computed goto
+    const void* handler;
+    uint32_t destination;
+    uint32_t left;
+    uint32_t right;
+
+    union {
+        // Index of branch target
+        uint32_t target;
+        // Range of switch targets in RegisterCode::switchTargets
+        ThreadedInstruction::Table table;
+        const RuntimeMethod* method;
+        // Type of array elements, ELEMENT_TYPE_CLASS for references
+        CLIElementType elementType;
+    } operand;
+};
+
+#ifdef CHECK_REGISTER_TYPES
+// Types of the registers which are used by instruction, they are checked against the shadow tags of registers
+//  when register code is tested with CHECK_REGISTER_TYPES. END is given for the registers which aren't read or
+//  written.
+struct RegisterTypes {
+    CLIElementType destination;
+    CLIElementType left;
+    CLIElementType right;
+    // Stores are reading their destination register.
+    bool readsDestination;
+    // Calls are writing it when the callee returns, its register is the first argument until then.
+    bool writesOnReturn;
+};
+#endif
+
+// Body of interpreted method as register code. Callee frames are starting at the register of their first
+//  argument, so arguments are passed without copying.
+struct RegisterCode {
+    // Threaded code of the same method, it's executed instead if instructions are empty.
+    const ThreadedCode* threaded = nullptr;
+    std::vector<RegisterInstruction> instructions;
+    std::vector<uint32_t> switchTargets;
+    // Values of constant registers, which are following the locals
+    std::vector<uint64_t> constants;
+#ifdef CHECK_REGISTER_TYPES
+    // Types by instruction, other builds are keeping no types at all.
+    std::vector<RegisterTypes> types;
+#endif
+    uint32_t argumentsCount = 0;
+    uint32_t localsCount = 0;
+    uint32_t registersCount = 0;
+};
+
+// Translate threaded code of the method into register code, using the types of evaluation stack which were
+//  inferred for it. Local variables, arguments, constants and stack slots are becoming registers, and the values
+//  which are only loaded and stored are getting no instructions at all. Branch targets are getting the stack in
+//  its own registers, so all paths are meeting with the same layout.
+//
+// Operations of register instructions are given in registerOpcodes, their handlers are left for the interpreter.
+//  Code without instructions is returned if the method uses polymorphic operations on the values of mixed types,
+//  which register code doesn't have, instructions which aren't supported by the interpreter, or if its stack is
+//  deeper than maxStack of the body.
+std::unique_ptr<RegisterCode> translateRegisters(const RuntimeMethod& method, const ThreadedCode& threaded,
+    const std::vector<InterpreterOpcode>& opcodes, const StackTypes& types, std::vector<RegisterOpcode>& registerOpcodes);
+
+#endif
@@ -0,0 +1,595 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "RegisterInterpreter.hxx"
+#include "AppDomain.hxx"
+#include "Arithmetic.hxx"
+#include "EnumCasting.hxx"
+#include "Interpreter.hxx"
+#include "ManagedHeap.hxx"
+#include "NumCasting.hxx"
+#include "Quickening.hxx"
+
+#if defined(__GNUC__) && !defined(USE_SWITCH_DISPATCH)
+    #define THREADED_DISPATCH
+#endif
+
+using namespace std;
+using et = CLIElementType;
+
+// Registers are holding values as the evaluation stack does: integers are sign-extended to 64 bits, float32
+//  takes the low bits.
+static inline int32_t asInt32(uint64_t bits) { return static_cast<int32_t>(bits); }
+static inline int64_t asInt64(uint64_t bits) { return static_cast<int64_t>(bits); }
+static inline double asFloat64(uint64_t bits) { return ulongToDouble(bits); }
+static inline uint64_t fromInt32(int32_t value) { return static_cast<uint64_t>(static_cast<int64_t>(value)); }
+static inline uint64_t fromInt64(int64_t value) { return static_cast<uint64_t>(value); }
+static inline uint64_t fromFloat32(float value) { return floatToUInt(value); }
+static inline uint64_t fromFloat64(double value) { return doubleToULong(value); }
+
+static ArrayObject* getArray(uint64_t reference) {
+    if (reference == 0) {
+        throw runtime_error("Null reference");
+    }
+    return reinterpret_cast<ArrayObject*>(static_cast<size_t>(reference));
+}
+
+// Address of array element, it's checked as the threaded interpreter does it.
+static uint8_t* getElement(uint64_t reference, uint64_t index, CLIElementType elementType) {
+    auto* array = getArray(reference);
+    const auto position = static_cast<int64_t>(index);
+    if (position < 0 || static_cast<uint64_t>(position) >= array->length) {
+        throw runtime_error("Index out of range");
+    }
+    if (ManagedHeap::getElementSize(elementType) != array->elementSize) {
+        throw runtime_error("Array type mismatch");
+    }
+    return array->data() + static_cast<size_t>(position) * array->elementSize;
+}
+
+static uint64_t loadElement(const uint8_t* element, CLIElementType elementType) {
+    switch (elementType) {
+    case et::ELEMENT_TYPE_I1:
+        return fromInt32(*reinterpret_cast<const int8_t*>(element));
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_U1:
+        return fromInt32(*element);
+    case et::ELEMENT_TYPE_I2:
+        return fromInt32(*reinterpret_cast<const int16_t*>(element));
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_U2:
+        return fromInt32(*reinterpret_cast<const uint16_t*>(element));
+    case et::ELEMENT_TYPE_I4:
+    case et::ELEMENT_TYPE_U4:
+        return fromInt32(*reinterpret_cast<const int32_t*>(element));
+    case et::ELEMENT_TYPE_I8:
+    case et::ELEMENT_TYPE_U8:
+        return fromInt64(*reinterpret_cast<const int64_t*>(element));
+    case et::ELEMENT_TYPE_R4:
+        return fromFloat32(*reinterpret_cast<const float*>(element));
+    case et::ELEMENT_TYPE_R8:
+        return fromFloat64(*reinterpret_cast<const double*>(element));
+    case et::ELEMENT_TYPE_I:
+    case et::ELEMENT_TYPE_U:
+        return fromInt64(*reinterpret_cast<const ptrdiff_t*>(element));
+    default:
+        return *reinterpret_cast<const size_t*>(element);
+    }
+}
+
+// Float elements are getting the values of their own type, so all elements are just truncating the bits.
+static void storeElement(uint8_t* element, CLIElementType elementType, uint64_t bits) {
+    switch (elementType) {
+    case et::ELEMENT_TYPE_BOOLEAN:
+    case et::ELEMENT_TYPE_I1:
+    case et::ELEMENT_TYPE_U1:
+        *element = static_cast<uint8_t>(bits);
+        break;
+    case et::ELEMENT_TYPE_CHAR:
+    case et::ELEMENT_TYPE_I2:
+    case et::ELEMENT_TYPE_U2:
+        *reinterpret_cast<uint16_t*>(element) = static_cast<uint16_t>(bits);
+        break;
+    case et::ELEMENT_TYPE_I4:
+    case et::ELEMENT_TYPE_U4:
+    case et::ELEMENT_TYPE_R4:
+        *reinterpret_cast<uint32_t*>(element) = static_cast<uint32_t>(bits);
+        break;
+    case et::ELEMENT_TYPE_I8:
+    case et::ELEMENT_TYPE_U8:
+    case et::ELEMENT_TYPE_R8:
+        *reinterpret_cast<uint64_t*>(element) = bits;
+        break;
+    default:
+        *reinterpret_cast<size_t*>(element) = static_cast<size_t>(bits);
+        break;
+    }
+}
+
+// Registers of the frame are starting at base, where its arguments already are. Locals are zero-filled as if
+//  the method had InitLocals flag, and constants are following them.
+static void setupFrame(ExecutionThread& thread, CallStackItem& frame, const RegisterCode& code, uint32_t base) {
+    auto& variables = thread.variables;
+    if (variables.size() < base + code.registersCount) {
+        variables.resize(base + code.registersCount);
+    }
+    auto* locals = variables.data() + base + code.argumentsCount;
+    fill(locals, locals + code.localsCount, 0);
+    copy(code.constants.begin(), code.constants.end(), locals + code.localsCount);
+#ifdef CHECK_REGISTER_TYPES
+    // Arguments are keeping the tags which were given to them by caller, stack registers aren't written yet.
+    auto& tags = thread.registerTags;
+    if (tags.size() < variables.size()) {
+        tags.resize(variables.size(), et::ELEMENT_TYPE_END);
+    }
+    auto* localTags = tags.data() + base + code.argumentsCount;
+    for (uint32_t n = 0; n < code.localsCount; ++n) {
+        localTags[n] = code.threaded->locals[n].stackType;
+    }
+    fill(localTags + code.localsCount, tags.data() + base + code.registersCount, et::ELEMENT_TYPE_END);
+#endif
+
+    frame.registerCode = &code;
+    frame.code = code.threaded;
+    frame.methodBody = code.threaded->body;
+    frame.localVarSig = code.threaded->body->localVarSig;
+    frame.methodDefSig = frame.method->methodDef->signature;
+    frame.argumentsCount = code.argumentsCount;
+    frame.variablesBase = base;
+    frame.stackBase = thread.evaluationStack.data.size();
+    frame.instructionPointer = 0;
+    frame.state = ExecutionState::MethodExecution;
+}
+
+#ifdef CHECK_REGISTER_TYPES
+// Registers are untyped, types of their values are kept in shadow tags if CHECK_REGISTER_TYPES is defined.
+//  Integers are kept in one form, so their types are interchangeable, but floats and other values aren't.
+static bool isCompatible(CLIElementType tag, CLIElementType type) {
+    const auto isFloat = [](CLIElementType t) { return t == et::ELEMENT_TYPE_R4 || t == et::ELEMENT_TYPE_R8; };
+    if (tag == et::ELEMENT_TYPE_END) {
+        return false;
+    }
+    return tag == type || (!isFloat(tag) && !isFloat(type));
+}
+
+// Registers which are read by the instruction must hold the values of its types, the tag of destination is
+//  written before it's executed. Constant registers are shared by the values of all types which have their bits.
+static void checkRegisters(ExecutionThread& thread, const CallStackItem& frame, const RegisterInstruction* ip) {
+    const auto& code = *frame.registerCode;
+    const auto& types = code.types[static_cast<size_t>(ip - code.instructions.data())];
+    auto* tags = thread.registerTags.data() + frame.variablesBase;
+    const auto constants = code.argumentsCount + code.localsCount;
+    const auto check = [&](uint32_t index, CLIElementType type) {
+        if (type != et::ELEMENT_TYPE_END && (index < constants || index >= constants + code.constants.size())) {
+            if (!isCompatible(tags[index], type)) {
+                throw runtime_error("Register holds the value of another type");
+            }
+        }
+    };
+    check(ip->left, types.left);
+    check(ip->right, types.right);
+    if (types.readsDestination) {
+        check(ip->destination, types.destination);
+    } else if (!types.writesOnReturn && types.destination != et::ELEMENT_TYPE_END) {
+        tags[ip->destination] = types.destination;
+    }
+}
+
+// Result of call is written when the callee returns.
+static void setResultTag(ExecutionThread& thread, const CallStackItem& frame, const RegisterInstruction* ip) {
+    const auto& code = *frame.registerCode;
+    thread.registerTags[frame.variablesBase + ip->destination] = code.types[static_cast<size_t>(ip - code.instructions.data())].destination;
+}
+#endif
+
+void RegisterInterpreter::execute(ExecutionThread& thread) {
+    run(&thread);
+}
+
+bool RegisterInterpreter::enterFrame(ExecutionThread& thread, CallStackItem& frame) {
+    const auto* code = getCode(*thread.domain, *frame.method);
+    if (code == nullptr) {
+        return false;
+    }
+    // Arguments are converted into the types of parameters as threaded code gets them, registers are following.
+    Interpreter::enterFrame(thread, frame);
+    setupFrame(thread, frame, *code, frame.variablesBase);
+#ifdef CHECK_REGISTER_TYPES
+    for (uint32_t n = 0; n < code->argumentsCount; ++n) {
+        thread.registerTags[frame.variablesBase + n] = frame.method->arguments[n].stackType;
+    }
+#endif
+    return true;
+}
+
+const RegisterCode* RegisterInterpreter::getCode(AppDomain& domain, const RuntimeMethod& method) {
+    auto& cache = method.tokens->registerCode;
+    auto cached = cache.get(method.methodDefRow - 1);
+    if (cached == nullptr) {
+        cached = cache.publish(method.methodDefRow - 1, compile(domain, method));
+    }
+    return cached->instructions.empty() ? nullptr : cached;
+}
+
+unique_ptr<RegisterCode> RegisterInterpreter::compile(AppDomain& domain, const RuntimeMethod& method) {
+    vector<InterpreterOpcode> opcodes;
+    StackTypes types;
+    Interpreter::translate(domain, method, opcodes, &types);
+    vector<RegisterOpcode> registerOpcodes;
+    auto result = translateRegisters(method, Interpreter::getCode(domain, method), opcodes, types, registerOpcodes);
+    const auto* handlers = run(nullptr);
+    for (size_t index = 0; index < registerOpcodes.size(); ++index) {
+        result->instructions[index].handler = handlers[_u(registerOpcodes[index])];
+    }
+    return result;
+}
+
+const void* const* RegisterInterpreter::run(ExecutionThread* thread) {
+#ifdef THREADED_DISPATCH
+    #define REGISTER_OPCODE_HANDLER(name) &&L_##name,
+#else
+    #define REGISTER_OPCODE_HANDLER(name) reinterpret_cast<const void*>(static_cast<uintptr_t>(RegisterOpcode::r_##name)),
+#endif
+    static const void* const handlers[] = {
+        REGISTER_OPCODES(REGISTER_OPCODE_HANDLER)
+    };
+    #undef REGISTER_OPCODE_HANDLER
+
+    if (thread == nullptr) {
+        return handlers;
+    }
+
+    auto& stack = thread->evaluationStack;
+    auto& callStack = thread->callStack;
+    const auto depth = callStack.size();
+    auto* frame = &callStack.back();
+    const auto entryBase = frame->variablesBase;
+    const RegisterInstruction* code = nullptr;
+    const uint32_t* switchTargets = nullptr;
+    uint64_t* registers = nullptr;
+    const RuntimeMethod* callee = nullptr;
+    uint64_t executed = 0;
+
+// Registers are reloaded after every call, since the callee could reallocate them.
+#define LOAD_FRAME() \
+    do { \
+        code = frame->registerCode->instructions.data(); \
+        switchTargets = frame->registerCode->switchTargets.data(); \
+        registers = thread->variables.data() + frame->variablesBase; \
+    } while (0)
+
+#ifdef CHECK_REGISTER_TYPES
+    #define CHECK_REGISTERS() checkRegisters(*thread, *frame, ip)
+    #define SET_RESULT_TAG(instruction) setResultTag(*thread, *frame, instruction)
+#else
+    #define CHECK_REGISTERS() do {} while (0)
+    #define SET_RESULT_TAG(instruction) do {} while (0)
+#endif
+#ifdef THREADED_DISPATCH
+    #define HANDLER(name) L_##name:
+    #define DISPATCH() do { ++executed; CHECK_REGISTERS(); goto *ip->handler; } while (0)
+#else
+    #define HANDLER(name) case RegisterOpcode::r_##name:
+    #define DISPATCH() do { ++executed; CHECK_REGISTERS(); goto dispatch; } while (0)
+#endif
+#define NEXT() do { ++ip; DISPATCH(); } while (0)
+#define JUMP(index) do { ip = code + (index); DISPATCH(); } while (0)
+#define DESTINATION registers[ip->destination]
+#define LEFT registers[ip->left]
+#define RIGHT registers[ip->right]
+
+    LOAD_FRAME();
+    const RegisterInstruction* ip = code + frame->instructionPointer;
+    DISPATCH();
+
+#ifndef THREADED_DISPATCH
+dispatch:
+    switch (static_cast<RegisterOpcode>(reinterpret_cast<uintptr_t>(ip->handler))) {
+#endif
+
+    HANDLER(move)
+        DESTINATION = LEFT;
+        NEXT();
+
+    HANDLER(callvirt)
+    {
+        callee = ip->operand.method;
+        const auto object = static_cast<size_t>(LEFT);
+        if (object == 0) {
+            throw runtime_error("Null reference");
+        }
+        const auto* objectType = reinterpret_cast<const ObjectHeader*>(object)->methodTable;
+        if (objectType != nullptr) {
+            callee = &thread->domain->resolveVirtualMethod(*objectType, *callee);
+        }
+        goto invoke;
+    }
+
+    HANDLER(call)
+        callee = ip->operand.method;
+    invoke:
+    {
+        const auto* calleeCode = callee->native == nullptr ? getCode(*thread->domain, *callee) : nullptr;
+        if (calleeCode != nullptr) {
+            frame->instructionPointer = static_cast<uint32_t>(ip - code) + 1;
+            const auto base = frame->variablesBase + ip->left;
+            callStack.push_back(Interpreter::makeFrame(*thread, *callee));
+            frame = &callStack.back();
+            setupFrame(*thread, *frame, *calleeCode, base);
+            LOAD_FRAME();
+            ip = code;
+            DISPATCH();
+        }
+
+        // Native methods and the methods which aren't translated are taking arguments from the evaluation stack.
+        const auto* arguments = registers + ip->left;
+        for (size_t n = 0; n < callee->arguments.size(); ++n) {
+            stack.push_bits(arguments[n], callee->arguments[n].stackType);
+        }
+        if (callee->native != nullptr) {
+            callee->native(*thread);
+        } else {
+            callStack.push_back(Interpreter::makeFrame(*thread, *callee));
+            Interpreter::enterFrame(*thread, callStack.back());
+            Interpreter::execute(*thread);
+            LOAD_FRAME();
+        }
+        if (callee->result.stackType != et::ELEMENT_TYPE_END) {
+            DESTINATION = stack.pop_bits();
+            SET_RESULT_TAG(ip);
+        }
+        NEXT();
+    }
+
+    // Result is written to the register of call instruction, or pushed to the evaluation stack when the first
+    //  frame returns.
+    HANDLER(ret)
+    {
+        const auto value = LEFT;
+        const auto type = frame->method->result.stackType;
+        callStack.pop_back();
+        if (callStack.size() < depth) {
+            thread->variables.resize(entryBase);
+            stack.push_bits(value, type);
+            thread->executedInstructions += executed;
+            return handlers;
+        }
+        frame = &callStack.back();
+        LOAD_FRAME();
+        ip = code + frame->instructionPointer;
+        registers[ip[-1].destination] = value;
+        SET_RESULT_TAG(ip - 1);
+        DISPATCH();
+    }
+
+    HANDLER(ret_void)
+        callStack.pop_back();
+        if (callStack.size() < depth) {
+            thread->variables.resize(entryBase);
+            thread->executedInstructions += executed;
+            return handlers;
+        }
+        frame = &callStack.back();
+        LOAD_FRAME();
+        ip = code + frame->instructionPointer;
+        DISPATCH();
+
+    HANDLER(br)
+        JUMP(ip->operand.target);
+
+    HANDLER(brfalse)
+        if (LEFT == 0) {
+            JUMP(ip->operand.target);
+        }
+        NEXT();
+
+    HANDLER(brtrue)
+        if (LEFT != 0) {
+            JUMP(ip->operand.target);
+        }
+        NEXT();
+
+    HANDLER(switch)
+    {
+        const auto value = static_cast<uint32_t>(LEFT);
+        if (value < ip->operand.table.count) {
+            JUMP(switchTargets[ip->operand.table.first + value]);
+        }
+        NEXT();
+    }
+
+    HANDLER(throw)
+        throw runtime_error("Managed exceptions aren't supported yet");
+
+    HANDLER(newarr)
+    {
+        const auto length = asInt64(LEFT);
+        if (length < 0) {
+            throw runtime_error("Array length is negative");
+        }
+        DESTINATION = reinterpret_cast<size_t>(thread->domain->heap.newArray(ip->operand.elementType, static_cast<size_t>(length)));
+        NEXT();
+    }
+
+    HANDLER(ldlen)
+        DESTINATION = fromInt64(static_cast<int64_t>(getArray(LEFT)->length));
+        NEXT();
+
+    HANDLER(ldelem)
+        DESTINATION = loadElement(getElement(LEFT, RIGHT, ip->operand.elementType), ip->operand.elementType);
+        NEXT();
+
+    HANDLER(stelem)
+        storeElement(getElement(LEFT, RIGHT, ip->operand.elementType), ip->operand.elementType, DESTINATION);
+        NEXT();
+
+    HANDLER(ldelem_i4)
+        DESTINATION = fromInt32(*reinterpret_cast<const int32_t*>(getElement(LEFT, RIGHT, et::ELEMENT_TYPE_I4)));
+        NEXT();
+
+    HANDLER(ldelem_i8)
+        DESTINATION = fromInt64(*reinterpret_cast<const int64_t*>(getElement(LEFT, RIGHT, et::ELEMENT_TYPE_I8)));
+        NEXT();
+
+    HANDLER(ldelem_r8)
+        DESTINATION = *reinterpret_cast<const uint64_t*>(getElement(LEFT, RIGHT, et::ELEMENT_TYPE_R8));
+        NEXT();
+
+    HANDLER(ldelem_ref)
+        DESTINATION = *reinterpret_cast<const size_t*>(getElement(LEFT, RIGHT, et::ELEMENT_TYPE_CLASS));
+        NEXT();
+
+    HANDLER(stelem_i4)
+        *reinterpret_cast<int32_t*>(getElement(LEFT, RIGHT, et::ELEMENT_TYPE_I4)) = asInt32(DESTINATION);
+        NEXT();
+
+    HANDLER(stelem_i8)
+        *reinterpret_cast<int64_t*>(getElement(LEFT, RIGHT, et::ELEMENT_TYPE_I8)) = asInt64(DESTINATION);
+        NEXT();
+
+    HANDLER(stelem_ref)
+        *reinterpret_cast<size_t*>(getElement(LEFT, RIGHT, et::ELEMENT_TYPE_CLASS)) = static_cast<size_t>(DESTINATION);
+        NEXT();
+
+// Typed operations, they are computing the same results as quickened operations of threaded code.
+#define BINARY(name, type, load, store, expression) \
+    HANDLER(name) \
+    { \
+        const type left = load(LEFT); \
+        const type right = load(RIGHT); \
+        DESTINATION = store(expression); \
+        NEXT(); \
+    }
+#define UNARY(name, type, load, store, expression) \
+    HANDLER(name) \
+    { \
+        const type value = load(LEFT); \
+        DESTINATION = store(expression); \
+        NEXT(); \
+    }
+#define SHIFT(name, type, load, store, expression) \
+    HANDLER(name) \
+    { \
+        const type value = load(LEFT); \
+        const auto amount = asInt32(RIGHT); \
+        DESTINATION = store(expression); \
+        NEXT(); \
+    }
+#define COMPARE_BRANCH(name, type, load, condition) \
+    HANDLER(name) \
+    { \
+        const type left = load(LEFT); \
+        const type right = load(RIGHT); \
+        if (condition) { \
+            JUMP(ip->operand.target); \
+        } \
+        NEXT(); \
+    }
+#define INTEGER_HANDLERS(prefix, type, load, store) \
+    BINARY(prefix##add, type, load, store, wrappingAdd(left, right)) \
+    BINARY(prefix##sub, type, load, store, wrappingSub(left, right)) \
+    BINARY(prefix##mul, type, load, store, wrappingMul(left, right)) \
+    BINARY(prefix##div, type, load, store, checkedDiv(left, right)) \
+    BINARY(prefix##div_un, type, load, store, unsignedDiv(left, right)) \
+    BINARY(prefix##rem, type, load, store, checkedRem(left, right)) \
+    BINARY(prefix##rem_un, type, load, store, unsignedRem(left, right)) \
+    BINARY(prefix##and, type, load, store, left & right) \
+    BINARY(prefix##or, type, load, store, left | right) \
+    BINARY(prefix##xor, type, load, store, left ^ right) \
+    SHIFT(prefix##shl, type, load, store, shiftLeft(value, amount)) \
+    SHIFT(prefix##shr, type, load, store, shiftRight(value, amount)) \
+    SHIFT(prefix##shr_un, type, load, store, shiftRightUnsigned(value, amount)) \
+    UNARY(prefix##neg, type, load, store, wrappingNeg(value)) \
+    UNARY(prefix##not, type, load, store, ~value) \
+    BINARY(prefix##ceq, type, load, fromInt32, left == right) \
+    BINARY(prefix##cgt, type, load, fromInt32, left > right) \
+    BINARY(prefix##cgt_un, type, load, fromInt32, unsignedLess(right, left)) \
+    BINARY(prefix##clt, type, load, fromInt32, left < right) \
+    BINARY(prefix##clt_un, type, load, fromInt32, unsignedLess(left, right)) \
+    COMPARE_BRANCH(prefix##beq, type, load, left == right) \
+    COMPARE_BRANCH(prefix##bge, type, load, left >= right) \
+    COMPARE_BRANCH(prefix##bgt, type, load, left > right) \
+    COMPARE_BRANCH(prefix##ble, type, load, left <= right) \
+    COMPARE_BRANCH(prefix##blt, type, load, left < right) \
+    COMPARE_BRANCH(prefix##bne_un, type, load, left != right) \
+    COMPARE_BRANCH(prefix##bge_un, type, load, !unsignedLess(left, right)) \
+    COMPARE_BRANCH(prefix##bgt_un, type, load, unsignedLess(right, left)) \
+    COMPARE_BRANCH(prefix##ble_un, type, load, !unsignedLess(right, left)) \
+    COMPARE_BRANCH(prefix##blt_un, type, load, unsignedLess(left, right))
+
+    INTEGER_HANDLERS(i, int32_t, asInt32, fromInt32)
+    INTEGER_HANDLERS(l, int64_t, asInt64, fromInt64)
+
+    // Unsigned and unordered comparisons are true for NaN operands.
+    BINARY(fadd, double, asFloat64, fromFloat64, left + right)
+    BINARY(fsub, double, asFloat64, fromFloat64, left - right)
+    BINARY(fmul, double, asFloat64, fromFloat64, left * right)
+    BINARY(fdiv, double, asFloat64, fromFloat64, left / right)
+    BINARY(frem, double, asFloat64, fromFloat64, fmod(left, right))
+    UNARY(fneg, double, asFloat64, fromFloat64, -value)
+    BINARY(fceq, double, asFloat64, fromInt32, left == right)
+    BINARY(fcgt, double, asFloat64, fromInt32, left > right)
+    BINARY(fcgt_un, double, asFloat64, fromInt32, !(left <= right))
+    BINARY(fclt, double, asFloat64, fromInt32, left < right)
+    BINARY(fclt_un, double, asFloat64, fromInt32, !(left >= right))
+    COMPARE_BRANCH(fbeq, double, asFloat64, left == right)
+    COMPARE_BRANCH(fbge, double, asFloat64, left >= right)
+    COMPARE_BRANCH(fbgt, double, asFloat64, left > right)
+    COMPARE_BRANCH(fble, double, asFloat64, left <= right)
+    COMPARE_BRANCH(fblt, double, asFloat64, left < right)
+    COMPARE_BRANCH(fbne_un, double, asFloat64, !(left == right))
+    COMPARE_BRANCH(fbge_un, double, asFloat64, !(left < right))
+    COMPARE_BRANCH(fbgt_un, double, asFloat64, !(left <= right))
+    COMPARE_BRANCH(fble_un, double, asFloat64, !(left > right))
+    COMPARE_BRANCH(fblt_un, double, asFloat64, !(left >= right))
+
+    UNARY(i2b, int32_t, asInt32, fromInt32, static_cast<int8_t>(value))
+    UNARY(i2ub, int32_t, asInt32, fromInt32, static_cast<uint8_t>(value))
+    UNARY(i2s, int32_t, asInt32, fromInt32, static_cast<int16_t>(value))
+    UNARY(i2us, int32_t, asInt32, fromInt32, static_cast<uint16_t>(value))
+    UNARY(i2ul, int32_t, asInt32, fromInt64, static_cast<uint32_t>(value))
+    UNARY(i2f, int32_t, asInt32, fromFloat32, static_cast<float>(static_cast<double>(value)))
+    UNARY(i2d, int32_t, asInt32, fromFloat64, value)
+    UNARY(ui2d, int32_t, asInt32, fromFloat64, static_cast<uint32_t>(value))
+    UNARY(l2b, int64_t, asInt64, fromInt32, static_cast<int8_t>(value))
+    UNARY(l2ub, int64_t, asInt64, fromInt32, static_cast<uint8_t>(value))
+    UNARY(l2s, int64_t, asInt64, fromInt32, static_cast<int16_t>(value))
+    UNARY(l2us, int64_t, asInt64, fromInt32, static_cast<uint16_t>(value))
+    UNARY(l2i, int64_t, asInt64, fromInt32, static_cast<int32_t>(value))
+    UNARY(l2f, int64_t, asInt64, fromFloat32, static_cast<float>(static_cast<double>(value)))
+    UNARY(l2d, int64_t, asInt64, fromFloat64, static_cast<double>(value))
+    UNARY(ul2d, int64_t, asInt64, fromFloat64, static_cast<double>(static_cast<uint64_t>(value)))
+    UNARY(f2b, double, asFloat64, fromInt32, static_cast<int8_t>(truncateSigned(value)))
+    UNARY(f2ub, double, asFloat64, fromInt32, static_cast<uint8_t>(truncateSigned(value)))
+    UNARY(f2s, double, asFloat64, fromInt32, static_cast<int16_t>(truncateSigned(value)))
+    UNARY(f2us, double, asFloat64, fromInt32, static_cast<uint16_t>(truncateSigned(value)))
+    UNARY(f2i, double, asFloat64, fromInt32, static_cast<int32_t>(truncateSigned(value)))
+    UNARY(f2ui, double, asFloat64, fromInt32, static_cast<int32_t>(static_cast<uint32_t>(truncateUnsigned(value))))
+    UNARY(f2l, double, asFloat64, fromInt64, truncateSigned(value))
+    UNARY(f2ul, double, asFloat64, fromInt64, static_cast<int64_t>(truncateUnsigned(value)))
+    UNARY(d2f, double, asFloat64, fromFloat32, static_cast<float>(value))
+
+#undef BINARY
+#undef UNARY
+#undef SHIFT
+#undef COMPARE_BRANCH
+#undef INTEGER_HANDLERS
+
+#ifndef THREADED_DISPATCH
+    default:
+        throw runtime_error("Invalid register opcode");
+    }
+#endif
+
+#undef LOAD_FRAME
+#undef CHECK_REGISTERS
+#undef SET_RESULT_TAG
+#undef HANDLER
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+#undef DESTINATION
+#undef LEFT
+#undef RIGHT
+}
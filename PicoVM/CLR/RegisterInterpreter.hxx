@@ -0,0 +1,35 @@
+#ifndef __REGISTERINTERPRETER_HXX__
+#define __REGISTERINTERPRETER_HXX__
+
+#include <memory>
+
+#include "RegisterCode.hxx"
+
+struct AppDomain;
+struct CallStackItem;
+struct ExecutionThread;
+
+// Interpreter of register code, the alternative engine which is used if AppDomainOptions::registerCode is set.
+//  Registers of frames are kept in ExecutionThread::variables, and the frame of callee is overlapping the stack
+//  registers of its caller from its first argument. Methods which can't be translated are executed by threaded
+//  interpreter, so are their callees. Dispatch is the same as in Interpreter, USE_SWITCH_DISPATCH works here too.
+class RegisterInterpreter
+{
+public:
+    // Run the frame on top of the call stack until it returns, its result is pushed to the evaluation stack.
+    static void execute(ExecutionThread& thread);
+
+    // Take arguments of the frame from the evaluation stack into its registers. Returns false if the method
+    //  can't be executed as register code.
+    static bool enterFrame(ExecutionThread& thread, CallStackItem& frame);
+
+    // Register code of interpreted method, it's translated on first use. Null if the method can't be translated.
+    static const RegisterCode* getCode(AppDomain& domain, const RuntimeMethod& method);
+
+private:
+    static std::unique_ptr<RegisterCode> compile(AppDomain& domain, const RuntimeMethod& method);
+    // Handler addresses by opcode, loop returns them when it's called without thread.
+    static const void* const* run(ExecutionThread* thread);
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef __RUNTIMEMETHOD_HXX__
+#define __RUNTIMEMETHOD_HXX__
+
+#include <cstdint>
+#include <vector>
+
+#include "CLIElementTypes.hxx"
+#include "MethodTable.hxx"
+
+class AssemblyData;
+struct MethodDefRow;
+struct MethodBody;
+struct ExecutionThread;
+struct TokenCache;
+struct RuntimeMethod;
+
+// Method which is implemented by the VM itself. It takes arguments from the evaluation stack and pushes result.
+typedef void (*NativeMethod)(ExecutionThread& thread);
+
+// Type of argument, local variable or array element
+struct VariableType {
+    // Type of the value on evaluation stack: I4, I8, R4, R8, I, U for references, or VALUETYPE for the
+    //  types which can't be kept in one slot.
+    CLIElementType stackType = CLIElementType::ELEMENT_TYPE_END;
+    // Declared type, small integers are truncated when they are stored
+    CLIElementType type = CLIElementType::ELEMENT_TYPE_END;
+
+    VariableType() = default;
+    VariableType(CLIElementType StackType, CLIElementType Type) : stackType(StackType), type(Type) {}
+};
+
+// Pre-decoded instruction: address of its handler in the interpreter loop and the operand in place.
+struct ThreadedInstruction {
+    struct Variable {
+        // Arguments and local variables are one array, locals are following the arguments.
+        uint32_t index;
+        CLIElementType stackType;
+        CLIElementType type;
+    };
+
+    struct Table {
+        // Range of switch targets in ThreadedCode::switchTargets
+        uint32_t first;
+        uint32_t count;
+    };
+
+    // Address of handler, or number of handler if the loop is compiled without computed goto
+    const void* handler;
+
+    union {
+        int32_t i4;
+        int64_t i8;
+        float r4;
+        double r8;
+        Variable variable;
+        // Index of branch target
+        uint32_t target;
+        Table table;
+        const RuntimeMethod* method;
+        // String literal
+        const void* object;
+        // Type of array elements, ELEMENT_TYPE_CLASS for references
+        CLIElementType elementType;
+    } operand;
+};
+
+// Body of interpreted method, decoded once and shared by all threads of the domain.
+struct ThreadedCode {
+    const MethodBody* body = nullptr;
+    std::vector<ThreadedInstruction> instructions;
+    std::vector<uint32_t> switchTargets;
+    std::vector<VariableType> locals;
+};
+
+// Method as it's seen by the execution engine. Created on first call, immutable after that.
+struct RuntimeMethod {
+    const AssemblyData* assembly = nullptr;
+    uint32_t methodDefRow = 0;
+    const MethodDefRow* methodDef = nullptr;
+    // Resolved references of the defining assembly, threaded code is kept there as well.
+    TokenCache* tokens = nullptr;
+    // Null if method is interpreted
+    NativeMethod native = nullptr;
+    // Including this pointer of instance methods
+    std::vector<VariableType> arguments;
+    // Returned value, its stack type is END if method returns nothing
+    VariableType result;
+    bool isVirtual = false;
+    // Slot of virtual method in the vtable of its declaring type, noSlot if calls aren't dispatched
+    uint32_t slot = MethodTable::noSlot;
+    // Declaring type of interface method, null for methods of classes
+    const MethodTable* interfaceType = nullptr;
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "SignatureArena.hxx"
+#include "AssemblyReader.hxx"
+
+using namespace std;
+
+const uint32_t SignatureArena::blockSize;
+const uint32_t SignatureArena::slotsPerPage;
+
+bool Signature::equals(const Signature& other) const {
+    return count == other.count && (items == other.items || memcmp(items, other.items, count * sizeof(uint32_t)) == 0);
+}
+
+SignatureArena::SignatureArena(uint32_t HeapOffset, uint32_t HeapSize) : heapOffset(HeapOffset), heapSize(HeapSize) {
+    const auto pagesCount = (heapSize + slotsPerPage - 1) / slotsPerPage;
+    slotPages.reset(new atomic<atomic<const Signature*>*>[pagesCount]);
+    for (uint32_t n = 0; n < pagesCount; ++n) {
+        slotPages[n].store(nullptr, memory_order_relaxed);
+    }
+}
+
+const Signature* SignatureArena::get(const AssemblyReader& reader, uint32_t blobOffset) {
+    // Already parsed signatures are read without locking, slots are written only once under the lock.
+    const auto inHeap = blobOffset - heapOffset < heapSize;
+    if (inHeap) {
+        const auto* known = lookup(blobOffset - heapOffset);
+        if (known != nullptr) {
+            return known;
+        }
+    }
+
+    lock_guard<mutex> guard(lock);
+
+    if (inHeap) {
+        // Other thread could have parsed it meanwhile
+        const auto* known = lookup(blobOffset - heapOffset);
+        if (known != nullptr) {
+            return known;
+        }
+    } else {
+        auto known = byOffset.find(blobOffset);
+        if (known != byOffset.end()) {
+            return (*known).second;
+        }
+    }
+
+    auto offset = blobOffset;
+    uint32_t length;
+    offset += reader.read_varsize(length, offset);
+    if (offset > reader.size() || length > reader.size() - offset) {
+        throw runtime_error("Invalid signature");
+    }
+
+    // Signature is presented by a set of variable length
+    //   integers, we're simply reading these numbers consequently.
+    parsed.clear();
+    auto end = offset + length;
+    while (offset < end) {
+        uint32_t value;
+        offset += reader.read_varsize(value, offset);
+        parsed.push_back(value);
+    }
+
+    auto result = intern(parsed);
+    if (inHeap) {
+        publish(blobOffset - heapOffset, result);
+    } else {
+        byOffset.emplace(blobOffset, result);
+    }
+    return result;
+}
+
+const Signature* SignatureArena::lookup(uint32_t index) const {
+    const auto* page = slotPages[index / slotsPerPage].load(memory_order_acquire);
+    return page != nullptr ? page[index % slotsPerPage].load(memory_order_acquire) : nullptr;
+}
+
+void SignatureArena::publish(uint32_t index, const Signature* signature) {
+    auto* page = slotPages[index / slotsPerPage].load(memory_order_relaxed);
+    if (page == nullptr) {
+        ownedPages.emplace_back(new atomic<const Signature*>[slotsPerPage]);
+        page = ownedPages.back().get();
+        for (uint32_t n = 0; n < slotsPerPage; ++n) {
+            page[n].store(nullptr, memory_order_relaxed);
+        }
+        slotPages[index / slotsPerPage].store(page, memory_order_release);
+    }
+    page[index % slotsPerPage].store(signature, memory_order_release);
+}
+
+const Signature* SignatureArena::intern(const vector<uint32_t>& items) {
+    // FNV-1a over items
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto item : items) {
+        hash = (hash ^ item) * 1099511628211ULL;
+    }
+
+    const Signature candidate(items.data(), static_cast<uint32_t>(items.size()));
+    auto range = byContent.equal_range(static_cast<size_t>(hash));
+    for (auto it = range.first; it != range.second; ++it) {
+        if ((*it).second->equals(candidate)) {
+            return (*it).second;
+        }
+    }
+
+    // Large signatures are getting their own blocks, the rest of current block is kept for the smaller ones.
+    const auto count = static_cast<uint32_t>(items.size());
+    uint32_t* storage = nullptr;
+    if (count > blockSize / 4) {
+        blocks.emplace_back(new uint32_t[count]);
+        storage = blocks.back().get();
+    } else if (count != 0) {
+        if (count > blockAvailable) {
+            blocks.emplace_back(new uint32_t[blockSize]);
+            blockFree = blocks.back().get();
+            blockAvailable = blockSize;
+        }
+        storage = blockFree;
+        blockFree += count;
+        blockAvailable -= count;
+    }
+    if (count != 0) {
+        memcpy(storage, items.data(), count * sizeof(uint32_t));
+    }
+
+    signatures.emplace_back(storage, count);
+    const auto* result = &signatures.back();
+    byContent.emplace(static_cast<size_t>(hash), result);
+    return result;
+}
+
+size_t SignatureArena::size() const {
+    lock_guard<mutex> guard(lock);
+    return signatures.size();
+}
@@ -0,0 +1,90 @@
+#ifndef __SIGNATUREARENA_HXX__
+#define __SIGNATUREARENA_HXX__
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "CLISignature.hxx"
+
+class AssemblyReader;
+
+// Immutable parsed signature, each compressed integer of the blob is one item. Signatures are owned by the arena
+//  of their assembly, identical signatures of one assembly are the same object, so they could be compared by pointer.
+class Signature
+{
+public:
+    Signature() = default;
+    Signature(const uint32_t* Items, uint32_t Count) : items(Items), count(Count) {}
+
+    uint32_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const uint32_t* begin() const { return items; }
+    const uint32_t* end() const { return items + count; }
+    uint32_t operator[](size_t index) const { return items[index]; }
+
+    // Calling convention of method signature or kind of other signatures, masked out of the first item
+    CLISignatureFlags getKind() const { return static_cast<CLISignatureFlags>(count != 0 ? items[0] & 0x0f : 0); }
+    bool isField() const { return count != 0 && getKind() == CLISignatureFlags::SIG_FIELD; }
+
+    // Compare items, signatures of different assemblies could be equal only if they don't refer to any types.
+    bool equals(const Signature& other) const;
+
+private:
+    const uint32_t* items = nullptr;
+    uint32_t count = 0;
+};
+
+// Storage of parsed signatures of one assembly. Every blob is parsed once, signatures are looked up by blob offset
+//  and then by content, so both repeated and identical blobs share one Signature. Items are allocated in blocks
+//  which are never moved or freed until the arena is destroyed. Arena is safe to use from several threads, parsed
+//  offsets of the blob heap are published into slots which are read without locking.
+class SignatureArena
+{
+public:
+    // Image offset and size of the #Blob heap
+    SignatureArena(uint32_t HeapOffset, uint32_t HeapSize);
+    SignatureArena(const SignatureArena& other) = delete;
+    SignatureArena& operator=(const SignatureArena& other) = delete;
+
+    // Signature which is stored at the given image offset of blob
+    const Signature* get(const AssemblyReader& reader, uint32_t blobOffset);
+
+    // Number of distinct signatures
+    size_t size() const;
+
+private:
+    static const uint32_t blockSize = 4096;
+    // Slots of blob offsets are allocated by pages, only the pages with parsed signatures are allocated.
+    static const uint32_t slotsPerPage = 1024;
+
+    const Signature* intern(const std::vector<uint32_t>& items);
+    // Parsed signature by offset from the start of blob heap, or null
+    const Signature* lookup(uint32_t index) const;
+    // Caller must hold lock
+    void publish(uint32_t index, const Signature* signature);
+
+    const uint32_t heapOffset;
+    const uint32_t heapSize;
+    std::unique_ptr<std::atomic<std::atomic<const Signature*>*>[]> slotPages;
+    std::vector<std::unique_ptr<std::atomic<const Signature*>[]> > ownedPages;
+
+    mutable std::mutex lock;
+    // Offsets out of the blob heap, they aren't expected in valid images
+    std::unordered_map<uint32_t, const Signature*> byOffset;
+    std::unordered_multimap<size_t, const Signature*> byContent;
+    std::deque<Signature> signatures;
+    std::vector<std::unique_ptr<uint32_t[]> > blocks;
+    // Free part of the current block
+    uint32_t* blockFree = nullptr;
+    uint32_t blockAvailable = 0;
+    // Items of the blob which is being parsed
+    std::vector<uint32_t> parsed;
+};
+
+#endif
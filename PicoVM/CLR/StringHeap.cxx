@@ -0,0 +1,54 @@
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#include "StringHeap.hxx"
+#include "utf8.h"
+
+using namespace std;
+
+StringHeap::StringHeap(const uint8_t* heapData, uint32_t Size) : base(reinterpret_cast<const char*>(heapData)), heapSize(Size) {
+    // Heap is padded by zeros, so the last string is always terminated.
+    if (heapSize != 0 && base[heapSize - 1] != 0) {
+        throw runtime_error("#Strings heap is not terminated");
+    }
+}
+
+const char* StringHeap::c_str(StringHandle handle) const {
+    if (handle.offset >= heapSize) {
+        if (handle.offset == 0) {
+            // Empty or missing heap
+            return "";
+        }
+        throw runtime_error("Invalid #Strings heap offset");
+    }
+    return base + handle.offset;
+}
+
+uint32_t StringHeap::length(StringHandle handle) const {
+    return static_cast<uint32_t>(strlen(c_str(handle)));
+}
+
+bool StringHeap::equals(StringHandle handle, const string& utf8) const {
+    auto str = c_str(handle);
+    return strncmp(str, utf8.c_str(), utf8.size()) == 0 && str[utf8.size()] == 0;
+}
+
+bool StringHeap::equals(StringHandle handle, StringHandle other) const {
+    return handle == other || strcmp(c_str(handle), c_str(other)) == 0;
+}
+
+bool StringHeap::equals(StringHandle handle, const StringHeap& otherHeap, StringHandle other) const {
+    return strcmp(c_str(handle), otherHeap.c_str(other)) == 0;
+}
+
+string StringHeap::utf8(StringHandle handle) const {
+    return string(c_str(handle));
+}
+
+u16string StringHeap::utf16(StringHandle handle) const {
+    auto str = c_str(handle);
+    u16string result;
+    utf8::utf8to16(str, str + strlen(str), back_inserter(result));
+    return result;
+}
@@ -0,0 +1,43 @@
+#ifndef __STRINGHEAP_HXX__
+#define __STRINGHEAP_HXX__
+
+#include <cstdint>
+#include <string>
+
+// Reference to the zero terminated UTF-8 string which is stored in #Strings heap.
+struct StringHandle {
+    // Offset from the beginning of heap
+    uint32_t offset = 0;
+
+    bool operator==(const StringHandle& other) const { return offset == other.offset; }
+    bool operator!=(const StringHandle& other) const { return offset != other.offset; }
+};
+
+// Read-only view of the #Strings heap. Strings are kept in UTF-8 and converted only on request.
+class StringHeap
+{
+public:
+    StringHeap() = default;
+    StringHeap(const uint8_t* heapData, uint32_t Size);
+
+    uint32_t size() const { return heapSize; }
+
+    // Pointer to the zero terminated UTF-8 string
+    const char* c_str(StringHandle handle) const;
+    uint32_t length(StringHandle handle) const;
+
+    // Byte-wise comparison of UTF-8 strings
+    bool equals(StringHandle handle, const std::string& utf8) const;
+    bool equals(StringHandle handle, StringHandle other) const;
+    bool equals(StringHandle handle, const StringHeap& otherHeap, StringHandle other) const;
+
+    // Get copy of string
+    std::string utf8(StringHandle handle) const;
+    std::u16string utf16(StringHandle handle) const;
+
+private:
+    const char* base = nullptr;
+    uint32_t heapSize = 0;
+};
+
+#endif
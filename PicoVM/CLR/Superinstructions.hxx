@@ -0,0 +1,32 @@
+#ifndef __SUPERINSTRUCTIONS_HXX__
+#define __SUPERINSTRUCTIONS_HXX__
+
+// Generated by opcodestats, don't edit it by hand. Sequences are taken from:
+//  Arrays.exe
+//  Fib.exe
+//  FibLoop.exe
+//  FibLoop_nolong.exe
+//  Fib_nolong.exe
+//  StringArg.exe
+//  mscorlib.dll
+//
+// SI(name, length, operations...), operations after the length are op_nop.
+#define SUPERINSTRUCTIONS(SI) \
+    SI(si_ldvar_ldc_i4, 2, op_ldvar, op_ldc_i4, op_nop, op_nop) \
+    SI(si_ldc_i4_iadd_stvar_i4_ldvar, 4, op_ldc_i4, op_iadd, op_stvar_i4, op_ldvar) \
+    SI(si_ldvar_ldc_i4_iadd_stvar_i4, 4, op_ldvar, op_ldc_i4, op_iadd, op_stvar_i4) \
+    SI(si_ldvar_ldc_i4_i2l, 3, op_ldvar, op_ldc_i4, op_i2l, op_nop) \
+    SI(si_stvar_i4_ldvar, 2, op_stvar_i4, op_ldvar, op_nop, op_nop) \
+    SI(si_iadd_stvar_i4_ldvar, 3, op_iadd, op_stvar_i4, op_ldvar, op_nop) \
+    SI(si_ldvar_ldvar, 2, op_ldvar, op_ldvar, op_nop, op_nop) \
+    SI(si_ldc_i4_iceq_stvar_i4_ldvar, 4, op_ldc_i4, op_iceq, op_stvar_i4, op_ldvar) \
+    SI(si_nop_nop_ldvar_ldc_i4, 4, op_nop, op_nop, op_ldvar, op_ldc_i4) \
+    SI(si_iceq_stvar_i4_ldvar_brtrue, 4, op_iceq, op_stvar_i4, op_ldvar, op_brtrue) \
+    SI(si_ldvar_ldc_i4_iadd, 3, op_ldvar, op_ldc_i4, op_iadd, op_nop) \
+    SI(si_ldc_i4_iadd_stvar_i4, 3, op_ldc_i4, op_iadd, op_stvar_i4, op_nop) \
+    SI(si_i2l_ladd_stvar_i8_ldvar, 4, op_i2l, op_ladd, op_stvar_i8, op_ldvar) \
+    SI(si_stvar_i8_ldvar_ldc_i4_i2l, 4, op_stvar_i8, op_ldvar, op_ldc_i4, op_i2l) \
+    SI(si_ldc_i4_i2l_ladd_stvar_i8, 4, op_ldc_i4, op_i2l, op_ladd, op_stvar_i8) \
+    SI(si_ldvar_ldc_i4_i2l_ladd, 4, op_ldvar, op_ldc_i4, op_i2l, op_ladd)
+
+#endif
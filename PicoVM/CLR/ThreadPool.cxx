@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+#include "ThreadPool.hxx"
+
+using namespace std;
+
+ThreadPool::ThreadPool(uint32_t threadsCount) {
+    if (threadsCount == 0) {
+        threadsCount = thread::hardware_concurrency();
+    }
+    if (threadsCount == 0) {
+        threadsCount = 1;
+    }
+
+    for (uint32_t n = 0; n < threadsCount; ++n) {
+        workers.emplace_back(&ThreadPool::worker, this);
+    }
+}
+
+ThreadPool::~ThreadPool() noexcept {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    taskAdded.notify_all();
+
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(function<void()> task) {
+    {
+        lock_guard<mutex> guard(lock);
+        tasks.push_back(move(task));
+    }
+    taskAdded.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(lock);
+    tasksDone.wait(guard, [this] { return tasks.empty() && running == 0; });
+}
+
+void ThreadPool::parallelFor(uint32_t count, const function<void(uint32_t)>& body) {
+    struct Loop {
+        atomic<uint32_t> next;
+        atomic<bool> failed;
+        exception_ptr error;
+        mutex lock;
+        condition_variable finished;
+        uint32_t helpers = 0;
+    } loop;
+    loop.next.store(0);
+    loop.failed.store(false);
+
+    // Iterations are taken one by one, so threads which got cheap iterations are taking more of them.
+    auto work = [&loop, &body, count] {
+        for (;;) {
+            auto index = loop.next.fetch_add(1);
+            if (index >= count || loop.failed.load()) {
+                break;
+            }
+            try {
+                body(index);
+            }
+            catch (...) {
+                lock_guard<mutex> guard(loop.lock);
+                if (!loop.failed.exchange(true)) {
+                    loop.error = current_exception();
+                }
+            }
+        }
+    };
+
+    uint32_t helpers = count > 1 ? min(size(), count - 1) : 0;
+    loop.helpers = helpers;
+    for (uint32_t n = 0; n < helpers; ++n) {
+        submit([&loop, &work] {
+            work();
+            lock_guard<mutex> guard(loop.lock);
+            if (--loop.helpers == 0) {
+                loop.finished.notify_all();
+            }
+        });
+    }
+
+    work();
+
+    unique_lock<mutex> guard(loop.lock);
+    loop.finished.wait(guard, [&loop] { return loop.helpers == 0; });
+    if (loop.error) {
+        rethrow_exception(loop.error);
+    }
+}
+
+uint32_t ThreadPool::size() const {
+    return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::worker() {
+    unique_lock<mutex> guard(lock);
+    for (;;) {
+        taskAdded.wait(guard, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) {
+            // Stopping and there is nothing left to do.
+            break;
+        }
+
+        auto task = move(tasks.front());
+        tasks.pop_front();
+        ++running;
+
+        guard.unlock();
+        task();
+        guard.lock();
+
+        if (--running == 0 && tasks.empty()) {
+            tasksDone.notify_all();
+        }
+    }
+}
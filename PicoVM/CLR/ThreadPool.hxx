@@ -0,0 +1,48 @@
+#ifndef __THREADPOOL_HXX__
+#define __THREADPOOL_HXX__
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads which are executing submitted tasks in FIFO order.
+class ThreadPool
+{
+public:
+    // Zero means one thread per hardware thread.
+    explicit ThreadPool(uint32_t threadsCount = 0);
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    // Remaining tasks are finished before threads are stopped.
+    ~ThreadPool() noexcept;
+
+    // Tasks must not throw, there is nobody to catch the exception.
+    void submit(std::function<void()> task);
+
+    // Wait until all submitted tasks are finished.
+    void wait();
+
+    // Fork/join loop: body is called for every index from [0, count), calling thread is working too.
+    //  The first exception is rethrown after all started iterations are finished.
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& body);
+
+    uint32_t size() const;
+
+private:
+    void worker();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()> > tasks;
+    std::mutex lock;
+    std::condition_variable taskAdded;
+    std::condition_variable tasksDone;
+    uint32_t running = 0;
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef __TOKENCACHE_HXX__
+#define __TOKENCACHE_HXX__
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "AssemblyData.hxx"
+#include "MethodTable.hxx"
+#include "RegisterCode.hxx"
+#include "RuntimeMethod.hxx"
+
+// Dense array of resolved references by zero-based row. Each slot is filled once and published with atomic
+//  compare-and-swap, so lookups never take locks. Published values are immutable and live as long as the array.
+template<typename T>
+class ResolvedSlots
+{
+public:
+    explicit ResolvedSlots(size_t Count) : slots(new std::atomic<const T*>[Count]), count(Count) {
+        for (size_t n = 0; n < count; ++n) {
+            slots[n].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ResolvedSlots(const ResolvedSlots& other) = delete;
+    ResolvedSlots& operator=(const ResolvedSlots& other) = delete;
+
+    ~ResolvedSlots() noexcept {
+        for (size_t n = 0; n < count; ++n) {
+            delete slots[n].load(std::memory_order_relaxed);
+        }
+    }
+
+    size_t size() const { return count; }
+
+    // Resolved value or null if it's not resolved yet
+    const T* get(size_t index) const {
+        return slots[index].load(std::memory_order_acquire);
+    }
+
+    // Publish resolved value, unless some other thread has already done it. Returns the published value.
+    const T* publish(size_t index, std::unique_ptr<T> value) {
+        const T* expected = nullptr;
+        if (slots[index].compare_exchange_strong(expected, value.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return value.release();
+        }
+        return expected;
+    }
+
+private:
+    std::unique_ptr<std::atomic<const T*>[]> slots;
+    size_t count;
+};
+
+struct ResolvedAssembly {
+    const AssemblyData* assembly = nullptr;
+};
+
+struct ResolvedType {
+    const AssemblyData* assembly = nullptr;
+    // One-based TypeDef row
+    uint32_t typeDefRow = 0;
+};
+
+struct ResolvedMember {
+    const AssemblyData* assembly = nullptr;
+    // MethodDef or FieldDef token in the defining assembly
+    uint32_t token = 0;
+    // Null for fields
+    const MethodDefRow* methodDef = nullptr;
+    const Signature* signature = nullptr;
+};
+
+// References of one assembly which are resolved within one application domain.
+struct TokenCache {
+    ResolvedSlots<ResolvedAssembly> assemblyRefs;
+    ResolvedSlots<ResolvedType> typeRefs;
+    ResolvedSlots<ResolvedMember> memberRefs;
+    // Loaded types by TypeDef row
+    ResolvedSlots<MethodTable> methodTables;
+    // Executable methods, their threaded and register code by MethodDef row
+    ResolvedSlots<RuntimeMethod> methods;
+    ResolvedSlots<ThreadedCode> methodCode;
+    ResolvedSlots<RegisterCode> registerCode;
+
+    TokenCache(const AssemblyData& assembly) :
+        assemblyRefs(assembly.getAssemblyRef().size()),
+        typeRefs(assembly.cliMetaDataTables._TypeRef.size()),
+        memberRefs(assembly.cliMetaDataTables._MemberRef.size()),
+        methodTables(assembly.cliMetaDataTables._TypeDef.size()),
+        methods(assembly.cliMetaDataTables._MethodDef.size()),
+        methodCode(assembly.cliMetaDataTables._MethodDef.size()),
+        registerCode(assembly.cliMetaDataTables._MethodDef.size()) {
+    }
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include <stdexcept>
+
+#include "TypeNameIndex.hxx"
+
+using namespace std;
+
+bool TypeNameIndex::Key::operator==(const Key& other) const {
+    return nameId == other.nameId && namespaceId == other.namespaceId && enclosing == other.enclosing;
+}
+
+TypeNameIndex::TypeNameIndex(uint32_t capacity) {
+    // At most half of slots are used, so probe sequences stay short.
+    uint32_t slotsCount = 1;
+    while (slotsCount < uint64_t(capacity) * 2) {
+        slotsCount <<= 1;
+    }
+    slots.resize(slotsCount, Slot{ Key{ 0, 0, 0 }, 0 });
+}
+
+uint32_t TypeNameIndex::hash(const Key& key) {
+    // Ids are small sequential integers, they are spread over the whole range before mixing.
+    uint32_t result = key.nameId * 2654435761u;
+    result ^= (key.namespaceId * 2246822519u) + (result >> 15);
+    result ^= (key.enclosing * 3266489917u) + (result >> 13);
+    return result ^ (result >> 16);
+}
+
+void TypeNameIndex::insert(const Key& key, uint32_t row) {
+    if (row == 0 || (count + 1) * 2 > slots.size()) {
+        throw runtime_error("Invalid type index insertion");
+    }
+
+    const auto mask = static_cast<uint32_t>(slots.size()) - 1;
+    for (auto slot = hash(key) & mask; ; slot = (slot + 1) & mask) {
+        auto& item = slots[slot];
+        if (item.row == 0) {
+            item.key = key;
+            item.row = row;
+            ++count;
+            return;
+        }
+        if (item.key == key) {
+            return;
+        }
+    }
+}
+
+uint32_t TypeNameIndex::find(const Key& key) const {
+    if (slots.empty()) {
+        return 0;
+    }
+
+    const auto mask = static_cast<uint32_t>(slots.size()) - 1;
+    for (auto slot = hash(key) & mask; ; slot = (slot + 1) & mask) {
+        const auto& item = slots[slot];
+        if (item.row == 0) {
+            return 0;
+        }
+        if (item.key == key) {
+            return item.row;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef __TYPENAMEINDEX_HXX__
+#define __TYPENAMEINDEX_HXX__
+
+#include <cstdint>
+#include <vector>
+
+// Open addressing hash index from (namespace, name, enclosing type) to the one-based row of TypeDef or
+//  ExportedType table. Names are presented by ids from the NameTable, so probing compares integers only.
+//  Index is filled once and then it's read-only.
+class TypeNameIndex
+{
+public:
+    struct Key {
+        uint32_t namespaceId;
+        uint32_t nameId;
+        // One-based row of the enclosing type, zero for top level types
+        uint32_t enclosing;
+
+        bool operator==(const Key& other) const;
+    };
+
+    TypeNameIndex() = default;
+    // Index with enough slots for the given number of types
+    explicit TypeNameIndex(uint32_t capacity);
+
+    // The first row which is inserted for the key wins.
+    void insert(const Key& key, uint32_t row);
+
+    // Row of the type or zero if there is no such type
+    uint32_t find(const Key& key) const;
+
+    uint32_t size() const { return count; }
+
+private:
+    struct Slot {
+        Key key;
+        // Zero for empty slots
+        uint32_t row;
+    };
+
+    static uint32_t hash(const Key& key);
+
+    std::vector<Slot> slots;
+    uint32_t count = 0;
+};
+
+#endif
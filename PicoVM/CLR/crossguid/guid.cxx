@@ -23,6 +23,8 @@ THE SOFTWARE.
 */
 
 #include "guid.hxx"
+#include <algorithm>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -62,20 +64,21 @@ string Guid::str() const {
 }
 
 // create a guid from vector of bytes
-Guid::Guid(const vector<uint8_t> &bytes) : _bytes(bytes)
+Guid::Guid(const vector<uint8_t> &bytes)
 {
+  memcpy(_bytes, bytes.data(), min<size_t>(bytes.size(), 16));
 }
 
 // create a guid from array of bytes
 Guid::Guid(const uint8_t *bytes)
 {
-  _bytes.assign(bytes, bytes + 16);
+  memcpy(_bytes, bytes, 16);
 }
 
 // create a guid frob bytes range
 Guid::Guid(vector<uint8_t>::const_iterator first, vector<uint8_t>::const_iterator last)
 {
-  _bytes.assign(first, last);
+  copy(first, first + min<ptrdiff_t>(last - first, 16), _bytes);
 }
 
 // converts a single hex char to a number (0 - 15)
@@ -102,8 +105,7 @@ uint8_t hexPairToChar(char a, char b)
 // create a guid from string
 Guid::Guid(const string &fromString)
 {
-  _bytes.clear();
-
+  size_t count = 0;
   char charOne = '\0', charTwo;
   bool lookingForFirstChar = true;
 
@@ -121,7 +123,8 @@ Guid::Guid(const string &fromString)
     {
       charTwo = ch;
       auto byte = hexPairToChar(charOne, charTwo);
-      _bytes.push_back(byte);
+      if (count < 16)
+        _bytes[count++] = byte;
       lookingForFirstChar = true;
     }
   }
@@ -129,19 +132,20 @@ Guid::Guid(const string &fromString)
 }
 
 // create empty guid
-Guid::Guid() : _bytes({0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0})
+Guid::Guid()
 {
 }
 
 // copy constructor
-Guid::Guid(const Guid &other) : _bytes(other._bytes)
+Guid::Guid(const Guid &other)
 {
+  memcpy(_bytes, other._bytes, 16);
 }
 
 // move constructor
-Guid::Guid(Guid &&other) noexcept : _bytes(other._bytes)
+Guid::Guid(Guid &&other) noexcept
 {
-  other._bytes.clear();
+  memcpy(_bytes, other._bytes, 16);
 }
 
 // overload assignment operator
@@ -154,7 +158,7 @@ Guid &Guid::operator=(const Guid &other)
 // overload equality operator
 bool Guid::operator==(const Guid &other) const
 {
-  return _bytes == other._bytes;
+  return memcmp(_bytes, other._bytes, 16) == 0;
 }
 
 // overload inequality operator
@@ -166,16 +170,23 @@ bool Guid::operator!=(const Guid &other) const
 // overload comparison operator (required by std::map)
 bool Guid::operator<(const Guid &other) const
 {
-  for(uint32_t n = 0; n < 16; ++n) {
-    if (other._bytes[n] > _bytes[n]) {
-      return true;
-    }
-  }
+  return memcmp(_bytes, other._bytes, 16) < 0;
+}
 
-  return false;
+// fold both halves, GUIDs are random enough to be used as hashes directly
+size_t Guid::hash() const
+{
+  uint64_t low, high;
+  memcpy(&low, _bytes, 8);
+  memcpy(&high, _bytes + 8, 8);
+  uint64_t value = (low ^ (high * 0x9e3779b97f4a7c15ULL));
+  return static_cast<size_t>(value ^ (value >> 32));
 }
 
 void Guid::swap(Guid& other) noexcept
 {
-  _bytes.swap(other._bytes);
+  uint8_t tmp[16];
+  memcpy(tmp, _bytes, 16);
+  memcpy(_bytes, other._bytes, 16);
+  memcpy(other._bytes, tmp, 16);
 }
@@ -29,6 +29,8 @@ THE SOFTWARE.
 #include <string>
 #include <iostream>
 #include <cstdint>
+#include <cstddef>
+#include <functional>
 
 // Class to represent a GUID/UUID. Each instance acts as a wrapper around a
 // 16 byte value that can be passed around by value. It also supports
@@ -69,6 +71,9 @@ class Guid
     // overload comparison operator (required by std::map)
     bool operator<(const Guid &other) const;
 
+    // hash for unordered containers, bytes of GUID are already well mixed
+    size_t hash() const;
+
     void swap(Guid& other) noexcept;
 
     // Convert to string
@@ -76,11 +81,18 @@ class Guid
 
   private:
 
-    // actual data
-    std::vector<uint8_t> _bytes = {0,0,0,0, 0,0, 0,0, 0,0, 0,0,0,0,0,0};
+    // actual data, kept inline so copies never allocate
+    uint8_t _bytes[16] = {0,0,0,0, 0,0, 0,0, 0,0, 0,0,0,0,0,0};
 
     // make the << operator a friend so it can access _bytes
     friend std::ostream &operator<<(std::ostream &s, const Guid &guid);
 };
 
+namespace std {
+  template<>
+  struct hash<Guid> {
+    size_t operator()(const Guid &guid) const { return guid.hash(); }
+  };
+}
+
 #endif
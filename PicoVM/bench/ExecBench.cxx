@@ -0,0 +1,75 @@
+// Interpreter dispatch cost: time per executed instruction of one static method with one integer argument.
+//
+// Usage: execbench [--registers] [assembly path] [method name] [argument] [iterations]
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "AppDomain.hxx"
+
+using namespace std;
+
+int main(int argc, const char *argv[]) {
+    // Register code is measured instead of threaded code if it's asked first.
+    auto registers = false;
+    if (argc > 1 && string(argv[1]) == "--registers") {
+        registers = true;
+        --argc;
+        ++argv;
+    }
+#ifdef WIN32
+    string path = argc > 1 ? argv[1] : R"(appcode\FibLoop.exe)";
+    AppDomain domain(R"(appcode\)");
+#else
+    string path = argc > 1 ? argv[1] : "./PicoVM/appcode/FibLoop.exe";
+    AppDomain domain("./PicoVM/appcode/");
+#endif
+    domain.options.registerCode = registers;
+    string name = argc > 2 ? argv[2] : "fib";
+    int64_t argument = argc > 3 ? stoll(argv[3]) : 92;
+    uint32_t iterations = argc > 4 ? stoul(argv[4]) : 100000;
+
+    const auto& id = domain.loadAssembly(path);
+    const auto* assembly = domain.getAssembly(id);
+
+    uint32_t methodDefRow = 0;
+    for (uint32_t row = 1; row <= assembly->getMethodCount(); ++row) {
+        if (assembly->getStrings().equals(assembly->getMethodDef(row).name, name)) {
+            methodDefRow = row;
+            break;
+        }
+    }
+    if (methodDefRow == 0) {
+        throw runtime_error("Method " + name + " isn't found");
+    }
+    const auto& method = domain.getRuntimeMethod(assembly, methodDefRow);
+    if (method.arguments.size() != 1) {
+        throw runtime_error("Method must have one argument");
+    }
+
+    auto* thread = domain.createThread();
+    uint64_t result = 0;
+    double best = 0;
+    for (uint32_t n = 0; n < iterations; ++n) {
+        thread->executedInstructions = 0;
+        auto start = chrono::steady_clock::now();
+        thread->evaluationStack.push_bits(static_cast<uint64_t>(argument), method.arguments[0].stackType);
+        thread->setup(id, 0x06000000 | methodDefRow);
+        thread->run();
+        // Void methods are leaving nothing on the stack.
+        if (method.result.stackType != CLIElementType::ELEMENT_TYPE_END) {
+            result = thread->evaluationStack.pop_bits();
+        }
+        chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        best = (n == 0 || elapsed.count() < best) ? elapsed.count() : best;
+    }
+
+    const auto executed = thread->executedInstructions;
+    cout << path << ": " << name << "(" << argument << ") = " << static_cast<int64_t>(result) << endl;
+    cout << "instructions  best, us  ns/instruction" << endl;
+    cout << setw(12) << executed << fixed << setprecision(2) << setw(10) << best / 1000 << setw(16) << best / executed << endl;
+
+    return 0;
+}
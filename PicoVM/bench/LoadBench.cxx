@@ -0,0 +1,262 @@
+// Wall-clock time of eager assembly loading versus number of decoding threads.
+//
+// Usage: loadbench [--snapshot | --kernels | --preload] [assembly path] [max threads] [iterations]
+//
+// With --snapshot timed loads take decoded metadata from the snapshot file, the first one writes it. The reference
+//  image is always decoded from the assembly, so the snapshot is verified against it. Lazy loads are timed first,
+//  alone and with the first type name lookup, with and without the snapshot.
+//
+// With --kernels every column of every table is extracted by each column kernel which the CPU supports, results
+//  are compared with cells which are read one by one, and extraction of all columns is timed instead of loading.
+//
+// With --preload the entry point of the executable is run in a new domain, with referenced assemblies loaded on
+//  demand and then with loader threads preloading them while it runs. Max threads is the number of loader threads.
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+#include "AppDomain.hxx"
+#include "AssemblyData.hxx"
+#include "ColumnKernels.hxx"
+
+using namespace std;
+
+// All method bodies must be the same as the ones which were parsed sequentially.
+static void verify(const AssemblyData& expected, const AssemblyData& actual) {
+    if (expected.getMethodCount() != actual.getMethodCount()) {
+        throw runtime_error("Method count mismatch");
+    }
+    for (uint32_t token = 1; token <= expected.getMethodCount(); ++token) {
+        const auto& expectedDef = expected.getMethodDef(token);
+        const auto& actualDef = actual.getMethodDef(token);
+        const auto& expectedBody = expected.getMethodBody(token);
+        const auto& actualBody = actual.getMethodBody(token);
+        if (expectedDef.name != actualDef.name || !expectedDef.signature->equals(*actualDef.signature)
+            || expectedBody.data != actualBody.data || (expectedBody.localVarSig == nullptr) != (actualBody.localVarSig == nullptr)
+            || (expectedBody.localVarSig != nullptr && !expectedBody.localVarSig->equals(*actualBody.localVarSig))
+            || expectedBody.maxStack != actualBody.maxStack || expectedBody.exceptions.size() != actualBody.exceptions.size()) {
+            throw runtime_error("Method " + to_string(token) + " differs from the sequentially loaded one");
+        }
+    }
+}
+
+// Cells of all columns by readColumn, or by the given kernel if it's set.
+static vector<vector<uint32_t> > extractColumns(const MetadataTablesLayout& layout, const ColumnKernelISA* isa) {
+    vector<vector<uint32_t> > columns;
+    for (uint32_t tableIndex = 0; tableIndex < MetadataTablesLayout::maxTables; ++tableIndex) {
+        const auto& table = layout.tables[tableIndex];
+        if (table.rowCount == 0) {
+            continue;
+        }
+        for (uint32_t column = 0; column < table.columns.size(); ++column) {
+            vector<uint32_t> cells(table.rowCount);
+            if (isa == nullptr) {
+                for (uint32_t row = 0; row < table.rowCount; ++row) {
+                    cells[row] = layout.readColumn(static_cast<CLIMetadataTableItem>(tableIndex), row, column);
+                }
+            } else {
+                auto offset = table.offset + table.columns[column].offset;
+                extractStridedColumn(*isa, &layout.reader[offset], table.rowSize, table.columns[column].size, table.rowCount,
+                    cells.data(), layout.reader.size() - offset);
+            }
+            columns.push_back(move(cells));
+        }
+    }
+    return columns;
+}
+
+static void benchmarkLazyLoads(const string& path, uint32_t iterations) {
+    cout << "lazy load  best, ms  with lookup, ms" << endl;
+    uint32_t expected = 0;
+    for (auto useSnapshot : { false, true }) {
+        AssemblyLoadOptions options;
+        options.useSnapshot = useSnapshot;
+        AssemblyData first(path, options);
+        const auto found = first.findTypeDef("System", "Object");
+        if (useSnapshot && found != expected) {
+            throw runtime_error("Type lookup with snapshot differs from the one without it");
+        }
+        expected = found;
+
+        double best[2] = {};
+        for (uint32_t lookup = 0; lookup < 2; ++lookup) {
+            for (uint32_t n = 0; n < iterations; ++n) {
+                auto start = chrono::steady_clock::now();
+                AssemblyData assembly(path, options);
+                if (lookup != 0 && assembly.findTypeDef("System", "Object") != expected) {
+                    throw runtime_error("Type lookup differs from the first one");
+                }
+                chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+                best[lookup] = (n == 0 || elapsed.count() < best[lookup]) ? elapsed.count() : best[lookup];
+            }
+        }
+        cout << setw(9) << (useSnapshot ? "snapshot" : "image") << fixed << setprecision(2) << setw(10) << best[0]
+             << setw(17) << best[1] << endl;
+    }
+}
+
+static int benchmarkKernels(const string& path, uint32_t iterations) {
+    AssemblyData assembly(path);
+    const auto& layout = assembly.cliMetaDataTables._Module.getLayout();
+    const auto expected = extractColumns(layout, nullptr);
+
+    size_t cells = 0;
+    for (const auto& column : expected) {
+        cells += column.size();
+    }
+    cout << path << ": " << expected.size() << " columns, " << cells << " cells" << endl;
+    cout << "kernel  best, ms  speedup" << endl;
+
+    static const char* const names[] = { "scalar", "sse2", "avx2" };
+    double readColumnBest = 0;
+    for (int n = -1; n <= static_cast<int>(getColumnKernelISA()); ++n) {
+        auto isa = static_cast<ColumnKernelISA>(n);
+        double best = 0;
+        for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+            auto start = chrono::steady_clock::now();
+            const auto actual = extractColumns(layout, n < 0 ? nullptr : &isa);
+            chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            if (actual != expected) {
+                throw runtime_error(string("Columns extracted by ") + names[n] + " kernel differ from readColumn");
+            }
+            best = (iteration == 0 || elapsed.count() < best) ? elapsed.count() : best;
+        }
+        if (n < 0) {
+            readColumnBest = best;
+        }
+        cout << setw(6) << (n < 0 ? "read" : names[n]) << fixed << setprecision(2) << setw(10) << best
+             << setw(9) << readColumnBest / best << endl;
+    }
+
+    // Public entry point is using the best kernel, TypeDef and MethodDef lists are extracted by it during loading.
+    for (uint32_t tableIndex = 0, n = 0; tableIndex < MetadataTablesLayout::maxTables; ++tableIndex) {
+        const auto& table = layout.tables[tableIndex];
+        for (uint32_t column = 0; table.rowCount != 0 && column < table.columns.size(); ++column, ++n) {
+            if (layout.extractColumn(static_cast<CLIMetadataTableItem>(tableIndex), column) != expected[n]) {
+                throw runtime_error("Column extracted by MetadataTablesLayout differs from readColumn");
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Time from loading of the entry assembly until the domain is gone. Images aren't kept between iterations, so
+//  every run loads all of them again.
+static int benchmarkPreload(const string& path, uint32_t loaderThreads, uint32_t iterations) {
+    const auto searchPath = path.substr(0, path.find_last_of("/\\") + 1);
+    cout << path << ": " << loaderThreads << " loader threads" << endl;
+    cout << "preload  best, ms  mean, ms  speedup" << endl;
+
+    auto* output = cout.rdbuf();
+    double onDemandBest = 0;
+    for (auto preload : { false, true }) {
+        double best = 0, total = 0;
+        for (uint32_t n = 0; n < iterations; ++n) {
+            auto start = chrono::steady_clock::now();
+            {
+                AppDomain domain(searchPath);
+                domain.options.preloadReferences = preload;
+                domain.options.loaderThreads = loaderThreads;
+                const auto& id = domain.loadAssembly(path);
+                auto* thread = domain.createThread();
+                thread->setup(id);
+                // Output of the program is discarded
+                cout.rdbuf(nullptr);
+                try {
+                    thread->run();
+                }
+                catch (...) {
+                    cout.rdbuf(output);
+                    throw;
+                }
+                cout.rdbuf(output);
+            }
+            chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            best = (n == 0 || elapsed.count() < best) ? elapsed.count() : best;
+            total += elapsed.count();
+        }
+        if (!preload) {
+            onDemandBest = best;
+        }
+        cout << setw(7) << (preload ? "yes" : "no") << fixed << setprecision(2) << setw(10) << best << setw(10) << total / iterations
+             << setw(9) << onDemandBest / best << endl;
+    }
+
+    return 0;
+}
+
+int main(int argc, const char *argv[]) {
+    auto snapshot = false;
+    auto kernels = false;
+    auto preload = false;
+    if (argc > 1 && string(argv[1]) == "--snapshot") {
+        snapshot = true;
+        --argc;
+        ++argv;
+    }
+    else if (argc > 1 && string(argv[1]) == "--kernels") {
+        kernels = true;
+        --argc;
+        ++argv;
+    }
+    else if (argc > 1 && string(argv[1]) == "--preload") {
+        preload = true;
+        --argc;
+        ++argv;
+    }
+
+#ifdef WIN32
+    string path = argc > 1 ? argv[1] : (preload ? R"(appcode\FibLoop.exe)" : R"(appcode\4.0.0.0\mscorlib.dll)");
+#else
+    string path = argc > 1 ? argv[1] : (preload ? "./PicoVM/appcode/FibLoop.exe" : "./PicoVM/appcode/4.0.0.0/mscorlib.dll");
+#endif
+    uint32_t maxThreads = argc > 2 ? stoul(argv[2]) : max(thread::hardware_concurrency(), 1u);
+    uint32_t iterations = argc > 3 ? stoul(argv[3]) : 10;
+
+    if (kernels) {
+        return benchmarkKernels(path, iterations);
+    }
+    if (preload) {
+        return benchmarkPreload(path, maxThreads, iterations);
+    }
+
+    AssemblyLoadOptions options;
+    options.lazyTables = false;
+    options.lazyMethodBodies = false;
+    options.decodeThreads = 1;
+    AssemblyData sequential(path, options);
+
+    cout << path << ": " << sequential.getMethodCount() << " methods" << endl;
+    if (snapshot) {
+        benchmarkLazyLoads(path, iterations);
+    }
+    options.useSnapshot = snapshot;
+    cout << "threads  best, ms  mean, ms  speedup" << endl;
+
+    double sequentialBest = 0;
+    for (uint32_t threads = 1; threads <= maxThreads; ++threads) {
+        options.decodeThreads = threads;
+        double best = 0, total = 0;
+        for (uint32_t n = 0; n < iterations; ++n) {
+            auto start = chrono::steady_clock::now();
+            AssemblyData assembly(path, options);
+            chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            if (n == 0) {
+                verify(sequential, assembly);
+            }
+            best = (n == 0 || elapsed.count() < best) ? elapsed.count() : best;
+            total += elapsed.count();
+        }
+        if (threads == 1) {
+            sequentialBest = best;
+        }
+        cout << setw(7) << threads << fixed << setprecision(2) << setw(10) << best << setw(10) << total / iterations
+             << setw(9) << sequentialBest / best << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Frequent sequences of interpreter operations in the methods of assemblies, and the superinstructions for them.
+//
+// Usage: opcodestats [-g header] [-n superinstructions] [assembly path...]
+//
+// Methods are translated as the interpreter does it, without superinstructions. Instructions inside loops are
+//  counted LOOP_WEIGHT times per loop level, as a static estimate of how often they are executed, and every
+//  assembly has the same total weight, so the class library doesn't hide the programs. Sequences of 2 to 4
+//  operations which could be fused are ranked by the share of dispatches they would save, and with -g the best
+//  ones are written to the header as SUPERINSTRUCTIONS list.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "AppDomain.hxx"
+#include "Interpreter.hxx"
+
+using namespace std;
+using op = InterpreterOpcode;
+
+static const double LOOP_WEIGHT = 10;
+static const uint32_t MAX_LOOP_LEVEL = 3;
+static const size_t MAX_LENGTH = 4;
+
+#define OPCODE_NAME(name) #name,
+#define SUPERINSTRUCTION_NAME(name, length, first, second, third, fourth) #name,
+static const char* const opcodeNames[] = {
+    INTERPRETER_OPCODES(OPCODE_NAME)
+    SUPERINSTRUCTIONS(SUPERINSTRUCTION_NAME)
+};
+#undef OPCODE_NAME
+#undef SUPERINSTRUCTION_NAME
+
+#define OPCODE_ITEM(name) op::name,
+static const set<op> operations = { INTERPRETER_OPERATIONS(OPCODE_ITEM) };
+static const set<op> jumps = { INTERPRETER_JUMPS(OPCODE_ITEM) };
+#undef OPCODE_ITEM
+
+static string getName(op opcode) {
+    return opcodeNames[static_cast<size_t>(opcode)];
+}
+
+// Instructions with branch target in their operand
+static bool isBranch(op opcode) {
+    return (opcode >= op::op_br && opcode <= op::op_blt_un) || opcode == op::op_leave || jumps.count(opcode) != 0;
+}
+
+// Weights of instructions by the number of backward branches which are jumping over them.
+static vector<double> getWeights(const ThreadedCode& code, const vector<op>& opcodes) {
+    vector<uint32_t> depth(opcodes.size());
+    for (uint32_t index = 0; index < opcodes.size(); ++index) {
+        const auto target = code.instructions[index].operand.target;
+        if (isBranch(opcodes[index]) && target <= index) {
+            for (auto covered = target; covered <= index; ++covered) {
+                ++depth[covered];
+            }
+        }
+    }
+    vector<double> weights;
+    for (auto level : depth) {
+        double weight = 1;
+        for (uint32_t n = 0; n < min(level, MAX_LOOP_LEVEL); ++n) {
+            weight *= LOOP_WEIGHT;
+        }
+        weights.push_back(weight);
+    }
+    return weights;
+}
+
+static string getSuperinstructionName(const vector<op>& sequence) {
+    string name = "si";
+    for (auto opcode : sequence) {
+        name += "_" + getName(opcode).substr(3);
+    }
+    return name;
+}
+
+static void writeHeader(const string& path, const vector<pair<double, vector<op>>>& selected, const vector<string>& assemblies) {
+    ofstream header(path);
+    if (!header) {
+        throw runtime_error("Unable to write " + path);
+    }
+    header << "#ifndef __SUPERINSTRUCTIONS_HXX__" << endl;
+    header << "#define __SUPERINSTRUCTIONS_HXX__" << endl << endl;
+    header << "// Generated by opcodestats, don't edit it by hand. Sequences are taken from:" << endl;
+    for (const auto& assembly : assemblies) {
+        header << "//  " << assembly.substr(assembly.find_last_of("/\\") + 1) << endl;
+    }
+    header << "//" << endl;
+    header << "// SI(name, length, operations...), operations after the length are op_nop." << endl;
+    header << "#define SUPERINSTRUCTIONS(SI)";
+    for (const auto& item : selected) {
+        const auto& sequence = item.second;
+        header << " \\" << endl << "    SI(" << getSuperinstructionName(sequence) << ", " << sequence.size();
+        for (size_t n = 0; n < MAX_LENGTH; ++n) {
+            header << ", " << getName(n < sequence.size() ? sequence[n] : op::op_nop);
+        }
+        header << ")";
+    }
+    header << endl << endl << "#endif" << endl;
+}
+
+int main(int argc, const char *argv[]) {
+    string headerPath;
+    size_t count = 16;
+    vector<string> paths;
+    for (int n = 1; n < argc; ++n) {
+        const string argument = argv[n];
+        if (argument == "-g" && n + 1 < argc) {
+            headerPath = argv[++n];
+        } else if (argument == "-n" && n + 1 < argc) {
+            count = stoul(argv[++n]);
+        } else {
+            paths.push_back(argument);
+        }
+    }
+#ifdef WIN32
+    AppDomain domain(R"(appcode\)");
+    if (paths.empty()) {
+        paths.push_back(R"(appcode\FibLoop.exe)");
+    }
+#else
+    AppDomain domain("./PicoVM/appcode/");
+    if (paths.empty()) {
+        paths.push_back("./PicoVM/appcode/FibLoop.exe");
+    }
+#endif
+
+    map<vector<op>, double> sequences;
+    for (const auto& path : paths) {
+        const auto* assembly = domain.getAssembly(domain.loadAssembly(path));
+        map<vector<op>, double> counts;
+        double total = 0;
+        uint32_t translated = 0;
+        for (uint32_t row = 1; row <= assembly->getMethodCount(); ++row) {
+            vector<op> opcodes;
+            unique_ptr<ThreadedCode> code;
+            try {
+                code = Interpreter::translate(domain, domain.getRuntimeMethod(assembly, row), opcodes);
+            } catch (const exception&) {
+                // Abstract, native and generic methods
+                continue;
+            }
+            ++translated;
+            const auto weights = getWeights(*code, opcodes);
+            for (size_t start = 0; start < opcodes.size(); ++start) {
+                total += weights[start];
+                vector<op> sequence;
+                for (auto index = start; index < opcodes.size() && sequence.size() < MAX_LENGTH; ++index) {
+                    const auto opcode = opcodes[index];
+                    if (operations.count(opcode) == 0 && jumps.count(opcode) == 0) {
+                        break;
+                    }
+                    sequence.push_back(opcode);
+                    if (sequence.size() > 1) {
+                        counts[sequence] += weights[start];
+                    }
+                    if (jumps.count(opcode) != 0) {
+                        break;
+                    }
+                }
+            }
+        }
+        for (const auto& item : counts) {
+            sequences[item.first] += item.second / total / static_cast<double>(paths.size());
+        }
+        cout << dec << path << ": " << translated << " of " << assembly->getMethodCount() << " methods" << endl;
+    }
+
+    // Every superinstruction saves one dispatch per operation after the first one.
+    vector<pair<double, vector<op>>> ranked;
+    for (const auto& item : sequences) {
+        ranked.emplace_back(item.second * static_cast<double>(item.first.size() - 1), item.first);
+    }
+    sort(ranked.begin(), ranked.end(), [](const pair<double, vector<op>>& left, const pair<double, vector<op>>& right) {
+        return left.first > right.first;
+    });
+    ranked.resize(min(ranked.size(), count));
+
+    cout << "saved dispatches, %  sequence" << endl;
+    for (const auto& item : ranked) {
+        cout << setfill(' ') << setw(19) << fixed << setprecision(2) << item.first * 100 << " ";
+        for (auto opcode : item.second) {
+            cout << " " << getName(opcode);
+        }
+        cout << endl;
+    }
+
+    if (!headerPath.empty()) {
+        writeHeader(headerPath, ranked, paths);
+    }
+
+    return 0;
+}
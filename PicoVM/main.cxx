@@ -5,31 +5,70 @@ using namespace std;
 
 int main(int argc, const char *argv[]) {
 
-    const AssemblyData *assembly;
+    shared_ptr<const AssemblyData> assembly;
+
+    // Entry point is executed, unless --disasm option asks to print it instead. With --registers it's executed
+    //  as register code. With --snapshot decoded metadata is taken from snapshot files, which are written next
+    //  to assemblies if they don't exist yet. With --preload referenced assemblies are loaded by loader threads
+    //  while the entry point runs.
+    auto disassemble = false;
+    auto registers = false;
+    auto preload = false;
+    AssemblyLoadOptions loadOptions;
+    for (; argc > 1 && string(argv[1]).compare(0, 2, "--") == 0; --argc, ++argv) {
+        const string option = argv[1];
+        if (option == "--disasm") {
+            disassemble = true;
+        }
+        else if (option == "--registers") {
+            registers = true;
+        }
+        else if (option == "--snapshot") {
+            loadOptions.useSnapshot = true;
+        }
+        else if (option == "--preload") {
+            preload = true;
+        }
+        else {
+            cerr << "Unknown option " << option << endl;
+            return 1;
+        }
+    }
 
     if (argc > 1) {
-        assembly = new AssemblyData(argv[1]);
+        assembly = AssemblyCache::load(argv[1], loadOptions);
     }
     else {
 #ifdef WIN32
-        assembly = new AssemblyData(R"(appcode\FibLoop.exe)");
+        assembly = AssemblyCache::load(R"(appcode\FibLoop.exe)", loadOptions);
 #else
-        assembly = new AssemblyData("./PicoVM/appcode/FibLoop.exe");
+        assembly = AssemblyCache::load("./PicoVM/appcode/FibLoop.exe", loadOptions);
 #endif
     }
 
-/*
+    if (!disassemble && assembly->cliHeader.entryPointToken != 0) {
 #ifdef WIN32
-    AppDomain domain(R"(appcode\)");
+        AppDomain domain(R"(appcode\)");
 #else
-    AppDomain domain("./PicoVM/appcode/");
+        AppDomain domain("./PicoVM/appcode/");
 #endif
-
-    const auto& id = domain.loadAssembly(assembly); // loading
-    const auto thread = domain.createThread();
-    thread->setup(id);
-    thread->run();
-*/
+        domain.options.registerCode = registers;
+        domain.options.preloadReferences = preload;
+        domain.options.loadOptions = loadOptions;
+        const auto& id = domain.loadAssembly(assembly);
+        const auto thread = domain.createThread();
+        thread->setup(id);
+        try {
+            thread->run();
+        }
+        catch (const exception& e) {
+            cout << flush;
+            cerr << "Unhandled exception: " << e.what() << endl;
+            return 1;
+        }
+        cout << flush;
+        return 0;
+    }
 
     // Few simple tests for our AppDomain stub
 #ifdef WIN32
@@ -39,16 +78,15 @@ int main(int argc, const char *argv[]) {
 #endif
     const auto& id = domain.loadAssembly(assembly); // loading
     domain.loadAssembly(assembly); // double-loading attempt
-    delete assembly;
 
     const auto* clrData1 = domain.getAssembly(id); // getting AssemblyData reference from our AppDomain, using GUID as a key
-    const auto* clrData = domain.getAssembly(clrData1->getName(), clrData1->getVersion()); // getting AssemblyData reference from our AppDomain, using name and value pair as a key 
+    const auto* clrData = domain.getAssembly(clrData1->getStrings().utf8(clrData1->getName()), clrData1->getVersion()); // getting AssemblyData reference from our AppDomain, using name and value pair as a key 
 
     // Print some module and entrypoint data.
-    cout << clrData->cliMetaDataTables._Module[0].str() << endl;
+    cout << clrData->cliMetaDataTables._Module[0].str(clrData->getStrings()) << endl;
     auto version = clrData->getVersion();
-    auto name = clrData->getName();
-    cout << "Name: " << string(name.begin(), name.end()) << endl; 
+    auto name = clrData->getStrings().c_str(clrData->getName());
+    cout << "Name: " << name << endl; 
     cout << "Version: " << dec << version[0] << " " << version[1] << " " << version[2] << " " << version[3] << endl; 
 
     uint32_t entryPoint = clrData->cliHeader.entryPointToken;
@@ -60,10 +98,12 @@ int main(int argc, const char *argv[]) {
 
         const MethodDefRow& methodDef = clrData->getMethodDef(entryPoint);
 
-        cout << "methodName=" << string(methodDef.name.begin(), methodDef.name.end()) << endl;
-        cout << methodDef.methodBody.str(true) << endl;
+        cout << "methodName=" << clrData->getStrings().c_str(methodDef.name) << endl;
+        const MethodBody& methodBody = clrData->getMethodBody(entryPoint);
+
+        cout << methodBody.str(true) << endl;
 
-        auto tree = InstructionTree::MakeTree(methodDef.methodBody.data);
+        auto tree = InstructionTree::MakeTree(methodBody.data);
 
         cout << tree->str() << endl;
 
@@ -74,8 +114,8 @@ int main(int argc, const char *argv[]) {
         for (uint32_t n = 1; n < clrData->getMethodCount(); ++n) {
             const MethodDefRow& methodDef = clrData->getMethodDef(n);
 
-            cout << "MethodName=" << string(methodDef.name.begin(), methodDef.name.end()) << endl;
-            cout << methodDef.methodBody.str(true) << endl;
+            cout << "MethodName=" << clrData->getStrings().c_str(methodDef.name) << endl;
+            cout << clrData->getMethodBody(n).str(true) << endl;
         }
     }
 